@@ -63,6 +63,14 @@ if((NOT ARGOS_DYNAMIC_LIBRARY_LOADING) AND (ARGOS_BUILD_FOR STREQUAL "simulator"
   message(FATAL_ERROR "When compiling for the simulator, ARGOS_DYNAMIC_LIBRARY_LOADING must be ON")
 endif((NOT ARGOS_DYNAMIC_LIBRARY_LOADING) AND (ARGOS_BUILD_FOR STREQUAL "simulator"))
 
+#
+# Compile the tick profiler timers or not
+# By default, the timers are not compiled, and cost nothing
+#
+if(NOT DEFINED ARGOS_TICK_PROFILER)
+  option(ARGOS_TICK_PROFILER "ON -> compile the timers of the tick profiler, OFF -> don't" OFF)
+endif(NOT DEFINED ARGOS_TICK_PROFILER)
+
 #
 # Whether to use double or float for the Real type
 #
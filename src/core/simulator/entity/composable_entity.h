@@ -207,11 +207,19 @@ namespace argos {
    class CSpaceOperationRemove ## ENTITY : public CSpaceOperationRemoveEntity { \
    public:                                                              \
    void ApplyTo(CSpace& c_space, ENTITY& c_entity) {                    \
-      CEntity* pcToRemove;                                              \
-      while(!c_entity.GetComponentVector().empty()) {                   \
-         pcToRemove = c_entity.GetComponentVector().back();             \
-         c_entity.RemoveComponent(pcToRemove->GetTypeDescription() + "[" + pcToRemove->GetId() + "]"); \
-         CallEntityOperation<CSpaceOperationRemoveEntity, CSpace, void>(c_space, *pcToRemove); \
+      if(c_space.IsPoolingEntities()) {                                 \
+         /* The entity goes to a pool, keep its components */          \
+         for(size_t i = c_entity.GetComponentVector().size(); i > 0; --i) { \
+            CallEntityOperation<CSpaceOperationRemoveEntity, CSpace, void>(c_space, *(c_entity.GetComponentVector()[i - 1])); \
+         }                                                              \
+      }                                                                 \
+      else {                                                            \
+         CEntity* pcToRemove;                                           \
+         while(!c_entity.GetComponentVector().empty()) {                \
+            pcToRemove = c_entity.GetComponentVector().back();          \
+            c_entity.RemoveComponent(pcToRemove->GetTypeDescription() + "[" + pcToRemove->GetId() + "]"); \
+            CallEntityOperation<CSpaceOperationRemoveEntity, CSpace, void>(c_space, *pcToRemove); \
+         }                                                              \
       }                                                                 \
       c_space.RemoveEntity(c_entity);                                   \
    }                                                                    \
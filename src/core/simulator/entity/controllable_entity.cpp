@@ -10,6 +10,8 @@
 #include <argos3/core/simulator/simulator.h>
 #include <argos3/core/simulator/entity/composable_entity.h>
 #include <argos3/core/simulator/space/space.h>
+#include <argos3/core/utility/math/rng.h>
+#include <argos3/core/utility/profiler/tick_profiler.h>
 
 namespace argos {
 
@@ -18,7 +20,10 @@ namespace argos {
 
    CControllableEntity::CControllableEntity(CComposableEntity* pc_parent) :
       CEntity(pc_parent),
-      m_pcController(nullptr) {}
+      m_pcController(nullptr),
+      m_unControllerZone(0),
+      m_bControllerDeferred(false),
+      m_bDeferredParams(false) {}
 
    /****************************************/
    /****************************************/
@@ -26,7 +31,10 @@ namespace argos {
    CControllableEntity::CControllableEntity(CComposableEntity* pc_parent,
                                             const std::string& str_id) :
       CEntity(pc_parent, str_id),
-      m_pcController(nullptr) {
+      m_pcController(nullptr),
+      m_unControllerZone(0),
+      m_bControllerDeferred(false),
+      m_bDeferredParams(false) {
    }
 
    /****************************************/
@@ -48,6 +56,16 @@ namespace argos {
          /* Get the controller id */
          std::string strControllerId;
          GetNodeAttribute(t_tree, "config", strControllerId);
+         /* With parallel initialization, the space creates the controller later */
+         if(CSimulator::GetInstance().GetSpace().IsDeferringControllers()) {
+            m_bControllerDeferred = true;
+            m_strDeferredControllerId = strControllerId;
+            m_bDeferredParams = NodeExists(t_tree, "params");
+            if(m_bDeferredParams) {
+               m_tDeferredParams = GetNode(t_tree, "params");
+            }
+            return;
+         }
          /* Check if the tree has parameters to pass to the controller */
          if(NodeExists(t_tree, "params")) {
             /* Set the controller */
@@ -109,6 +127,56 @@ namespace argos {
       }
    }
 
+   /****************************************/
+   /****************************************/
+
+   /*
+    * Copies the given node and all its children.
+    * The copy shares nothing with the original tree and is freed with its last reference.
+    */
+   static TConfigurationNode CopyNode(TConfigurationNode& t_node) {
+      return dynamic_cast<TConfigurationNode&>(*t_node.Clone());
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CControllableEntity::PrepareDeferredController() {
+      /* The copies live as long as the entity, like the original tree */
+      try {
+         m_tDeferredController = CopyNode(CSimulator::GetInstance().GetConfigForController(m_strDeferredControllerId));
+         if(m_bDeferredParams) {
+            m_tDeferredParams = CopyNode(m_tDeferredParams);
+         }
+      }
+      catch(CARGoSException& ex) {
+         THROW_ARGOSEXCEPTION_NESTED("Failed to initialize controllable entity \"" << GetId() << "\".", ex);
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CControllableEntity::InitDeferredController() {
+      try {
+         m_bControllerDeferred = false;
+         try {
+            if(m_bDeferredParams) {
+               CreateController(m_tDeferredController, m_tDeferredParams);
+            }
+            else {
+               CreateController(m_tDeferredController, GetNode(m_tDeferredController, "params"));
+            }
+         }
+         catch(CARGoSException& ex) {
+            THROW_ARGOSEXCEPTION_NESTED("Can't set controller for controllable entity \"" << GetId() << "\"", ex);
+         }
+      }
+      catch(CARGoSException& ex) {
+         THROW_ARGOSEXCEPTION_NESTED("Failed to initialize controllable entity \"" << GetId() << "\".", ex);
+      }
+   }
+
    /****************************************/
    /****************************************/
    
@@ -149,50 +217,8 @@ namespace argos {
                                            TConfigurationNode& t_controller_config) {
       try {
          /* Look in the map for the parsed XML configuration of the wanted controller */
-         TConfigurationNode& tConfig = CSimulator::GetInstance().GetConfigForController(str_controller_id);
-         /* tConfig is the base of the XML section of the wanted controller */
-         std::string strImpl;
-         /* Create the controller */
-         m_pcController = CFactory<CCI_Controller>::New(tConfig.Value());
-         m_pcController->SetId(GetParent().GetId());
-         /* Go through actuators */
-         TConfigurationNode& tActuators = GetNode(tConfig, "actuators");
-         TConfigurationNodeIterator itAct;
-         for(itAct = itAct.begin(&tActuators);
-             itAct != itAct.end();
-             ++itAct) {
-            /* itAct->Value() is the name of the current actuator */
-            GetNodeAttribute(*itAct, "implementation", strImpl);
-            CSimulatedActuator* pcAct = CFactory<CSimulatedActuator>::New(itAct->Value() + " (" + strImpl + ")");
-            auto* pcCIAct = dynamic_cast<CCI_Actuator*>(pcAct);
-            if(pcCIAct == nullptr) {
-               THROW_ARGOSEXCEPTION("BUG: actuator \"" << itAct->Value() << "\" does not inherit from CCI_Actuator");
-            }
-            pcAct->SetRobot(GetParent());
-            pcCIAct->Init(*itAct);
-            m_mapActuators[itAct->Value()] = pcAct;
-            m_pcController->AddActuator(itAct->Value(), pcCIAct);
-         }
-         /* Go through sensors */
-         TConfigurationNode& tSensors = GetNode(tConfig, "sensors");
-         TConfigurationNodeIterator itSens;
-         for(itSens = itSens.begin(&tSensors);
-             itSens != itSens.end();
-             ++itSens) {
-            /* itSens->Value() is the name of the current actuator */
-            GetNodeAttribute(*itSens, "implementation", strImpl);
-            CSimulatedSensor* pcSens = CFactory<CSimulatedSensor>::New(itSens->Value() + " (" + strImpl + ")");
-            auto* pcCISens = dynamic_cast<CCI_Sensor*>(pcSens);
-            if(pcCISens == nullptr) {
-               THROW_ARGOSEXCEPTION("BUG: sensor \"" << itSens->Value() << "\" does not inherit from CCI_Sensor");
-            }
-            pcSens->SetRobot(GetParent());
-            pcCISens->Init(*itSens);
-            m_mapSensors[itSens->Value()] = pcSens;
-            m_pcController->AddSensor(itSens->Value(), pcCISens);
-         }
-         /* Configure the controller */
-         m_pcController->Init(t_controller_config);
+         CreateController(CSimulator::GetInstance().GetConfigForController(str_controller_id),
+                          t_controller_config);
       }
       catch(CARGoSException& ex) {
          THROW_ARGOSEXCEPTION_NESTED("Can't set controller for controllable entity \"" << GetId() << "\"", ex);
@@ -202,11 +228,94 @@ namespace argos {
    /****************************************/
    /****************************************/
 
+   /*
+    * Seeds the RNGs created by the calling thread from the given key while in scope.
+    */
+   struct SSeedKey {
+      SSeedKey(const std::string& str_key) { CRandom::SetSeedKey(str_key); }
+      ~SSeedKey() { CRandom::ClearSeedKey(); }
+   };
+
+   void CControllableEntity::CreateController(TConfigurationNode& t_controller_tree,
+                                              TConfigurationNode& t_controller_config) {
+      /*
+       * The RNGs of the controller, sensors and actuators are seeded from the id
+       * of the robot, so that they get the same seeds whatever the order in which
+       * the controllers are created, serially or in parallel
+       */
+      SSeedKey sSeedKey(GetParent().GetId());
+      /* tConfig is the base of the XML section of the wanted controller */
+      TConfigurationNode& tConfig = t_controller_tree;
+      std::string strImpl;
+      /* Create the controller */
+      m_pcController = CFactory<CCI_Controller>::New(tConfig.Value());
+      m_pcController->SetId(GetParent().GetId());
+      /* Go through actuators */
+      TConfigurationNode& tActuators = GetNode(tConfig, "actuators");
+      TConfigurationNodeIterator itAct;
+      for(itAct = itAct.begin(&tActuators);
+          itAct != itAct.end();
+          ++itAct) {
+         /* itAct->Value() is the name of the current actuator */
+         GetNodeAttribute(*itAct, "implementation", strImpl);
+         CSimulatedActuator* pcAct = CFactory<CSimulatedActuator>::New(itAct->Value() + " (" + strImpl + ")");
+         auto* pcCIAct = dynamic_cast<CCI_Actuator*>(pcAct);
+         if(pcCIAct == nullptr) {
+            THROW_ARGOSEXCEPTION("BUG: actuator \"" << itAct->Value() << "\" does not inherit from CCI_Actuator");
+         }
+         pcAct->SetRobot(GetParent());
+         pcCIAct->Init(*itAct);
+         m_mapActuators[itAct->Value()] = pcAct;
+         m_pcController->AddActuator(itAct->Value(), pcCIAct);
+      }
+      /* Go through sensors */
+      TConfigurationNode& tSensors = GetNode(tConfig, "sensors");
+      TConfigurationNodeIterator itSens;
+      for(itSens = itSens.begin(&tSensors);
+          itSens != itSens.end();
+          ++itSens) {
+         /* itSens->Value() is the name of the current actuator */
+         GetNodeAttribute(*itSens, "implementation", strImpl);
+         CSimulatedSensor* pcSens = CFactory<CSimulatedSensor>::New(itSens->Value() + " (" + strImpl + ")");
+         auto* pcCISens = dynamic_cast<CCI_Sensor*>(pcSens);
+         if(pcCISens == nullptr) {
+            THROW_ARGOSEXCEPTION("BUG: sensor \"" << itSens->Value() << "\" does not inherit from CCI_Sensor");
+         }
+         pcSens->SetRobot(GetParent());
+         pcCISens->Init(*itSens);
+         m_mapSensors[itSens->Value()] = pcSens;
+         m_pcController->AddSensor(itSens->Value(), pcCISens);
+      }
+#ifdef ARGOS_TICK_PROFILER
+      /* Make a profiler zone for each device and for the controller */
+      m_vecActuatorZones.clear();
+      for(auto it = m_mapActuators.begin(); it != m_mapActuators.end(); ++it) {
+         m_vecActuatorZones.push_back(CTickProfiler::GetZone("actuator", it->first));
+      }
+      m_vecSensorZones.clear();
+      for(auto it = m_mapSensors.begin(); it != m_mapSensors.end(); ++it) {
+         m_vecSensorZones.push_back(CTickProfiler::GetZone("sensor", it->first));
+      }
+      m_unControllerZone = CTickProfiler::GetZone("controller", tConfig.Value());
+#endif
+      /* Configure the controller */
+      m_pcController->Init(t_controller_config);
+   }
+
+   /****************************************/
+   /****************************************/
+
    void CControllableEntity::Sense() {
       m_vecCheckedRays.clear();
       m_vecIntersectionPoints.clear();
+#ifdef ARGOS_TICK_PROFILER
+      size_t i = 0;
+#endif
       for(auto it = m_mapSensors.begin();
           it != m_mapSensors.end(); ++it) {
+#ifdef ARGOS_TICK_PROFILER
+         ARGOS_PROFILE_ZONE(m_vecSensorZones[i++]);
+#endif
          it->second->Update();
       }
    }
@@ -216,6 +325,7 @@ namespace argos {
 
    void CControllableEntity::ControlStep() {
       if(m_pcController != nullptr) {
+         ARGOS_PROFILE_ZONE(m_unControllerZone);
          m_pcController->ControlStep();
       }
       else {
@@ -227,8 +337,14 @@ namespace argos {
    /****************************************/
 
    void CControllableEntity::Act() {
+#ifdef ARGOS_TICK_PROFILER
+      size_t i = 0;
+#endif
       for(auto it = m_mapActuators.begin();
           it != m_mapActuators.end(); ++it) {
+#ifdef ARGOS_TICK_PROFILER
+         ARGOS_PROFILE_ZONE(m_vecActuatorZones[i++]);
+#endif
          it->second->Update();
       }
    }
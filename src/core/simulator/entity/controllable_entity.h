@@ -86,6 +86,44 @@ namespace argos {
        */
       virtual void Destroy();
 
+      /**
+       * Returns <tt>true</tt> if Init() deferred the creation of the controller.
+       * Init() defers the creation of the controller when the space asks for it.
+       * @return <tt>true</tt> if Init() deferred the creation of the controller.
+       * @see CSpace::IsDeferringControllers()
+       */
+      inline bool HasDeferredController() const {
+         return m_bControllerDeferred;
+      }
+
+      /**
+       * Copies the XML configuration of the controller whose creation was deferred by Init().
+       * ticpp updates the nodes of the XML tree even when they are only read, so
+       * InitDeferredController() works on a copy that no other entity touches.
+       * Call this method from the thread that loaded the configuration, before
+       * InitDeferredController().
+       * @throws CARGoSException if the controller configuration is not found
+       * @see InitDeferredController()
+       */
+      void PrepareDeferredController();
+
+      /**
+       * Creates the controller whose creation was deferred by Init().
+       * Different entities can call this method at the same time from different threads.
+       * @throws CARGoSException if an error occurs in the creation of the controller
+       * @see PrepareDeferredController()
+       * @see SetController()
+       */
+      void InitDeferredController();
+
+      /**
+       * Returns <tt>true</tt> if a controller is associated to this entity.
+       * @return <tt>true</tt> if a controller is associated to this entity.
+       */
+      inline bool HasController() const {
+         return m_pcController != nullptr;
+      }
+
       /**
        * Returns a reference to the associated controller.
        * @return A reference to the associated controller.
@@ -231,6 +269,18 @@ namespace argos {
          return m_mapSensors;
       }
 
+   protected:
+
+      /**
+       * Creates and assigns a controller from the given XML sections.
+       * @param t_controller_tree The XML section of the controller
+       * @param t_controller_config An XML tree to pass to CCI_Controller::Init()
+       * @throws CARGoSException if an error occurs in the creation of the controller
+       * @see SetController()
+       */
+      void CreateController(TConfigurationNode& t_controller_tree,
+                            TConfigurationNode& t_controller_config);
+
    protected:
 
       /** The pointer to the associated controller */
@@ -242,12 +292,36 @@ namespace argos {
       /** The map of sensors, indexed by sensor type (not implementation!) */
       std::map<std::string, CSimulatedSensor*> m_mapSensors;
 
+      /** The profiler zones of the actuators, in the order of the map */
+      std::vector<UInt32> m_vecActuatorZones;
+
+      /** The profiler zones of the sensors, in the order of the map */
+      std::vector<UInt32> m_vecSensorZones;
+
+      /** The profiler zone of the controller */
+      UInt32 m_unControllerZone;
+
       /** The list of checked rays */
       std::vector<std::pair<bool, CRay3> > m_vecCheckedRays;
 
       /** The list of intersection points */
       std::vector<CVector3> m_vecIntersectionPoints;
 
+      /** <tt>true</tt> if the creation of the controller was deferred */
+      bool m_bControllerDeferred;
+
+      /** The id of the deferred controller */
+      std::string m_strDeferredControllerId;
+
+      /** <tt>true</tt> if the entity gives the parameters of the deferred controller */
+      bool m_bDeferredParams;
+
+      /** The parameters of the deferred controller, if given in the entity */
+      TConfigurationNode m_tDeferredParams;
+
+      /** A copy of the XML section of the deferred controller */
+      TConfigurationNode m_tDeferredController;
+
    };
 
 }
@@ -128,6 +128,34 @@ namespace argos {
          return *m_psOriginAnchor;
       }
 
+      /**
+       * Returns the position the entity returns to when it is reset.
+       * @return The initial position of the origin anchor.
+       */
+      inline const CVector3& GetInitOriginPosition() const {
+         return m_cInitOriginPosition;
+      }
+
+      /**
+       * Returns the orientation the entity returns to when it is reset.
+       * @return The initial orientation of the origin anchor.
+       */
+      inline const CQuaternion& GetInitOriginOrientation() const {
+         return m_cInitOriginOrientation;
+      }
+
+      /**
+       * Sets the position and orientation the entity returns to when it is reset.
+       * This does not move the entity. To move the entity, use MoveTo().
+       * @param c_position The new initial position of the origin anchor.
+       * @param c_orientation The new initial orientation of the origin anchor.
+       */
+      inline void SetInitOriginPose(const CVector3& c_position,
+                                    const CQuaternion& c_orientation) {
+         m_cInitOriginPosition = c_position;
+         m_cInitOriginOrientation = c_orientation;
+      }
+
       /**
        * Adds an anchor to the embodied entity.
        * The anchor is initially disabled. To enable it you must call EnableAnchor().
@@ -19,7 +19,8 @@ namespace argos {
       m_pcParent(pc_parent),
       m_nIndex(-1),
       m_bEnabled(true),
-      m_ptConfNode(nullptr) {
+      m_ptConfNode(nullptr),
+      m_unConfigurationKey(0) {
    }
 
    /****************************************/
@@ -31,7 +32,8 @@ namespace argos {
       m_strId(str_id),
       m_nIndex(-1),
       m_bEnabled(true),
-      m_ptConfNode(nullptr) {
+      m_ptConfNode(nullptr),
+      m_unConfigurationKey(0) {
    }
 
    /****************************************/
@@ -43,6 +45,10 @@ namespace argos {
           * Set the configuration node
           */
          m_ptConfNode = &t_tree;
+         /* Remember what a root entity was made of, for the entity pools */
+         if(m_pcParent == nullptr) {
+            m_unConfigurationKey = ComputeConfigurationKey(t_tree);
+         }
          /*
           * Set the id of the entity from XML or type description
           */
@@ -76,6 +82,61 @@ namespace argos {
    /****************************************/
    /****************************************/
 
+   static void HashString(UInt64& un_hash,
+                          const std::string& str_text) {
+      /* FNV-1a, with a zero byte to end each string */
+      for(size_t i = 0; i < str_text.size(); ++i) {
+         un_hash = (un_hash ^ static_cast<UInt8>(str_text[i])) * 1099511628211ULL;
+      }
+      un_hash *= 1099511628211ULL;
+   }
+
+   /*
+    * Hashes a configuration node and its subtree.
+    * The id of the root node and the pose in its <body> child are skipped.
+    */
+   static void HashConfigurationNode(UInt64& un_hash,
+                                     TConfigurationNode& t_node,
+                                     UInt32 un_depth) {
+      HashString(un_hash, t_node.Value());
+      bool bBody = (un_depth == 1 && t_node.Value() == "body");
+      TConfigurationAttributeIterator itAttribute;
+      std::string strKey, strValue;
+      for(itAttribute = itAttribute.begin(&t_node);
+          itAttribute != itAttribute.end();
+          ++itAttribute) {
+         itAttribute.Get()->GetName(&strKey);
+         if((un_depth == 0 && strKey == "id") ||
+            (bBody && (strKey == "position" || strKey == "orientation"))) {
+            continue;
+         }
+         itAttribute.Get()->GetValue(&strValue);
+         HashString(un_hash, strKey);
+         HashString(un_hash, strValue);
+      }
+      HashString(un_hash, t_node.GetText(false));
+      TConfigurationNodeIterator itChild;
+      for(itChild = itChild.begin(&t_node);
+          itChild != itChild.end();
+          ++itChild) {
+         HashConfigurationNode(un_hash, *itChild, un_depth + 1);
+      }
+      /* Mark the end of the children */
+      un_hash *= 1099511628211ULL;
+   }
+
+   /****************************************/
+   /****************************************/
+
+   UInt64 CEntity::ComputeConfigurationKey(TConfigurationNode& t_tree) {
+      UInt64 unHash = 14695981039346656037ULL;
+      HashConfigurationNode(unHash, t_tree, 0);
+      return unHash;
+   }
+
+   /****************************************/
+   /****************************************/
+
    std::string CEntity::GetContext() const {
       if(m_pcParent != nullptr) {
          return GetParent().GetContext() + GetParent().GetId() + ".";
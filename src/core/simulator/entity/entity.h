@@ -224,12 +224,15 @@ namespace argos {
        * Returns the entity index.
        * 
        * The entity index is used to order entities globally when
-       * necessary to ensure determinism.
+       * necessary to ensure determinism. The space gives increasing
+       * indices to the entities in the order they are added, and never
+       * gives the index of a removed entity to another entity.
        *
        * When an entity index is <0, the index is considered unset and
        * it should not be used.
        *
        * @return The entity index.
+       * @see CSpace::GetEntityByIndex()
        */
       ssize_t GetIndex() const {
          return m_nIndex;
@@ -293,6 +296,41 @@ namespace argos {
          return m_ptConfNode;
       }
 
+      /**
+       * Returns a hash of the configuration this root entity was initialized with.
+       * The id of the entity and the pose in its <tt>&lt;body&gt;</tt> tag are left out.
+       * The hash is zero if the entity was not initialized from a configuration node,
+       * or if it is a component of another entity.
+       * @return A hash of the configuration this root entity was initialized with.
+       * @see CSpace::SpawnFromPool()
+       */
+      inline UInt64 GetConfigurationKey() const {
+         return m_unConfigurationKey;
+      }
+
+      /**
+       * Returns a hash of the given configuration of a root entity.
+       * The id of the entity and the pose in its <tt>&lt;body&gt;</tt> tag are left out.
+       * @param t_tree The configuration of the entity.
+       * @return A hash of the configuration.
+       * @see GetConfigurationKey()
+       */
+      static UInt64 ComputeConfigurationKey(TConfigurationNode& t_tree);
+
+   private:
+
+      /**
+       * Sets the id of this entity.
+       * The id can be changed only while the entity is not in the space.
+       * @param str_id The new id of this entity.
+       * @see CSpace::SpawnFromPool()
+       */
+      inline void SetId(const std::string& str_id) {
+         m_strId = str_id;
+      }
+
+      friend class CSpace;
+
    private:
 
       /** The parent of this entity */
@@ -310,6 +348,9 @@ namespace argos {
       /** The XML tag used to configure this entity, if any */
       TConfigurationNode* m_ptConfNode;
 
+      /** The hash of the configuration of this root entity, if any */
+      UInt64 m_unConfigurationKey;
+
    };
 
    /**
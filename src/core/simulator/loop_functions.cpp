@@ -56,4 +56,32 @@ namespace argos {
    /****************************************/
    /****************************************/
 
+   CEntity& CLoopFunctions::SpawnFromPool(const std::string& str_type,
+                                          TConfigurationNode& t_tree) {
+      CEntity* pcEntity = m_cSpace.SpawnFromPool(str_type, t_tree);
+      if(pcEntity == nullptr) {
+         pcEntity = CFactory<CEntity>::New(str_type);
+         pcEntity->Init(t_tree);
+         AddEntity(*pcEntity);
+      }
+      return *pcEntity;
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CLoopFunctions::ReturnToPool(const std::string& str_entity_id) {
+      ReturnToPool(m_cSpace.GetEntity(str_entity_id));
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CLoopFunctions::ReturnToPool(CEntity& c_entity) {
+      m_cSpace.PoolEntity(c_entity);
+   }
+
+   /****************************************/
+   /****************************************/
+
 }
@@ -236,6 +236,40 @@ namespace argos {
        */
       virtual void RemoveEntity(CEntity& c_entity);
 
+      /**
+       * Adds an entity of the given type to the simulation, reusing a pooled entity if possible.
+       * If an entity of the given type was pooled after being created from the same
+       * configuration, except for the id and the body pose, it is put back in the
+       * simulation with the id and the body pose in the given configuration, and then
+       * reset. Otherwise, a new entity is created from the configuration, as
+       * AddEntity() would.
+       * Use this method with ReturnToPool() when entities are often added and removed,
+       * to avoid creating and destroying them.
+       * @param str_type The type of the entity, as returned by CEntity::GetTypeDescription().
+       * @param t_tree The configuration of the entity, as in the <tt>&lt;arena&gt;</tt> section.
+       * @return A reference to the spawned entity.
+       * @throws CARGoSException if an error occurs.
+       * @see ReturnToPool()
+       */
+      virtual CEntity& SpawnFromPool(const std::string& str_type,
+                                     TConfigurationNode& t_tree);
+
+      /**
+       * Removes an entity from the simulation and keeps it for SpawnFromPool().
+       * @param str_entity_id The id of the entity to remove.
+       * @throws CARGoSException If an entity with the specified id was not found.
+       * @see SpawnFromPool()
+       */
+      virtual void ReturnToPool(const std::string& str_entity_id);
+
+      /**
+       * Removes an entity from the simulation and keeps it for SpawnFromPool().
+       * The entity must not be a component of another entity.
+       * @param c_entity A reference to the entity to remove.
+       * @see SpawnFromPool()
+       */
+      virtual void ReturnToPool(CEntity& c_entity);
+
 
      /**
       * \brief Iterate over all controllable entities currently present in the
@@ -28,4 +28,41 @@ namespace argos {
    /****************************************/
    /****************************************/
 
+   void CMedium::ParseGridIndex(TConfigurationNode& t_tree,
+                                bool& b_flat_grid,
+                                CVector3& c_min,
+                                CVector3& c_max,
+                                size_t* pun_grid_size) {
+      /* Get the positional index method */
+      std::string strPosIndexMethod("grid");
+      GetNodeAttributeOrDefault(t_tree, "index", strPosIndexMethod, strPosIndexMethod);
+      if(strPosIndexMethod != "grid" &&
+         strPosIndexMethod != "flat_grid") {
+         THROW_ARGOSEXCEPTION("Unknown method \"" << strPosIndexMethod << "\" for the positional index.");
+      }
+      b_flat_grid = (strPosIndexMethod == "flat_grid");
+      /* Get the arena center and size */
+      CVector3 cArenaCenter;
+      CVector3 cArenaSize;
+      TConfigurationNode& tArena = GetNode(CSimulator::GetInstance().GetConfigurationRoot(), "arena");
+      GetNodeAttribute(tArena, "size", cArenaSize);
+      GetNodeAttributeOrDefault(tArena, "center", cArenaCenter, cArenaCenter);
+      c_min = cArenaCenter - cArenaSize * 0.5f;
+      c_max = cArenaCenter + cArenaSize * 0.5f;
+      /* Get the grid size */
+      if(!NodeAttributeExists(t_tree, "grid_size")) {
+         pun_grid_size[0] = static_cast<size_t>(cArenaSize.GetX());
+         pun_grid_size[1] = static_cast<size_t>(cArenaSize.GetY());
+         pun_grid_size[2] = static_cast<size_t>(cArenaSize.GetZ());
+      }
+      else {
+         std::string strPosGridSize;
+         GetNodeAttribute(t_tree, "grid_size", strPosGridSize);
+         ParseValues<size_t>(strPosGridSize, 3, pun_grid_size, ',');
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
 }
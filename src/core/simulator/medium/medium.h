@@ -16,6 +16,8 @@ namespace argos {
 #include <argos3/core/utility/configuration/argos_configuration.h>
 #include <argos3/core/utility/datatypes/datatypes.h>
 #include <argos3/core/utility/plugins/factory.h>
+#include <argos3/core/simulator/space/positional_indices/grid.h>
+#include <argos3/core/simulator/space/positional_indices/flat_grid.h>
 
 namespace argos {
 
@@ -69,6 +71,37 @@ namespace argos {
        */
       virtual void Update() = 0;
 
+      /**
+       * Splits the update of this medium in tasks.
+       * The multi-thread spaces call this method from the main thread instead
+       * of Update(). Then, they call UpdateTask() once for each task, possibly
+       * from different threads at the same time, and finally EndUpdate() from
+       * the main thread. The result must not depend on how the tasks are
+       * distributed across the threads.
+       * By default, this method returns 0, meaning that the update cannot be
+       * split and Update() must be called instead.
+       * @return The number of tasks the update was split into.
+       * @see UpdateTask()
+       * @see EndUpdate()
+       */
+      virtual size_t BeginUpdate() {
+         return 0;
+      }
+
+      /**
+       * Executes one of the tasks prepared by BeginUpdate().
+       * @param un_task The task index, between 0 and the value returned by BeginUpdate().
+       * @see BeginUpdate()
+       */
+      virtual void UpdateTask(size_t un_task) {}
+
+      /**
+       * Completes an update split by BeginUpdate().
+       * This method is called once all the tasks are done.
+       * @see BeginUpdate()
+       */
+      virtual void EndUpdate() {}
+
       /**
        * Returns the id of this medium.
        * @return The id of this medium.
@@ -93,6 +126,59 @@ namespace argos {
          return *m_pcSpace;
       }
 
+   protected:
+
+      /**
+       * Creates the positional index of the entities managed by this medium.
+       * The index type is read from the 'index' attribute, which can be
+       * "grid" (the default) or "flat_grid". The grid covers the arena, and
+       * its number of cells per axis is read from the 'grid_size' attribute
+       * (default: one cell per meter).
+       * @param t_tree The XML configuration tree of this medium.
+       * @param pc_update_operation Set to the newly created update operation.
+       * @return The positional index.
+       * @throw CARGoSException if the index type is unknown.
+       * @see ParseGridIndex()
+       */
+      template <class ENTITY, class GRID_UPDATER, class FLAT_GRID_UPDATER>
+      CPositionalIndex<ENTITY>* CreateGridIndex(TConfigurationNode& t_tree,
+                                                typename CPositionalIndex<ENTITY>::COperation*& pc_update_operation) {
+         bool bFlatGrid;
+         CVector3 cMin, cMax;
+         size_t punGridSize[3];
+         ParseGridIndex(t_tree, bFlatGrid, cMin, cMax, punGridSize);
+         if(!bFlatGrid) {
+            CGrid<ENTITY>* pcGrid = new CGrid<ENTITY>(
+               cMin, cMax, punGridSize[0], punGridSize[1], punGridSize[2]);
+            pc_update_operation = new GRID_UPDATER(*pcGrid);
+            pcGrid->SetUpdateEntityOperation(pc_update_operation);
+            return pcGrid;
+         }
+         else {
+            CFlatGrid<ENTITY>* pcGrid = new CFlatGrid<ENTITY>(
+               cMin, cMax, punGridSize[0], punGridSize[1], punGridSize[2]);
+            pc_update_operation = new FLAT_GRID_UPDATER(*pcGrid);
+            pcGrid->SetUpdateEntityOperation(pc_update_operation);
+            return pcGrid;
+         }
+      }
+
+      /**
+       * Parses the positional index settings of this medium.
+       * @param t_tree The XML configuration tree of this medium.
+       * @param b_flat_grid Set to <tt>true</tt> if index="flat_grid".
+       * @param c_min Set to the minimum corner of the arena.
+       * @param c_max Set to the maximum corner of the arena.
+       * @param pun_grid_size Set to the number of cells per axis.
+       * @throw CARGoSException if the index type is unknown.
+       * @see CreateGridIndex()
+       */
+      void ParseGridIndex(TConfigurationNode& t_tree,
+                          bool& b_flat_grid,
+                          CVector3& c_min,
+                          CVector3& c_max,
+                          size_t* pun_grid_size);
+
    private:
                
       /** The medium's id. */
@@ -40,16 +40,15 @@ namespace argos {
 
    bool GetClosestEmbodiedEntityIntersectedByRay(SEmbodiedEntityIntersectionItem& s_item,
                                                  const CRay3& c_ray) {
+      /* This variable is instantiated at the first call of this function, once and forever */
+      static CSimulator& cSimulator = CSimulator::GetInstance();
       /* Initialize s_item */
       s_item.IntersectedEntity = nullptr;
       s_item.TOnRay = 1.0f;
-      /* Perform full ray query */
-      TEmbodiedEntityIntersectionData tData;
-      GetEmbodiedEntitiesIntersectedByRay(tData, c_ray);
-      /* Go through intersections and find the closest */
-      for(size_t i = 0; i < tData.size(); ++i) {
-         if(s_item.TOnRay > tData[i].TOnRay)
-            s_item = tData[i];
+      /* Ask each engine for its closest intersection */
+      CPhysicsEngine::TVector& vecEngines = cSimulator.GetPhysicsEngines();
+      for(size_t i = 0; i < vecEngines.size(); ++i) {
+         vecEngines[i]->CheckClosestIntersectionWithRay(s_item, c_ray, nullptr);
       }
       /* Return true if an intersection was found */
       return (s_item.IntersectedEntity != nullptr);
@@ -61,18 +60,15 @@ namespace argos {
    bool GetClosestEmbodiedEntityIntersectedByRay(SEmbodiedEntityIntersectionItem& s_item,
                                                  const CRay3& c_ray,
                                                  CEmbodiedEntity& c_entity) {
+      /* This variable is instantiated at the first call of this function, once and forever */
+      static CSimulator& cSimulator = CSimulator::GetInstance();
       /* Initialize s_item */
       s_item.IntersectedEntity = nullptr;
       s_item.TOnRay = 1.0f;
-      /* Perform full ray query */
-      TEmbodiedEntityIntersectionData tData;
-      GetEmbodiedEntitiesIntersectedByRay(tData, c_ray);
-      /* Go through intersections and find the closest */
-      for(size_t i = 0; i < tData.size(); ++i) {
-         if(s_item.TOnRay > tData[i].TOnRay &&
-            &c_entity != tData[i].IntersectedEntity) {
-            s_item = tData[i];
-         }
+      /* Ask each engine for its closest intersection */
+      CPhysicsEngine::TVector& vecEngines = cSimulator.GetPhysicsEngines();
+      for(size_t i = 0; i < vecEngines.size(); ++i) {
+         vecEngines[i]->CheckClosestIntersectionWithRay(s_item, c_ray, &c_entity);
       }
       /* Return true if an intersection was found */
       return (s_item.IntersectedEntity != nullptr);
@@ -81,6 +77,28 @@ namespace argos {
    /****************************************/
    /****************************************/
 
+   bool GetClosestEmbodiedEntitiesIntersectedByRays(TEmbodiedEntityIntersectionData& t_items,
+                                                    const std::vector<CRay3>& vec_rays,
+                                                    CEmbodiedEntity& c_entity) {
+      /* This variable is instantiated at the first call of this function, once and forever */
+      static CSimulator& cSimulator = CSimulator::GetInstance();
+      /* Initialize the items */
+      t_items.assign(vec_rays.size(), SEmbodiedEntityIntersectionItem());
+      /* Ask each engine to perform the ray queries */
+      CPhysicsEngine::TVector& vecEngines = cSimulator.GetPhysicsEngines();
+      for(size_t i = 0; i < vecEngines.size(); ++i) {
+         vecEngines[i]->CheckIntersectionWithRays(t_items, vec_rays, &c_entity);
+      }
+      /* Return true if an intersection was found */
+      for(size_t i = 0; i < t_items.size(); ++i) {
+         if(t_items[i].IntersectedEntity != nullptr) return true;
+      }
+      return false;
+   }
+
+   /****************************************/
+   /****************************************/
+
    /* The default value of the simulation clock tick */
    Real CPhysicsEngine::m_fSimulationClockTick = 0.1f;
    Real CPhysicsEngine::m_fInverseSimulationClockTick = 1.0f / CPhysicsEngine::m_fSimulationClockTick;
@@ -88,6 +106,44 @@ namespace argos {
    /****************************************/
    /****************************************/
 
+   void CPhysicsEngine::CheckIntersectionWithRays(TEmbodiedEntityIntersectionData& t_items,
+                                                  const std::vector<CRay3>& vec_rays,
+                                                  const CEmbodiedEntity* pc_excluded) const {
+      /* Reuse the buffer across calls, each thread has its own */
+      static thread_local TEmbodiedEntityIntersectionData tData;
+      for(size_t i = 0; i < vec_rays.size(); ++i) {
+         tData.clear();
+         CheckIntersectionWithRay(tData, vec_rays[i]);
+         for(size_t j = 0; j < tData.size(); ++j) {
+            if(t_items[i].TOnRay > tData[j].TOnRay &&
+               pc_excluded != tData[j].IntersectedEntity) {
+               t_items[i] = tData[j];
+            }
+         }
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CPhysicsEngine::CheckClosestIntersectionWithRay(SEmbodiedEntityIntersectionItem& s_item,
+                                                        const CRay3& c_ray,
+                                                        const CEmbodiedEntity* pc_excluded) const {
+      /* Reuse the buffer across calls, each thread has its own */
+      static thread_local TEmbodiedEntityIntersectionData tData;
+      tData.clear();
+      CheckIntersectionWithRay(tData, c_ray);
+      for(size_t i = 0; i < tData.size(); ++i) {
+         if(s_item.TOnRay > tData[i].TOnRay &&
+            pc_excluded != tData[i].IntersectedEntity) {
+            s_item = tData[i];
+         }
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
    CPhysicsEngine::SVolume::SVolume() :
       TopFace(nullptr),
       BottomFace(nullptr) {
@@ -88,6 +88,22 @@ namespace argos {
                                                         const CRay3& c_ray,
                                                         CEmbodiedEntity& c_entity);
 
+   /**
+    * Returns the closest intersection with an embodied entity for each ray of a batch.
+    * The result is the same as calling GetClosestEmbodiedEntityIntersectedByRay() for
+    * each ray, but each physics engine receives all the rays at once, and can share
+    * the search for the candidate entities across the rays.
+    * @param t_items The closest intersection of each ray; an item without intersected
+    * entity means no intersection. The vector is resized to the number of rays.
+    * @param vec_rays The rays to test for intersections.
+    * @param c_entity The entity to exclude from the intersection check.
+    * @return <tt>true</tt> if at least one intersection is found
+    * @see CPhysicsEngine::CheckIntersectionWithRays()
+    */
+   extern bool GetClosestEmbodiedEntitiesIntersectedByRays(TEmbodiedEntityIntersectionData& t_items,
+                                                           const std::vector<CRay3>& vec_rays,
+                                                           CEmbodiedEntity& c_entity);
+
    /****************************************/
    /****************************************/
 
@@ -231,6 +247,36 @@ namespace argos {
       virtual void CheckIntersectionWithRay(TEmbodiedEntityIntersectionData& t_data,
                                             const CRay3& c_ray) const = 0;
 
+      /**
+       * Check which object in this engine intersects the given ray closest to its start.
+       * The intersection found replaces <tt>s_item</tt> only if it is closer to the ray
+       * start, so that the same item can be passed to all the engines in turn.
+       * Unlike CheckIntersectionWithRay(), the engine can stop the search as soon as
+       * the remaining objects are farther than the closest intersection found.
+       * By default, this method calls CheckIntersectionWithRay() on a per-thread buffer.
+       * @param s_item The closest intersection found so far.
+       * @param c_ray The test ray.
+       * @param pc_excluded An entity to ignore, or <tt>nullptr</tt>.
+       */
+      virtual void CheckClosestIntersectionWithRay(SEmbodiedEntityIntersectionItem& s_item,
+                                                   const CRay3& c_ray,
+                                                   const CEmbodiedEntity* pc_excluded) const;
+
+      /**
+       * Check which objects in this engine intersect a batch of rays, keeping only
+       * the closest intersection of each ray.
+       * The intersection found for ray <tt>i</tt> replaces <tt>t_items[i]</tt> only
+       * if it is closer to the ray start, so that the same items can be passed
+       * to all the engines in turn.
+       * By default, this method calls CheckIntersectionWithRay() for each ray.
+       * @param t_items The closest intersection of each ray found so far, one item per ray.
+       * @param vec_rays The test rays.
+       * @param pc_excluded An entity to ignore, or <tt>nullptr</tt>.
+       */
+      virtual void CheckIntersectionWithRays(TEmbodiedEntityIntersectionData& t_items,
+                                             const std::vector<CRay3>& vec_rays,
+                                             const CEmbodiedEntity* pc_excluded) const;
+
       /**
        * Returns the simulation clock tick.
        * The clock tick is the time elapsed between two control steps
@@ -18,6 +18,7 @@
 #include <argos3/core/simulator/space/space_no_threads.h>
 #include <argos3/core/simulator/space/space_multi_thread_balance_quantity.h>
 #include <argos3/core/simulator/space/space_multi_thread_balance_length.h>
+#include <argos3/core/simulator/space/space_multi_thread_work_stealing.h>
 #include <argos3/core/simulator/visualization/default_visualization.h>
 #include <argos3/core/simulator/physics_engine/physics_engine.h>
 #include <argos3/core/simulator/loop_functions.h>
@@ -36,6 +37,7 @@ namespace argos {
       m_unMaxSimulationClock(0),
       m_bWasRandomSeedSet(false),
       m_unThreads(0),
+      m_bParallelInit(false),
       m_pcProfiler(nullptr),
       m_bHumanReadableProfile(true),
       m_bRealTimeClock(false),
@@ -264,6 +266,8 @@ namespace argos {
          m_pcProfiler->Stop();
          m_pcProfiler->Flush(m_bHumanReadableProfile);
       }
+      LOG.StopDrainThread();
+      LOGERR.StopDrainThread();
       LOG.Flush();
       LOGERR.Flush();
    }
@@ -306,9 +310,24 @@ namespace argos {
    void CSimulator::InitFramework(TConfigurationNode& t_tree) {
       try {
          /* Parse the 'system' node */
+         m_bParallelInit = false;
          if(NodeExists(t_tree, "system")) {
             TConfigurationNode tSystem;
             tSystem = GetNode(t_tree, "system");
+            /* Parse the log buffering */
+            size_t unLogBufferSize = 0;
+            GetNodeAttributeOrDefault(tSystem, "log_buffer_size", unLogBufferSize, unLogBufferSize);
+            if(unLogBufferSize > 0) {
+               LOG.SetBufferSize(unLogBufferSize);
+               LOGERR.SetBufferSize(unLogBufferSize);
+            }
+            std::string strLogOverflow = "block";
+            GetNodeAttributeOrDefault(tSystem, "log_overflow", strLogOverflow, strLogOverflow);
+            if(strLogOverflow != "block" && strLogOverflow != "drop") {
+               THROW_ARGOSEXCEPTION("Error parsing the <system> tag. Unknown log overflow policy \"" << strLogOverflow << "\". Available policies: \"block\" and \"drop\".");
+            }
+            LOG.SetDropOnOverflow(strLogOverflow == "drop");
+            LOGERR.SetDropOnOverflow(strLogOverflow == "drop");
             GetNodeAttributeOrDefault(tSystem, "threads", m_unThreads, m_unThreads);
             if(m_unThreads == 0) {
                LOG << "[INFO] Not using threads" << std::endl;
@@ -316,6 +335,10 @@ namespace argos {
             }
             else {
                LOG << "[INFO] Using " << m_unThreads << " parallel threads" << std::endl;
+               GetNodeAttributeOrDefault(tSystem, "parallel_init", m_bParallelInit, false);
+               if(m_bParallelInit) {
+                  LOG << "[INFO] The controllers will be initialized in parallel" << std::endl;
+               }
                std::string strThreadingMethod = "balance_quantity";
                GetNodeAttributeOrDefault(tSystem, "method", strThreadingMethod, strThreadingMethod);
                if(strThreadingMethod == "balance_quantity") {
@@ -330,10 +353,25 @@ namespace argos {
                       << std::endl
                       << "[INFO]   numbers of tasks, depending on the task length."
                       << std::endl;
-                  m_pcSpace = new CSpaceMultiThreadBalanceLength();
+                  std::string strChunking = "single";
+                  GetNodeAttributeOrDefault(tSystem, "chunking", strChunking, strChunking);
+                  if(strChunking == "guided") {
+                     LOG << "[INFO]   Tasks are claimed in guided chunks." << std::endl;
+                  }
+                  else if(strChunking != "single") {
+                     THROW_ARGOSEXCEPTION("Error parsing the <system> tag. Unknown chunking \"" << strChunking << "\". Available chunkings: \"single\" and \"guided\".");
+                  }
+                  m_pcSpace = new CSpaceMultiThreadBalanceLength(strChunking == "guided");
+               }
+               else if(strThreadingMethod == "work_stealing") {
+                  LOG << "[INFO]   Chosen method \"work_stealing\": threads will be assigned chunks of"
+                      << std::endl
+                      << "[INFO]   tasks, and idle threads will steal chunks from busy ones."
+                      << std::endl;
+                  m_pcSpace = new CSpaceMultiThreadWorkStealing();
                }
                else {
-                  THROW_ARGOSEXCEPTION("Error parsing the <system> tag. Unknown threading method \"" << strThreadingMethod << "\". Available methods: \"balance_quantity\" and \"balance_length\".");
+                  THROW_ARGOSEXCEPTION("Error parsing the <system> tag. Unknown threading method \"" << strThreadingMethod << "\". Available methods: \"balance_quantity\", \"balance_length\", and \"work_stealing\".");
                }
             }
          }
@@ -341,6 +379,9 @@ namespace argos {
             LOG << "[INFO] Not using threads" << std::endl;
             m_pcSpace = new CSpaceNoThreads();
          }
+         /* Write the logs from a separate thread, so that the ticks do not wait for the output */
+         LOG.StartDrainThread();
+         LOGERR.StartDrainThread();
          /* Get 'experiment' node */
          TConfigurationNode tExperiment;
          tExperiment = GetNode(t_tree, "experiment");
@@ -408,6 +449,13 @@ namespace argos {
             bool bTrunc = true;
             GetNodeAttributeOrDefault(tProfiling, "truncate_file", bTrunc, bTrunc);
             m_pcProfiler = new CProfiler(strFile, bTrunc);
+            /* Tick timers, to get a trace and a summary per phase, engine, medium and device */
+            std::string strTraceFile, strSummaryFile;
+            GetNodeAttributeOrDefault(tProfiling, "trace_file", strTraceFile, strTraceFile);
+            GetNodeAttributeOrDefault(tProfiling, "summary_file", strSummaryFile, strSummaryFile);
+            size_t unTraceBufferSize = 1 << 20;
+            GetNodeAttributeOrDefault(tProfiling, "trace_buffer_size", unTraceBufferSize, unTraceBufferSize);
+            m_pcProfiler->SetTickProfiling(strTraceFile, strSummaryFile, unTraceBufferSize);
          }
       }
       catch(CARGoSException& ex) {
@@ -261,6 +261,20 @@ namespace argos {
          return m_unThreads;
       }
 
+      /**
+       * Returns <tt>true</tt> if the controllers are initialized in parallel.
+       * The controllers are initialized in parallel when the <tt>system</tt> node
+       * has <tt>parallel_init="true"</tt> and the experiment uses threads.
+       * The RNGs created by a controller, its sensors and its actuators are seeded
+       * from the id of the robot, whatever the initialization, so the experiment is
+       * the same as with a serial initialization.
+       * @see CRandom::SetSeedKey()
+       * @return <tt>true</tt> if the controllers are initialized in parallel.
+       */
+      inline bool IsParallelInit() const {
+         return m_bParallelInit;
+      }
+
       /**
        * Returns <tt>true</tt> if the clock tick follows the real time.
        * By default, this flag is <tt>false</tt>.
@@ -471,6 +485,11 @@ namespace argos {
        */
       UInt32 m_unThreads;
 
+      /**
+       * <tt>true</tt> when the controllers are initialized in parallel.
+       */
+      bool m_bParallelInit;
+
       /**
        * Pointer to the profiler class (NULL when profiling is off).
        */
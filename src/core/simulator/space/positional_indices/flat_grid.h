@@ -0,0 +1,230 @@
+/**
+ * @file <argos3/core/simulator/space/positional_indices/flat_grid.h>
+ *
+ * @brief This file provides the definition of the flat grid positional index.
+ *
+ * The flat grid partitions the space in cells like CGrid, but it does not
+ * store a list per cell. Instead, the cell contents are rebuilt at every
+ * update in compressed sparse row (CSR) form: the entity update operation
+ * registers (cell, entity) pairs with UpdateCell(), the pairs are counted
+ * per cell, the counts are prefix-summed into cell offsets, and the entity
+ * pointers are scattered into a single contiguous array. The entities of a
+ * cell are then a contiguous slice of that array.
+ *
+ * Within a cell, the entities keep the order in which they were passed to
+ * UpdateCell(), i.e., the order of the index entities (by id).
+ *
+ * The update can also be split in stages that run in parallel: after
+ * BeginUpdate(), each stage runs an update operation on a slice of the
+ * entities with UpdateStage(), and the operation passes the stage to
+ * UpdateCell(). EndUpdate() merges the stages in order, so the result is
+ * the same as Update().
+ */
+
+#ifndef FLAT_GRID_H
+#define FLAT_GRID_H
+
+#include <argos3/core/utility/datatypes/set.h>
+#include <argos3/core/utility/math/range.h>
+#include <argos3/core/utility/math/ray3.h>
+#include <argos3/core/simulator/space/positional_indices/positional_index.h>
+#include <vector>
+
+namespace argos {
+
+   template<class ENTITY>
+   class CFlatGrid : public CPositionalIndex<ENTITY> {
+
+   public:
+
+      typedef typename CPositionalIndex<ENTITY>::COperation CEntityOperation;
+
+   public:
+
+      CFlatGrid(const CVector3& c_area_min_corner,
+                const CVector3& c_area_max_corner,
+                SInt32 n_size_i,
+                SInt32 n_size_j,
+                SInt32 n_size_k);
+
+      virtual ~CFlatGrid() {}
+
+      virtual void Init(TConfigurationNode& t_tree);
+      virtual void Reset();
+      virtual void Destroy();
+
+      virtual void AddEntity(ENTITY& c_entity);
+
+      virtual void RemoveEntity(ENTITY& c_entity);
+
+      virtual void Update();
+
+      virtual void GetEntitiesAt(CSet<ENTITY*,SEntityComparator>& c_entities,
+                                 const CVector3& c_position) const;
+
+      virtual void ForAllEntities(CEntityOperation& c_operation);
+
+      virtual void ForEntitiesInSphereRange(const CVector3& c_center,
+                                            Real f_radius,
+                                            CEntityOperation& c_operation);
+
+      virtual void ForEntitiesInBoxRange(const CVector3& c_center,
+                                         const CVector3& c_half_size,
+                                         CEntityOperation& c_operation);
+
+      virtual void ForEntitiesInCircleRange(const CVector3& c_center,
+                                            Real f_radius,
+                                            CEntityOperation& c_operation);
+
+      virtual void ForEntitiesInRectangleRange(const CVector3& c_center,
+                                               const CVector2& c_half_size,
+                                               CEntityOperation& c_operation);
+
+      virtual void ForEntitiesAlongRay(const CRay3& c_ray,
+                                       CEntityOperation& c_operation,
+                                       bool b_stop_at_closest_match = false);
+
+      inline SInt32 GetSizeI() const {
+         return m_nSizeI;
+      }
+
+      inline SInt32 GetSizeJ() const {
+         return m_nSizeJ;
+      }
+
+      inline SInt32 GetSizeK() const {
+         return m_nSizeK;
+      }
+
+      inline void SetUpdateEntityOperation(CEntityOperation* pc_operation) {
+         m_pcUpdateEntityOperation = pc_operation;
+      }
+
+      /**
+       * Starts an update split in stages.
+       * @param un_stages The number of stages.
+       * @see UpdateStage()
+       * @see EndUpdate()
+       */
+      void BeginUpdate(size_t un_stages);
+
+      /**
+       * Runs the update operation on the entities of a stage.
+       * Different stages can run at the same time, each with its own
+       * operation, which must pass the stage to UpdateCell().
+       * @param un_stage The stage.
+       * @param c_operation The update operation for the stage.
+       */
+      void UpdateStage(size_t un_stage,
+                       CEntityOperation& c_operation);
+
+      /**
+       * Completes an update split in stages, rebuilding the cells.
+       */
+      void EndUpdate();
+
+      /**
+       * Registers an entity in a cell.
+       * This method must be called only by the entity update operation.
+       * The entity becomes visible in the cell when Update() returns.
+       * @param un_stage The update stage the operation is running in.
+       * @throws CARGoSException if the cell is out of bounds.
+       */
+      void UpdateCell(SInt32 n_i,
+                      SInt32 n_j,
+                      SInt32 n_k,
+                      ENTITY& c_entity,
+                      size_t un_stage = 0);
+
+      /**
+       * Registers an entity in all the cells that overlap the given box.
+       * This method must be called only by the entity update operation.
+       * The cell range is clamped to the grid.
+       * @param un_stage The update stage the operation is running in.
+       */
+      void UpdateCellsInBoxRange(const CVector3& c_center,
+                                 const CVector3& c_half_size,
+                                 ENTITY& c_entity,
+                                 size_t un_stage = 0);
+
+      /**
+       * Returns the entities in a cell.
+       * The returned pointer is valid until the next call to Update().
+       * @param ppc_entities Set to the first entity of the cell.
+       * @return The number of entities in the cell.
+       */
+      inline size_t GetCellEntities(SInt32 n_i,
+                                    SInt32 n_j,
+                                    SInt32 n_k,
+                                    ENTITY* const*& ppc_entities) const {
+         size_t unCell = CellIndex(n_i, n_j, n_k);
+         ppc_entities = m_vecCellEntities.data() + m_vecCellStart[unCell];
+         return m_vecCellStart[unCell + 1] - m_vecCellStart[unCell];
+      }
+
+      inline void PositionToCell(SInt32& n_i,
+                                 SInt32& n_j,
+                                 SInt32& n_k,
+                                 const CVector3& c_position) const;
+
+      inline void PositionToCellUnsafe(SInt32& n_i,
+                                       SInt32& n_j,
+                                       SInt32& n_k,
+                                       const CVector3& c_position) const;
+
+      inline void ClampCoordinates(SInt32& n_i,
+                                   SInt32& n_j,
+                                   SInt32& n_k) const;
+
+   protected:
+
+      inline size_t CellIndex(SInt32 n_i,
+                              SInt32 n_j,
+                              SInt32 n_k) const {
+         return m_nSizeI * m_nSizeJ * n_k +
+                m_nSizeI * n_j +
+                n_i;
+      }
+
+      /**
+       * Applies the operation to the entities in a cell.
+       * @return <tt>false</tt> if the operation asked to stop.
+       */
+      inline bool ApplyToCell(SInt32 n_i,
+                              SInt32 n_j,
+                              SInt32 n_k,
+                              CEntityOperation& c_operation);
+
+   protected:
+
+      CVector3 m_cAreaMinCorner;
+      CVector3 m_cAreaMaxCorner;
+      SInt32 m_nSizeI;
+      SInt32 m_nSizeJ;
+      SInt32 m_nSizeK;
+      CRange<Real> m_cRangeX;
+      CRange<Real> m_cRangeY;
+      CRange<Real> m_cRangeZ;
+      CVector3 m_cCellSize;
+      CVector3 m_cInvCellSize;
+      /** Offset of the first entity of each cell, plus the total at the end */
+      std::vector<UInt32> m_vecCellStart;
+      /** The entities of all the cells, grouped by cell */
+      std::vector<ENTITY*> m_vecCellEntities;
+      /** The (cell, entity) pairs registered by UpdateCell() in an update stage */
+      struct SStage {
+         std::vector<UInt32> Cells;
+         std::vector<ENTITY*> Entities;
+      };
+      /** The stages of the current update */
+      std::vector<SStage> m_vecStages;
+      CSet<ENTITY*,SEntityComparator> m_cEntities;
+      CEntityOperation* m_pcUpdateEntityOperation;
+
+   };
+
+}
+
+#include <argos3/core/simulator/space/positional_indices/flat_grid_impl.h>
+
+#endif
@@ -0,0 +1,462 @@
+namespace argos {
+
+   /****************************************/
+   /****************************************/
+
+   template<class ENTITY>
+   CFlatGrid<ENTITY>::CFlatGrid(const CVector3& c_area_min_corner,
+                                const CVector3& c_area_max_corner,
+                                SInt32 n_size_i,
+                                SInt32 n_size_j,
+                                SInt32 n_size_k) :
+      m_cAreaMinCorner(c_area_min_corner),
+      m_cAreaMaxCorner(c_area_max_corner),
+      m_nSizeI(n_size_i),
+      m_nSizeJ(n_size_j),
+      m_nSizeK(n_size_k),
+      m_cRangeX(m_cAreaMinCorner.GetX(), m_cAreaMaxCorner.GetX()),
+      m_cRangeY(m_cAreaMinCorner.GetY(), m_cAreaMaxCorner.GetY()),
+      m_cRangeZ(m_cAreaMinCorner.GetZ(), m_cAreaMaxCorner.GetZ()),
+      m_vecStages(1),
+      m_pcUpdateEntityOperation(nullptr) {
+      m_cCellSize.Set(m_cRangeX.GetSpan() / m_nSizeI,
+                      m_cRangeY.GetSpan() / m_nSizeJ,
+                      m_cRangeZ.GetSpan() / m_nSizeK);
+      m_cInvCellSize.Set(1.0f / m_cCellSize.GetX(),
+                         1.0f / m_cCellSize.GetY(),
+                         1.0f / m_cCellSize.GetZ());
+      m_vecCellStart.resize(m_nSizeI * m_nSizeJ * m_nSizeK + 1, 0);
+   }
+
+   /****************************************/
+   /****************************************/
+
+   template<class ENTITY>
+   void CFlatGrid<ENTITY>::Init(TConfigurationNode& t_tree) {
+   }
+
+   /****************************************/
+   /****************************************/
+
+   template<class ENTITY>
+   void CFlatGrid<ENTITY>::Reset() {
+      std::fill(m_vecCellStart.begin(), m_vecCellStart.end(), 0);
+      m_vecCellEntities.clear();
+      Update();
+   }
+
+   /****************************************/
+   /****************************************/
+
+   template<class ENTITY>
+   void CFlatGrid<ENTITY>::Destroy() {
+   }
+
+   /****************************************/
+   /****************************************/
+
+   template<class ENTITY>
+   void CFlatGrid<ENTITY>::AddEntity(ENTITY& c_entity) {
+      m_cEntities.insert(&c_entity);
+   }
+
+   /****************************************/
+   /****************************************/
+
+   template<class ENTITY>
+   void CFlatGrid<ENTITY>::RemoveEntity(ENTITY& c_entity) {
+      m_cEntities.erase(&c_entity);
+   }
+
+   /****************************************/
+   /****************************************/
+
+   template<class ENTITY>
+   void CFlatGrid<ENTITY>::Update() {
+      /* Collect the (cell, entity) pairs */
+      BeginUpdate(1);
+      ForAllEntities(*m_pcUpdateEntityOperation);
+      EndUpdate();
+   }
+
+   /****************************************/
+   /****************************************/
+
+   template<class ENTITY>
+   void CFlatGrid<ENTITY>::BeginUpdate(size_t un_stages) {
+      m_vecStages.resize(Max<size_t>(1, un_stages));
+      for(size_t s = 0; s < m_vecStages.size(); ++s) {
+         m_vecStages[s].Cells.clear();
+         m_vecStages[s].Entities.clear();
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   template<class ENTITY>
+   void CFlatGrid<ENTITY>::UpdateStage(size_t un_stage,
+                                       CEntityOperation& c_operation) {
+      /* The entities of this stage are a contiguous slice of the entities */
+      size_t unNumEntities = m_cEntities.size();
+      size_t unStart = unNumEntities *  un_stage      / m_vecStages.size();
+      size_t unEnd   = unNumEntities * (un_stage + 1) / m_vecStages.size();
+      if(unStart == unEnd) return;
+      ENTITY** ppcEntities = &*m_cEntities.begin();
+      for(size_t i = unStart; i < unEnd && c_operation(*ppcEntities[i]); ++i);
+   }
+
+   /****************************************/
+   /****************************************/
+
+   template<class ENTITY>
+   void CFlatGrid<ENTITY>::EndUpdate() {
+      /* Count the entities per cell */
+      std::fill(m_vecCellStart.begin(), m_vecCellStart.end(), 0);
+      size_t unNumStaged = 0;
+      for(size_t s = 0; s < m_vecStages.size(); ++s) {
+         const std::vector<UInt32>& vecCells = m_vecStages[s].Cells;
+         for(size_t i = 0; i < vecCells.size(); ++i) {
+            ++m_vecCellStart[vecCells[i]];
+         }
+         unNumStaged += vecCells.size();
+      }
+      /* Prefix sum: each entry now marks the end of its cell */
+      for(size_t i = 1; i < m_vecCellStart.size(); ++i) {
+         m_vecCellStart[i] += m_vecCellStart[i-1];
+      }
+      /* Scatter backwards, moving each entry back to the start of its
+         cell. Going backwards through the stages and through each stage
+         keeps the registration order in each cell. */
+      m_vecCellEntities.resize(unNumStaged);
+      for(size_t s = m_vecStages.size(); s > 0; --s) {
+         const std::vector<UInt32>& vecCells = m_vecStages[s-1].Cells;
+         const std::vector<ENTITY*>& vecEntities = m_vecStages[s-1].Entities;
+         for(size_t i = vecCells.size(); i > 0; --i) {
+            m_vecCellEntities[--m_vecCellStart[vecCells[i-1]]] = vecEntities[i-1];
+         }
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   template<class ENTITY>
+   void CFlatGrid<ENTITY>::GetEntitiesAt(CSet<ENTITY*,SEntityComparator>& c_entities,
+                                         const CVector3& c_position) const {
+      try {
+         SInt32 i, j, k;
+         PositionToCell(i, j, k, c_position);
+         ENTITY* const* ppcEntities;
+         size_t unNum = GetCellEntities(i, j, k, ppcEntities);
+         c_entities.clear();
+         for(size_t n = 0; n < unNum; ++n) {
+            c_entities.insert(ppcEntities[n]);
+         }
+      }
+      catch(CARGoSException& ex) {
+         THROW_ARGOSEXCEPTION_NESTED("CFlatGrid<ENTITY>::GetEntitiesAt() : Position <" << c_position << "> out of bounds X -> " << m_cRangeX << " Y -> " << m_cRangeY << " Z -> " << m_cRangeZ, ex);
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   template<class ENTITY>
+   void CFlatGrid<ENTITY>::ForAllEntities(CEntityOperation& c_operation) {
+      for(typename CSet<ENTITY*,SEntityComparator>::iterator it = m_cEntities.begin();
+          it != m_cEntities.end() && c_operation(**it);
+          ++it);
+   }
+
+   /****************************************/
+   /****************************************/
+
+   template<class ENTITY>
+   void CFlatGrid<ENTITY>::ForEntitiesInSphereRange(const CVector3& c_center,
+                                                    Real f_radius,
+                                                    CEntityOperation& c_operation) {
+      /* Calculate cell for center */
+      SInt32 nIC, nJC, nKC;
+      PositionToCellUnsafe(nIC, nJC, nKC, c_center);
+      /* Go through the circles that make up the sphere, one per k */
+      SInt32 nKR = Floor(f_radius * m_cInvCellSize.GetZ() + 0.5f);
+      for(SInt32 k = -nKR; k <= nKR; ++k) {
+         if(nKC + k < 0 || nKC + k >= m_nSizeK) continue;
+         /* Calculate radius of circle at k */
+         Real fCircleRadius2 = Max<Real>(0.0f, f_radius * f_radius - k * m_cCellSize.GetZ() * k * m_cCellSize.GetZ());
+         SInt32 nJR = Floor(Sqrt(fCircleRadius2) * m_cInvCellSize.GetY() + 0.5f);
+         for(SInt32 j = -nJR; j <= nJR; ++j) {
+            if(nJC + j < 0 || nJC + j >= m_nSizeJ) continue;
+            /* Calculate radius of circle at j,k */
+            SInt32 nIR = Floor(Sqrt(Max<Real>(0.0f, fCircleRadius2 - j * m_cCellSize.GetY() * j * m_cCellSize.GetY())) * m_cInvCellSize.GetX() + 0.5f);
+            for(SInt32 i = Max<SInt32>(0, nIC - nIR); i <= Min<SInt32>(m_nSizeI - 1, nIC + nIR); ++i) {
+               if(!ApplyToCell(i, nJC + j, nKC + k, c_operation)) return;
+            }
+         }
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   template<class ENTITY>
+   void CFlatGrid<ENTITY>::ForEntitiesInBoxRange(const CVector3& c_center,
+                                                 const CVector3& c_half_size,
+                                                 CEntityOperation& c_operation) {
+      /* Calculate cell range */
+      SInt32 nI1, nJ1, nK1, nI2, nJ2, nK2;
+      PositionToCellUnsafe(nI1, nJ1, nK1, c_center - c_half_size);
+      ClampCoordinates(nI1, nJ1, nK1);
+      PositionToCellUnsafe(nI2, nJ2, nK2, c_center + c_half_size);
+      ClampCoordinates(nI2, nJ2, nK2);
+      /* Go through cells */
+      for(SInt32 k = nK1; k <= nK2; ++k) {
+         for(SInt32 j = nJ1; j <= nJ2; ++j) {
+            for(SInt32 i = nI1; i <= nI2; ++i) {
+               if(!ApplyToCell(i, j, k, c_operation)) return;
+            }
+         }
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   template<class ENTITY>
+   void CFlatGrid<ENTITY>::ForEntitiesInCircleRange(const CVector3& c_center,
+                                                    Real f_radius,
+                                                    CEntityOperation& c_operation) {
+      /* Make sure the Z coordinate is inside the range */
+      if(! m_cRangeZ.WithinMinBoundIncludedMaxBoundIncluded(c_center.GetZ())) return;
+      /* Calculate cell for center */
+      SInt32 nIC, nJC, nK;
+      PositionToCellUnsafe(nIC, nJC, nK, c_center);
+      if(nK >= m_nSizeK) nK = m_nSizeK - 1;
+      /* Go through the circle, one column per i */
+      SInt32 nIR = Floor(f_radius * m_cInvCellSize.GetX() + 0.5f);
+      for(SInt32 i = -nIR; i <= nIR; ++i) {
+         if(nIC + i < 0 || nIC + i >= m_nSizeI) continue;
+         SInt32 nJR = Floor(Sqrt(Max<Real>(0.0f, f_radius * f_radius - i * m_cCellSize.GetX() * i * m_cCellSize.GetX())) * m_cInvCellSize.GetY() + 0.5f);
+         for(SInt32 j = Max<SInt32>(0, nJC - nJR); j <= Min<SInt32>(m_nSizeJ - 1, nJC + nJR); ++j) {
+            if(!ApplyToCell(nIC + i, j, nK, c_operation)) return;
+         }
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   template<class ENTITY>
+   void CFlatGrid<ENTITY>::ForEntitiesInRectangleRange(const CVector3& c_center,
+                                                       const CVector2& c_half_size,
+                                                       CEntityOperation& c_operation) {
+      /* Calculate cell range */
+      SInt32 nI1 = Min<SInt32>(m_nSizeI-1, Max<SInt32>(0, Floor((c_center.GetX() - c_half_size.GetX() - m_cAreaMinCorner.GetX()) * m_cInvCellSize.GetX())));
+      SInt32 nJ1 = Min<SInt32>(m_nSizeJ-1, Max<SInt32>(0, Floor((c_center.GetY() - c_half_size.GetY() - m_cAreaMinCorner.GetY()) * m_cInvCellSize.GetY())));
+      SInt32 nI2 = Min<SInt32>(m_nSizeI-1, Max<SInt32>(0, Floor((c_center.GetX() + c_half_size.GetX() - m_cAreaMinCorner.GetX()) * m_cInvCellSize.GetX())));
+      SInt32 nJ2 = Min<SInt32>(m_nSizeJ-1, Max<SInt32>(0, Floor((c_center.GetY() + c_half_size.GetY() - m_cAreaMinCorner.GetY()) * m_cInvCellSize.GetY())));
+      SInt32 nK  = Min<SInt32>(m_nSizeK-1, Max<SInt32>(0, Floor((c_center.GetZ()                      - m_cAreaMinCorner.GetZ()) * m_cInvCellSize.GetZ())));
+      /* Go through cells */
+      for(SInt32 j = nJ1; j <= nJ2; ++j) {
+         for(SInt32 i = nI1; i <= nI2; ++i) {
+            if(!ApplyToCell(i, j, nK, c_operation)) return;
+         }
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   template<class ENTITY>
+   void CFlatGrid<ENTITY>::ForEntitiesAlongRay(const CRay3& c_ray,
+                                               CEntityOperation& c_operation,
+                                               bool b_stop_at_closest_match) {
+      /* Transform ray start and end position into cell coordinates */
+      SInt32 nStart[3], nEnd[3];
+      PositionToCellUnsafe(nStart[0], nStart[1], nStart[2], c_ray.GetStart());
+      ClampCoordinates(nStart[0], nStart[1], nStart[2]);
+      PositionToCellUnsafe(nEnd[0], nEnd[1], nEnd[2], c_ray.GetEnd());
+      ClampCoordinates(nEnd[0], nEnd[1], nEnd[2]);
+      /* Calculate deltas and increments for each axis */
+      SInt32 nD[3], nS[3];
+      for(UInt32 a = 0; a < 3; ++a) {
+         nD[a] = Abs(nEnd[a] - nStart[a]);
+         nS[a] = nEnd[a] >= nStart[a] ? 1 : -1;
+      }
+      /* Pick the driving axis (the longest) and the other two, in the same
+         order as CGrid, so that both indices visit the same cells */
+      UInt32 unD, unA, unB;
+      if(nD[0] >= nD[1] && nD[0] >= nD[2])      { unD = 0; unA = 1; unB = 2; }
+      else if(nD[1] >= nD[0] && nD[1] >= nD[2]) { unD = 1; unA = 0; unB = 2; }
+      else                                      { unD = 2; unA = 0; unB = 1; }
+      /* 3D Bresenham: go through cells one by one, from start to end */
+      SInt32 nC[3] = { nStart[0], nStart[1], nStart[2] };
+      SInt32 nEA(3 * nD[unA] - nD[unD]);
+      SInt32 nEB(3 * nD[unB] - nD[unD]);
+#define FLAT_GRID_VISIT_CELL_ALONG_RAY                                  \
+      {                                                                 \
+         size_t unCell = CellIndex(nC[0], nC[1], nC[2]);                \
+         if(m_vecCellStart[unCell] < m_vecCellStart[unCell+1]) {        \
+            if(!ApplyToCell(nC[0], nC[1], nC[2], c_operation)) return;  \
+            if(b_stop_at_closest_match) return;                         \
+         }                                                              \
+      }
+      FLAT_GRID_VISIT_CELL_ALONG_RAY;
+      for(SInt32 nCell = nD[unD]; nCell > 0; --nCell) {
+         /* Advance on driving axis */
+         nC[unD] += nS[unD];
+         FLAT_GRID_VISIT_CELL_ALONG_RAY;
+         /* Advance on other axes, if necessary */
+         if(nEA > 0 && nEB > 0) {
+            if(nEA * nD[unB] > nEB * nD[unA]) {
+               nC[unA] += nS[unA];
+               FLAT_GRID_VISIT_CELL_ALONG_RAY;
+               nC[unB] += nS[unB];
+               FLAT_GRID_VISIT_CELL_ALONG_RAY;
+            }
+            else {
+               nC[unB] += nS[unB];
+               FLAT_GRID_VISIT_CELL_ALONG_RAY;
+               nC[unA] += nS[unA];
+               FLAT_GRID_VISIT_CELL_ALONG_RAY;
+            }
+            nEA += 2 * (nD[unA] - nD[unD]);
+            nEB += 2 * (nD[unB] - nD[unD]);
+         }
+         else if(nEA > 0) {
+            nC[unA] += nS[unA];
+            FLAT_GRID_VISIT_CELL_ALONG_RAY;
+            nEA += 2 * (nD[unA] - nD[unD]);
+            nEB += 2 * nD[unB];
+         }
+         else {
+            nEA += 2 * nD[unA];
+            if(nEB > 0) {
+               nC[unB] += nS[unB];
+               FLAT_GRID_VISIT_CELL_ALONG_RAY;
+               nEB += 2 * (nD[unB] - nD[unD]);
+            }
+            else {
+               nEB += 2 * nD[unB];
+            }
+         }
+      }
+#undef FLAT_GRID_VISIT_CELL_ALONG_RAY
+   }
+
+   /****************************************/
+   /****************************************/
+
+   template<class ENTITY>
+   void CFlatGrid<ENTITY>::UpdateCell(SInt32 n_i,
+                                      SInt32 n_j,
+                                      SInt32 n_k,
+                                      ENTITY& c_entity,
+                                      size_t un_stage) {
+      if((n_i >= 0) && (n_i < m_nSizeI) &&
+         (n_j >= 0) && (n_j < m_nSizeJ) &&
+         (n_k >= 0) && (n_k < m_nSizeK)) {
+         m_vecStages[un_stage].Cells.push_back(CellIndex(n_i, n_j, n_k));
+         m_vecStages[un_stage].Entities.push_back(&c_entity);
+      }
+      else {
+         THROW_ARGOSEXCEPTION("CFlatGrid<ENTITY>::UpdateCell() : index (" << n_i << "," << n_j << "," << n_k << ") out of bounds (" << m_nSizeI-1 << "," << m_nSizeJ-1 << "," << m_nSizeK-1 << ")");
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   template<class ENTITY>
+   void CFlatGrid<ENTITY>::UpdateCellsInBoxRange(const CVector3& c_center,
+                                                 const CVector3& c_half_size,
+                                                 ENTITY& c_entity,
+                                                 size_t un_stage) {
+      /* Calculate cell range */
+      SInt32 nI1, nJ1, nK1, nI2, nJ2, nK2;
+      PositionToCellUnsafe(nI1, nJ1, nK1, c_center - c_half_size);
+      ClampCoordinates(nI1, nJ1, nK1);
+      PositionToCellUnsafe(nI2, nJ2, nK2, c_center + c_half_size);
+      ClampCoordinates(nI2, nJ2, nK2);
+      /* Register the entity in each cell */
+      SStage& sStage = m_vecStages[un_stage];
+      for(SInt32 k = nK1; k <= nK2; ++k) {
+         for(SInt32 j = nJ1; j <= nJ2; ++j) {
+            for(SInt32 i = nI1; i <= nI2; ++i) {
+               sStage.Cells.push_back(CellIndex(i, j, k));
+               sStage.Entities.push_back(&c_entity);
+            }
+         }
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   template<class ENTITY>
+   void CFlatGrid<ENTITY>::PositionToCell(SInt32& n_i,
+                                          SInt32& n_j,
+                                          SInt32& n_k,
+                                          const CVector3& c_position) const {
+      if(m_cRangeX.WithinMinBoundIncludedMaxBoundIncluded(c_position.GetX()) &&
+         m_cRangeY.WithinMinBoundIncludedMaxBoundIncluded(c_position.GetY()) &&
+         m_cRangeZ.WithinMinBoundIncludedMaxBoundIncluded(c_position.GetZ())) {
+         n_i = Floor((c_position.GetX() - m_cAreaMinCorner.GetX()) * m_cInvCellSize.GetX());
+         n_j = Floor((c_position.GetY() - m_cAreaMinCorner.GetY()) * m_cInvCellSize.GetY());
+         n_k = Floor((c_position.GetZ() - m_cAreaMinCorner.GetZ()) * m_cInvCellSize.GetZ());
+         /* A position on the max bound belongs to the last cell */
+         ClampCoordinates(n_i, n_j, n_k);
+      }
+      else {
+         THROW_ARGOSEXCEPTION("CFlatGrid<ENTITY>::PositionToCell() : Position <" << c_position << "> out of bounds X -> " << m_cRangeX << " Y -> " << m_cRangeY << " Z -> " << m_cRangeZ);
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   template<class ENTITY>
+   void CFlatGrid<ENTITY>::PositionToCellUnsafe(SInt32& n_i,
+                                                SInt32& n_j,
+                                                SInt32& n_k,
+                                                const CVector3& c_position) const {
+      n_i = Floor((c_position.GetX() - m_cAreaMinCorner.GetX()) * m_cInvCellSize.GetX());
+      n_j = Floor((c_position.GetY() - m_cAreaMinCorner.GetY()) * m_cInvCellSize.GetY());
+      n_k = Floor((c_position.GetZ() - m_cAreaMinCorner.GetZ()) * m_cInvCellSize.GetZ());
+   }
+
+   /****************************************/
+   /****************************************/
+
+   template<class ENTITY>
+   void CFlatGrid<ENTITY>::ClampCoordinates(SInt32& n_i,
+                                            SInt32& n_j,
+                                            SInt32& n_k) const {
+      if(n_i < 0) n_i = 0;
+      else if(n_i >= m_nSizeI) n_i = m_nSizeI - 1;
+      if(n_j < 0) n_j = 0;
+      else if(n_j >= m_nSizeJ) n_j = m_nSizeJ - 1;
+      if(n_k < 0) n_k = 0;
+      else if(n_k >= m_nSizeK) n_k = m_nSizeK - 1;
+   }
+
+   /****************************************/
+   /****************************************/
+
+   template<class ENTITY>
+   bool CFlatGrid<ENTITY>::ApplyToCell(SInt32 n_i,
+                                       SInt32 n_j,
+                                       SInt32 n_k,
+                                       CEntityOperation& c_operation) {
+      size_t unCell = CellIndex(n_i, n_j, n_k);
+      for(UInt32 n = m_vecCellStart[unCell]; n < m_vecCellStart[unCell + 1]; ++n) {
+         if(!c_operation(*m_vecCellEntities[n])) return false;
+      }
+      return true;
+   }
+
+   /****************************************/
+   /****************************************/
+
+}
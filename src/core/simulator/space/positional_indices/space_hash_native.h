@@ -7,13 +7,25 @@
 #ifndef SPACE_HASH_NATIVE_H
 #define SPACE_HASH_NATIVE_H
 
-#include <argos3/core/simulator/space/space_hash.h>
+#include <argos3/core/simulator/space/positional_indices/space_hash.h>
+#include <vector>
 
 namespace argos {
 
    /**
     * A space hash implementation that does not rely on std::map or std::tr1:unordered_map.
     * It is much more performant than the standard hash table implementations.
+    * <p>
+    * The hash is a flat, open-addressed array of slots. Each slot holds an
+    * element and the coordinates of the cell it was stored into. Collisions
+    * are resolved with linear probing, so all the slots of a bucket are
+    * contiguous in memory. A slot is in use only if its timestamp matches the
+    * current one: emptying the hash is done by incrementing the timestamp, and
+    * no memory is allocated or freed during an update.
+    * </p>
+    * <p>
+    * The hash grows automatically when it becomes half full.
+    * </p>
     */
    template <class Element, class Updater>
    class CSpaceHashNative : public CSpaceHash<Element,Updater> {
@@ -21,137 +33,31 @@ namespace argos {
    private:
 
       /**
-       * A bucket of the native space hash.
+       * A slot of the native space hash.
        */
-      struct SBucket {
-
+      struct SSlot {
          /**
-          * An item of data held by each bucket.
-          * These data items are organized into a simple linked list.
+          * The step of the storage operation in this slot.
+          * The slot is in use only if this matches the current timestamp.
           */
-         struct SBucketData {
-            /**
-             * The element indexed by this data item.
-             */
-            Element* Elem;
-            /**
-             * The space hash cell coordinate corresponding to this data item.
-             */
-            SInt32 I,J,K;
-            /**
-             * Pointer to the next data item in the list, or NULL if this is the last
-             */
-            SBucketData* Next;
-
-            /**
-             * Struct constructor.
-             * @param c_element The element to reference.
-             * @param n_i The X coordinate of the space hash cell.
-             * @param n_j The Y coordinate of the space hash cell.
-             * @param n_k The Z coordinate of the space hash cell.
-             */
-            SBucketData(Element& c_element,
-                        SInt32 n_i,
-                        SInt32 n_j,
-                        SInt32 n_k,
-                        SBucketData* ps_next = NULL) :
-               Elem(&c_element),
-               I(n_i),
-               J(n_j),
-               K(n_k),
-               Next(ps_next) {}
-
-         };
-
+         UInt64 StoreTimestamp;
          /**
-          * The step of the last storage operation in this bucket.
+          * The element indexed by this slot.
           */
-         UInt64 StoreTimestamp;
-
+         Element* Elem;
          /**
-          * The list of data items held in this bucket.
+          * The space hash cell coordinate corresponding to this slot.
           */
-         SBucketData* ElementList;
+         SInt32 I,J,K;
 
          /**
           * Struct constructor.
-          * The bucket is created empty.
+          * The slot is created unused.
           */
-         SBucket() :
+         SSlot() :
             StoreTimestamp(0),
-            ElementList(NULL) {}
-
-         /**
-          * Struct destructor.
-          * It clears all the data items.
-          * @see SBucketData
-          */
-         ~SBucket() {
-            Clear();
-         }
-
-         /**
-          * Returns <tt>true</tt> if the bucket is empty.
-          * @return <tt>true</tt> if the bucket is empty.
-          */
-         inline bool Empty() const {
-            return (ElementList == NULL);
-         }
-
-         /**
-          * Deletes all the data items of this bucket.
-          * @see SBucketData
-          */
-         inline void Clear() {
-            if(!Empty()) {
-               SBucketData* psCur = ElementList;
-               SBucketData* psNext = psCur->Next;
-               do {
-                  delete psCur;
-                  psCur = psNext;
-                  if(psCur) psNext = psCur->Next;
-               } while(psCur);
-               ElementList = NULL;
-            }
-         }
-
-         /**
-          * Adds an element to this bucket.
-          * @param c_element The element to add.
-          * @param n_i The X coordinate of the space hash cell.
-          * @param n_j The Y coordinate of the space hash cell.
-          * @param n_k The Z coordinate of the space hash cell.
-          */
-         inline void Add(Element& c_element,
-                         SInt32 n_i,
-                         SInt32 n_j,
-                         SInt32 n_k) {
-            if(Empty()) ElementList = new SBucketData(c_element, n_i, n_j, n_k);
-            else ElementList = new SBucketData(c_element, n_i, n_j, n_k, ElementList);
-         }
-
-         /**
-          * Returns <tt>true</tt> if a certain data item is already in the bucket.
-          * @param c_element The element to search for.
-          * @param n_i The corresponding X coordinate of the space hash cell.
-          * @param n_j The corresponding Y coordinate of the space hash cell.
-          * @param n_k The corresponding Z coordinate of the space hash cell.
-          */
-         bool Exists(const Element& c_element,
-                     SInt32 n_i,
-                     SInt32 n_j,
-                     SInt32 n_k) {
-            SBucketData* psCur = ElementList;
-            while(psCur) {
-               if(psCur->Elem == &c_element &&
-                  psCur->I == n_i &&
-                  psCur->J == n_j &&
-                  psCur->K == n_k) return true;
-               psCur = psCur->Next;
-            }
-            return false;
-         }
-
+            Elem(NULL),
+            I(0), J(0), K(0) {}
       };
 
    public:
@@ -164,35 +70,48 @@ namespace argos {
        * @see SetSize()
        */
       CSpaceHashNative() :
-         m_psBuckets(NULL),
-         m_unCurrentStoreTimestamp(0) {}
+         m_unCurrentStoreTimestamp(1),
+         m_unOccupiedSlots(0) {}
 
       /**
        * Class destructor.
        */
-      ~CSpaceHashNative() {
-         Clear();
-         delete[] m_psBuckets;
-      }
+      ~CSpaceHashNative() {}
 
       /**
        * Empties all the buckets in the space hash.
+       * This is done in constant time, by incrementing the timestamp.
        */
       inline void Clear() {
-         for(size_t i = 0; i < CSpaceHash<Element,Updater>::GetSize(); ++i) {
-            m_psBuckets[i].Clear();
-         }
+         ++m_unCurrentStoreTimestamp;
+         m_unOccupiedSlots = 0;
       }
 
       /**
        * Sets the size of the space hash.
-       * The size corresponds to the number of buckets.
+       * The size corresponds to the number of slots. The current content of
+       * the space hash is rehashed into the new slots. The size is increased,
+       * if necessary, to keep the hash at most half full.
        * @param un_size The size of the space hash.
        */
       inline virtual void SetSize(size_t un_size) {
+         /* Save the slots in use */
+         std::vector<SSlot> vecOld;
+         vecOld.swap(m_vecSlots);
+         /* Make sure the slots in use fit, with the load factor below 1/2 */
+         if(un_size < 2 * (m_unOccupiedSlots + 1)) {
+            un_size = 2 * (m_unOccupiedSlots + 1);
+         }
+         /* Make the new slots */
          CSpaceHash<Element,Updater>::SetSize(un_size);
-         m_psBuckets = new SBucket[CSpaceHash<Element,Updater>::GetSize()];
-         /** @todo rehash */
+         m_vecSlots.resize(un_size);
+         m_unOccupiedSlots = 0;
+         /* Rehash */
+         for(size_t i = 0; i < vecOld.size(); ++i) {
+            if(vecOld[i].StoreTimestamp == m_unCurrentStoreTimestamp) {
+               Store(*vecOld[i].Elem, vecOld[i].I, vecOld[i].J, vecOld[i].K);
+            }
+         }
       }
 
       /**
@@ -202,7 +121,7 @@ namespace argos {
        */
       inline virtual void Update() {
          /* Set the current store time stamp */
-         m_unCurrentStoreTimestamp++;
+         Clear();
          /* Call base class method */
          CSpaceHash<Element,Updater>::Update();
       }
@@ -218,25 +137,11 @@ namespace argos {
                                      SInt32 n_j,
                                      SInt32 n_k,
                                      Element& c_element) {
-         /* Calculate the hash of the current position */
-         SInt32 nHash = CSpaceHash<Element,Updater>::CoordinateHash(n_i, n_j, n_k);
-         /* Get a reference to the bucket */
-         SBucket& sBucket = m_psBuckets[nHash];
-         /* Check if the bucket's content is obsolete */
-         if(sBucket.StoreTimestamp == m_unCurrentStoreTimestamp) {
-            /* Add the current element to the bucket */
-            if(! sBucket.Exists(c_element, n_i, n_j, n_k)) {
-               sBucket.Add(c_element, n_i, n_j, n_k);
-            }
-         }
-         else {
-            /* The bucket's content is obsolete, erase it */
-            sBucket.Clear();
-            /* Set the store timestamp to the current time */
-            sBucket.StoreTimestamp = m_unCurrentStoreTimestamp;
-            /* Add the current element to the bucket */
-            sBucket.Add(c_element, n_i, n_j, n_k);
+         /* Keep the load factor below 1/2 */
+         if(2 * (m_unOccupiedSlots + 1) > m_vecSlots.size()) {
+            SetSize(m_vecSlots.empty() ? 64 : 2 * m_vecSlots.size());
          }
+         Store(c_element, n_i, n_j, n_k);
       }
 
       /**
@@ -249,75 +154,101 @@ namespace argos {
       virtual bool CheckCell(SInt32 n_i,
                              SInt32 n_j,
                              SInt32 n_k,
-                             typename CSpaceHash<Element,Updater>::TElementList& t_elements) {
+                             typename CAbstractSpaceHash<Element>::TEntityList& t_elements) {
          /* In the beginning, no new elements have been found */
          bool bNewElements = false;
-         /* Calculate the hash of the current position */
-         SInt32 nHash = CSpaceHash<Element,Updater>::CoordinateHash(n_i, n_j, n_k);
-         /* Get a reference to the bucket */
-         SBucket& sBucket = m_psBuckets[nHash];
-         /* Visit the bucket IF:
-            1. its data is up-to-date AND
-            2. it is not empty
-          */
-         if((sBucket.StoreTimestamp == m_unCurrentStoreTimestamp) && /* 1. */
-            !sBucket.Empty()) /* 2. */ {
-            /* Check the bucket's elements */
-            for(typename SBucket::SBucketData* psCur = sBucket.ElementList;
-                psCur;
-                psCur = psCur->Next) {
-               /* Check that the element is in the wanted cell */
-               if(n_i == psCur->I &&
-                  n_j == psCur->J &&
-                  n_k == psCur->K) {
-                  /* We have a new element to add to the list */
-                  bNewElements = true;
-                  t_elements.insert(psCur->Elem);
-               }
+         if(m_vecSlots.empty()) return false;
+         /* Go through the slots of the bucket, until an unused slot is found */
+         for(size_t unSlot = CSpaceHash<Element,Updater>::CoordinateHash(n_i, n_j, n_k);
+             m_vecSlots[unSlot].StoreTimestamp == m_unCurrentStoreTimestamp;
+             unSlot = NextSlot(unSlot)) {
+            const SSlot& sSlot = m_vecSlots[unSlot];
+            /* Check that the element is in the wanted cell */
+            if(n_i == sSlot.I &&
+               n_j == sSlot.J &&
+               n_k == sSlot.K) {
+               /* We have a new element to add to the list */
+               bNewElements = true;
+               t_elements.insert(sSlot.Elem);
             }
          }
          return bNewElements;
       }
 
       virtual void Dump(CARGoSLog& c_os) {
-         for(size_t i = 0; i < CSpaceHash<Element,Updater>::GetSize(); ++i) {
-            if((m_psBuckets[i].StoreTimestamp == m_unCurrentStoreTimestamp) &&
-               !m_psBuckets[i].Empty()) {
-               c_os << "BUCKET " << i << std::endl;
-               for(typename SBucket::SBucketData* psCur = m_psBuckets[i].ElementList;
-                   psCur;
-                   psCur = psCur->Next) {
-                  c_os << "   "
-                       << psCur->Elem->GetId()
-                       << " ("
-                       << psCur->I
-                       << ","
-                       << psCur->J
-                       << ","
-                       << psCur->K
-                       << ")"
-                       << std::endl;
-               }
+         for(size_t i = 0; i < m_vecSlots.size(); ++i) {
+            if(m_vecSlots[i].StoreTimestamp == m_unCurrentStoreTimestamp) {
+               c_os << "SLOT " << i << ": "
+                    << m_vecSlots[i].Elem->GetId()
+                    << " ("
+                    << m_vecSlots[i].I
+                    << ","
+                    << m_vecSlots[i].J
+                    << ","
+                    << m_vecSlots[i].K
+                    << ")"
+                    << std::endl;
             }
          }
       }
-      
+
    private:
 
       /**
-       * The list of buckets in this space hash.
+       * Returns the slot that follows the given one in the probing sequence.
        */
-      SBucket* m_psBuckets;
+      inline size_t NextSlot(size_t un_slot) const {
+         return (un_slot + 1 == m_vecSlots.size()) ? 0 : un_slot + 1;
+      }
+
+      /**
+       * Stores an element in the first unused slot of its bucket.
+       * Nothing is done if the element is already stored for the given cell.
+       * There must be at least an unused slot.
+       */
+      inline void Store(Element& c_element,
+                        SInt32 n_i,
+                        SInt32 n_j,
+                        SInt32 n_k) {
+         size_t unSlot = CSpaceHash<Element,Updater>::CoordinateHash(n_i, n_j, n_k);
+         while(m_vecSlots[unSlot].StoreTimestamp == m_unCurrentStoreTimestamp) {
+            const SSlot& sSlot = m_vecSlots[unSlot];
+            if(sSlot.Elem == &c_element &&
+               sSlot.I == n_i &&
+               sSlot.J == n_j &&
+               sSlot.K == n_k) return;
+            unSlot = NextSlot(unSlot);
+         }
+         SSlot& sSlot = m_vecSlots[unSlot];
+         sSlot.StoreTimestamp = m_unCurrentStoreTimestamp;
+         sSlot.Elem = &c_element;
+         sSlot.I = n_i;
+         sSlot.J = n_j;
+         sSlot.K = n_k;
+         ++m_unOccupiedSlots;
+      }
+
+   private:
+
+      /**
+       * The slots of this space hash.
+       */
+      std::vector<SSlot> m_vecSlots;
 
       /**
        * The current timestamp.
-       * Internally used to check whether the content of a bucket is up-to-date.
+       * Internally used to check whether the content of a slot is up-to-date.
        * @see Update
        * @see UpdateCell
        * @see CheckCell
        */
       UInt64 m_unCurrentStoreTimestamp;
 
+      /**
+       * The number of slots in use.
+       */
+      size_t m_unOccupiedSlots;
+
    };
 
 }
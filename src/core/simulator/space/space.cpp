@@ -16,7 +16,13 @@
 #include <argos3/core/simulator/entity/composable_entity.h>
 #include <argos3/core/simulator/entity/positional_entity.h>
 #include <argos3/core/simulator/loop_functions.h>
+#include <argos3/core/utility/profiler/tick_profiler.h>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
 #include <cstring>
+#include <pthread.h>
+#include <unordered_map>
 #include "space.h"
 
 namespace argos {
@@ -27,6 +33,9 @@ namespace argos {
    CSpace::CSpace() :
       m_cSimulator(CSimulator::GetInstance()),
       m_unSimulationClock(0),
+      m_nNextEntityIndex(0),
+      m_bPoolingEntities(false),
+      m_bDeferControllers(false),
       m_pcFloorEntity(nullptr),
       m_ptPhysicsEngines(nullptr),
       m_ptMedia(nullptr) {}
@@ -46,6 +55,8 @@ namespace argos {
       /*
        * Add and initialize all entities in XML
        */
+      /* With parallel initialization, the controllers are created once all the entities are in place */
+      m_bDeferControllers = m_cSimulator.IsParallelInit();
       /* Start from the entities placed manually */
       TConfigurationNodeIterator itArenaItem;
       for(itArenaItem = itArenaItem.begin(&t_tree);
@@ -65,6 +76,89 @@ namespace argos {
             Distribute(*itArenaItem);
          }
       }
+      /* Create the deferred controllers */
+      if(m_bDeferControllers) {
+         m_bDeferControllers = false;
+         InitDeferredControllers();
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   struct SDeferredControllers {
+      /* The entities whose controller must be created */
+      CControllableEntity::TVector Entities;
+      /* The errors raised by the creation of each controller */
+      std::vector<std::string> Errors;
+      /* The next entity to process */
+      std::atomic<size_t> Next;
+   };
+
+   static void InitDeferredControllerRange(SDeferredControllers& s_data) {
+      for(size_t i = s_data.Next++; i < s_data.Entities.size(); i = s_data.Next++) {
+         /* Skip the entities whose configuration could not be copied */
+         if(!s_data.Errors[i].empty()) continue;
+         try {
+            s_data.Entities[i]->InitDeferredController();
+         }
+         catch(CARGoSException& ex) {
+            s_data.Errors[i] = ex.what();
+         }
+      }
+   }
+
+   static void* LaunchDeferredControllerThread(void* p_data) {
+      LOG.AddThreadSafeBuffer();
+      LOGERR.AddThreadSafeBuffer();
+      InitDeferredControllerRange(*reinterpret_cast<SDeferredControllers*>(p_data));
+      return nullptr;
+   }
+
+   void CSpace::InitDeferredControllers() {
+      SDeferredControllers sData;
+      for(size_t i = 0; i < m_vecControllableEntities.size(); ++i) {
+         if(m_vecControllableEntities[i]->HasDeferredController()) {
+            sData.Entities.push_back(m_vecControllableEntities[i]);
+         }
+      }
+      /* Removals reorder the vector, the indices give the order of creation */
+      std::sort(sData.Entities.begin(), sData.Entities.end(), SEntityComparator());
+      sData.Errors.resize(sData.Entities.size());
+      /* The threads must not share XML nodes, give each entity its own copy */
+      for(size_t i = 0; i < sData.Entities.size(); ++i) {
+         try {
+            sData.Entities[i]->PrepareDeferredController();
+         }
+         catch(CARGoSException& ex) {
+            sData.Errors[i] = ex.what();
+         }
+      }
+      sData.Next = 0;
+      /* The calling thread takes part in the work */
+      UInt32 unWorkers = Min<UInt32>(m_cSimulator.GetNumThreads(), sData.Entities.size());
+      std::vector<pthread_t> vecWorkers;
+      for(UInt32 i = 1; i < unWorkers; ++i) {
+         pthread_t tWorker;
+         if(pthread_create(&tWorker,
+                           nullptr,
+                           LaunchDeferredControllerThread,
+                           reinterpret_cast<void*>(&sData)) != 0) {
+            /* The threads already running, and the calling thread, do the rest */
+            break;
+         }
+         vecWorkers.push_back(tWorker);
+      }
+      InitDeferredControllerRange(sData);
+      for(size_t i = 0; i < vecWorkers.size(); ++i) {
+         pthread_join(vecWorkers[i], nullptr);
+      }
+      /* Report the first error, in entity order */
+      for(size_t i = 0; i < sData.Errors.size(); ++i) {
+         if(!sData.Errors[i].empty()) {
+            THROW_ARGOSEXCEPTION(sData.Errors[i]);
+         }
+      }
    }
 
    /****************************************/
@@ -82,11 +176,38 @@ namespace argos {
    /****************************************/
    /****************************************/
 
+   /*
+    * Deletes an entity that is not in the space, along with its components.
+    * The components are taken out of their parent first, as the remove
+    * operations of the space do.
+    */
+   static void DeleteEntityTree(CEntity& c_entity) {
+      auto* pcComposable = dynamic_cast<CComposableEntity*>(&c_entity);
+      if(pcComposable != nullptr) {
+         CEntity* pcToDelete;
+         while(!pcComposable->GetComponentVector().empty()) {
+            pcToDelete = pcComposable->GetComponentVector().back();
+            pcComposable->RemoveComponent(pcToDelete->GetTypeDescription() + "[" + pcToDelete->GetId() + "]");
+            DeleteEntityTree(*pcToDelete);
+         }
+      }
+      c_entity.Destroy();
+      delete &c_entity;
+   }
+
    void CSpace::Destroy() {
       /* Remove all entities */
       while(!m_vecRootEntities.empty()) {
          CallEntityOperation<CSpaceOperationRemoveEntity, CSpace, void>(*this, *m_vecRootEntities.back());
       }
+      /* Delete the pooled entities */
+      for(auto it = m_mapEntityPools.begin(); it != m_mapEntityPools.end(); ++it) {
+         for(size_t i = 0; i < it->second.size(); ++i) {
+            DeleteEntityTree(*it->second[i].Entity);
+         }
+      }
+      m_mapEntityPools.clear();
+      m_nNextEntityIndex = 0;
    }
 
    /****************************************/
@@ -113,20 +234,85 @@ namespace argos {
        THROW_ARGOSEXCEPTION("Entity map for type \"" << str_type << "\" not found.");
      }
    }
+
+   /****************************************/
+   /****************************************/
+
+   void CSpace::AddEntityToIndexes(CEntity& c_entity) {
+      SEntitySlot sSlot;
+      sSlot.Entity = m_vecEntities.size();
+      sSlot.Root = SEntitySlot::NO_POSITION;
+      sSlot.Controllable = SEntitySlot::NO_POSITION;
+      m_vecEntities.push_back(&c_entity);
+      if(!c_entity.HasParent()) {
+         sSlot.Root = m_vecRootEntities.size();
+         m_vecRootEntities.push_back(&c_entity);
+      }
+      /* Indices are never reused, so that they keep the order of addition */
+      c_entity.SetIndex(m_nNextEntityIndex);
+      m_mapEntitySlots[m_nNextEntityIndex] = sSlot;
+      ++m_nNextEntityIndex;
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CSpace::RemoveEntityFromIndexes(CEntity& c_entity) {
+      unordered_map<ssize_t, SEntitySlot>::iterator it = m_mapEntitySlots.find(c_entity.GetIndex());
+      if(it == m_mapEntitySlots.end()) return;
+      /* Move the last entity into the freed position */
+      size_t unPos = it->second.Entity;
+      if(unPos + 1 < m_vecEntities.size()) {
+         m_vecEntities[unPos] = m_vecEntities.back();
+         m_mapEntitySlots[m_vecEntities[unPos]->GetIndex()].Entity = unPos;
+      }
+      m_vecEntities.pop_back();
+      unPos = it->second.Root;
+      if(unPos != SEntitySlot::NO_POSITION) {
+         if(unPos + 1 < m_vecRootEntities.size()) {
+            m_vecRootEntities[unPos] = m_vecRootEntities.back();
+            m_mapEntitySlots[m_vecRootEntities[unPos]->GetIndex()].Root = unPos;
+         }
+         m_vecRootEntities.pop_back();
+      }
+      m_mapEntitySlots.erase(it);
+   }
    /****************************************/
    /****************************************/
 
    void CSpace::Update() {
+      ARGOS_PROFILE_STATIC_ZONE("phase", "step");
+      /* Make a profiler zone for each engine and medium added since the last step */
+      while(m_vecPhysicsEngineZones.size() < m_ptPhysicsEngines->size()) {
+         m_vecPhysicsEngineZones.push_back(
+            CTickProfiler::GetZone("physics_engine", (*m_ptPhysicsEngines)[m_vecPhysicsEngineZones.size()]->GetId()));
+      }
+      while(m_vecMediumZones.size() < m_ptMedia->size()) {
+         m_vecMediumZones.push_back(
+            CTickProfiler::GetZone("medium", (*m_ptMedia)[m_vecMediumZones.size()]->GetId()));
+      }
       /* Increase the simulation clock */
       IncreaseSimulationClock();
       /* Perform the 'act' phase for controllable entities */
-      UpdateControllableEntitiesAct();
+      {
+         ARGOS_PROFILE_STATIC_ZONE("phase", "act");
+         UpdateControllableEntitiesAct();
+      }
       /* Update the physics engines */
-      UpdatePhysics();
+      {
+         ARGOS_PROFILE_STATIC_ZONE("phase", "physics");
+         UpdatePhysics();
+      }
       /* Update media */
-      UpdateMedia();
+      {
+         ARGOS_PROFILE_STATIC_ZONE("phase", "media");
+         UpdateMedia();
+      }
       /* Call loop functions */
-      m_cSimulator.GetLoopFunctions().PreStep();
+      {
+         ARGOS_PROFILE_STATIC_ZONE("phase", "pre_step");
+         m_cSimulator.GetLoopFunctions().PreStep();
+      }
       /*
        * If the loop functions did not use ARGoS threads during PreStep(), tell
        * the waiting thread pool to continue.
@@ -140,9 +326,15 @@ namespace argos {
        */
       m_cbControllableEntityIter = nullptr;
       /* Perform the 'sense+step' phase for controllable entities */
-      UpdateControllableEntitiesSenseStep();
+      {
+         ARGOS_PROFILE_STATIC_ZONE("phase", "sense_step");
+         UpdateControllableEntitiesSenseStep();
+      }
       /* Call loop functions */
-      m_cSimulator.GetLoopFunctions().PostStep();
+      {
+         ARGOS_PROFILE_STATIC_ZONE("phase", "post_step");
+         m_cSimulator.GetLoopFunctions().PostStep();
+      }
 
       /*
        * If the loop functions did not use ARGoS threads during PostStep(), tell
@@ -156,15 +348,73 @@ namespace argos {
        * unless enabled again by the loop functions.
        */
       m_cbControllableEntityIter = nullptr;
-      /* Flush logs */
-      LOG.Flush();
-      LOGERR.Flush();
+      /* Flush logs, without waiting for the output */
+      LOG.RequestFlush();
+      LOGERR.RequestFlush();
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CSpace::UpdatePhysicsEngine(size_t un_engine) {
+      ARGOS_PROFILE_ZONE(m_vecPhysicsEngineZones[un_engine]);
+      (*m_ptPhysicsEngines)[un_engine]->Update();
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CSpace::BeginMediaUpdate() {
+      m_vecMediaTasks.clear();
+      for(size_t i = 0; i < m_ptMedia->size(); ++i) {
+         CMedium* pcMedium = (*m_ptMedia)[i];
+         size_t unTasks = pcMedium->BeginUpdate();
+         if(unTasks == 0) {
+            /* The medium cannot be split */
+            m_vecMediaTasks.push_back(SMediumTask{pcMedium, SMediumTask::NO_TASK, m_vecMediumZones[i]});
+         }
+         else {
+            for(size_t t = 0; t < unTasks; ++t) {
+               m_vecMediaTasks.push_back(SMediumTask{pcMedium, t, m_vecMediumZones[i]});
+            }
+         }
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CSpace::UpdateMediaTask(size_t un_task) {
+      SMediumTask& sTask = m_vecMediaTasks[un_task];
+      ARGOS_PROFILE_ZONE(sTask.Zone);
+      if(sTask.Task == SMediumTask::NO_TASK) {
+         sTask.Medium->Update();
+      }
+      else {
+         sTask.Medium->UpdateTask(sTask.Task);
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CSpace::EndMediaUpdate() {
+      /* The tasks of a medium are consecutive, end each split medium once */
+      for(size_t i = 0; i < m_vecMediaTasks.size(); ++i) {
+         if(m_vecMediaTasks[i].Task == 0) {
+            m_vecMediaTasks[i].Medium->EndUpdate();
+         }
+      }
    }
 
    /****************************************/
    /****************************************/
 
    void CSpace::AddControllableEntity(CControllableEntity& c_entity) {
+      unordered_map<ssize_t, SEntitySlot>::iterator it = m_mapEntitySlots.find(c_entity.GetIndex());
+      if(it != m_mapEntitySlots.end()) {
+         it->second.Controllable = m_vecControllableEntities.size();
+      }
       m_vecControllableEntities.push_back(&c_entity);
    }
 
@@ -172,12 +422,17 @@ namespace argos {
    /****************************************/
 
    void CSpace::RemoveControllableEntity(CControllableEntity& c_entity) {
-      auto it = find(m_vecControllableEntities.begin(),
-                                                       m_vecControllableEntities.end(),
-                                                       &c_entity);
-      if(it != m_vecControllableEntities.end()) {
-         m_vecControllableEntities.erase(it);
+      unordered_map<ssize_t, SEntitySlot>::iterator it = m_mapEntitySlots.find(c_entity.GetIndex());
+      if(it == m_mapEntitySlots.end() ||
+         it->second.Controllable == SEntitySlot::NO_POSITION) return;
+      /* Move the last controllable entity into the freed position */
+      size_t unPos = it->second.Controllable;
+      if(unPos + 1 < m_vecControllableEntities.size()) {
+         m_vecControllableEntities[unPos] = m_vecControllableEntities.back();
+         m_mapEntitySlots[m_vecControllableEntities[unPos]->GetIndex()].Controllable = unPos;
       }
+      m_vecControllableEntities.pop_back();
+      it->second.Controllable = SEntitySlot::NO_POSITION;
    }
 
    /****************************************/
@@ -346,6 +601,98 @@ namespace argos {
       UInt32 m_unNumEntityPlaced;
    };
 
+   /*
+    * Draws uniform positions that are at least a given distance apart from the
+    * positions drawn before (Poisson-disk sampling by dart throwing). The drawn
+    * positions are kept in a grid of cells as large as the minimum distance, so
+    * that each draw is checked against the positions in the neighbouring cells only.
+    */
+   class PoissonDiskGenerator : public RealNumberGenerator {
+   public:
+      PoissonDiskGenerator(const CVector3& c_min,
+                           const CVector3& c_max,
+                           Real f_min_distance,
+                           UInt32 un_max_attempts) :
+         m_cUniform(c_min, c_max),
+         m_cMin(c_min),
+         m_fMinDistance(f_min_distance),
+         m_unMaxAttempts(un_max_attempts) {}
+
+      virtual CVector3 operator()(bool b_is_retry) {
+         if(b_is_retry && !m_vecPositions.empty()) {
+            /* The last position was not used, free it */
+            m_mapCells[GetCellKey(m_vecPositions.back())].pop_back();
+            m_vecPositions.pop_back();
+         }
+         for(UInt32 i = 0; i < m_unMaxAttempts; ++i) {
+            CVector3 cPosition = m_cUniform(false);
+            if(IsFree(cPosition)) {
+               m_mapCells[GetCellKey(cPosition)].push_back(m_vecPositions.size());
+               m_vecPositions.push_back(cPosition);
+               return cPosition;
+            }
+         }
+         THROW_ARGOSEXCEPTION("Distribute position, method 'poisson_disk': cannot find a position at least " <<
+                              m_fMinDistance << " away from the " << m_vecPositions.size() <<
+                              " positions placed so far after " << m_unMaxAttempts << " attempts");
+      }
+
+   private:
+
+      void GetCell(const CVector3& c_position,
+                   SInt32* pn_cell) const {
+         /* The cells are clamped so that the neighbours of a cell can be packed too */
+         static const Real MAX_CELL = (1 << 20) - 2;
+         pn_cell[0] = static_cast<SInt32>(Min<Real>(std::floor((c_position.GetX() - m_cMin.GetX()) / m_fMinDistance), MAX_CELL));
+         pn_cell[1] = static_cast<SInt32>(Min<Real>(std::floor((c_position.GetY() - m_cMin.GetY()) / m_fMinDistance), MAX_CELL));
+         pn_cell[2] = static_cast<SInt32>(Min<Real>(std::floor((c_position.GetZ() - m_cMin.GetZ()) / m_fMinDistance), MAX_CELL));
+      }
+
+      static UInt64 PackCell(SInt32 n_x,
+                             SInt32 n_y,
+                             SInt32 n_z) {
+         /* The positions are never below m_cMin, so the coordinates are at least -1 */
+         return
+            (static_cast<UInt64>(n_x + 1) << 42) |
+            (static_cast<UInt64>(n_y + 1) << 21) |
+             static_cast<UInt64>(n_z + 1);
+      }
+
+      UInt64 GetCellKey(const CVector3& c_position) const {
+         SInt32 pnCell[3];
+         GetCell(c_position, pnCell);
+         return PackCell(pnCell[0], pnCell[1], pnCell[2]);
+      }
+
+      bool IsFree(const CVector3& c_position) const {
+         SInt32 pnCell[3];
+         GetCell(c_position, pnCell);
+         Real fMinSquareDistance = Square(m_fMinDistance);
+         for(SInt32 nX = pnCell[0] - 1; nX <= pnCell[0] + 1; ++nX) {
+            for(SInt32 nY = pnCell[1] - 1; nY <= pnCell[1] + 1; ++nY) {
+               for(SInt32 nZ = pnCell[2] - 1; nZ <= pnCell[2] + 1; ++nZ) {
+                  auto itCell = m_mapCells.find(PackCell(nX, nY, nZ));
+                  if(itCell == m_mapCells.end()) continue;
+                  for(UInt32 unIdx : itCell->second) {
+                     if(SquareDistance(c_position, m_vecPositions[unIdx]) < fMinSquareDistance) {
+                        return false;
+                     }
+                  }
+               }
+            }
+         }
+         return true;
+      }
+
+   private:
+      UniformGenerator m_cUniform;
+      CVector3 m_cMin;
+      Real m_fMinDistance;
+      UInt32 m_unMaxAttempts;
+      std::vector<CVector3> m_vecPositions;
+      std::unordered_map<UInt64, std::vector<UInt32> > m_mapCells;
+   };
+
    /****************************************/
    /****************************************/
 
@@ -382,6 +729,22 @@ namespace argos {
          ParseValues<UInt32> (strLayout, 3, unLayout, ',');
          return new GridGenerator(cCenter, unLayout, cDistances);
       }
+      else if(strMethod == "poisson_disk") {
+         CVector3 cMin, cMax;
+         GetNodeAttribute(t_tree, "min", cMin);
+         GetNodeAttribute(t_tree, "max", cMax);
+         if(! (cMin <= cMax)) {
+            THROW_ARGOSEXCEPTION("Poisson-disk generator: the min is not less than or equal to max: " << cMin << " / " << cMax);
+         }
+         Real fMinDistance;
+         GetNodeAttribute(t_tree, "min_distance", fMinDistance);
+         if(fMinDistance <= 0) {
+            THROW_ARGOSEXCEPTION("Poisson-disk generator: the min_distance must be positive");
+         }
+         UInt32 unMaxAttempts = 1000;
+         GetNodeAttributeOrDefault(t_tree, "max_attempts", unMaxAttempts, unMaxAttempts);
+         return new PoissonDiskGenerator(cMin, cMax, fMinDistance, unMaxAttempts);
+      }
       else {
          THROW_ARGOSEXCEPTION("Unknown distribution method \"" << strMethod << "\"");
       }
@@ -430,6 +793,37 @@ namespace argos {
    /****************************************/
    /****************************************/
 
+   /*
+    * Returns true if the physics engines that house the given entity would
+    * house it at the given position too.
+    */
+   static bool IsHousedByEngines(CEmbodiedEntity& c_entity,
+                                 const CVector3& c_position,
+                                 CPhysicsEngine::TVector& vec_engines) {
+      /* The engines that house the entity must contain the position */
+      for(size_t i = 0; i < c_entity.GetPhysicsModelsNum(); ++i) {
+         if(!c_entity.GetPhysicsModel(i).GetEngine().IsPointContained(c_position)) {
+            return false;
+         }
+      }
+      /* No other engine must contain the position before them */
+      size_t unMatching = 0;
+      for(size_t i = 0; i < vec_engines.size(); ++i) {
+         if(vec_engines[i]->IsPointContained(c_position)) {
+            ++unMatching;
+            /* A movable entity is housed by the first matching engine that accepts it */
+            if(c_entity.IsMovable()) {
+               return vec_engines[i] == &c_entity.GetPhysicsModel(0).GetEngine();
+            }
+         }
+      }
+      /* A non-movable entity is housed by all the matching engines */
+      return unMatching == c_entity.GetPhysicsModelsNum();
+   }
+
+   /****************************************/
+   /****************************************/
+
    void CSpace::Distribute(TConfigurationNode& t_tree) {
       try {
          /* Get the needed nodes */
@@ -448,6 +842,13 @@ namespace argos {
          /* How many trials before failing? */
          UInt32 unMaxTrials;
          GetNodeAttribute(cEntityNode, "max_trials", unMaxTrials);
+         /* Should the colliding entities be moved, rather than created anew? */
+         bool bMoveOnRetry = false;
+         GetNodeAttributeOrDefault(cEntityNode, "move_on_retry", bMoveOnRetry, bMoveOnRetry);
+         if(bMoveOnRetry) {
+            LOG << "[INFO] <distribute> moves the colliding entities (move_on_retry=\"true\"):" << std::endl
+                << "[INFO]   the layout is not bit-identical to that of the default <distribute>" << std::endl;
+         }
          /* Get the (optional) entity base numbering */
          UInt64 unBaseNum = 0;
          GetNodeAttributeOrDefault(cEntityNode, "base_num", unBaseNum, unBaseNum);
@@ -471,10 +872,13 @@ namespace argos {
             UInt32 unTrials = 0;
             bool bDone = false;
             bool bRetry = false;
-            CEntity* pcEntity;
+            CEntity* pcEntity = nullptr;
+            CEmbodiedEntity* pcEmbodiedEntity = nullptr;
             do {
-               /* Create entity */
-               pcEntity = CFactory<CEntity>::New(tEntityTree.Value());
+               /* Create entity, unless it was created in a previous trial */
+               if(pcEntity == nullptr) {
+                  pcEntity = CFactory<CEntity>::New(tEntityTree.Value());
+               }
                /*
                 * Now that you have the entity, check whether the
                 * entity is positional or embodied or has one such
@@ -491,7 +895,14 @@ namespace argos {
                 * engine if that entity is colliding with something.
                 *
                 * In case of collision, we remove the entity and try a
-                * different position/orientation.
+                * different position/orientation. With 'move_on_retry',
+                * if the physics engines that house the entity would
+                * house it at the new position too, the entity is just
+                * moved there instead. The positions are the same, but
+                * a moved entity takes its orientation back from the
+                * engine, with a different rounding, and the engine
+                * orders its contacts differently. When the entities
+                * touch, their trajectories then differ too.
                 */
                /* Check whether the entity is positional */
                CPositionalEntity* pcPositionalEntity = GetPositionalEntity(pcEntity);
@@ -519,38 +930,62 @@ namespace argos {
                   SetNodeAttribute(tBodyNode, "position", (*pcPositionGenerator)(bRetry));
                   /* Set the orientation */
                   SetNodeAttribute(tBodyNode, "orientation", (*pcOrientationGenerator)(bRetry));
-                  /* Init the entity (this also creates the components, if pcEntity is a composable) */
-                  pcEntity->Init(tEntityTree);
-                  /* Check whether the entity is indeed embodied */
-                  CEmbodiedEntity* pcEmbodiedEntity = GetEmbodiedEntity(pcEntity);
                   if(pcEmbodiedEntity != nullptr) {
+                     /* The entity was added in a previous trial, read back the new pose as Init() would */
+                     CVector3 cPosition;
+                     CQuaternion cOrientation;
+                     GetNodeAttribute(tBodyNode, "position", cPosition);
+                     GetNodeAttribute(tBodyNode, "orientation", cOrientation);
+                     if(IsHousedByEngines(*pcEmbodiedEntity, cPosition, *m_ptPhysicsEngines)) {
+                        /* Move the entity, the collisions are checked below */
+                        pcEmbodiedEntity->MoveTo(cPosition, cOrientation, false, true);
+                        pcEmbodiedEntity->SetInitOriginPose(cPosition, cOrientation);
+                     }
+                     else {
+                        /* Get rid of the entity and create it anew */
+                        CallEntityOperation<CSpaceOperationRemoveEntity, CSpace, void>(*this, *pcEntity);
+                        pcEntity = CFactory<CEntity>::New(tEntityTree.Value());
+                        pcEmbodiedEntity = nullptr;
+                     }
+                  }
+                  if(pcEmbodiedEntity == nullptr) {
+                     /* Init the entity (this also creates the components, if pcEntity is a composable) */
+                     pcEntity->Init(tEntityTree);
+                     /* Check whether the entity is indeed embodied */
+                     pcEmbodiedEntity = GetEmbodiedEntity(pcEntity);
+                     if(pcEmbodiedEntity == nullptr) {
+                        THROW_ARGOSEXCEPTION("Cannot distribute entities that are not positional nor embodied, and \"" << tEntityTree.Value() << "\" is neither.");
+                     }
                      /* Yes, the entity is embodied */
                      /* Add it to the space and to the designated physics engine */
                      CallEntityOperation<CSpaceOperationAddEntity, CSpace, void>(*this, *pcEntity);
-                     /* Check if it's colliding with anything else */
-                     if(pcEmbodiedEntity->IsCollidingWithSomething()) {
-                        /* Set retry to true */
-                        bRetry = true;
+                  }
+                  /* Check if it's colliding with anything else */
+                  if(pcEmbodiedEntity->IsCollidingWithSomething()) {
+                     /* Set retry to true */
+                     bRetry = true;
+                     /* Increase the trial count */
+                     ++unTrials;
+                     /* Too many trials? */
+                     if(unTrials > unMaxTrials) {
                         /* Get rid of the entity */
                         CallEntityOperation<CSpaceOperationRemoveEntity, CSpace, void>(*this, *pcEntity);
-                        /* Increase the trial count */
-                        ++unTrials;
-                        /* Too many trials? */
-                        if(unTrials > unMaxTrials) {
-                           /* Yes, bomb out */
-                           THROW_ARGOSEXCEPTION("Exceeded max trials when trying to distribute objects of type " <<
-                                                tEntityTree.Value() << " with base id \"" <<
-                                                strBaseId << "\". I managed to place only " << i << " objects.");
-                        }
-                        /* Retry with a new position */
+                        /* Yes, bomb out */
+                        THROW_ARGOSEXCEPTION("Exceeded max trials when trying to distribute objects of type " <<
+                                             tEntityTree.Value() << " with base id \"" <<
+                                             strBaseId << "\". I managed to place only " << i << " objects.");
                      }
-                     else {
-                        /* No collision, we're done with this entity */
-                        bDone = true;
+                     if(!bMoveOnRetry) {
+                        /* Get rid of the entity, the next trial creates it anew */
+                        CallEntityOperation<CSpaceOperationRemoveEntity, CSpace, void>(*this, *pcEntity);
+                        pcEntity = nullptr;
+                        pcEmbodiedEntity = nullptr;
                      }
+                     /* Retry with a new position */
                   }
                   else {
-                     THROW_ARGOSEXCEPTION("Cannot distribute entities that are not positional nor embodied, and \"" << tEntityTree.Value() << "\" is neither.");
+                     /* No collision, we're done with this entity */
+                     bDone = true;
                   }
                }
             }
@@ -568,4 +1003,147 @@ namespace argos {
    /****************************************/
    /****************************************/
 
+   /*
+    * Lists an entity and its components, parents before children, along with
+    * their enabled state.
+    */
+   static void CollectEntityTree(CEntity& c_entity,
+                                 std::vector<std::pair<CEntity*, bool> >& vec_tree) {
+      vec_tree.emplace_back(&c_entity, c_entity.IsEnabled());
+      auto* pcComposable = dynamic_cast<CComposableEntity*>(&c_entity);
+      if(pcComposable != nullptr) {
+         for(size_t i = 0; i < pcComposable->GetComponentVector().size(); ++i) {
+            CollectEntityTree(*pcComposable->GetComponentVector()[i], vec_tree);
+         }
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CSpace::PoolEntity(CEntity& c_entity) {
+      if(c_entity.HasParent()) {
+         THROW_ARGOSEXCEPTION("Cannot put entity \"" << c_entity.GetContext() << c_entity.GetId() <<
+                              "\" in a pool, because it is a component of \"" <<
+                              c_entity.GetRootEntity().GetId() << "\".");
+      }
+      if(c_entity.GetConfigurationKey() == 0) {
+         THROW_ARGOSEXCEPTION("Cannot put entity \"" << c_entity.GetId() <<
+                              "\" in a pool, because it was not initialized from a configuration.");
+      }
+      SPooledEntity sPooled;
+      sPooled.Entity = &c_entity;
+      /* The remove operations disable some components, remember their state */
+      CollectEntityTree(c_entity, sPooled.Tree);
+      /* Take the entity out of the space, keeping it and its components */
+      m_bPoolingEntities = true;
+      try {
+         CallEntityOperation<CSpaceOperationRemoveEntity, CSpace, void>(*this, c_entity);
+      }
+      catch(CARGoSException& ex) {
+         m_bPoolingEntities = false;
+         THROW_ARGOSEXCEPTION_NESTED("While putting entity \"" << c_entity.GetId() << "\" in a pool", ex);
+      }
+      m_bPoolingEntities = false;
+      m_mapEntityPools[std::make_pair(c_entity.GetTypeDescription(), c_entity.GetConfigurationKey())].push_back(sPooled);
+   }
+
+   /****************************************/
+   /****************************************/
+
+   CEntity* CSpace::SpawnFromPool(const std::string& str_type,
+                                  TConfigurationNode& t_tree) {
+      /* Only an entity made from the same configuration can be reused */
+      auto itPool = m_mapEntityPools.find(std::make_pair(str_type, CEntity::ComputeConfigurationKey(t_tree)));
+      if(itPool == m_mapEntityPools.end() || itPool->second.empty()) {
+         return nullptr;
+      }
+      SPooledEntity sPooled = itPool->second.back();
+      CEntity& cEntity = *sPooled.Entity;
+      std::string strPooledId = cEntity.GetId();
+      /* The pose the entity was pooled with, to restore if the spawn fails */
+      CEmbodiedEntity* pcEmbodiedEntity = GetEmbodiedEntity(&cEntity);
+      bool bPoseChanged = false;
+      CVector3 cPooledPosition;
+      CQuaternion cPooledOrientation;
+      if(pcEmbodiedEntity != nullptr) {
+         cPooledPosition = pcEmbodiedEntity->GetInitOriginPosition();
+         cPooledOrientation = pcEmbodiedEntity->GetInitOriginOrientation();
+      }
+      try {
+         /* Take the id and the pose in the configuration */
+         std::string strId;
+         GetNodeAttributeOrDefault(t_tree, "id", strId, cEntity.GetId());
+         if(pcEmbodiedEntity != nullptr && NodeExists(t_tree, "body")) {
+            TConfigurationNode& tBodyNode = GetNode(t_tree, "body");
+            CVector3 cPosition;
+            CQuaternion cOrientation;
+            GetNodeAttribute(tBodyNode, "position", cPosition);
+            GetNodeAttributeOrDefault(tBodyNode, "orientation", cOrientation, cOrientation);
+            /* Make sure the entity can be added back before changing it */
+            bool bHoused = false;
+            for(size_t i = 0; i < m_ptPhysicsEngines->size() && !bHoused; ++i) {
+               bHoused = (*m_ptPhysicsEngines)[i]->IsPointContained(cPosition);
+            }
+            if(!bHoused) {
+               THROW_ARGOSEXCEPTION("No physics engines available to house entity \"" << strId <<
+                                    "\"@(" << cPosition << ").");
+            }
+            pcEmbodiedEntity->SetInitOriginPose(cPosition, cOrientation);
+            pcEmbodiedEntity->Reset();
+            bPoseChanged = true;
+         }
+         cEntity.SetId(strId);
+         /*
+          * Restore the enabled flags before adding the entity back, so the
+          * add operations put the enabled components back in their media
+          */
+         for(size_t i = 0; i < sPooled.Tree.size(); ++i) {
+            sPooled.Tree[i].first->CEntity::SetEnabled(sPooled.Tree[i].second);
+         }
+         /* Put the entity back in the space */
+         CallEntityOperation<CSpaceOperationAddEntity, CSpace, void>(*this, cEntity);
+         /* The entity is in the space now, it can leave the pool */
+         itPool->second.pop_back();
+      }
+      catch(CARGoSException& ex) {
+         /* The entity stays in the pool, as it was */
+         cEntity.SetId(strPooledId);
+         if(bPoseChanged) {
+            pcEmbodiedEntity->SetInitOriginPose(cPooledPosition, cPooledOrientation);
+            pcEmbodiedEntity->Reset();
+         }
+         THROW_ARGOSEXCEPTION_NESTED("While spawning a " << str_type << " entity from its pool", ex);
+      }
+      /* Bring the entity back to its initial state */
+      cEntity.Reset();
+      /* The controllers keep the id of their robot */
+      for(size_t i = 0; i < sPooled.Tree.size(); ++i) {
+         auto* pcControllable = dynamic_cast<CControllableEntity*>(sPooled.Tree[i].first);
+         if(pcControllable != nullptr &&
+            pcControllable->HasController() &&
+            pcControllable->HasParent()) {
+            pcControllable->GetController().SetId(pcControllable->GetParent().GetId());
+         }
+      }
+      return &cEntity;
+   }
+
+   /****************************************/
+   /****************************************/
+
+   size_t CSpace::GetPoolSize(const std::string& str_type) const {
+      /* Sum the pools of all the configurations of the given type */
+      size_t unSize = 0;
+      for(auto itPool = m_mapEntityPools.lower_bound(std::make_pair(str_type, static_cast<UInt64>(0)));
+          itPool != m_mapEntityPools.end() && itPool->first.first == str_type;
+          ++itPool) {
+         unSize += itPool->second.size();
+      }
+      return unSize;
+   }
+
+   /****************************************/
+   /****************************************/
+
 }
@@ -130,8 +130,15 @@ namespace argos {
       /**
        * Returns a vector of all the entities in the space.
        * All entities are returned, i.e., all the components of a robot.
+       * <p>
+       * The entities are in the order they were added, until one is removed.
+       * A removed entity is replaced by the last entity of the vector, so
+       * the order after a removal is not the order of addition. Use the
+       * entity indices to order entities deterministically.
+       * </p>
        * @return a vector of all the entities in the space.
        * @see GetRootEntityVector()
+       * @see CEntity::GetIndex()
        */
       inline CEntity::TVector& GetEntityVector() {
          return m_vecEntities;
@@ -144,6 +151,7 @@ namespace argos {
        * returns all entities including the components of a composable
        * entity, while this method does not return any component, but only
        * the parentless composables.
+       * The order of the entities follows the same rules as GetEntityVector().
        * @return a vector of all the root entities in the space.
        * @see GetEntityVector()
        */
@@ -166,6 +174,23 @@ namespace argos {
                               "\" when requesting entity from space.");
       }
 
+      /**
+       * Returns the entity with the given index.
+       * The index of an entity is never given to another entity during an
+       * experiment. Unlike a pointer, it can therefore be kept as a handle
+       * to an entity that might be removed, and checked with this method.
+       * @param n_index The index of the wanted entity
+       * @return The entity with the given index, or <tt>NULL</tt> if the entity was removed.
+       * @see CEntity::GetIndex()
+       */
+      inline CEntity* GetEntityByIndex(ssize_t n_index) {
+         unordered_map<ssize_t, SEntitySlot>::const_iterator it = m_mapEntitySlots.find(n_index);
+         if(it != m_mapEntitySlots.end()) {
+            return m_vecEntities[it->second.Entity];
+         }
+         return NULL;
+      }
+
       /**
        * Returns the entities matching a given pattern.
        * The pattern must be a valid regexp.
@@ -282,18 +307,7 @@ namespace argos {
                                  "\". An entity with that id already exists.");
          }
          /* Add the entity to the indexes */
-         if(!c_entity.HasParent()) {
-            m_vecRootEntities.push_back(&c_entity);
-         }
-         /* Calculate index of in the global vector */
-         size_t unIdx =
-            !m_vecEntities.empty() ?
-            m_vecEntities.back()->GetIndex() + 1
-            :
-            0;
-         /* Add entity to global vector */
-         m_vecEntities.push_back(&c_entity);
-         c_entity.SetIndex(unIdx);
+         AddEntityToIndexes(c_entity);
          m_mapEntitiesPerId[strEntityQualifiedName] = &c_entity;
          m_mapEntitiesPerTypePerId[c_entity.GetTypeDescription()][strEntityQualifiedName] = &c_entity;
       }
@@ -313,22 +327,14 @@ namespace argos {
             TMapPerType::iterator itMapPerTypePerId = itMapPerType->second.find(strEntityQualifiedName);
             if(itMapPerTypePerId != itMapPerType->second.end()) {
                /* Remove the entity from the indexes */
-               CEntity::TVector::iterator itVec = find(m_vecEntities.begin(),
-                                                       m_vecEntities.end(),
-                                                       &c_entity);
-               m_vecEntities.erase(itVec);
-               CEntity::TMap::iterator itMap = m_mapEntitiesPerId.find(strEntityQualifiedName);
+               RemoveEntityFromIndexes(c_entity);
                itMapPerType->second.erase(itMapPerTypePerId);
-               m_mapEntitiesPerId.erase(itMap);
-               if(!c_entity.HasParent()) {
-                  CEntity::TVector::iterator itRootVec = find(m_vecRootEntities.begin(),
-                                                              m_vecRootEntities.end(),
-                                                              &c_entity);
-                  m_vecRootEntities.erase(itRootVec);
+               m_mapEntitiesPerId.erase(strEntityQualifiedName);
+               /* Remove entity object, unless it goes to a pool */
+               if(!m_bPoolingEntities) {
+                  c_entity.Destroy();
+                  delete &c_entity;
                }
-               /* Remove entity object */
-               c_entity.Destroy();
-               delete &c_entity;
                return;
             }
          }
@@ -337,6 +343,52 @@ namespace argos {
                               "\" has not been found in the indexes.");
       }
 
+      /**
+       * Takes an entity out of the space and keeps it in the pool of its type.
+       * The entity leaves the physics engines, the media and the indexes of the
+       * space as if it were removed, but it is not destroyed. Its components and
+       * its controller are kept, so that SpawnFromPool() can put it back in the
+       * space without creating it anew.
+       * There is a pool for each type and configuration, as returned by
+       * CEntity::GetConfigurationKey().
+       * @param c_entity The entity to put in the pool. It must be a root entity.
+       * @throws CARGoSException if the entity is a component of another entity,
+       * or if it was not initialized from a configuration.
+       * @see SpawnFromPool()
+       */
+      void PoolEntity(CEntity& c_entity);
+
+      /**
+       * Puts back in the space an entity from the pool of the given type and configuration.
+       * Only an entity initialized from the same configuration, except for the
+       * id and the body pose, is reused. It takes the id and the body pose given
+       * in the configuration, if any, and is then reset, as with an experiment reset.
+       * If the entity cannot be added back, it stays in the pool with its previous id and initial pose.
+       * @param str_type The type of the wanted entity, as returned by CEntity::GetTypeDescription().
+       * @param t_tree The configuration of the entity.
+       * @return The spawned entity, or <tt>NULL</tt> if no pooled entity matches the configuration.
+       * @throws CARGoSException if the entity cannot be placed at the given pose.
+       * @see PoolEntity()
+       */
+      CEntity* SpawnFromPool(const std::string& str_type,
+                             TConfigurationNode& t_tree);
+
+      /**
+       * Returns the number of entities in the pools of the given type, for all configurations.
+       * @param str_type The type of the entities, as returned by CEntity::GetTypeDescription().
+       * @return The number of entities in the pool of the given type.
+       */
+      size_t GetPoolSize(const std::string& str_type) const;
+
+      /**
+       * Returns <tt>true</tt> while an entity is being put in a pool.
+       * This method is used internally by the remove operations, don't use it in your code.
+       * @return <tt>true</tt> while an entity is being put in a pool.
+       */
+      inline bool IsPoolingEntities() const {
+         return m_bPoolingEntities;
+      }
+
       /**
        * Returns the current value of the simulation clock.
        * The clock is measured in ticks. You can set how much a tick is long in seconds in the XML.
@@ -364,6 +416,18 @@ namespace argos {
          m_unSimulationClock += un_increase;
       }
 
+      /**
+       * Returns <tt>true</tt> if the controllable entities must defer the creation of their controllers.
+       * This is the case while Init() runs with parallel initialization enabled.
+       * The deferred controllers are created in parallel at the end of Init().
+       * @return <tt>true</tt> if the controllable entities must defer the creation of their controllers.
+       * @see CSimulator::IsParallelInit()
+       * @see CControllableEntity::InitDeferredController()
+       */
+      inline bool IsDeferringControllers() const {
+         return m_bDeferControllers;
+      }
+
       /**
        * Returns the arena size.
        * @return the arena size.
@@ -442,14 +506,76 @@ namespace argos {
        */
       virtual void ControllableEntityIterationWaitAbort() {}
 
+      /**
+       * Adds the entities described by a <tt>&lt;distribute&gt;</tt> node.
+       * An entity that collides at its drawn pose is removed and created anew
+       * at the next drawn pose, as the physics engines are the only judges of
+       * collisions. No occupancy grid is kept to skip the doomed poses: the
+       * physics engines number the shapes of the entities they house in order of
+       * creation and order the contacts by these numbers, so skipping the
+       * entities created for the doomed poses would change the order of the
+       * contacts, and with it the experiment.
+       *
+       * Two options trade this for speed in crowded arenas, and their layouts
+       * are NOT bit-identical to those of the default <tt>&lt;distribute&gt;</tt>:
+       * - With <tt>move_on_retry="true"</tt> in the <tt>&lt;entity&gt;</tt> node,
+       *   a colliding entity is moved to the next drawn pose instead. The
+       *   positions are the same as by default, but the orientations are rounded
+       *   differently and the physics engine may order the contacts differently.
+       * - With <tt>method="poisson_disk"</tt> in the <tt>&lt;position&gt;</tt>
+       *   node, the positions are drawn at least <tt>min_distance</tt> apart,
+       *   so they differ from those of <tt>method="uniform"</tt>.
+       * @param t_tree The <tt>&lt;distribute&gt;</tt> node.
+       */
       void Distribute(TConfigurationNode& t_tree);
 
       void AddBoxStrip(TConfigurationNode& t_tree);
 
+      /**
+       * Creates the controllers deferred during Init().
+       * The controllers are spread among as many threads as set in the
+       * <tt>system</tt> node. The RNGs they create are seeded as if the
+       * controllers had been created one after the other, in the order of
+       * the controllable entities.
+       */
+      void InitDeferredControllers();
+
       bool ControllableEntityIterationEnabled() const {
         return nullptr != m_cbControllableEntityIter;
       }
 
+      /**
+       * Updates a physics engine.
+       * Different engines can be updated at the same time by different threads.
+       * @param un_engine The engine index in the list of physics engines.
+       */
+      void UpdatePhysicsEngine(size_t un_engine);
+
+      /**
+       * Prepares the tasks of the media phase.
+       * Each medium is asked to split its update with CMedium::BeginUpdate();
+       * a medium that cannot be split becomes a single task. The tasks are
+       * listed in media order.
+       * Used by the multi-thread spaces, from the main thread.
+       * @see UpdateMediaTask()
+       * @see EndMediaUpdate()
+       */
+      void BeginMediaUpdate();
+
+      /**
+       * Executes a task of the media phase.
+       * Different tasks can be executed at the same time by different threads.
+       * @param un_task The task index in the list prepared by BeginMediaUpdate().
+       */
+      void UpdateMediaTask(size_t un_task);
+
+      /**
+       * Completes the media phase, calling CMedium::EndUpdate() on the split
+       * media in media order.
+       * Used by the multi-thread spaces, from the main thread.
+       */
+      void EndMediaUpdate();
+
    protected:
 
       friend class CSpaceOperationAddControllableEntity;
@@ -473,6 +599,18 @@ namespace argos {
       /** Arena limits */
       CRange<CVector3> m_cArenaLimits;
 
+      /** The positions of an entity in the entity vectors */
+      struct SEntitySlot {
+         /** The position in m_vecEntities */
+         size_t Entity;
+         /** The position in m_vecRootEntities, or NO_POSITION */
+         size_t Root;
+         /** The position in m_vecControllableEntities, or NO_POSITION */
+         size_t Controllable;
+
+         static const size_t NO_POSITION = static_cast<size_t>(-1);
+      };
+
       /** A vector of entities. */
       CEntity::TVector m_vecEntities;
 
@@ -482,6 +620,12 @@ namespace argos {
       /** A map of entities. */
       CEntity::TMap m_mapEntitiesPerId;
 
+      /** The positions of the entities in the entity vectors, indexed by entity index */
+      unordered_map<ssize_t, SEntitySlot> m_mapEntitySlots;
+
+      /** The index given to the next entity added to the space */
+      ssize_t m_nNextEntityIndex;
+
       /** A map of maps of all the simulated entities.
           The top-level map is indexed by type, as returned by CEntity::GetTypeDescription().
           The second-level maps are indexed by entity id */
@@ -490,6 +634,23 @@ namespace argos {
       /** A vector of controllable entities */
       CControllableEntity::TVector m_vecControllableEntities;
 
+      /** An entity kept in a pool */
+      struct SPooledEntity {
+         /** The entity */
+         CEntity* Entity;
+         /** The entity and its components, with their enabled state when they were pooled */
+         std::vector<std::pair<CEntity*, bool> > Tree;
+      };
+
+      /** The pools of entities, indexed by type and configuration key */
+      std::map<std::pair<std::string, UInt64>, std::vector<SPooledEntity> > m_mapEntityPools;
+
+      /** <tt>true</tt> while an entity is being put in a pool */
+      bool m_bPoolingEntities;
+
+      /** <tt>true</tt> while the controllable entities must defer the creation of their controllers */
+      bool m_bDeferControllers;
+
       /** The floor entity */
       CFloorEntity* m_pcFloorEntity;
 
@@ -499,12 +660,37 @@ namespace argos {
       /** A pointer to the list of media */
       CMedium::TVector* m_ptMedia;
 
+      /** A task of the media phase */
+      struct SMediumTask {
+         /** The medium to update */
+         CMedium* Medium;
+         /** The task of the medium, or NO_TASK to call CMedium::Update() */
+         size_t Task;
+         /** The profiler zone of the medium */
+         UInt32 Zone;
+
+         static const size_t NO_TASK = static_cast<size_t>(-1);
+      };
+
+      /** The tasks of the media phase, prepared by BeginMediaUpdate() */
+      std::vector<SMediumTask> m_vecMediaTasks;
+
+      /** The profiler zones of the physics engines, in engine order */
+      std::vector<UInt32> m_vecPhysicsEngineZones;
+
+      /** The profiler zones of the media, in media order */
+      std::vector<UInt32> m_vecMediumZones;
+
       /** Callback for iterating over entities from within the loop functions */
       TControllableEntityIterCBType m_cbControllableEntityIter{nullptr};
 
   private:
       TMapPerType& GetEntitiesByTypeImpl(const std::string& str_type) const;
 
+      void AddEntityToIndexes(CEntity& c_entity);
+
+      void RemoveEntityFromIndexes(CEntity& c_entity);
+
    };
 
    /****************************************/
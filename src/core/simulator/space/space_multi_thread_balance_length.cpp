@@ -7,6 +7,8 @@
 #include "space_multi_thread_balance_length.h"
 #include <argos3/core/simulator/simulator.h>
 #include <argos3/core/utility/profiler/profiler.h>
+#include <cstring>
+#include <ctime>
 
 namespace argos {
 
@@ -29,12 +31,12 @@ namespace argos {
       }
       SCleanupThreadData& sData =
          *reinterpret_cast<SCleanupThreadData*>(p_data);
-      pthread_mutex_unlock(sData.FetchTaskMutex);
       pthread_mutex_unlock(sData.StartSenseControlPhaseMutex);
       pthread_mutex_unlock(sData.StartActPhaseMutex);
       pthread_mutex_unlock(sData.StartPhysicsPhaseMutex);
       pthread_mutex_unlock(sData.StartMediaPhaseMutex);
       pthread_mutex_unlock(sData.StartEntityIterPhaseMutex);
+      pthread_mutex_unlock(sData.FetchTaskMutex);
    }
 
    void* LaunchThreadBalanceLength(void* p_data) {
@@ -64,6 +66,33 @@ namespace argos {
    /****************************************/
    /****************************************/
 
+   /** Target duration of a chunk of tasks, in nanoseconds */
+   static const UInt64 TARGET_CHUNK_DURATION_NS = 20000;
+
+   /** Returns the value of the monotonic clock, in nanoseconds */
+   static UInt64 GetMonotonicTimeNs() {
+      ::timespec tTime;
+      ::clock_gettime(CLOCK_MONOTONIC, &tTime);
+      return static_cast<UInt64>(tTime.tv_sec) * 1000000000ULL + tTime.tv_nsec;
+   }
+
+   /****************************************/
+   /****************************************/
+
+   CSpaceMultiThreadBalanceLength::CSpaceMultiThreadBalanceLength(bool b_guided_chunking) :
+      m_ptThreads(nullptr),
+      m_psThreadData(nullptr),
+      m_bGuidedChunking(b_guided_chunking),
+      m_unTaskIndex(0),
+      m_unSenseControlPhaseMinChunkSize(1),
+      m_unActPhaseMinChunkSize(1),
+      m_unPhysicsPhaseMinChunkSize(1),
+      m_unMediaPhaseMinChunkSize(1),
+      m_unEntityIterPhaseMinChunkSize(1) {}
+
+   /****************************************/
+   /****************************************/
+
    void CSpaceMultiThreadBalanceLength::Init(TConfigurationNode& t_tree) {
       /* Initialize the space */
       CSpace::Init(t_tree);
@@ -83,8 +112,7 @@ namespace argos {
          (nErrors = pthread_cond_init(&m_tStartActPhaseCond, nullptr)) ||
          (nErrors = pthread_cond_init(&m_tStartPhysicsPhaseCond, nullptr)) ||
          (nErrors = pthread_cond_init(&m_tStartMediaPhaseCond, nullptr)) ||
-         (nErrors = pthread_cond_init(&m_tStartEntityIterPhaseCond, nullptr)) ||
-         (nErrors = pthread_cond_init(&m_tFetchTaskCond, nullptr))) {
+         (nErrors = pthread_cond_init(&m_tStartEntityIterPhaseCond, nullptr))) {
          THROW_ARGOSEXCEPTION("Error creating thread conditionals " << ::strerror(nErrors));
       }
       /* Reset the idle thread count */
@@ -140,7 +168,6 @@ namespace argos {
       pthread_cond_destroy(&m_tStartPhysicsPhaseCond);
       pthread_cond_destroy(&m_tStartMediaPhaseCond);
       pthread_cond_destroy(&m_tStartEntityIterPhaseCond);
-      pthread_cond_destroy(&m_tFetchTaskCond);
 
       /* Destroy the base space */
       CSpace::Destroy();
@@ -163,10 +190,63 @@ namespace argos {
    /****************************************/
    /****************************************/
 
+   void CSpaceMultiThreadBalanceLength::TuneChunkSize(size_t& un_min_chunk_size,
+                                                      size_t un_tasks,
+                                                      UInt64 un_elapsed_ns) {
+      if(un_tasks == 0) return;
+      /* Time spent on a single task, summed across threads */
+      UInt64 unTaskNs =
+         un_elapsed_ns * CSimulator::GetInstance().GetNumThreads() / un_tasks;
+      /* Number of tasks that fit in the target chunk duration */
+      size_t unChunkSize =
+         unTaskNs > 0 ?
+         static_cast<size_t>(TARGET_CHUNK_DURATION_NS / unTaskNs) :
+         un_tasks;
+      /* Never give a thread more than its fair share, never less than a task */
+      size_t unMaxChunkSize = un_tasks / CSimulator::GetInstance().GetNumThreads();
+      un_min_chunk_size = Max<size_t>(1, Min(unChunkSize, unMaxChunkSize));
+   }
+
+   /****************************************/
+   /****************************************/
+
+   bool CSpaceMultiThreadBalanceLength::ClaimChunk(size_t un_tot_tasks,
+                                                   size_t un_min_chunk_size,
+                                                   CRange<size_t>& c_chunk) {
+      if(!m_bGuidedChunking) {
+         /* One task at a time */
+         pthread_mutex_lock(&m_tFetchTaskMutex);
+         size_t unTask = m_unTaskIndex.load(std::memory_order_relaxed);
+         bool bClaimed = (unTask < un_tot_tasks);
+         if(bClaimed) {
+            m_unTaskIndex.store(unTask + 1, std::memory_order_relaxed);
+            c_chunk.Set(unTask, unTask + 1);
+         }
+         pthread_mutex_unlock(&m_tFetchTaskMutex);
+         return bClaimed;
+      }
+      /* Guided scheduling: the chunk shrinks with the remaining tasks */
+      size_t unNext = m_unTaskIndex.load(std::memory_order_relaxed);
+      if(unNext >= un_tot_tasks) return false;
+      size_t unChunkSize = Max(un_min_chunk_size,
+                               (un_tot_tasks - unNext) /
+                               (2 * CSimulator::GetInstance().GetNumThreads()));
+      /* The actual claim */
+      size_t unStart = m_unTaskIndex.fetch_add(unChunkSize, std::memory_order_relaxed);
+      if(unStart >= un_tot_tasks) return false;
+      c_chunk.Set(unStart, Min(unStart + unChunkSize, un_tot_tasks));
+      return true;
+   }
+
+   /****************************************/
+   /****************************************/
+
 #define MAIN_START_PHASE(PHASE)                             \
+   UInt64 un ## PHASE ## PhaseStart =                       \
+      m_bGuidedChunking ? GetMonotonicTimeNs() : 0;         \
    pthread_mutex_lock(&m_tStart ## PHASE ## PhaseMutex);    \
    m_un ## PHASE ## PhaseIdleCounter = 0;                   \
-   m_unTaskIndex = 0;                                       \
+   m_unTaskIndex.store(0, std::memory_order_relaxed);       \
    pthread_cond_broadcast(&m_tStart ## PHASE ## PhaseCond); \
    pthread_mutex_unlock(&m_tStart ## PHASE ## PhaseMutex);
 
@@ -177,10 +257,18 @@ namespace argos {
    }                                                                                        \
    pthread_mutex_unlock(&m_tStart ## PHASE ## PhaseMutex);
 
+#define MAIN_TUNE_CHUNK_SIZE(PHASE, TASKVEC)                   \
+   if(m_bGuidedChunking) {                                     \
+      TuneChunkSize(m_un ## PHASE ## PhaseMinChunkSize,        \
+                    (TASKVEC).size(),                          \
+                    GetMonotonicTimeNs() - un ## PHASE ## PhaseStart); \
+   }
+
    void CSpaceMultiThreadBalanceLength::UpdateControllableEntitiesAct() {
       /* Act phase */
       MAIN_START_PHASE(Act);
       MAIN_WAIT_FOR_END_OF(Act);
+      MAIN_TUNE_CHUNK_SIZE(Act, m_vecControllableEntities);
    }
 
    /****************************************/
@@ -190,6 +278,7 @@ namespace argos {
       /* Physics phase */
       MAIN_START_PHASE(Physics);
       MAIN_WAIT_FOR_END_OF(Physics);
+      MAIN_TUNE_CHUNK_SIZE(Physics, *m_ptPhysicsEngines);
       /* Perform entity transfer from engine to engine, if needed */
       for(size_t i = 0; i < m_ptPhysicsEngines->size(); ++i) {
          if((*m_ptPhysicsEngines)[i]->IsEntityTransferNeeded()) {
@@ -203,8 +292,11 @@ namespace argos {
 
    void CSpaceMultiThreadBalanceLength::UpdateMedia() {
       /* Media phase */
+      BeginMediaUpdate();
       MAIN_START_PHASE(Media);
       MAIN_WAIT_FOR_END_OF(Media);
+      MAIN_TUNE_CHUNK_SIZE(Media, m_vecMediaTasks);
+      EndMediaUpdate();
    }
 
    /****************************************/
@@ -216,8 +308,19 @@ namespace argos {
      /* Iterate over all robots in the swarm */
      MAIN_START_PHASE(EntityIter);
      MAIN_WAIT_FOR_END_OF(EntityIter);
+     /* When aborting the wait, no task was executed */
+     if(ControllableEntityIterationEnabled()) {
+        MAIN_TUNE_CHUNK_SIZE(EntityIter, m_vecControllableEntities);
+     }
    } /* IterateOverControllableEntities() */
 
+   /****************************************/
+   /****************************************/
+
+   void CSpaceMultiThreadBalanceLength::ControllableEntityIterationWaitAbort() {
+     IterateOverControllableEntities(nullptr);
+   } /* ControllableEntityIterationWaitAbort() */
+
 
    /****************************************/
    /****************************************/
@@ -226,6 +329,7 @@ namespace argos {
       /* Sense/control phase */
       MAIN_START_PHASE(SenseControl);
       MAIN_WAIT_FOR_END_OF(SenseControl);
+      MAIN_TUNE_CHUNK_SIZE(SenseControl, m_vecControllableEntities);
    }
 
    /****************************************/
@@ -262,20 +366,19 @@ namespace argos {
 
 #define THREAD_PERFORM_TASK(PHASE, TASKVEC, CONDITION, SNIPPET)     \
    while(1) {                                                       \
-      pthread_mutex_lock(&m_tFetchTaskMutex);                       \
-      if((CONDITION) && m_unTaskIndex < (TASKVEC).size()) {         \
-         unTaskIndex = m_unTaskIndex;                               \
-         ++m_unTaskIndex;                                           \
-         pthread_mutex_unlock(&m_tFetchTaskMutex);                  \
+      if((CONDITION) &&                                             \
+         ClaimChunk((TASKVEC).size(),                               \
+                    m_un ## PHASE ## PhaseMinChunkSize,             \
+                    cChunk)) {                                      \
          pthread_testcancel();                                      \
-         {                                                          \
+         for(unTaskIndex = cChunk.GetMin();                         \
+             unTaskIndex < cChunk.GetMax();                         \
+             ++unTaskIndex) {                                       \
             SNIPPET;                                                \
          }                                                          \
          pthread_testcancel();                                      \
       }                                                             \
       else {                                                        \
-         pthread_mutex_unlock(&m_tFetchTaskMutex);                  \
-         pthread_testcancel();                                      \
          pthread_mutex_lock(&m_tStart ## PHASE ## PhaseMutex);      \
          ++m_un ## PHASE ## PhaseIdleCounter;                       \
          pthread_cond_broadcast(&m_tStart ## PHASE ## PhaseCond);   \
@@ -289,6 +392,8 @@ namespace argos {
    void CSpaceMultiThreadBalanceLength::SlaveThread() {
       /* Task index */
       size_t unTaskIndex;
+      /* Chunk of tasks claimed by this thread */
+      CRange<size_t> cChunk;
       while(1) {
          THREAD_WAIT_FOR_START_OF(Act);
          THREAD_PERFORM_TASK(
@@ -302,14 +407,14 @@ namespace argos {
             Physics,
             *m_ptPhysicsEngines,
             true,
-            (*m_ptPhysicsEngines)[unTaskIndex]->Update();
+            UpdatePhysicsEngine(unTaskIndex);
             );
          THREAD_WAIT_FOR_START_OF(Media);
          THREAD_PERFORM_TASK(
             Media,
-            *m_ptMedia,
+            m_vecMediaTasks,
             true,
-            (*m_ptMedia)[unTaskIndex]->Update();
+            UpdateMediaTask(unTaskIndex);
             );
          /* loop functions PreStep() */
          THREAD_WAIT_FOR_START_OF(EntityIter);
@@ -16,6 +16,7 @@ namespace argos {
 }
 
 #include <argos3/core/simulator/space/space.h>
+#include <atomic>
 
 namespace argos {
 
@@ -23,7 +24,12 @@ namespace argos {
 
    public:
 
-      CSpaceMultiThreadBalanceLength() {}
+      /**
+       * Class constructor.
+       * @param b_guided_chunking <tt>true</tt> to claim tasks in guided chunks
+       * instead of one at a time.
+       */
+      CSpaceMultiThreadBalanceLength(bool b_guided_chunking = false);
       virtual ~CSpaceMultiThreadBalanceLength() {}
 
       virtual void Init(TConfigurationNode& t_tree);
@@ -41,6 +47,36 @@ namespace argos {
 
       void StartThreads();
       void SlaveThread();
+
+      /**
+       * Tunes the minimum chunk size of a phase.
+       * The chunk size is chosen so that a chunk takes roughly the same time,
+       * given the per-task duration measured in the last run of the phase.
+       * @param un_min_chunk_size The minimum chunk size to update.
+       * @param un_tasks The number of tasks executed in the phase.
+       * @param un_elapsed_ns The wall-clock duration of the phase, in nanoseconds.
+       */
+      void TuneChunkSize(size_t& un_min_chunk_size,
+                         size_t un_tasks,
+                         UInt64 un_elapsed_ns);
+
+      /**
+       * Claims the next chunk of tasks.
+       * By default, a chunk is a single task claimed under a mutex.
+       * With guided chunking, chunks are claimed with an atomic fetch-add:
+       * large chunks at the beginning of a phase, shrinking down to the
+       * minimum size at its end.
+       * @param un_tot_tasks The total number of tasks in the phase.
+       * @param un_min_chunk_size The minimum chunk size.
+       * @param c_chunk The claimed chunk.
+       * @return <tt>false</tt> if no tasks are left.
+       */
+      bool ClaimChunk(size_t un_tot_tasks,
+                      size_t un_min_chunk_size,
+                      CRange<size_t>& c_chunk);
+
+      virtual void ControllableEntityIterationWaitAbort();
+
       friend void* LaunchThreadBalanceLength(void* p_data);
 
    private:
@@ -62,8 +98,14 @@ namespace argos {
       /** Data structure needed to launch the threads */
       SThreadLaunchData** m_psThreadData;
 
-      /** All tasks in arrays. This is the current array index. */
-      size_t m_unTaskIndex;
+      /** True if the tasks are claimed in guided chunks */
+      bool m_bGuidedChunking;
+
+      /** All tasks in arrays. This is the index of the next task to claim. */
+      std::atomic<size_t> m_unTaskIndex;
+
+      /** Mutex to claim a task when guided chunking is off */
+      pthread_mutex_t m_tFetchTaskMutex;
 
       /** Mutex for the start of the sense/control phase */
       pthread_mutex_t m_tStartSenseControlPhaseMutex;
@@ -75,8 +117,6 @@ namespace argos {
       pthread_mutex_t m_tStartMediaPhaseMutex;
       /** Mutex for the start of the robot iteration phase */
       pthread_mutex_t m_tStartEntityIterPhaseMutex;
-      /** Mutex to fetch a task from the dispatcher */
-      pthread_mutex_t m_tFetchTaskMutex;
 
       /** Conditional for the start of the sense/control phase */
       pthread_cond_t m_tStartSenseControlPhaseCond;
@@ -88,8 +128,6 @@ namespace argos {
       pthread_cond_t m_tStartMediaPhaseCond;
       /** Conditional for the start of the robot iteration phase */
       pthread_cond_t m_tStartEntityIterPhaseCond;
-      /** Conditional controlling task fetching from the dispatcher */
-      pthread_cond_t m_tFetchTaskCond;
 
       /** How many threads are idle in the sense/control phase */
       UInt32 m_unSenseControlPhaseIdleCounter;
@@ -102,6 +140,17 @@ namespace argos {
       /** How many threads are idle in the media phase */
       UInt32 m_unEntityIterPhaseIdleCounter;
 
+      /** Minimum chunk size for the sense/control phase */
+      size_t m_unSenseControlPhaseMinChunkSize;
+      /** Minimum chunk size for the act phase */
+      size_t m_unActPhaseMinChunkSize;
+      /** Minimum chunk size for the physics phase */
+      size_t m_unPhysicsPhaseMinChunkSize;
+      /** Minimum chunk size for the media phase */
+      size_t m_unMediaPhaseMinChunkSize;
+      /** Minimum chunk size for the robot iteration phase */
+      size_t m_unEntityIterPhaseMinChunkSize;
+
    };
 
 }
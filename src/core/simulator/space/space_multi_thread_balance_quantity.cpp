@@ -176,8 +176,8 @@ namespace argos {
    /****************************************/
 
 #define MAIN_SEND_GO_FOR_PHASE(PHASE)                       \
-   LOG.Flush();                                             \
-   LOGERR.Flush();                                          \
+   LOG.RequestFlush();                                      \
+   LOGERR.RequestFlush();                                   \
    pthread_mutex_lock(&m_t ## PHASE ## ConditionalMutex);   \
    m_un ## PHASE ## PhaseDoneCounter = 0;                   \
    pthread_cond_broadcast(&m_t ## PHASE ## Conditional);    \
@@ -217,8 +217,10 @@ namespace argos {
 
    void CSpaceMultiThreadBalanceQuantity::UpdateMedia() {
       /* Update the media */
+      BeginMediaUpdate();
       MAIN_SEND_GO_FOR_PHASE(Media);
       MAIN_WAIT_FOR_PHASE_END(Media);
+      EndMediaUpdate();
    }
 
    /****************************************/
@@ -318,9 +320,6 @@ namespace argos {
       /* Id range for the physics engines assigned to this thread */
       CRange<size_t> cPhysicsRange = CalculatePluginRangeForThread(unId,
                                                                    m_ptPhysicsEngines->size());
-      /* Id range for the media assigned to this thread */
-      CRange<size_t> cMediaRange = CalculatePluginRangeForThread(unId,
-                                                                 m_ptMedia->size());
 
       /*
        * Id range for the entities to update assigned to this thread. Can change
@@ -338,7 +337,7 @@ namespace argos {
         UpdateThreadPhysics(cPhysicsRange);
 
         /* Update media assigned to this thread */
-        UpdateThreadMedia(cMediaRange);
+        UpdateThreadMedia(un_id);
 
         /* loop functions PreStep() iteration (maybe) */
         UpdateThreadIterateOverEntities(un_id, cEntityRange);
@@ -391,7 +390,7 @@ namespace argos {
      if (c_range.GetSpan() > 0) {
        /* This thread has engines, update them */
        for (size_t i = c_range.GetMin(); i < c_range.GetMax(); ++i) {
-         (*m_ptPhysicsEngines)[i]->Update();
+         UpdatePhysicsEngine(i);
        }
        pthread_testcancel();
        THREAD_SIGNAL_PHASE_DONE(Physics);
@@ -405,14 +404,16 @@ namespace argos {
    /****************************************/
    /****************************************/
 
-   void CSpaceMultiThreadBalanceQuantity::UpdateThreadMedia(
-       const CRange<size_t>& c_range) {
+   void CSpaceMultiThreadBalanceQuantity::UpdateThreadMedia(UInt32 un_id) {
      /* Update media, if this thread has been assigned to them */
      THREAD_WAIT_FOR_GO_SIGNAL(Media);
-     if(c_range.GetSpan() > 0) {
-       /* This thread has media, update them */
-       for(size_t i = c_range.GetMin(); i < c_range.GetMax(); ++i) {
-         (*m_ptMedia)[i]->Update();
+     /* The media tasks can change at every step */
+     CRange<size_t> cRange = CalculatePluginRangeForThread(un_id,
+                                                           m_vecMediaTasks.size());
+     if(cRange.GetSpan() > 0) {
+       /* This thread has media tasks, execute them */
+       for(size_t i = cRange.GetMin(); i < cRange.GetMax(); ++i) {
+         UpdateMediaTask(i);
        }
        pthread_testcancel();
        THREAD_SIGNAL_PHASE_DONE(Media);
@@ -103,10 +103,11 @@ namespace argos {
       void UpdateThreadPhysics(const CRange<size_t>& c_range);
 
      /**
-      * \brief Update the media engines assigned to this thread (static
-      * assignment throughout simulation).
+      * \brief Execute the media tasks assigned to this thread. The tasks are
+      * prepared at every step by CSpace::BeginMediaUpdate(), so the
+      * assignment is recalculated at every step.
       */
-     void UpdateThreadMedia(const CRange<size_t>& c_range);
+     void UpdateThreadMedia(UInt32 un_id);
 
      /**
       * \brief (Maybe) iterate over entities as called from
@@ -0,0 +1,409 @@
+/**
+ * @file <argos3/core/simulator/space/space_multi_thread_work_stealing.cpp>
+ */
+
+#include "space_multi_thread_work_stealing.h"
+#include <argos3/core/simulator/simulator.h>
+#include <argos3/core/utility/profiler/profiler.h>
+#include <cstring>
+#include <unistd.h>
+
+namespace argos {
+
+   /****************************************/
+   /****************************************/
+
+   /** Busy-wait iterations of the barrier before a thread parks */
+   static const UInt32 BARRIER_SPINS = 4000;
+
+   /** Target number of chunks per thread for the controllable entity phases */
+   static const size_t ENTITY_CHUNKS_PER_THREAD = 8;
+
+   /** Hint to the processor that we are busy-waiting */
+   static inline void CPURelax() {
+#if defined(__x86_64__) || defined(__i386__)
+      __builtin_ia32_pause();
+#elif defined(__aarch64__)
+      asm volatile("yield" ::: "memory");
+#endif
+   }
+
+   /****************************************/
+   /****************************************/
+
+   CSpaceMultiThreadWorkStealing::CBarrier::CBarrier() :
+      m_unParticipants(0),
+      m_unSpins(0),
+      m_unRemaining(0),
+      m_bSense(false),
+      m_unParked(0) {
+      int nErrors;
+      if((nErrors = pthread_mutex_init(&m_tParkMutex, nullptr)) ||
+         (nErrors = pthread_cond_init(&m_tParkCond, nullptr))) {
+         THROW_ARGOSEXCEPTION("Error creating barrier mutex/conditional " << ::strerror(nErrors));
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   CSpaceMultiThreadWorkStealing::CBarrier::~CBarrier() {
+      pthread_mutex_destroy(&m_tParkMutex);
+      pthread_cond_destroy(&m_tParkCond);
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CSpaceMultiThreadWorkStealing::CBarrier::Init(UInt32 un_participants,
+                                                      UInt32 un_spins) {
+      m_unParticipants = un_participants;
+      m_unSpins = un_spins;
+      m_unRemaining.store(un_participants);
+      m_bSense.store(false);
+      m_unParked.store(0);
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CSpaceMultiThreadWorkStealing::CBarrier::Wait(bool& b_local_sense) {
+      b_local_sense = !b_local_sense;
+      if(m_unRemaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+         /* Last to arrive: reset the counter and release everybody */
+         m_unRemaining.store(m_unParticipants, std::memory_order_relaxed);
+         m_bSense.store(b_local_sense, std::memory_order_seq_cst);
+         /* Wake up the parked threads, if any */
+         if(m_unParked.load(std::memory_order_seq_cst) > 0) {
+            pthread_mutex_lock(&m_tParkMutex);
+            pthread_cond_broadcast(&m_tParkCond);
+            pthread_mutex_unlock(&m_tParkMutex);
+         }
+      }
+      else {
+         /* Spin for a while */
+         for(UInt32 i = 0; i < m_unSpins; ++i) {
+            if(m_bSense.load(std::memory_order_acquire) == b_local_sense) return;
+            CPURelax();
+         }
+         /* Park */
+         pthread_mutex_lock(&m_tParkMutex);
+         m_unParked.fetch_add(1, std::memory_order_seq_cst);
+         while(m_bSense.load(std::memory_order_seq_cst) != b_local_sense) {
+            pthread_cond_wait(&m_tParkCond, &m_tParkMutex);
+         }
+         m_unParked.fetch_sub(1, std::memory_order_relaxed);
+         pthread_mutex_unlock(&m_tParkMutex);
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CSpaceMultiThreadWorkStealing::SChunkDeque::Set(UInt32 un_head,
+                                                        UInt32 un_tail) {
+      Bounds.store((static_cast<UInt64>(un_tail) << 32) | un_head,
+                   std::memory_order_relaxed);
+   }
+
+   /****************************************/
+   /****************************************/
+
+   bool CSpaceMultiThreadWorkStealing::SChunkDeque::PopFront(UInt32& un_chunk) {
+      UInt64 unBounds = Bounds.load(std::memory_order_relaxed);
+      while(true) {
+         auto unHead = static_cast<UInt32>(unBounds);
+         auto unTail = static_cast<UInt32>(unBounds >> 32);
+         if(unHead >= unTail) return false;
+         if(Bounds.compare_exchange_weak(unBounds,
+                                         (static_cast<UInt64>(unTail) << 32) | (unHead + 1),
+                                         std::memory_order_relaxed)) {
+            un_chunk = unHead;
+            return true;
+         }
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   bool CSpaceMultiThreadWorkStealing::SChunkDeque::PopBack(UInt32& un_chunk) {
+      UInt64 unBounds = Bounds.load(std::memory_order_relaxed);
+      while(true) {
+         auto unHead = static_cast<UInt32>(unBounds);
+         auto unTail = static_cast<UInt32>(unBounds >> 32);
+         if(unHead >= unTail) return false;
+         if(Bounds.compare_exchange_weak(unBounds,
+                                         (static_cast<UInt64>(unTail - 1) << 32) | unHead,
+                                         std::memory_order_relaxed)) {
+            un_chunk = unTail - 1;
+            return true;
+         }
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void* LaunchThreadWorkStealing(void* p_data) {
+      /* Set up thread-safe buffers for this new thread */
+      LOG.AddThreadSafeBuffer();
+      LOGERR.AddThreadSafeBuffer();
+      /* Get a handle to the thread launch data */
+      auto* psData = reinterpret_cast<CSpaceMultiThreadWorkStealing::SThreadLaunchData*>(p_data);
+      psData->Space->WorkerThread(psData->ThreadId);
+      /* Collect profiling data, if needed */
+      CSimulator& cSimulator = CSimulator::GetInstance();
+      if(cSimulator.IsProfiling()) {
+         cSimulator.GetProfiler().CollectThreadResourceUsage();
+      }
+      return nullptr;
+   }
+
+   /****************************************/
+   /****************************************/
+
+   CSpaceMultiThreadWorkStealing::CSpaceMultiThreadWorkStealing() :
+      m_ptThreads(nullptr),
+      m_psThreadData(nullptr),
+      m_psDeques(nullptr),
+      m_bMainSense(false),
+      m_ePhase(PHASE_ACT),
+      m_unPhaseTasks(0),
+      m_unPhaseChunkSize(1) {}
+
+   /****************************************/
+   /****************************************/
+
+   void CSpaceMultiThreadWorkStealing::Init(TConfigurationNode& t_tree) {
+      /* Initialize the space */
+      CSpace::Init(t_tree);
+      /*
+       * The main thread takes part in the barrier together with the workers.
+       * Spinning only pays off if every participant can run on its own core.
+       */
+      UInt32 unParticipants = CSimulator::GetInstance().GetNumThreads() + 1;
+      long nCores = ::sysconf(_SC_NPROCESSORS_ONLN);
+      m_cBarrier.Init(unParticipants,
+                      (nCores > 0 && unParticipants <= static_cast<UInt32>(nCores)) ?
+                      BARRIER_SPINS : 0);
+      m_bMainSense = false;
+      /* Create the deques */
+      m_psDeques = new SChunkDeque[CSimulator::GetInstance().GetNumThreads()];
+      /* Start threads */
+      StartThreads();
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CSpaceMultiThreadWorkStealing::Destroy() {
+      /* Tell the worker threads to quit */
+      int nErrors;
+      if(m_ptThreads != nullptr) {
+         m_ePhase = PHASE_EXIT;
+         m_cBarrier.Wait(m_bMainSense);
+         for(UInt32 i = 0; i < CSimulator::GetInstance().GetNumThreads(); ++i) {
+            if((nErrors = pthread_join(m_ptThreads[i], nullptr))) {
+               THROW_ARGOSEXCEPTION("Error joining threads " << ::strerror(nErrors));
+            }
+         }
+      }
+      delete[] m_ptThreads;
+      m_ptThreads = nullptr;
+      /* Destroy the thread launch info */
+      if(m_psThreadData != nullptr) {
+         for(UInt32 i = 0; i < CSimulator::GetInstance().GetNumThreads(); ++i) {
+            delete m_psThreadData[i];
+         }
+      }
+      delete[] m_psThreadData;
+      m_psThreadData = nullptr;
+      delete[] m_psDeques;
+      m_psDeques = nullptr;
+      /* Destroy the base space */
+      CSpace::Destroy();
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CSpaceMultiThreadWorkStealing::UpdateControllableEntitiesAct() {
+      RunPhase(PHASE_ACT,
+               m_vecControllableEntities.size(),
+               GetEntityChunkSize());
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CSpaceMultiThreadWorkStealing::UpdatePhysics() {
+      /* Physics engines are coarse tasks, one per chunk */
+      RunPhase(PHASE_PHYSICS, m_ptPhysicsEngines->size(), 1);
+      /* Perform entity transfer from engine to engine, if needed */
+      for(size_t i = 0; i < m_ptPhysicsEngines->size(); ++i) {
+         if((*m_ptPhysicsEngines)[i]->IsEntityTransferNeeded()) {
+            (*m_ptPhysicsEngines)[i]->TransferEntities();
+         }
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CSpaceMultiThreadWorkStealing::UpdateMedia() {
+      /* Media tasks are coarse, one per chunk */
+      BeginMediaUpdate();
+      RunPhase(PHASE_MEDIA, m_vecMediaTasks.size(), 1);
+      EndMediaUpdate();
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CSpaceMultiThreadWorkStealing::IterateOverControllableEntities(
+      const TControllableEntityIterCBType& c_cb) {
+      m_cbControllableEntityIter = c_cb;
+      if(ControllableEntityIterationEnabled()) {
+         RunPhase(PHASE_ENTITY_ITER,
+                  m_vecControllableEntities.size(),
+                  GetEntityChunkSize());
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CSpaceMultiThreadWorkStealing::UpdateControllableEntitiesSenseStep() {
+      RunPhase(PHASE_SENSE_CONTROL,
+               m_vecControllableEntities.size(),
+               GetEntityChunkSize());
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CSpaceMultiThreadWorkStealing::StartThreads() {
+      int nErrors;
+      /* Create the worker threads */
+      m_ptThreads = new pthread_t[CSimulator::GetInstance().GetNumThreads()];
+      m_psThreadData = new SThreadLaunchData*[CSimulator::GetInstance().GetNumThreads()];
+      for(UInt32 i = 0; i < CSimulator::GetInstance().GetNumThreads(); ++i) {
+         /* Create the struct with the info to launch the thread */
+         m_psThreadData[i] = new SThreadLaunchData(i, this);
+         /* Create the thread */
+         if((nErrors = pthread_create(m_ptThreads + i,
+                                      nullptr,
+                                      LaunchThreadWorkStealing,
+                                      reinterpret_cast<void*>(m_psThreadData[i])))) {
+            THROW_ARGOSEXCEPTION("Error creating thread: " << ::strerror(nErrors));
+         }
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CSpaceMultiThreadWorkStealing::RunPhase(EPhase e_phase,
+                                                size_t un_tasks,
+                                                size_t un_chunk_size) {
+      /* Nothing to do? Don't wake up the threads */
+      if(un_tasks == 0) return;
+      /* Set up the phase */
+      m_ePhase = e_phase;
+      m_unPhaseTasks = un_tasks;
+      m_unPhaseChunkSize = un_chunk_size;
+      /* Spread the chunks evenly across the deques */
+      size_t unThreads = CSimulator::GetInstance().GetNumThreads();
+      size_t unChunks = (un_tasks + un_chunk_size - 1) / un_chunk_size;
+      for(size_t i = 0; i < unThreads; ++i) {
+         m_psDeques[i].Set(static_cast<UInt32>( i    * unChunks / unThreads),
+                           static_cast<UInt32>((i+1) * unChunks / unThreads));
+      }
+      /* Start the phase and wait for its end */
+      m_cBarrier.Wait(m_bMainSense);
+      m_cBarrier.Wait(m_bMainSense);
+   }
+
+   /****************************************/
+   /****************************************/
+
+   size_t CSpaceMultiThreadWorkStealing::GetEntityChunkSize() const {
+      size_t unChunkSize =
+         m_vecControllableEntities.size() /
+         (CSimulator::GetInstance().GetNumThreads() * ENTITY_CHUNKS_PER_THREAD);
+      return unChunkSize > 0 ? unChunkSize : 1;
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CSpaceMultiThreadWorkStealing::ExecuteChunk(UInt32 un_chunk) {
+      size_t unStart = un_chunk * m_unPhaseChunkSize;
+      size_t unEnd = Min(unStart + m_unPhaseChunkSize, m_unPhaseTasks);
+      switch(m_ePhase) {
+         case PHASE_ACT:
+            for(size_t i = unStart; i < unEnd; ++i) {
+               if(m_vecControllableEntities[i]->IsEnabled())
+                  m_vecControllableEntities[i]->Act();
+            }
+            break;
+         case PHASE_PHYSICS:
+            for(size_t i = unStart; i < unEnd; ++i) {
+               UpdatePhysicsEngine(i);
+            }
+            break;
+         case PHASE_MEDIA:
+            for(size_t i = unStart; i < unEnd; ++i) {
+               UpdateMediaTask(i);
+            }
+            break;
+         case PHASE_ENTITY_ITER:
+            for(size_t i = unStart; i < unEnd; ++i) {
+               m_cbControllableEntityIter(m_vecControllableEntities[i]);
+            }
+            break;
+         case PHASE_SENSE_CONTROL:
+            for(size_t i = unStart; i < unEnd; ++i) {
+               if(m_vecControllableEntities[i]->IsEnabled()) {
+                  m_vecControllableEntities[i]->Sense();
+                  m_vecControllableEntities[i]->ControlStep();
+               }
+            }
+            break;
+         default:
+            break;
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CSpaceMultiThreadWorkStealing::WorkerThread(UInt32 un_id) {
+      UInt32 unThreads = CSimulator::GetInstance().GetNumThreads();
+      bool bSense = false;
+      UInt32 unChunk;
+      while(true) {
+         /* Wait for the start of the next phase */
+         m_cBarrier.Wait(bSense);
+         if(m_ePhase == PHASE_EXIT) return;
+         /* Consume the own deque */
+         while(m_psDeques[un_id].PopFront(unChunk)) {
+            ExecuteChunk(unChunk);
+         }
+         /* Steal from the other deques until all are empty */
+         for(UInt32 i = 1; i < unThreads; ++i) {
+            SChunkDeque& sVictim = m_psDeques[(un_id + i) % unThreads];
+            while(sVictim.PopBack(unChunk)) {
+               ExecuteChunk(unChunk);
+            }
+         }
+         /* Signal the end of the phase */
+         m_cBarrier.Wait(bSense);
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+}
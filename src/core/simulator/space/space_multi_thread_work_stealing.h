@@ -0,0 +1,197 @@
+/**
+ * @file <argos3/core/simulator/space/space_multi_thread_work_stealing.h>
+ *
+ * @brief This file provides the definition of the work-stealing space.
+ *
+ * In this space, the tasks of each phase (controllable entities, physics
+ * engines, media) are split into chunks. At the beginning of a phase, every
+ * thread receives a contiguous set of chunks in its own deque. A thread first
+ * consumes its own deque from the front, and when it is empty it steals chunks
+ * from the back of the deques of the other threads.
+ *
+ * Phases are separated by a sense-reversing barrier which spins for a short
+ * time before parking the thread on a condition variable. For short phases,
+ * this avoids most of the wakeup cost of the mutex/conditional handoffs used
+ * by the other multi-thread spaces.
+ */
+
+#ifndef SPACE_MULTI_THREAD_WORK_STEALING_H
+#define SPACE_MULTI_THREAD_WORK_STEALING_H
+
+#include <argos3/core/simulator/space/space.h>
+#include <atomic>
+#include <pthread.h>
+
+namespace argos {
+
+   class CSpaceMultiThreadWorkStealing : public CSpace {
+
+      /****************************************/
+      /****************************************/
+
+   public:
+
+      /**
+       * A sense-reversing barrier that spins briefly and then parks.
+       * Each participant keeps its own sense flag, which must be initialized
+       * to <tt>false</tt> and passed to every call of Wait().
+       */
+      class CBarrier {
+
+      public:
+
+         CBarrier();
+         ~CBarrier();
+
+         /**
+          * Initializes the barrier.
+          * @param un_participants The number of threads that call Wait() in each round.
+          * @param un_spins The number of busy-wait iterations before parking.
+          */
+         void Init(UInt32 un_participants,
+                   UInt32 un_spins);
+
+         /**
+          * Waits until all the participants have reached the barrier.
+          * @param b_local_sense The sense flag of the calling thread.
+          */
+         void Wait(bool& b_local_sense);
+
+      private:
+
+         /** Number of participants */
+         UInt32 m_unParticipants;
+         /** Number of busy-wait iterations before parking */
+         UInt32 m_unSpins;
+         /** Number of participants yet to arrive in this round */
+         alignas(64) std::atomic<UInt32> m_unRemaining;
+         /** The global sense, flipped by the last participant to arrive */
+         alignas(64) std::atomic<bool> m_bSense;
+         /** Number of participants currently parked */
+         std::atomic<UInt32> m_unParked;
+         /** Mutex for parked participants */
+         pthread_mutex_t m_tParkMutex;
+         /** Conditional for parked participants */
+         pthread_cond_t m_tParkCond;
+
+      };
+
+      /****************************************/
+      /****************************************/
+
+   private:
+
+      /** The phases executed by the worker threads */
+      enum EPhase {
+         PHASE_ACT = 0,
+         PHASE_PHYSICS,
+         PHASE_MEDIA,
+         PHASE_ENTITY_ITER,
+         PHASE_SENSE_CONTROL,
+         PHASE_EXIT
+      };
+
+      /**
+       * The chunk deque of a thread.
+       * The deque contains the chunk indices in [head,tail). Both bounds are
+       * packed in a single word, so that the owner (popping at the head) and
+       * the thieves (stealing at the tail) synchronize with a single CAS.
+       */
+      struct alignas(64) SChunkDeque {
+         std::atomic<UInt64> Bounds;
+
+         SChunkDeque() : Bounds(0) {}
+
+         void Set(UInt32 un_head, UInt32 un_tail);
+         bool PopFront(UInt32& un_chunk);
+         bool PopBack(UInt32& un_chunk);
+      };
+
+      /** Thread launch data */
+      struct SThreadLaunchData {
+         UInt32 ThreadId;
+         CSpaceMultiThreadWorkStealing* Space;
+
+         SThreadLaunchData(UInt32 un_thread_id,
+                           CSpaceMultiThreadWorkStealing* pc_space) :
+            ThreadId(un_thread_id),
+            Space(pc_space) {}
+      };
+
+      /****************************************/
+      /****************************************/
+
+   public:
+
+      CSpaceMultiThreadWorkStealing();
+      virtual ~CSpaceMultiThreadWorkStealing() {}
+
+      virtual void Init(TConfigurationNode& t_tree);
+      virtual void Destroy();
+
+      virtual void UpdateControllableEntitiesAct();
+      virtual void UpdatePhysics();
+      virtual void UpdateMedia();
+      virtual void UpdateControllableEntitiesSenseStep();
+      virtual void IterateOverControllableEntities(
+          const TControllableEntityIterCBType& c_cb);
+
+   private:
+
+      void StartThreads();
+
+      /**
+       * Executes a phase on the worker threads and waits for its end.
+       * @param e_phase The phase to execute.
+       * @param un_tasks The number of tasks in the phase.
+       * @param un_chunk_size The number of tasks in a chunk.
+       */
+      void RunPhase(EPhase e_phase,
+                    size_t un_tasks,
+                    size_t un_chunk_size);
+
+      /**
+       * Returns the chunk size for a phase over the controllable entities.
+       */
+      size_t GetEntityChunkSize() const;
+
+      /**
+       * Executes the tasks of the given chunk in the current phase.
+       */
+      void ExecuteChunk(UInt32 un_chunk);
+
+      void WorkerThread(UInt32 un_id);
+
+      friend void* LaunchThreadWorkStealing(void* p_data);
+
+   private:
+
+      /** The worker thread array */
+      pthread_t* m_ptThreads;
+
+      /** Data structure needed to launch the threads */
+      SThreadLaunchData** m_psThreadData;
+
+      /** The chunk deques, one per thread */
+      SChunkDeque* m_psDeques;
+
+      /** The barrier between the main thread and the workers */
+      CBarrier m_cBarrier;
+
+      /** The sense flag of the main thread */
+      bool m_bMainSense;
+
+      /** The current phase */
+      EPhase m_ePhase;
+
+      /** The number of tasks in the current phase */
+      size_t m_unPhaseTasks;
+
+      /** The number of tasks in a chunk in the current phase */
+      size_t m_unPhaseChunkSize;
+
+   };
+
+}
+
+#endif
@@ -10,6 +10,7 @@
 
 #include "space_no_threads.h"
 #include <argos3/core/simulator/simulator.h>
+#include <argos3/core/utility/profiler/tick_profiler.h>
 
 namespace argos {
 
@@ -29,7 +30,7 @@ namespace argos {
    void CSpaceNoThreads::UpdatePhysics() {
       /* Update the physics engines */
       for(size_t i = 0; i < m_ptPhysicsEngines->size(); ++i) {
-         (*m_ptPhysicsEngines)[i]->Update();
+         UpdatePhysicsEngine(i);
       }
       /* Perform entity transfer from engine to engine, if needed */
       for(size_t i = 0; i < m_ptPhysicsEngines->size(); ++i) {
@@ -44,6 +45,7 @@ namespace argos {
 
    void CSpaceNoThreads::UpdateMedia() {
       for(size_t i = 0; i < m_ptMedia->size(); ++i) {
+         ARGOS_PROFILE_ZONE(m_vecMediumZones[i]);
          (*m_ptMedia)[i]->Update();
       }
    }
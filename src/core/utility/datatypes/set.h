@@ -7,33 +7,22 @@
 #ifndef SET_H
 #define SET_H
 
+#include <algorithm>
 #include <cstddef>
+#include <cstring>
+#include <functional>
 #include <iterator>
+#include <type_traits>
+#include <utility>
 
 namespace argos {
 
-   /**
-    * The data container of CSet.
-    * @see CSet
-    */
-   template <class T>
-   struct SSetElement {
-      T Data;
-      SSetElement* Previous;
-      SSetElement* Next;
-      
-      SSetElement(const T& t_data,
-                  SSetElement* ps_prev = NULL,
-                  SSetElement* ps_next = NULL) :
-         Data(t_data),
-         Previous(ps_prev),
-         Next(ps_next) {}
-   };
-
    /**
     * The CSet iterator.
+    * The iterator type does not depend on the comparator of the set, so an
+    * iterator of <tt>CSet&lt;T&gt;</tt> can be used on a
+    * <tt>CSet&lt;T,C&gt;</tt>.
     * @see CSet
-    * @see SSetElement
     */
    template<class CONTAINED_TYPE, class REFERENCED_TYPE>
    class CSetIterator {
@@ -48,73 +37,90 @@ namespace argos {
 
    public:
 
-      CSetIterator(SSetElement<CONTAINED_TYPE>* ps_elem = NULL) :
-         m_psElem(ps_elem) {}
+      CSetIterator(CONTAINED_TYPE* pt_elem = NULL) :
+         m_ptElem(pt_elem) {}
 
       CSetIterator(const CSetIterator& c_it) :
-         m_psElem(c_it.m_psElem) {}
+         m_ptElem(c_it.m_ptElem) {}
 
       CSetIterator& operator=(const CSetIterator& c_it) {
          if(this != &c_it) {
-            m_psElem = c_it.m_psElem;
+            m_ptElem = c_it.m_ptElem;
          }
          return *this;
       }
 
       reference operator*() {
-         return m_psElem->Data;
+         return *m_ptElem;
       }
 
       pointer operator->() {
-         return &(m_psElem->Data);
+         return m_ptElem;
       }
 
       CSetIterator& operator++() {
-         m_psElem = m_psElem->Next;
+         ++m_ptElem;
          return *this;
       }
 
-      bool operator==(const CSetIterator& c_it) {
-         return (m_psElem == c_it.m_psElem);
+      CSetIterator operator++(int) {
+         CSetIterator cOld(*this);
+         ++m_ptElem;
+         return cOld;
+      }
+
+      bool operator==(const CSetIterator& c_it) const {
+         return (m_ptElem == c_it.m_ptElem);
       }
 
-      bool operator!=(const CSetIterator& c_it) {
-         return (m_psElem != c_it.m_psElem);
+      bool operator!=(const CSetIterator& c_it) const {
+         return (m_ptElem != c_it.m_ptElem);
       }
 
-      SSetElement<CONTAINED_TYPE>* m_psElem;
+      CONTAINED_TYPE* m_ptElem;
 
    };
 
    /**
-    * Defines a very simple double-linked list that stores unique elements.
+    * Defines a very simple sorted container that stores unique elements.
     * The interface of this class is STL-compatible, but internally it behaves
     * differently from standard containers. In fact, it only stores pointers to
     * objects, and never copies them like STL containers do. The pointers are used
-    * to decide whether an element is already present in the list or not. Internally,
-    * the list is ordered using the comparator C. By default, the comparator uses the
+    * to decide whether an element is already present in the set or not. Internally,
+    * the set is ordered using the comparator C. By default, the comparator uses the
     * pointer values.
-    * @see SSetElement
+    *
+    * The elements are kept in a contiguous sorted array. The first
+    * INLINE_CAPACITY elements are stored inside the set itself, so small sets
+    * never allocate; larger sets grow a heap buffer, which is kept by clear()
+    * and reused when the set is filled again. Insertions and removals shift
+    * the elements after the affected position, and invalidate all iterators.
     * @see CSetIterator
     */
    template <class T, class C = std::less<T> >
    class CSet {
 
+      static_assert(std::is_trivially_copyable<T>::value,
+                    "CSet can only store trivially copyable types, such as pointers");
+
    public:
 
       typedef CSetIterator<T, T> iterator;
 
       class const_iterator : public CSetIterator<T, const T> {
       public:
-         const_iterator(const iterator& c_it) : CSetIterator<T, const T>(c_it.m_psElem) {}
+         const_iterator(const iterator& c_it) : CSetIterator<T, const T>(c_it.m_ptElem) {}
          const_iterator& operator=(const iterator& c_it) {
-            CSetIterator<T, const T>::m_psElem = c_it.m_psElem;
+            CSetIterator<T, const T>::m_ptElem = c_it.m_ptElem;
             return *this;
          }
-         bool operator==(const iterator& c_it) { return (CSetIterator<T, const T>::m_psElem == c_it.m_psElem); }
-         bool operator!=(const iterator& c_it) { return (CSetIterator<T, const T>::m_psElem != c_it.m_psElem); }
+         bool operator==(const iterator& c_it) const { return (CSetIterator<T, const T>::m_ptElem == c_it.m_ptElem); }
+         bool operator!=(const iterator& c_it) const { return (CSetIterator<T, const T>::m_ptElem != c_it.m_ptElem); }
       };
 
+      /** The number of elements stored without allocating */
+      static constexpr size_t INLINE_CAPACITY = 8;
+
    public:
 
       /**
@@ -122,9 +128,9 @@ namespace argos {
        * Creates an empty set.
        */
       CSet() :
-         m_psFirst(NULL),
-         m_psLast(NULL),
-         m_unSize(0) {}
+         m_ptData(m_ptInline),
+         m_unSize(0),
+         m_unCapacity(INLINE_CAPACITY) {}
 
       /**
        * Class copy constructor.
@@ -132,17 +138,31 @@ namespace argos {
        * @param c_set The set to copy from.
        */
       CSet(const CSet& c_set) :
-         m_psFirst(NULL),
-         m_psLast(NULL),
-         m_unSize(0) {
+         m_ptData(m_ptInline),
+         m_unSize(0),
+         m_unCapacity(INLINE_CAPACITY) {
          *this = c_set;
       }
 
+      /**
+       * Class move constructor.
+       * Steals the heap buffer of the given set, if it has one.
+       * @param c_set The set to move from.
+       */
+      CSet(CSet&& c_set) :
+         m_ptData(m_ptInline),
+         m_unSize(0),
+         m_unCapacity(INLINE_CAPACITY) {
+         *this = std::move(c_set);
+      }
+
       /**
        * Class destructor.
        */
       ~CSet() {
-         clear();
+         if(m_ptData != m_ptInline) {
+            delete[] m_ptData;
+         }
       }
 
       /**
@@ -151,194 +171,124 @@ namespace argos {
        * @param c_set The set to copy from.
        */
       CSet& operator=(const CSet& c_set) {
-         /* Is the passed set a different set? */
          if(this != &c_set) {
-            /* Yes, copy from it */
-            /* First, erase this set's contents */
-            clear();
-            /* Is the other set empty? */
-            if(! c_set.empty()) {
-               /* Not empty, there's at least one element to copy */
-               /* Start by copying the size of the other set into this one */
-               m_unSize = c_set.m_unSize;
-               /* Create the first element */
-               m_psFirst = new SSetElement<T>(c_set.m_psFirst->Data);
-               /* Is the size of the other set 1? */
-               if(m_unSize == 1) {
-                  /* Yes, the first element is also the last one */
-                  m_psLast = m_psFirst;
-               }
-               else {
-                  /* There's more than just one element */
-                  /* Copy all the elements starting from the second */
-                  /* Current element on other set to be copied */
-                  SSetElement<T>* psCurElemOnOther = c_set.m_psFirst->Next;
-                  /* Last copied element on this set */
-                  SSetElement<T>* psLastElemOnThis = m_psFirst;
-                  /* Current element on this set being created */
-                  SSetElement<T>* psCurElemOnThis = NULL;
-                  /* Go on until we hit the end of the list on the other set */
-                  while(psCurElemOnOther != NULL) {
-                     /* Create a new element for this set, setting as previous psLastElemOnThis */
-                     psCurElemOnThis = new SSetElement<T>(psCurElemOnOther->Data, psLastElemOnThis);
-                     /* Set the next of psLastElemOnThis to the element just created */
-                     psLastElemOnThis->Next = psCurElemOnThis;
-                     /* Advance with the last element on this */
-                     psLastElemOnThis = psCurElemOnThis;
-                     /* Advance with the element to copy on the other set */
-                     psCurElemOnOther = psCurElemOnOther->Next;
-                  }
-                  /* At this point, psCurElemOnThis corresponds to the last element of the list */
-                  m_psLast = psCurElemOnThis;
+            m_unSize = 0;
+            Reserve(c_set.m_unSize);
+            ::memcpy(m_ptData, c_set.m_ptData, c_set.m_unSize * sizeof(T));
+            m_unSize = c_set.m_unSize;
+         }
+         return *this;
+      }
+
+      /**
+       * Move assignment operator.
+       * Substitutes the contents of this set with those of the passed one,
+       * which is left empty.
+       * @param c_set The set to move from.
+       */
+      CSet& operator=(CSet&& c_set) {
+         if(this != &c_set) {
+            if(c_set.m_ptData != c_set.m_ptInline) {
+               /* Take the heap buffer of the other set */
+               if(m_ptData != m_ptInline) {
+                  delete[] m_ptData;
                }
+               m_ptData = c_set.m_ptData;
+               m_unSize = c_set.m_unSize;
+               m_unCapacity = c_set.m_unCapacity;
+               c_set.m_ptData = c_set.m_ptInline;
+               c_set.m_unCapacity = INLINE_CAPACITY;
+            }
+            else {
+               /* The elements are inline, copy them */
+               *this = static_cast<const CSet&>(c_set);
             }
+            c_set.m_unSize = 0;
          }
          return *this;
       }
 
       /**
-       * Returns <tt>true</tt> if the list is empty.
-       * @return <tt>true</tt> if the list is empty.
+       * Returns <tt>true</tt> if the set is empty.
+       * @return <tt>true</tt> if the set is empty.
        */
       inline bool empty() const {
          return m_unSize == 0;
       }
 
       /**
-       * Returns the number of elements in the list.
-       * @return The number of elements in the list.
+       * Returns the number of elements in the set.
+       * @return The number of elements in the set.
        */
       inline size_t size() const {
          return m_unSize;
       }
 
       inline T& first() {
-         return m_psFirst->Data;
+         return m_ptData[0];
       }
 
       inline const T& first() const {
-         return m_psFirst->Data;
+         return m_ptData[0];
       }
 
       inline T& last() {
-         return m_psLast->Data;
+         return m_ptData[m_unSize - 1];
       }
 
       inline const T& last() const {
-         return m_psLast->Data;
+         return m_ptData[m_unSize - 1];
       }
 
       /**
-       * Inserts an element to the list.
-       * The element is inserted only if not already present in the list.
+       * Inserts an element to the set.
+       * The element is inserted only if not already present in the set.
        * @param t_element The element to insert.
        */
       void insert(const T& t_element, C comp = C()) {
-         /* Is the list empty? */
-         if(m_unSize == 0) {
-            /* Yes, the first and last element coincide */
-            m_psFirst = new SSetElement<T>(t_element);
-            m_psLast = m_psFirst;
-            m_unSize = 1;
-         }
-         else {
-            /* No, we have at least 1 element */
-            /* Search for the element in the list that will be the next
-               of the element to add */
-            SSetElement<T>* psNextElem = m_psFirst;
-            while(psNextElem != NULL &&
-                  comp(psNextElem->Data, t_element)) {
-               psNextElem = psNextElem->Next;
-            }
-            /* Did we get to the end of the list? */
-            if(psNextElem == NULL) {
-               /* Yes, add the new element after the last one */
-               SSetElement<T>* psNewElem = new SSetElement<T>(t_element, m_psLast);
-               m_psLast->Next = psNewElem;
-               m_psLast = psNewElem;
-               ++m_unSize;
-               return;
+         /* Fast path: the element goes at the end */
+         if(m_unSize == 0 || comp(m_ptData[m_unSize - 1], t_element)) {
+            if(m_unSize == m_unCapacity) {
+               Reserve(m_unCapacity * 2);
             }
-            /* Is the element already present? */
-            if(psNextElem->Data == t_element) {
-               /* Yes, nothing to add */
-               return;
-            }
-            /* Is the next element the first in the list? */
-            if(psNextElem == m_psFirst) {
-               /* Yes, we must add the new element as the new first */
-               SSetElement<T>* psNewElem = new SSetElement<T>(t_element, NULL, m_psFirst);
-               m_psFirst->Previous = psNewElem;
-               m_psFirst = psNewElem;
-               ++m_unSize;
-               return;
-            }
-            /* If we get here, it's because we have to add the new element in the middle */
-            SSetElement<T>* psNewElem = new SSetElement<T>(t_element, psNextElem->Previous, psNextElem);
-            psNextElem->Previous->Next = psNewElem;
-            psNextElem->Previous = psNewElem;
+            m_ptData[m_unSize] = t_element;
             ++m_unSize;
+            return;
          }
+         /* Search for the first element that is not smaller */
+         size_t unPos = LowerBound(t_element, comp);
+         /* Is the element already present? */
+         if(m_ptData[unPos] == t_element) {
+            /* Yes, nothing to add */
+            return;
+         }
+         /* Make room and add the element */
+         if(m_unSize == m_unCapacity) {
+            Reserve(m_unCapacity * 2);
+         }
+         ::memmove(m_ptData + unPos + 1,
+                   m_ptData + unPos,
+                   (m_unSize - unPos) * sizeof(T));
+         m_ptData[unPos] = t_element;
+         ++m_unSize;
       }
 
       /**
-       * Removes the passed element from the list.
+       * Removes the passed element from the set.
        * @param t_element The element to remove.
        */
       void erase(const T& t_element) {
-         /* Is the list empty? */
-         if(m_unSize == 0) {
-            /* Yes, nothing to do */
-            return;
-         }
-         /* Is the list composed of a single element? */
-         if(m_unSize == 1) {
-            /* Is that the element we want to eliminate? */
-            if(m_psFirst->Data == t_element) {
-               /* Yes, erase it! */
-               delete m_psFirst;
-               m_psFirst = NULL;
-               m_psLast = NULL;
-               m_unSize = 0;
-            }
-            return;
-         }
-         /* If we get here, it's because the trivial cases
-            don't apply */
-         /* Look for the passed element */
-         SSetElement<T>* psElem = find_impl(t_element);
-         /* Did we find it? */
-         if(psElem != NULL) {
-            /* Yes, let's erase it */
-            /* Are we removing the first element? */
-            if(psElem == m_psFirst) {
-               /* Yes, we need to update m_psFirst */
-               m_psFirst = m_psFirst->Next;
-               m_psFirst->Previous = NULL;
-               delete psElem;
-               --m_unSize;
-               return;
-            }
-            /* Are we removing the last element? */
-            if(psElem == m_psLast) {
-               /* Yes, we need to update m_psLast */
-               m_psLast = m_psLast->Previous;
-               m_psLast->Next = NULL;
-               delete psElem;
-               --m_unSize;
-               return;
-            }
-            /* If we get here, it's because we need to remove
-               an element in the middle */
-            psElem->Previous->Next = psElem->Next;
-            psElem->Next->Previous = psElem->Previous;
-            delete psElem;
+         size_t unPos = find_impl(t_element);
+         if(unPos < m_unSize) {
+            ::memmove(m_ptData + unPos,
+                      m_ptData + unPos + 1,
+                      (m_unSize - unPos - 1) * sizeof(T));
             --m_unSize;
          }
       }
 
       /**
-       * Removes the passed element from the list.
+       * Removes the passed element from the set.
        * @param t_it An iterator to the element to remove.
        */
       inline void erase(iterator& c_it) {
@@ -346,40 +296,20 @@ namespace argos {
       }
 
       /**
-       * Erases the contents of the list.
+       * Erases the contents of the set.
+       * The heap buffer, if any, is kept for later insertions.
        */
-      void clear() {
-         if(m_unSize == 0) {
-            return;
-         }
-         if(m_unSize == 1) {
-            delete m_psFirst;
-            m_psFirst = NULL;
-            m_psLast = NULL;
-            m_unSize = 0;
-            return;
-         }
-         SSetElement<T>* psCurElem = m_psFirst;
-         SSetElement<T>* psNextElem = psCurElem->Next;
-         while(psCurElem != NULL) {
-            delete psCurElem;
-            psCurElem = psNextElem;
-            if(psCurElem != NULL) {
-               psNextElem = psNextElem->Next;
-            }
-         }
-         m_psFirst = NULL;
-         m_psLast = NULL;
+      inline void clear() {
          m_unSize = 0;
       }
 
       /**
-       * Returns <tt>true</tt> if the given element is in the list.
+       * Returns <tt>true</tt> if the given element is in the set.
        * @param t_element The element to search for.
-       * @return <tt>true</tt> if the given element is in the list.
+       * @return <tt>true</tt> if the given element is in the set.
        */
       inline bool exists(const T& t_element) {
-         return find_impl(t_element) != NULL;
+         return find_impl(t_element) < m_unSize;
       }
 
       /**
@@ -387,49 +317,64 @@ namespace argos {
        * @return An iterator to the first element.
        */
       inline iterator begin() const {
-         return iterator(m_psFirst);
+         return iterator(m_ptData);
       }
 
       /**
-       * Returns an invalid iterator.
-       * @return An invalid iterator.
+       * Returns an iterator past the last element.
+       * @return An iterator past the last element.
        */
       inline iterator end() const {
-         return iterator();
+         return iterator(m_ptData + m_unSize);
       }
 
       /**
-       * Searches for an element in the list.
-       * @return An iterator to the element found.
+       * Searches for an element in the set.
+       * @return An iterator to the element found, or end().
        */
       inline iterator find(const T& t_element) {
-         return iterator(find_impl(t_element));
+         return iterator(m_ptData + find_impl(t_element));
       }
 
    private:
 
-      SSetElement<T>* find_impl(const T& t_element, C comp = C()) const {
-         if(m_psFirst == NULL) {
-            return NULL;
-         }
-         SSetElement<T>* psElem = m_psFirst;
-         while(psElem != NULL &&
-               comp(psElem->Data, t_element)) {
-            psElem = psElem->Next;
-         }
-         if(psElem == NULL) {
-            return NULL;
-         }
-         else {
-            return (psElem->Data == t_element) ? psElem : NULL;
+      /**
+       * Returns the position of the first element that is not smaller than
+       * the passed one.
+       */
+      inline size_t LowerBound(const T& t_element, C comp = C()) const {
+         return std::lower_bound(m_ptData, m_ptData + m_unSize, t_element, comp) - m_ptData;
+      }
+
+      /**
+       * Returns the position of the passed element, or size() if not found.
+       */
+      inline size_t find_impl(const T& t_element, C comp = C()) const {
+         size_t unPos = LowerBound(t_element, comp);
+         return (unPos < m_unSize && m_ptData[unPos] == t_element) ? unPos : m_unSize;
+      }
+
+      /**
+       * Makes sure the set can hold the given number of elements.
+       */
+      void Reserve(size_t un_capacity) {
+         if(un_capacity > m_unCapacity) {
+            T* ptData = new T[un_capacity];
+            ::memcpy(ptData, m_ptData, m_unSize * sizeof(T));
+            if(m_ptData != m_ptInline) {
+               delete[] m_ptData;
+            }
+            m_ptData = ptData;
+            m_unCapacity = un_capacity;
          }
       }
 
    private:
 
-      SSetElement<T>* m_psFirst;
-      SSetElement<T>* m_psLast;
+      T* m_ptData;
       size_t m_unSize;
+      size_t m_unCapacity;
+      T m_ptInline[INLINE_CAPACITY];
 
    };
 
@@ -5,6 +5,10 @@
  */
 
 #include "argos_log.h"
+#ifdef ARGOS_THREADSAFE_LOG
+#include <time.h>
+#include <unordered_map>
+#endif
 
 namespace argos {
 
@@ -12,4 +16,456 @@ namespace argos {
    CARGoSLog LOG(std::cout, SLogColor(ARGOS_LOG_ATTRIBUTE_BRIGHT, ARGOS_LOG_COLOR_GREEN));
    CARGoSLog LOGERR(std::cerr, SLogColor(ARGOS_LOG_ATTRIBUTE_BRIGHT, ARGOS_LOG_COLOR_RED));
 
+#ifdef ARGOS_THREADSAFE_LOG
+
+   /****************************************/
+   /****************************************/
+
+   /* The default size of the ring of a thread, in bytes */
+   static const size_t DEFAULT_BUFFER_SIZE = 64 * 1024;
+
+   /* How often the drain thread wakes up when nobody asks it to */
+   static const long DRAIN_PERIOD_NS = 20 * 1000 * 1000;
+
+   /*
+    * The number of logs whose buffers are found through a fixed slot; ARGoS
+    * itself creates two, LOG and LOGERR. The logs created when all the slots
+    * are taken find their buffers through a map instead.
+    */
+   static const size_t MAX_SLOTS = 16;
+
+   /* The id of a log that has no slot */
+   static const size_t NO_SLOT = MAX_SLOTS;
+
+   /* The buffer of the calling thread for the log with the given serial */
+   struct SThreadBufferSlot {
+      size_t Serial;
+      CARGoSLog::SThreadBuffer* Buffer;
+   };
+
+   /*
+    * The buffers of the calling thread, indexed by log id.
+    * A slot is taken again by a later log once its log is destroyed, so the
+    * serial tells whether the buffer belongs to the log asking for it.
+    * The array has no destructor, so that the objects destroyed at exit can
+    * still log.
+    */
+   static thread_local SThreadBufferSlot THREAD_BUFFERS[MAX_SLOTS] = {};
+
+   /*
+    * The buffers of the calling thread for the logs without a slot, by serial.
+    * Serials are never reused, so the entries of destroyed logs are never
+    * matched again.
+    */
+   typedef std::unordered_map<size_t, CARGoSLog::SThreadBuffer*> TThreadBufferMap;
+   static thread_local TThreadBufferMap* THREAD_BUFFER_MAP = nullptr;
+
+   /*
+    * Keeps the buffers of the calling thread alive while it runs, and releases
+    * them when it exits, so that they can be reused. A buffer whose log is
+    * already destroyed is freed then.
+    */
+   struct SThreadBufferOwner {
+      ~SThreadBufferOwner() {
+         for(size_t i = 0; i < Buffers.size(); ++i) {
+            Buffers[i]->Release();
+         }
+         Buffers.clear();
+         delete THREAD_BUFFER_MAP;
+         THREAD_BUFFER_MAP = nullptr;
+      }
+
+      std::vector<std::shared_ptr<CARGoSLog::SThreadBuffer> > Buffers;
+   };
+
+   static thread_local SThreadBufferOwner THREAD_BUFFER_OWNER;
+
+   /* The slots in use, one bit each; constant-initialized, as LOG and LOGERR are created before main() */
+   static std::atomic<size_t> SLOTS_IN_USE(0);
+
+   /* The serial of the next log; 0 marks an empty slot */
+   static std::atomic<size_t> NEXT_SERIAL(1);
+
+   /*
+    * Takes a free slot.
+    * Returns NO_SLOT if all the slots are taken.
+    */
+   static size_t TakeSlot() {
+      size_t unUsed = SLOTS_IN_USE.load(std::memory_order_relaxed);
+      for(;;) {
+         size_t unSlot = 0;
+         while(unSlot < MAX_SLOTS && (unUsed & (static_cast<size_t>(1) << unSlot)) != 0) ++unSlot;
+         if(unSlot == MAX_SLOTS) return NO_SLOT;
+         if(SLOTS_IN_USE.compare_exchange_weak(unUsed, unUsed | (static_cast<size_t>(1) << unSlot))) {
+            return unSlot;
+         }
+      }
+   }
+
+   /*
+    * Gives back a slot taken with TakeSlot().
+    */
+   static void ReleaseSlot(size_t un_slot) {
+      if(un_slot != NO_SLOT) {
+         SLOTS_IN_USE.fetch_and(~(static_cast<size_t>(1) << un_slot));
+      }
+   }
+
+   static size_t RoundUpToPowerOfTwo(size_t un_size) {
+      size_t unResult = 1;
+      while(unResult < un_size) unResult <<= 1;
+      return unResult;
+   }
+
+   /****************************************/
+   /****************************************/
+
+   CARGoSLog::SThreadBuffer::CMessageBuffer::CMessageBuffer() :
+      m_vecData(256) {
+      setp(m_vecData.data(), m_vecData.data() + m_vecData.size());
+   }
+
+   /****************************************/
+   /****************************************/
+
+   CARGoSLog::SThreadBuffer::CMessageBuffer::int_type CARGoSLog::SThreadBuffer::CMessageBuffer::overflow(int_type n_char) {
+      /* Grow the storage, keeping the text */
+      size_t unSize = GetSize();
+      m_vecData.resize(2 * m_vecData.size());
+      setp(m_vecData.data(), m_vecData.data() + m_vecData.size());
+      pbump(static_cast<int>(unSize));
+      if(!traits_type::eq_int_type(n_char, traits_type::eof())) {
+         *pptr() = traits_type::to_char_type(n_char);
+         pbump(1);
+      }
+      return traits_type::not_eof(n_char);
+   }
+
+   /****************************************/
+   /****************************************/
+
+   CARGoSLog::SThreadBuffer::SThreadBuffer(size_t un_size) :
+      Pending(&PendingBuffer),
+      Ring(un_size),
+      Head(0),
+      Tail(0),
+      Dropped(0),
+      Owned(true) {}
+
+   /****************************************/
+   /****************************************/
+
+   size_t CARGoSLog::SThreadBuffer::Push(const char* pch_text,
+                                         size_t un_size) {
+      size_t unTail = Tail.load(std::memory_order_relaxed);
+      size_t unFree = Ring.size() - (unTail - Head.load(std::memory_order_acquire));
+      size_t unCount = std::min(un_size, unFree);
+      /* Copy the text in at most two pieces, as it may wrap around */
+      size_t unStart = unTail & (Ring.size() - 1);
+      size_t unFirst = std::min(unCount, Ring.size() - unStart);
+      ::memcpy(&Ring[unStart], pch_text, unFirst);
+      ::memcpy(&Ring[0], pch_text + unFirst, unCount - unFirst);
+      Tail.store(unTail + unCount, std::memory_order_release);
+      return unCount;
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CARGoSLog::SThreadBuffer::Release() {
+      /* Keep the unfinished message, unless the ring is full */
+      size_t unSize = PendingBuffer.GetSize();
+      if(unSize > 0) {
+         if(Push(PendingBuffer.GetData(), unSize) < unSize) {
+            ++Dropped;
+         }
+         PendingBuffer.Clear();
+      }
+      Owned.store(false, std::memory_order_release);
+   }
+
+#endif
+
+   /****************************************/
+   /****************************************/
+
+   CARGoSLog::CARGoSLog(std::ostream& c_stream,
+                        const SLogColor& s_log_color,
+                        bool b_colored_output_enabled) :
+      m_cStream(c_stream),
+      m_sLogColor(s_log_color),
+      m_bColoredOutput(b_colored_output_enabled) {
+#ifdef ARGOS_THREADSAFE_LOG
+      m_unId = TakeSlot();
+      m_unSerial = NEXT_SERIAL++;
+      m_unBufferSize = DEFAULT_BUFFER_SIZE;
+      m_bDropOnOverflow = false;
+      m_unDropped = 0;
+      m_bDrainThreadRunning.store(false);
+      m_bDrainRequested = false;
+      m_bDrainThreadStopping = false;
+      pthread_mutex_init(&m_tBuffersMutex, nullptr);
+      pthread_mutex_init(&m_tDrainMutex, nullptr);
+      pthread_mutex_init(&m_tDrainRequestMutex, nullptr);
+      pthread_cond_init(&m_tDrainRequestCond, nullptr);
+#endif
+   }
+
+   /****************************************/
+   /****************************************/
+
+   CARGoSLog::~CARGoSLog() {
+#ifdef ARGOS_THREADSAFE_LOG
+      StopDrainThread();
+      pthread_mutex_lock(&m_tDrainMutex);
+      DrainBuffers();
+      pthread_mutex_unlock(&m_tDrainMutex);
+      pthread_cond_destroy(&m_tDrainRequestCond);
+      pthread_mutex_destroy(&m_tDrainRequestMutex);
+      pthread_mutex_destroy(&m_tDrainMutex);
+      pthread_mutex_destroy(&m_tBuffersMutex);
+      /* The buffers of the threads still running are freed when they exit */
+      m_vecBuffers.clear();
+      ReleaseSlot(m_unId);
+#endif
+      if(m_bColoredOutput) {
+         reset(m_cStream);
+      }
+   }
+
+#ifdef ARGOS_THREADSAFE_LOG
+
+   /****************************************/
+   /****************************************/
+
+   void CARGoSLog::Flush() {
+      EndMessage(GetThreadBuffer());
+      pthread_mutex_lock(&m_tDrainMutex);
+      DrainBuffers();
+      pthread_mutex_unlock(&m_tDrainMutex);
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CARGoSLog::RequestFlush() {
+      if(m_bDrainThreadRunning) {
+         EndMessage(GetThreadBuffer());
+         WakeDrainThread();
+      }
+      else {
+         Flush();
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CARGoSLog::AddThreadSafeBuffer() {
+      GetThreadBuffer();
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CARGoSLog::StartDrainThread() {
+      if(m_bDrainThreadRunning) return;
+      m_bDrainThreadStopping = false;
+      m_bDrainRequested = false;
+      if(pthread_create(&m_tDrainThread, nullptr, &DrainThread, this) == 0) {
+         m_bDrainThreadRunning = true;
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CARGoSLog::StopDrainThread() {
+      if(!m_bDrainThreadRunning) return;
+      pthread_mutex_lock(&m_tDrainRequestMutex);
+      m_bDrainThreadStopping = true;
+      pthread_cond_signal(&m_tDrainRequestCond);
+      pthread_mutex_unlock(&m_tDrainRequestMutex);
+      pthread_join(m_tDrainThread, nullptr);
+      m_bDrainThreadRunning = false;
+      pthread_mutex_lock(&m_tDrainMutex);
+      DrainBuffers();
+      pthread_mutex_unlock(&m_tDrainMutex);
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CARGoSLog::SetBufferSize(size_t un_size) {
+      pthread_mutex_lock(&m_tDrainMutex);
+      DrainBuffers();
+      pthread_mutex_lock(&m_tBuffersMutex);
+      m_unBufferSize = RoundUpToPowerOfTwo(un_size);
+      for(size_t i = 0; i < m_vecBuffers.size(); ++i) {
+         m_vecBuffers[i]->Ring.assign(m_unBufferSize, 0);
+         m_vecBuffers[i]->Head = 0;
+         m_vecBuffers[i]->Tail = 0;
+      }
+      pthread_mutex_unlock(&m_tBuffersMutex);
+      pthread_mutex_unlock(&m_tDrainMutex);
+   }
+
+   /****************************************/
+   /****************************************/
+
+   CARGoSLog::SThreadBuffer& CARGoSLog::GetThreadBuffer() {
+      if(m_unId != NO_SLOT) {
+         if(THREAD_BUFFERS[m_unId].Serial == m_unSerial) {
+            return *THREAD_BUFFERS[m_unId].Buffer;
+         }
+      }
+      else if(THREAD_BUFFER_MAP != nullptr) {
+         TThreadBufferMap::iterator it = THREAD_BUFFER_MAP->find(m_unSerial);
+         if(it != THREAD_BUFFER_MAP->end()) {
+            return *it->second;
+         }
+      }
+      return AddThreadBuffer();
+   }
+
+   /****************************************/
+   /****************************************/
+
+   CARGoSLog::SThreadBuffer& CARGoSLog::AddThreadBuffer() {
+      pthread_mutex_lock(&m_tBuffersMutex);
+      /* Reuse the buffer of a thread that exited, or make a new one */
+      std::shared_ptr<SThreadBuffer> ptBuffer;
+      for(size_t i = 0; i < m_vecBuffers.size() && !ptBuffer; ++i) {
+         if(!m_vecBuffers[i]->Owned.load(std::memory_order_acquire)) {
+            ptBuffer = m_vecBuffers[i];
+            ptBuffer->Owned.store(true, std::memory_order_relaxed);
+         }
+      }
+      if(!ptBuffer) {
+         ptBuffer = std::make_shared<SThreadBuffer>(m_unBufferSize);
+         m_vecBuffers.push_back(ptBuffer);
+      }
+      pthread_mutex_unlock(&m_tBuffersMutex);
+      THREAD_BUFFER_OWNER.Buffers.push_back(ptBuffer);
+      if(m_unId != NO_SLOT) {
+         THREAD_BUFFERS[m_unId].Serial = m_unSerial;
+         THREAD_BUFFERS[m_unId].Buffer = ptBuffer.get();
+      }
+      else {
+         if(THREAD_BUFFER_MAP == nullptr) {
+            THREAD_BUFFER_MAP = new TThreadBufferMap;
+         }
+         (*THREAD_BUFFER_MAP)[m_unSerial] = ptBuffer.get();
+      }
+      return *ptBuffer;
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CARGoSLog::EndMessage(SThreadBuffer& s_buffer) {
+      const char* pchMessage = s_buffer.PendingBuffer.GetData();
+      size_t unLeft = s_buffer.PendingBuffer.GetSize();
+      if(unLeft == 0) return;
+      while(unLeft > 0) {
+         size_t unTail = s_buffer.Tail.load(std::memory_order_relaxed);
+         size_t unFree = s_buffer.Ring.size() - (unTail - s_buffer.Head.load(std::memory_order_acquire));
+         /* Unless the message is larger than the ring, write it in one go */
+         if(unFree < std::min(unLeft, s_buffer.Ring.size())) {
+            if(m_bDropOnOverflow) {
+               ++s_buffer.Dropped;
+               ++m_unDropped;
+               s_buffer.PendingBuffer.Clear();
+               WakeDrainThread();
+               return;
+            }
+            /* Make room by writing the rings to the stream */
+            pthread_mutex_lock(&m_tDrainMutex);
+            DrainBuffers();
+            pthread_mutex_unlock(&m_tDrainMutex);
+            continue;
+         }
+         size_t unCount = s_buffer.Push(pchMessage, unLeft);
+         pchMessage += unCount;
+         unLeft -= unCount;
+      }
+      s_buffer.PendingBuffer.Clear();
+      /* Past half the ring, ask for it to be written */
+      if(m_bDrainThreadRunning &&
+         s_buffer.Tail.load(std::memory_order_relaxed) - s_buffer.Head.load(std::memory_order_relaxed) > s_buffer.Ring.size() / 2) {
+         WakeDrainThread();
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CARGoSLog::DrainBuffers() {
+      pthread_mutex_lock(&m_tBuffersMutex);
+      for(size_t b = 0; b < m_vecBuffers.size(); ++b) {
+         SThreadBuffer& sBuffer = *m_vecBuffers[b];
+         size_t unHead = sBuffer.Head.load(std::memory_order_relaxed);
+         size_t unTail = sBuffer.Tail.load(std::memory_order_acquire);
+         if(unTail != unHead) {
+            /* Write the text in at most two pieces, as it may wrap around */
+            size_t unSize = sBuffer.Ring.size();
+            size_t unStart = unHead & (unSize - 1);
+            size_t unFirst = std::min(unTail - unHead, unSize - unStart);
+            m_cStream.write(&sBuffer.Ring[unStart], unFirst);
+            m_cStream.write(&sBuffer.Ring[0], (unTail - unHead) - unFirst);
+            sBuffer.Head.store(unTail, std::memory_order_release);
+         }
+         size_t unDropped = sBuffer.Dropped.exchange(0);
+         if(unDropped > 0) {
+            m_cStream << "[WARNING] " << unDropped << " log messages were dropped because the buffer of thread #" << b << " was full" << std::endl;
+         }
+      }
+      pthread_mutex_unlock(&m_tBuffersMutex);
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CARGoSLog::WakeDrainThread() {
+      if(!m_bDrainThreadRunning) return;
+      pthread_mutex_lock(&m_tDrainRequestMutex);
+      m_bDrainRequested = true;
+      pthread_cond_signal(&m_tDrainRequestCond);
+      pthread_mutex_unlock(&m_tDrainRequestMutex);
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void* CARGoSLog::DrainThread(void* pt_log) {
+      CARGoSLog& cLog = *reinterpret_cast<CARGoSLog*>(pt_log);
+      pthread_mutex_lock(&cLog.m_tDrainRequestMutex);
+      while(!cLog.m_bDrainThreadStopping) {
+         if(!cLog.m_bDrainRequested) {
+            /* Wait for a request, or for the period to elapse */
+            ::timespec tDeadline;
+            ::clock_gettime(CLOCK_REALTIME, &tDeadline);
+            tDeadline.tv_nsec += DRAIN_PERIOD_NS;
+            if(tDeadline.tv_nsec >= 1000000000L) {
+               tDeadline.tv_sec += 1;
+               tDeadline.tv_nsec -= 1000000000L;
+            }
+            pthread_cond_timedwait(&cLog.m_tDrainRequestCond, &cLog.m_tDrainRequestMutex, &tDeadline);
+         }
+         cLog.m_bDrainRequested = false;
+         pthread_mutex_unlock(&cLog.m_tDrainRequestMutex);
+         pthread_mutex_lock(&cLog.m_tDrainMutex);
+         cLog.DrainBuffers();
+         pthread_mutex_unlock(&cLog.m_tDrainMutex);
+         pthread_mutex_lock(&cLog.m_tDrainRequestMutex);
+      }
+      pthread_mutex_unlock(&cLog.m_tDrainRequestMutex);
+      return nullptr;
+   }
+
+   /****************************************/
+   /****************************************/
+
+#endif
+
 }
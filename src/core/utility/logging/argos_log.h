@@ -27,8 +27,10 @@
 
 #ifdef ARGOS_THREADSAFE_LOG
 #include <pthread.h>
+#include <atomic>
+#include <memory>
 #include <sstream>
-#include <map>
+#include <streambuf>
 #include <vector>
 #endif
 
@@ -70,42 +72,116 @@ namespace argos {
       bool m_bColoredOutput;
 
 #ifdef ARGOS_THREADSAFE_LOG
-      /** Maps a thread to its visualization order */
-      std::map<pthread_t, size_t> m_mapStreamOrder;
+   public:
+
+      /**
+       * The buffer of a thread.
+       * The thread formats its messages into the pending stream. When it ends
+       * a message, it moves the text into the ring. The ring has a single
+       * producer, the thread, and a single consumer, whoever holds the drain
+       * mutex: Flush() or the drain thread.
+       * The buffer is owned by both the log and the thread, as either may go
+       * first. When the thread exits, it releases the buffer, which the log
+       * can then give to another thread.
+       */
+      struct SThreadBuffer {
+         /** Keeps the text of the current message, without copies */
+         class CMessageBuffer : public std::streambuf {
+         public:
+            CMessageBuffer();
+            inline const char* GetData() const { return pbase(); }
+            inline size_t GetSize() const { return pptr() - pbase(); }
+            inline void Clear() { setp(pbase(), epptr()); }
+         protected:
+            virtual int_type overflow(int_type n_char);
+         private:
+            std::vector<char> m_vecData;
+         };
+         /** The buffer of the pending stream */
+         CMessageBuffer PendingBuffer;
+         /** The text of the current message */
+         std::ostream Pending;
+         /** The ring of text, its size is a power of two */
+         std::vector<char> Ring;
+         /** The position of the consumer */
+         std::atomic<size_t> Head;
+         /** The position of the producer */
+         std::atomic<size_t> Tail;
+         /** The number of messages dropped since the last drain */
+         std::atomic<size_t> Dropped;
+         /** <tt>false</tt> once the thread has exited, so the buffer can be reused */
+         std::atomic<bool> Owned;
+
+         SThreadBuffer(size_t un_size);
+
+         /**
+          * Copies as much of the given text as fits into the ring.
+          * Only the thread of the buffer may call this function.
+          * @return The number of characters copied.
+          */
+         size_t Push(const char* pch_text,
+                     size_t un_size);
+
+         /**
+          * Releases the buffer when its thread exits.
+          * The text of an unfinished message is moved into the ring, if it fits,
+          * so that the pending stream is empty for the next thread.
+          */
+         void Release();
+      };
+
+   private:
+
+      /** The slot of this log, to find the buffers of the calling thread */
+      size_t m_unId;
+
+      /** The serial of this log, unique over the lifetime of the process */
+      size_t m_unSerial;
+
+      /** The buffers of the threads, in the order in which they were added */
+      std::vector<std::shared_ptr<SThreadBuffer> > m_vecBuffers;
+
+      /** Protects the list of buffers */
+      pthread_mutex_t m_tBuffersMutex;
+
+      /** Protects the consumer side of the rings and the stream */
+      pthread_mutex_t m_tDrainMutex;
+
+      /** The size of the ring of a new buffer */
+      size_t m_unBufferSize;
+
+      /** <tt>true</tt> to drop the messages that do not fit, <tt>false</tt> to wait */
+      bool m_bDropOnOverflow;
 
-      /** Contains the buffer streams */
-      std::vector<std::stringstream*> m_vecStreams;
+      /** The total number of messages dropped */
+      std::atomic<size_t> m_unDropped;
 
-      /** The mutex to protect the operations on the buffers */
-      pthread_mutex_t m_tMutex;
+      /** The drain thread */
+      pthread_t m_tDrainThread;
+
+      /** <tt>true</tt> when the drain thread is running; read by the logging threads */
+      std::atomic<bool> m_bDrainThreadRunning;
+
+      /** Protects the flags of the drain thread */
+      pthread_mutex_t m_tDrainRequestMutex;
+
+      /** Wakes up the drain thread */
+      pthread_cond_t m_tDrainRequestCond;
+
+      /** <tt>true</tt> when a drain was requested */
+      bool m_bDrainRequested;
+
+      /** <tt>true</tt> when the drain thread must stop */
+      bool m_bDrainThreadStopping;
 #endif
 
    public:
 
       CARGoSLog(std::ostream& c_stream,
                 const SLogColor& s_log_color,
-                bool b_colored_output_enabled = true) :
-         m_cStream(c_stream),
-         m_sLogColor(s_log_color),
-         m_bColoredOutput(b_colored_output_enabled) {
-#ifdef ARGOS_THREADSAFE_LOG
-         pthread_mutex_init(&m_tMutex, NULL);
-         AddThreadSafeBuffer();
-#endif
-      }
+                bool b_colored_output_enabled = true);
 
-      ~CARGoSLog() {
-#ifdef ARGOS_THREADSAFE_LOG
-         pthread_mutex_destroy(&m_tMutex);
-         while(!m_vecStreams.empty()) {
-            delete m_vecStreams.back();
-            m_vecStreams.pop_back();
-         }
-#endif
-         if(m_bColoredOutput) {
-            reset(m_cStream);
-         }
-      }
+      ~CARGoSLog();
 
       inline void EnableColoredOutput() {
          m_bColoredOutput = true;
@@ -128,28 +204,94 @@ namespace argos {
       }
 
 #ifdef ARGOS_THREADSAFE_LOG
-      inline void Flush() {
-         pthread_mutex_lock(&m_tMutex);
-         for(size_t i = 0; i < m_vecStreams.size(); ++i) {
-            m_cStream << m_vecStreams[i]->str();
-            m_vecStreams[i]->str("");
-         }
-         pthread_mutex_unlock(&m_tMutex);
+      /**
+       * Writes all the buffered messages to the stream.
+       * The message the calling thread is writing is ended first. The
+       * messages of the other threads are written once they are ended.
+       * This function returns when the messages are written.
+       * @see RequestFlush()
+       */
+      void Flush();
+
+      /**
+       * Asks for the buffered messages to be written to the stream.
+       * If the drain thread is running, this function wakes it up and
+       * returns immediately. Otherwise, it is the same as Flush().
+       * @see StartDrainThread()
+       */
+      void RequestFlush();
+
+      /**
+       * Adds a buffer for the calling thread.
+       * A thread gets its buffer the first time it logs. Calling this function
+       * beforehand fixes the order in which the buffers are written.
+       */
+      void AddThreadSafeBuffer();
+
+      /**
+       * Starts a thread that writes the buffered messages to the stream.
+       * The thread writes when a flush is requested, when a buffer is half
+       * full, and periodically otherwise.
+       * @see StopDrainThread()
+       */
+      void StartDrainThread();
+
+      /**
+       * Stops the drain thread and writes the buffered messages to the stream.
+       * Call this function before writing to the stream from a single thread only,
+       * such as a GUI thread.
+       * @see StartDrainThread()
+       */
+      void StopDrainThread();
+
+      /**
+       * Sets the size of the buffer of each thread.
+       * Call this function when no other thread is logging.
+       * @param un_size The size in bytes, rounded up to a power of two.
+       */
+      void SetBufferSize(size_t un_size);
+
+      /**
+       * Sets what to do when a message does not fit in the buffer of a thread.
+       * @param b_drop <tt>true</tt> to drop the message and count it, <tt>false</tt>
+       * to wait for the buffer to be written to the stream.
+       */
+      inline void SetDropOnOverflow(bool b_drop) {
+         m_bDropOnOverflow = b_drop;
       }
 
-      inline void AddThreadSafeBuffer() {
-         pthread_mutex_lock(&m_tMutex);
-         m_mapStreamOrder.insert(std::make_pair<pthread_t, size_t>(pthread_self(), m_vecStreams.size()));
-         m_vecStreams.push_back(new std::stringstream);
-         pthread_mutex_unlock(&m_tMutex);
+      /**
+       * Returns the number of messages dropped because a buffer was full.
+       * @return The number of messages dropped because a buffer was full.
+       */
+      inline size_t GetDroppedMessages() const {
+         return m_unDropped;
       }
 #else
       void Flush() {}
+
+      void RequestFlush() {}
+
+      void AddThreadSafeBuffer() {}
+
+      void StartDrainThread() {}
+
+      void StopDrainThread() {}
+
+      void SetBufferSize(size_t) {}
+
+      void SetDropOnOverflow(bool) {}
+
+      size_t GetDroppedMessages() const {
+         return 0;
+      }
 #endif
       
       inline CARGoSLog& operator<<(std::ostream& (*c_stream)(std::ostream&)) {
 #ifdef ARGOS_THREADSAFE_LOG
-         *(m_vecStreams[m_mapStreamOrder.find(pthread_self())->second]) << c_stream;
+         SThreadBuffer& sBuffer = GetThreadBuffer();
+         sBuffer.Pending << c_stream;
+         EndMessage(sBuffer);
 #else
          m_cStream << c_stream;
 #endif
@@ -159,14 +301,14 @@ namespace argos {
       template <typename T> CARGoSLog& operator<<(const T t_msg) {
          if(m_bColoredOutput) {
 #ifdef ARGOS_THREADSAFE_LOG
-            *(m_vecStreams[m_mapStreamOrder.find(pthread_self())->second]) << m_sLogColor << t_msg << reset;
+            GetThreadBuffer().Pending << m_sLogColor << t_msg << reset;
 #else
             m_cStream << m_sLogColor << t_msg << reset;
 #endif
          }
          else {
 #ifdef ARGOS_THREADSAFE_LOG
-            *(m_vecStreams[m_mapStreamOrder.find(pthread_self())->second]) << t_msg;
+            GetThreadBuffer().Pending << t_msg;
 #else
             m_cStream << m_sLogColor << t_msg << reset;
 #endif
@@ -174,6 +316,28 @@ namespace argos {
          return *this;
       }
 
+#ifdef ARGOS_THREADSAFE_LOG
+   private:
+
+      /** Returns the buffer of the calling thread, adding it if needed */
+      SThreadBuffer& GetThreadBuffer();
+
+      /** Adds a buffer for the calling thread */
+      SThreadBuffer& AddThreadBuffer();
+
+      /** Moves the pending text of a buffer into its ring */
+      void EndMessage(SThreadBuffer& s_buffer);
+
+      /** Writes the rings to the stream; the caller holds the drain mutex */
+      void DrainBuffers();
+
+      /** Wakes up the drain thread */
+      void WakeDrainThread();
+
+      /** The body of the drain thread */
+      static void* DrainThread(void* pt_log);
+#endif
+
    };
 
    extern CARGoSLog LOG;
@@ -9,9 +9,11 @@
 #include "rng.h"
 #include <argos3/core/utility/configuration/argos_exception.h>
 #include <argos3/core/utility/logging/argos_log.h>
+#include <algorithm>
 #include <cstring>
 #include <limits>
 #include <cmath>
+#include <pthread.h>
 
 namespace argos {
 
@@ -26,6 +28,35 @@ namespace argos {
    static const UInt32 LOWER_MASK = 0x7fffffffUL; /* least significant r bits */
    static const CRange<UInt32> INT_RANGE = CRange<UInt32>(0, 0xFFFFFFFFUL);
 
+   /* Philox4x32 parameters */
+   static const UInt32 PHILOX_M0 = 0xD2511F53UL; /* multipliers */
+   static const UInt32 PHILOX_M1 = 0xCD9E8D57UL;
+   static const UInt32 PHILOX_W0 = 0x9E3779B9UL; /* key increments */
+   static const UInt32 PHILOX_W1 = 0xBB67AE85UL;
+   static const UInt32 PHILOX_ROUNDS = 10;
+
+   /* Maps a random 32bit unsigned integer into [0,1) */
+   static inline double ToUnitOpenMax(UInt32 un_value) {
+      return un_value * (1.0 / 4294967296.0);
+   }
+
+   /* Maps a random 32bit unsigned integer into (0,1] */
+   static inline double ToUnitOpenMin(UInt32 un_value) {
+      return (un_value + 1.0) * (1.0 / 4294967296.0);
+   }
+
+   /* Draws two values from the standard normal distribution with the
+      Box-Muller method in its trigonometric variant, which needs no rejection */
+   static inline void BoxMuller(UInt32 un_value1,
+                                UInt32 un_value2,
+                                double& f_normal1,
+                                double& f_normal2) {
+      double fRadius = std::sqrt(-2.0 * std::log(ToUnitOpenMin(un_value1)));
+      double fAngle = 2.0 * ARGOS_PI * ToUnitOpenMax(un_value2);
+      f_normal1 = fRadius * std::cos(fAngle);
+      f_normal2 = fRadius * std::sin(fAngle);
+   }
+
    std::map<std::string, CRandom::CCategory*> CRandom::m_mapCategories;
 
    /* Checks that a category exists. It internally creates an iterator that points to the category, if found.  */
@@ -35,6 +66,26 @@ namespace argos {
       THROW_ARGOSEXCEPTION("CRandom:: can't find category \"" << category << "\"."); \
    }
 
+   /* Protects the categories, so that RNGs can be created from several threads */
+   static pthread_mutex_t CATEGORY_MUTEX = PTHREAD_MUTEX_INITIALIZER;
+
+   struct SCategoryLock {
+      SCategoryLock() { pthread_mutex_lock(&CATEGORY_MUTEX); }
+      ~SCategoryLock() { pthread_mutex_unlock(&CATEGORY_MUTEX); }
+   };
+
+   /* Whether the calling thread has a seed key, the key, and the number of RNGs created with it */
+   static thread_local bool HAS_SEED_KEY = false;
+   static thread_local UInt64 SEED_KEY = 0;
+   static thread_local UInt64 SEED_KEY_RNGS = 0;
+
+   /* Mixes the bits of a value (the finalizer of SplitMix64) */
+   static UInt64 MixSeedBits(UInt64 un_value) {
+      un_value = (un_value ^ (un_value >> 30)) * 0xbf58476d1ce4e5b9ULL;
+      un_value = (un_value ^ (un_value >> 27)) * 0x94d049bb133111ebULL;
+      return un_value ^ (un_value >> 31);
+   }
+
    /****************************************/
    /****************************************/
 
@@ -233,6 +284,202 @@ namespace argos {
    /****************************************/
    /****************************************/
 
+   CRandom::CCounterRNG::CCounterRNG(UInt32 un_seed,
+                                     UInt32 un_stream) :
+      m_unEntity(0),
+      m_unTick(0),
+      m_unBlock(0),
+      m_unCacheIndex(4),
+      m_bHasSpareGaussian(false),
+      m_fSpareGaussian(0.0) {
+      m_punKey[0] = un_seed;
+      m_punKey[1] = un_stream;
+      m_punCache[0] = m_punCache[1] = m_punCache[2] = m_punCache[3] = 0;
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CRandom::CCounterRNG::Reset() {
+      m_unBlock = 0;
+      m_unCacheIndex = 4;
+      m_bHasSpareGaussian = false;
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CRandom::CCounterRNG::Seek(UInt64 un_entity,
+                                   UInt64 un_tick) {
+      m_unEntity = un_entity;
+      m_unTick = un_tick;
+      Reset();
+   }
+
+   /****************************************/
+   /****************************************/
+
+   UInt64 CRandom::CCounterRNG::Hash(const std::string& str_text) {
+      UInt64 unHash = 14695981039346656037ULL;
+      for(size_t i = 0; i < str_text.size(); ++i) {
+         unHash ^= static_cast<UInt8>(str_text[i]);
+         unHash *= 1099511628211ULL;
+      }
+      return unHash;
+   }
+
+   /****************************************/
+   /****************************************/
+
+   bool CRandom::CCounterRNG::Bernoulli(Real f_true) {
+      return Uniform32bit() < f_true * 4294967296.0;
+   }
+
+   /****************************************/
+   /****************************************/
+
+   CRadians CRandom::CCounterRNG::Uniform(const CRange<CRadians>& c_range) {
+      return c_range.GetMin() + c_range.GetSpan() * ToUnitOpenMax(Uniform32bit());
+   }
+
+   /****************************************/
+   /****************************************/
+
+   Real CRandom::CCounterRNG::Uniform(const CRange<Real>& c_range) {
+      return c_range.GetMin() + c_range.GetSpan() * ToUnitOpenMax(Uniform32bit());
+   }
+
+   /****************************************/
+   /****************************************/
+
+   UInt32 CRandom::CCounterRNG::Uniform(const CRange<UInt32>& c_range) {
+      return c_range.GetMin() +
+         static_cast<UInt32>((static_cast<UInt64>(Uniform32bit()) * c_range.GetSpan()) >> 32);
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CRandom::CCounterRNG::Uniform(Real* pf_values,
+                                      size_t un_count,
+                                      const CRange<Real>& c_range) {
+      Real fMin = c_range.GetMin();
+      Real fSpan = c_range.GetSpan();
+      size_t i = 0;
+      /* Use what is left of the last block */
+      for(; i < un_count && m_unCacheIndex < 4; ++i) {
+         pf_values[i] = fMin + fSpan * ToUnitOpenMax(m_punCache[m_unCacheIndex++]);
+      }
+      /* Use whole blocks */
+      UInt32 punBlock[4];
+      for(; i + 4 <= un_count; i += 4) {
+         NextBlock(punBlock);
+         for(UInt32 j = 0; j < 4; ++j) {
+            pf_values[i + j] = fMin + fSpan * ToUnitOpenMax(punBlock[j]);
+         }
+      }
+      /* Start a new block for the rest */
+      for(; i < un_count; ++i) {
+         pf_values[i] = fMin + fSpan * ToUnitOpenMax(Uniform32bit());
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   Real CRandom::CCounterRNG::Gaussian(Real f_std_dev,
+                                       Real f_mean) {
+      if(m_bHasSpareGaussian) {
+         m_bHasSpareGaussian = false;
+         return f_mean + f_std_dev * m_fSpareGaussian;
+      }
+      double fNormal1, fNormal2;
+      UInt32 unValue1 = Uniform32bit();
+      BoxMuller(unValue1, Uniform32bit(), fNormal1, fNormal2);
+      m_fSpareGaussian = fNormal2;
+      m_bHasSpareGaussian = true;
+      return f_mean + f_std_dev * fNormal1;
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CRandom::CCounterRNG::Gaussian(Real* pf_values,
+                                       size_t un_count,
+                                       Real f_std_dev,
+                                       Real f_mean) {
+      if(un_count == 0) return;
+      size_t i = 0;
+      /* Use the value left by the last transform */
+      if(m_bHasSpareGaussian) {
+         pf_values[i++] = f_mean + f_std_dev * m_fSpareGaussian;
+         m_bHasSpareGaussian = false;
+      }
+      /* Use both values of each transform */
+      double fNormal1, fNormal2;
+      for(; i + 2 <= un_count; i += 2) {
+         UInt32 unValue1 = Uniform32bit();
+         BoxMuller(unValue1, Uniform32bit(), fNormal1, fNormal2);
+         pf_values[i]     = f_mean + f_std_dev * fNormal1;
+         pf_values[i + 1] = f_mean + f_std_dev * fNormal2;
+      }
+      /* Keep the second value of the last transform for the next call */
+      if(i < un_count) {
+         pf_values[i] = Gaussian(f_std_dev, f_mean);
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CRandom::CCounterRNG::Philox(UInt32 pun_counter[4],
+                                     const UInt32 pun_key[2]) {
+      UInt32 unKey0 = pun_key[0];
+      UInt32 unKey1 = pun_key[1];
+      for(UInt32 i = 0; i < PHILOX_ROUNDS; ++i) {
+         UInt64 unProd0 = static_cast<UInt64>(PHILOX_M0) * pun_counter[0];
+         UInt64 unProd1 = static_cast<UInt64>(PHILOX_M1) * pun_counter[2];
+         UInt32 unCounter0 = static_cast<UInt32>(unProd1 >> 32) ^ pun_counter[1] ^ unKey0;
+         UInt32 unCounter2 = static_cast<UInt32>(unProd0 >> 32) ^ pun_counter[3] ^ unKey1;
+         pun_counter[0] = unCounter0;
+         pun_counter[1] = static_cast<UInt32>(unProd1);
+         pun_counter[2] = unCounter2;
+         pun_counter[3] = static_cast<UInt32>(unProd0);
+         unKey0 += PHILOX_W0;
+         unKey1 += PHILOX_W1;
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   UInt32 CRandom::CCounterRNG::Uniform32bit() {
+      if(m_unCacheIndex >= 4) {
+         NextBlock(m_punCache);
+         m_unCacheIndex = 0;
+      }
+      return m_punCache[m_unCacheIndex++];
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CRandom::CCounterRNG::NextBlock(UInt32 pun_block[4]) {
+      pun_block[0] = m_unBlock++;
+      pun_block[1] = static_cast<UInt32>(m_unEntity);
+      pun_block[2] = static_cast<UInt32>(m_unEntity >> 32);
+      pun_block[3] = static_cast<UInt32>(m_unTick);
+      /* The counter has no room left for the upper bits of the tick */
+      UInt32 punKey[2] = {
+         m_punKey[0],
+         m_punKey[1] + static_cast<UInt32>(m_unTick >> 32)
+      };
+      Philox(pun_block, punKey);
+   }
+
+   /****************************************/
+   /****************************************/
+
    CRandom::CCategory::CCategory(const std::string& str_id,
                                  UInt32 un_seed) :
       m_strId(str_id),
@@ -248,6 +495,14 @@ namespace argos {
          delete m_vecRNGList.back();
          m_vecRNGList.pop_back();
       }
+      while(! m_vecCounterRNGList.empty()) {
+         delete m_vecCounterRNGList.back();
+         m_vecCounterRNGList.pop_back();
+      }
+      while(! m_vecKeyedRNGs.empty()) {
+         delete m_vecKeyedRNGs.back().second;
+         m_vecKeyedRNGs.pop_back();
+      }
    }
 
    /****************************************/
@@ -262,6 +517,12 @@ namespace argos {
    /****************************************/
 
    CRandom::CRNG* CRandom::CCategory::CreateRNG() {
+      if(HAS_SEED_KEY) {
+         /* The seed depends on the key and on the RNGs created with it so far */
+         UInt64 unKey = MixSeedBits(SEED_KEY + SEED_KEY_RNGS++);
+         m_vecKeyedRNGs.emplace_back(unKey, new CRNG(GetKeyedSeed(unKey)));
+         return m_vecKeyedRNGs.back().second;
+      }
       /* Get seed from internal RNG */
       UInt32 unSeed = m_cSeeder.Uniform(m_cSeedRange);
       /* Create new RNG */
@@ -272,6 +533,24 @@ namespace argos {
    /****************************************/
    /****************************************/
 
+   CRandom::CCounterRNG* CRandom::CCategory::CreateCounterRNG(UInt32 un_stream) {
+      /* The seed does not depend on the order of creation */
+      m_vecCounterRNGList.push_back(new CCounterRNG(m_unSeed, un_stream));
+      return m_vecCounterRNGList.back();
+   }
+
+   /****************************************/
+   /****************************************/
+
+   UInt32 CRandom::CCategory::GetKeyedSeed(UInt64 un_key) const {
+      /* A seed in the range of the seeds drawn by m_cSeeder */
+      UInt64 unBits = MixSeedBits(un_key ^ m_unSeed);
+      return m_cSeedRange.GetMin() + static_cast<UInt32>(unBits % m_cSeedRange.GetSpan());
+   }
+
+   /****************************************/
+   /****************************************/
+
    void CRandom::CCategory::ResetRNGs() {
       /* Reset internal RNG */
       m_cSeeder.Reset();
@@ -280,6 +559,14 @@ namespace argos {
       for(size_t i = 0; i < m_vecRNGList.size(); ++i) {
          m_vecRNGList[i]->Reset();
       }
+      for(size_t i = 0; i < m_vecKeyedRNGs.size(); ++i) {
+         m_vecKeyedRNGs[i].second->Reset();
+      }
+      /* Reset the counter-based RNGs */
+      for(size_t i = 0; i < m_vecCounterRNGList.size(); ++i) {
+         m_vecCounterRNGList[i]->SetSeed(m_unSeed);
+         m_vecCounterRNGList[i]->Reset();
+      }
    }
 
    /****************************************/
@@ -290,6 +577,10 @@ namespace argos {
          /* Get seed from internal RNG */
          m_vecRNGList[i]->SetSeed(m_cSeeder.Uniform(m_cSeedRange));
       }
+      for(size_t i = 0; i < m_vecKeyedRNGs.size(); ++i) {
+         /* The category seed may have changed */
+         m_vecKeyedRNGs[i].second->SetSeed(GetKeyedSeed(m_vecKeyedRNGs[i].first));
+      }
    }
 
    /****************************************/
@@ -297,6 +588,7 @@ namespace argos {
 
    bool CRandom::CreateCategory(const std::string& str_category,
                                 UInt32 un_seed) {
+      SCategoryLock sLock;
       /* Is there a category already? */
       auto itCategory = m_mapCategories.find(str_category);
       if(itCategory == m_mapCategories.end()) {
@@ -315,6 +607,7 @@ namespace argos {
    /****************************************/
 
    CRandom::CCategory& CRandom::GetCategory(const std::string& str_category) {
+      SCategoryLock sLock;
       CHECK_CATEGORY(str_category);
       return *(itCategory->second);
    }
@@ -323,6 +616,7 @@ namespace argos {
    /****************************************/
 
    bool CRandom::ExistsCategory(const std::string& str_category) {
+      SCategoryLock sLock;
       try {
          CHECK_CATEGORY(str_category);
          return true;
@@ -336,6 +630,7 @@ namespace argos {
    /****************************************/
 
    void CRandom::RemoveCategory(const std::string& str_category) {
+      SCategoryLock sLock;
       CHECK_CATEGORY(str_category);
       delete itCategory->second;
       m_mapCategories.erase(itCategory);
@@ -345,6 +640,7 @@ namespace argos {
    /****************************************/
 
    CRandom::CRNG* CRandom::CreateRNG(const std::string& str_category) {
+      SCategoryLock sLock;
       CHECK_CATEGORY(str_category);
       return itCategory->second->CreateRNG();
    }
@@ -352,7 +648,21 @@ namespace argos {
    /****************************************/
    /****************************************/
 
+   CRandom::CCounterRNG* CRandom::CreateCounterRNG(const std::string& str_category,
+                                                   const std::string& str_stream) {
+      /* The stream id is the hash of its name, folded to 32 bits */
+      UInt64 unHash = CCounterRNG::Hash(str_stream);
+      UInt32 unStream = static_cast<UInt32>(unHash ^ (unHash >> 32));
+      SCategoryLock sLock;
+      CHECK_CATEGORY(str_category);
+      return itCategory->second->CreateCounterRNG(unStream);
+   }
+
+   /****************************************/
+   /****************************************/
+
    UInt32 CRandom::GetSeedOf(const std::string& str_category) {
+      SCategoryLock sLock;
       CHECK_CATEGORY(str_category);
       return itCategory->second->GetSeed();
    }
@@ -362,6 +672,7 @@ namespace argos {
 
    void CRandom::SetSeedOf(const std::string& str_category,
                            UInt32 un_seed) {
+      SCategoryLock sLock;
       CHECK_CATEGORY(str_category);
       itCategory->second->SetSeed(un_seed);
    }
@@ -370,6 +681,7 @@ namespace argos {
    /****************************************/
 
    void CRandom::Reset() {
+      SCategoryLock sLock;
       for(auto itCategory = m_mapCategories.begin();
           itCategory != m_mapCategories.end();
           ++itCategory) {
@@ -380,4 +692,20 @@ namespace argos {
    /****************************************/
    /****************************************/
 
+   void CRandom::SetSeedKey(const std::string& str_key) {
+      HAS_SEED_KEY = true;
+      SEED_KEY = CCounterRNG::Hash(str_key);
+      SEED_KEY_RNGS = 0;
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CRandom::ClearSeedKey() {
+      HAS_SEED_KEY = false;
+   }
+
+   /****************************************/
+   /****************************************/
+
 }
@@ -5,6 +5,7 @@
  */
 
 #include "profiler.h"
+#include "tick_profiler.h"
 #include <argos3/core/utility/logging/argos_log.h>
 #include <argos3/core/utility/configuration/argos_configuration.h>
 
@@ -114,7 +115,8 @@ namespace argos {
    /****************************************/
 
    CProfiler::CProfiler(const std::string& str_file_name,
-                        bool b_trunc) {
+                        bool b_trunc) :
+      m_unTraceBufferSize(0) {
       if(b_trunc) {
          m_cOutFile.open(str_file_name.c_str(),
                          std::ios::trunc | std::ios::out);
@@ -144,12 +146,16 @@ namespace argos {
    void CProfiler::Start() {
       StartWallClock();
       StartCPUProfiler();
+      if(!m_strTraceFile.empty() || !m_strSummaryFile.empty()) {
+         CTickProfiler::Start(m_unTraceBufferSize);
+      }
    }
 
    /****************************************/
    /****************************************/
 
    void CProfiler::Stop() {
+      CTickProfiler::Stop();
       StopCPUProfiler();
       StopWallClock();
    }
@@ -164,6 +170,14 @@ namespace argos {
       else {
          FlushAsTable();
       }
+      if(!m_strTraceFile.empty()) {
+         CTickProfiler::WriteTrace(m_strTraceFile);
+         LOG << "[INFO] Wrote the profiler trace to \"" << m_strTraceFile << "\"." << std::endl;
+      }
+      if(!m_strSummaryFile.empty()) {
+         CTickProfiler::WriteSummary(m_strSummaryFile);
+         LOG << "[INFO] Wrote the profiler summary to \"" << m_strSummaryFile << "\"." << std::endl;
+      }
    }
 
    /****************************************/
@@ -186,6 +200,22 @@ namespace argos {
    /****************************************/
    /****************************************/
 
+   void CProfiler::SetTickProfiling(const std::string& str_trace_file,
+                                    const std::string& str_summary_file,
+                                    size_t un_buffer_size) {
+      m_strTraceFile = str_trace_file;
+      m_strSummaryFile = str_summary_file;
+      m_unTraceBufferSize = un_buffer_size;
+#ifndef ARGOS_TICK_PROFILER
+      if(!m_strTraceFile.empty() || !m_strSummaryFile.empty()) {
+         LOGERR << "[WARNING] ARGoS was compiled without ARGOS_TICK_PROFILER: the profiler trace and summary will be empty." << std::endl;
+      }
+#endif
+   }
+
+   /****************************************/
+   /****************************************/
+
    void CProfiler::FlushHumanReadable() {
       m_cOutFile << "[profiled portion overall]" << std::endl << std::endl;
       double fStartTime = TV2Sec(m_tWallClockStart);
@@ -30,6 +30,18 @@ namespace argos {
       void Flush(bool b_human_readable);
       void CollectThreadResourceUsage();
 
+      /**
+       * Makes the profiler record the tick timers.
+       * The timers are recorded between Start() and Stop(), and written by Flush().
+       * @param str_trace_file The file to write the Chrome trace to, or an empty string for no trace.
+       * @param str_summary_file The file to write the CSV summary to, or an empty string for no summary.
+       * @param un_buffer_size The number of timers kept per thread for the trace.
+       * @see CTickProfiler
+       */
+      void SetTickProfiling(const std::string& str_trace_file,
+                            const std::string& str_summary_file,
+                            size_t un_buffer_size);
+
    private:
 
       void StartWallClock();
@@ -50,6 +62,9 @@ namespace argos {
       ::rusage m_tResourceUsageEnd;
       std::vector< ::rusage > m_vecThreadResourceUsage;
       pthread_mutex_t m_tThreadResourceUsageMutex;
+      std::string m_strTraceFile;
+      std::string m_strSummaryFile;
+      size_t m_unTraceBufferSize;
 
    };
 
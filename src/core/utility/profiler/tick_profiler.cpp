@@ -0,0 +1,369 @@
+/**
+ * @file <argos3/core/utility/profiler/tick_profiler.cpp>
+ */
+
+#include "tick_profiler.h"
+#include <argos3/core/utility/configuration/argos_exception.h>
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <pthread.h>
+#include <time.h>
+
+namespace argos {
+
+   /****************************************/
+   /****************************************/
+
+   bool CTickProfiler::m_bStarted = false;
+
+   /****************************************/
+   /****************************************/
+
+   namespace {
+
+      struct SZone {
+         std::string Category;
+         std::string Name;
+      };
+
+      struct STimer {
+         UInt32 Zone;
+         UInt64 Start;
+         UInt64 End;
+      };
+
+      /*
+       * The data recorded by a thread.
+       * Only the thread writes it while the profiler is recording.
+       */
+      struct SThreadData {
+         /* The number of the thread in the trace */
+         UInt32 Thread;
+         /* The ring buffer of timers */
+         std::vector<STimer> Timers;
+         /* The total number of timers recorded */
+         UInt64 Recorded;
+         /* The statistics, indexed by zone */
+         std::vector<CTickProfiler::SStats> Stats;
+      };
+
+      /* Protects the zones and the list of threads */
+      pthread_mutex_t MUTEX = PTHREAD_MUTEX_INITIALIZER;
+      std::vector<SZone> ZONES;
+      std::map<std::pair<std::string, std::string>, UInt32> ZONE_IDS;
+      std::vector<SThreadData*> THREADS;
+
+      /* The size of the ring buffers */
+      size_t BUFFER_SIZE = 0;
+
+      /* Increased at each start, so that the threads drop their old data */
+      UInt32 GENERATION = 0;
+
+      /* The data of the calling thread, valid if its generation is current */
+      thread_local SThreadData* THREAD_DATA = nullptr;
+      thread_local UInt32 THREAD_GENERATION = 0;
+
+      /* The clock and the time at the start and at the stop, for calibration */
+      UInt64 START_CLOCK = 0;
+      UInt64 STOP_CLOCK = 0;
+      UInt64 START_NS = 0;
+      UInt64 STOP_NS = 0;
+
+      UInt64 GetNanoseconds() {
+         ::timespec tTime;
+         ::clock_gettime(CLOCK_MONOTONIC, &tTime);
+         return static_cast<UInt64>(tTime.tv_sec) * 1000000000ULL + tTime.tv_nsec;
+      }
+
+      SThreadData& GetThreadData() {
+         if(THREAD_DATA == nullptr || THREAD_GENERATION != GENERATION) {
+            pthread_mutex_lock(&MUTEX);
+            THREAD_DATA = new SThreadData;
+            THREAD_DATA->Thread = THREADS.size();
+            THREAD_DATA->Timers.resize(BUFFER_SIZE);
+            THREAD_DATA->Recorded = 0;
+            THREAD_DATA->Stats.resize(ZONES.size());
+            THREADS.push_back(THREAD_DATA);
+            THREAD_GENERATION = GENERATION;
+            pthread_mutex_unlock(&MUTEX);
+         }
+         return *THREAD_DATA;
+      }
+
+      void WriteJSONString(std::ostream& c_os,
+                           const std::string& str_value) {
+         c_os << '"';
+         for(size_t i = 0; i < str_value.size(); ++i) {
+            if(str_value[i] == '"' || str_value[i] == '\\') {
+               c_os << '\\';
+            }
+            c_os << str_value[i];
+         }
+         c_os << '"';
+      }
+
+      /*
+       * Estimates the duration under which the given fraction of the timers fall.
+       */
+      UInt64 EstimatePercentile(const CTickProfiler::SStats& s_stats,
+                                Real f_fraction) {
+         UInt64 unTarget = static_cast<UInt64>(f_fraction * s_stats.Count);
+         UInt64 unSeen = 0;
+         for(UInt32 i = 0; i < CTickProfiler::HISTOGRAM_BUCKETS; ++i) {
+            unSeen += s_stats.Histogram[i];
+            if(unSeen > unTarget) {
+               /* Take the middle of the bucket, within the observed range */
+               UInt64 unMin = CTickProfiler::GetBucketMin(i);
+               UInt64 unMax = (i + 1 < CTickProfiler::HISTOGRAM_BUCKETS) ?
+                  CTickProfiler::GetBucketMin(i + 1) : unMin;
+               UInt64 unEstimate = unMin + (unMax - unMin) / 2;
+               return std::min(std::max(unEstimate, s_stats.Min), s_stats.Max);
+            }
+         }
+         return s_stats.Max;
+      }
+
+   }
+
+   /****************************************/
+   /****************************************/
+
+   CTickProfiler::SStats::SStats() :
+      Count(0),
+      Total(0),
+      Min(~0ULL),
+      Max(0) {
+      ::memset(Histogram, 0, sizeof(Histogram));
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CTickProfiler::SStats::Add(UInt64 un_duration) {
+      ++Count;
+      Total += un_duration;
+      if(un_duration < Min) Min = un_duration;
+      if(un_duration > Max) Max = un_duration;
+      ++Histogram[GetBucket(un_duration)];
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CTickProfiler::SStats::Merge(const SStats& s_stats) {
+      Count += s_stats.Count;
+      Total += s_stats.Total;
+      if(s_stats.Min < Min) Min = s_stats.Min;
+      if(s_stats.Max > Max) Max = s_stats.Max;
+      for(UInt32 i = 0; i < HISTOGRAM_BUCKETS; ++i) {
+         Histogram[i] += s_stats.Histogram[i];
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   UInt32 CTickProfiler::GetZone(const std::string& str_category,
+                                 const std::string& str_name) {
+      pthread_mutex_lock(&MUTEX);
+      std::pair<std::string, std::string> cKey(str_category, str_name);
+      auto it = ZONE_IDS.find(cKey);
+      UInt32 unZone;
+      if(it != ZONE_IDS.end()) {
+         unZone = it->second;
+      }
+      else {
+         unZone = ZONES.size();
+         ZONES.push_back(SZone{str_category, str_name});
+         ZONE_IDS[cKey] = unZone;
+      }
+      pthread_mutex_unlock(&MUTEX);
+      return unZone;
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CTickProfiler::Start(size_t un_buffer_size) {
+      pthread_mutex_lock(&MUTEX);
+      for(size_t i = 0; i < THREADS.size(); ++i) {
+         delete THREADS[i];
+      }
+      THREADS.clear();
+      ++GENERATION;
+      BUFFER_SIZE = un_buffer_size;
+      START_NS = GetNanoseconds();
+      START_CLOCK = ReadClock();
+      m_bStarted = true;
+      pthread_mutex_unlock(&MUTEX);
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CTickProfiler::Stop() {
+      if(!m_bStarted) return;
+      m_bStarted = false;
+      STOP_CLOCK = ReadClock();
+      STOP_NS = GetNanoseconds();
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CTickProfiler::Record(UInt32 un_zone,
+                              UInt64 un_start,
+                              UInt64 un_end) {
+      SThreadData& sData = GetThreadData();
+      if(!sData.Timers.empty()) {
+         sData.Timers[sData.Recorded % sData.Timers.size()] = STimer{un_zone, un_start, un_end};
+      }
+      ++sData.Recorded;
+      if(un_zone >= sData.Stats.size()) {
+         sData.Stats.resize(un_zone + 1);
+      }
+      sData.Stats[un_zone].Add(un_end - un_start);
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CTickProfiler::WriteTrace(const std::string& str_file_name) {
+      std::ofstream cOutFile(str_file_name.c_str(), std::ios::trunc | std::ios::out);
+      if(!cOutFile) {
+         THROW_ARGOSEXCEPTION("Can't open file \"" << str_file_name << "\" to write the profiler trace");
+      }
+      double fMicrosecondsPerTick = GetNanosecondsPerTick() * 1e-3;
+      cOutFile << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+      bool bFirst = true;
+      for(size_t t = 0; t < THREADS.size(); ++t) {
+         const SThreadData& sData = *THREADS[t];
+         /* Name the thread */
+         cOutFile << (bFirst ? "\n" : ",\n")
+                  << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << sData.Thread
+                  << ",\"args\":{\"name\":\"thread " << sData.Thread << "\"}}";
+         bFirst = false;
+         /* Write the timers in the buffer, from the oldest */
+         size_t unSize = sData.Timers.size();
+         UInt64 unCount = std::min<UInt64>(sData.Recorded, unSize);
+         UInt64 unFirst = sData.Recorded - unCount;
+         for(UInt64 i = unFirst; i < sData.Recorded; ++i) {
+            const STimer& sTimer = sData.Timers[i % unSize];
+            const SZone& sZone = ZONES[sTimer.Zone];
+            cOutFile << ",\n{\"name\":";
+            WriteJSONString(cOutFile, sZone.Name);
+            cOutFile << ",\"cat\":";
+            WriteJSONString(cOutFile, sZone.Category);
+            cOutFile << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << sData.Thread
+                     << ",\"ts\":" << (sTimer.Start - START_CLOCK) * fMicrosecondsPerTick
+                     << ",\"dur\":" << (sTimer.End - sTimer.Start) * fMicrosecondsPerTick
+                     << "}";
+         }
+      }
+      cOutFile << "\n]}" << std::endl;
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CTickProfiler::WriteSummary(const std::string& str_file_name) {
+      std::ofstream cOutFile(str_file_name.c_str(), std::ios::trunc | std::ios::out);
+      if(!cOutFile) {
+         THROW_ARGOSEXCEPTION("Can't open file \"" << str_file_name << "\" to write the profiler summary");
+      }
+      double fMicrosecondsPerTick = GetNanosecondsPerTick() * 1e-3;
+      /* Merge the statistics of the threads */
+      std::vector<SStats> vecStats(ZONES.size());
+      for(UInt32 i = 0; i < ZONES.size(); ++i) {
+         vecStats[i] = GetStats(i);
+      }
+      /* Sort the zones by category, and then by total time */
+      std::vector<UInt32> vecOrder;
+      for(UInt32 i = 0; i < ZONES.size(); ++i) {
+         if(vecStats[i].Count > 0) vecOrder.push_back(i);
+      }
+      std::sort(vecOrder.begin(), vecOrder.end(),
+                [&vecStats](UInt32 un_a, UInt32 un_b) {
+                   if(ZONES[un_a].Category != ZONES[un_b].Category) {
+                      return ZONES[un_a].Category < ZONES[un_b].Category;
+                   }
+                   return vecStats[un_a].Total > vecStats[un_b].Total;
+                });
+      cOutFile << "category,name,count,total_us,mean_us,min_us,p50_us,p90_us,p99_us,max_us" << std::endl;
+      for(size_t i = 0; i < vecOrder.size(); ++i) {
+         const SZone& sZone = ZONES[vecOrder[i]];
+         const SStats& sStats = vecStats[vecOrder[i]];
+         cOutFile << sZone.Category << ","
+                  << sZone.Name << ","
+                  << sStats.Count << ","
+                  << sStats.Total * fMicrosecondsPerTick << ","
+                  << sStats.Total * fMicrosecondsPerTick / sStats.Count << ","
+                  << sStats.Min * fMicrosecondsPerTick << ","
+                  << EstimatePercentile(sStats, 0.5) * fMicrosecondsPerTick << ","
+                  << EstimatePercentile(sStats, 0.9) * fMicrosecondsPerTick << ","
+                  << EstimatePercentile(sStats, 0.99) * fMicrosecondsPerTick << ","
+                  << sStats.Max * fMicrosecondsPerTick
+                  << std::endl;
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   CTickProfiler::SStats CTickProfiler::GetStats(UInt32 un_zone) {
+      SStats sStats;
+      for(size_t t = 0; t < THREADS.size(); ++t) {
+         if(un_zone < THREADS[t]->Stats.size()) {
+            sStats.Merge(THREADS[t]->Stats[un_zone]);
+         }
+      }
+      return sStats;
+   }
+
+   /****************************************/
+   /****************************************/
+
+   double CTickProfiler::GetNanosecondsPerTick() {
+#if defined(__x86_64__) || defined(__i386__)
+      UInt64 unStopClock = m_bStarted ? ReadClock() : STOP_CLOCK;
+      UInt64 unStopNs = m_bStarted ? GetNanoseconds() : STOP_NS;
+      if(unStopClock <= START_CLOCK) return 1.0;
+      return static_cast<double>(unStopNs - START_NS) / (unStopClock - START_CLOCK);
+#else
+      return 1.0;
+#endif
+   }
+
+   /****************************************/
+   /****************************************/
+
+   UInt32 CTickProfiler::GetBucket(UInt64 un_duration) {
+      /* Exact buckets for the smallest durations */
+      if(un_duration < HISTOGRAM_SUBBUCKETS) {
+         return un_duration;
+      }
+      /* Otherwise, HISTOGRAM_SUBBUCKETS buckets per power of two */
+      UInt32 unExponent = 63 - __builtin_clzll(un_duration);
+      UInt32 unFraction = (un_duration >> (unExponent - 2)) & (HISTOGRAM_SUBBUCKETS - 1);
+      return unExponent * HISTOGRAM_SUBBUCKETS + unFraction;
+   }
+
+   /****************************************/
+   /****************************************/
+
+   UInt64 CTickProfiler::GetBucketMin(UInt32 un_bucket) {
+      if(un_bucket < 2 * HISTOGRAM_SUBBUCKETS) {
+         /* The buckets between the exact ones and the first power of two are unused */
+         return std::min(un_bucket, HISTOGRAM_SUBBUCKETS);
+      }
+      UInt32 unExponent = un_bucket / HISTOGRAM_SUBBUCKETS;
+      UInt64 unFraction = un_bucket % HISTOGRAM_SUBBUCKETS;
+      return (1ULL << unExponent) | (unFraction << (unExponent - 2));
+   }
+
+   /****************************************/
+   /****************************************/
+
+}
@@ -0,0 +1,232 @@
+/**
+ * @file <argos3/core/utility/profiler/tick_profiler.h>
+ *
+ * A low-overhead profiler for the phases of a simulation tick.
+ *
+ * Code is instrumented with scoped timers attached to zones. A zone is
+ * identified by a category, such as "phase" or "sensor", and a name, such as
+ * "physics" or "footbot_proximity". Each thread records the timers in its own
+ * ring buffer, and also aggregates them into per-zone statistics and
+ * histograms. At the end of the experiment, the buffers are written as a
+ * Chrome trace (to be opened with chrome://tracing or Perfetto), and the
+ * statistics as a CSV summary.
+ *
+ * The timers are compiled in only when ARGoS is built with the CMake option
+ * ARGOS_TICK_PROFILER. Otherwise, the ARGOS_PROFILE_* macros expand to
+ * nothing. Even when compiled in, the timers record nothing unless the
+ * profiler was started, which CProfiler does when the <tt>&lt;profiling&gt;</tt>
+ * tag asks for a trace or a summary.
+ */
+#ifndef TICK_PROFILER_H
+#define TICK_PROFILER_H
+
+namespace argos {
+   class CTickProfiler;
+}
+
+#include <argos3/core/config.h>
+#include <argos3/core/utility/datatypes/datatypes.h>
+#include <string>
+#include <vector>
+#if defined(__x86_64__) || defined(__i386__)
+#  include <x86intrin.h>
+#else
+#  include <time.h>
+#endif
+
+namespace argos {
+
+   class CTickProfiler {
+
+   public:
+
+      /** The number of histogram buckets per power of two */
+      static const UInt32 HISTOGRAM_SUBBUCKETS = 4;
+
+      /** The number of histogram buckets */
+      static const UInt32 HISTOGRAM_BUCKETS = 64 * HISTOGRAM_SUBBUCKETS;
+
+      /**
+       * Timing statistics of a zone.
+       * The durations are in clock ticks, see ReadClock().
+       */
+      struct SStats {
+         UInt64 Count;
+         UInt64 Total;
+         UInt64 Min;
+         UInt64 Max;
+         /** Bucket <tt>i</tt> counts the durations d such that GetBucket(d) = i */
+         UInt64 Histogram[HISTOGRAM_BUCKETS];
+
+         SStats();
+
+         void Add(UInt64 un_duration);
+
+         void Merge(const SStats& s_stats);
+      };
+
+      /**
+       * A timer that records the time spent in its scope.
+       * Use it through the ARGOS_PROFILE_* macros.
+       */
+      class CScope {
+
+      public:
+
+         CScope(UInt32 un_zone) :
+            m_unZone(un_zone),
+            m_unStart(IsStarted() ? ReadClock() : 0) {}
+
+         ~CScope() {
+            if(m_unStart != 0) {
+               Record(m_unZone, m_unStart, ReadClock());
+            }
+         }
+
+      private:
+
+         UInt32 m_unZone;
+         UInt64 m_unStart;
+
+      };
+
+   public:
+
+      /**
+       * Returns the id of the zone with the given category and name.
+       * The zone is created the first time it is asked for.
+       * This function is thread-safe, but it takes a lock: in code executed
+       * often, keep the id instead of asking for it every time.
+       * @param str_category The category of the zone.
+       * @param str_name The name of the zone.
+       * @return The id of the zone.
+       */
+      static UInt32 GetZone(const std::string& str_category,
+                            const std::string& str_name);
+
+      /**
+       * Starts recording.
+       * The data recorded so far is discarded.
+       * @param un_buffer_size The number of timers kept per thread for the trace.
+       * When a buffer is full, the oldest timers are overwritten. The statistics
+       * include all the timers.
+       */
+      static void Start(size_t un_buffer_size);
+
+      /**
+       * Stops recording.
+       */
+      static void Stop();
+
+      /**
+       * Returns <tt>true</tt> if the profiler is recording.
+       * @return <tt>true</tt> if the profiler is recording.
+       */
+      static inline bool IsStarted() {
+         return m_bStarted;
+      }
+
+      /**
+       * Records a timer.
+       * @param un_zone The zone of the timer.
+       * @param un_start The clock at the start of the timer.
+       * @param un_end The clock at the end of the timer.
+       */
+      static void Record(UInt32 un_zone,
+                         UInt64 un_start,
+                         UInt64 un_end);
+
+      /**
+       * Writes the timers kept in the buffers as a Chrome trace.
+       * Call this function when no thread is recording.
+       * @param str_file_name The name of the file to write.
+       * @throws CARGoSException if the file cannot be written.
+       */
+      static void WriteTrace(const std::string& str_file_name);
+
+      /**
+       * Writes the statistics of each zone as CSV.
+       * The durations are written in microseconds. The percentiles are
+       * estimated from the histograms, within a few percent.
+       * Call this function when no thread is recording.
+       * @param str_file_name The name of the file to write.
+       * @throws CARGoSException if the file cannot be written.
+       */
+      static void WriteSummary(const std::string& str_file_name);
+
+      /**
+       * Returns the statistics of a zone, merged over all the threads.
+       * Call this function when no thread is recording.
+       * @param un_zone The zone.
+       * @return The statistics of the zone.
+       */
+      static SStats GetStats(UInt32 un_zone);
+
+      /**
+       * Returns the number of nanoseconds in a clock tick.
+       * The value is measured between Start() and the last call to Stop().
+       * @return The number of nanoseconds in a clock tick.
+       */
+      static double GetNanosecondsPerTick();
+
+      /**
+       * Returns the current value of the clock.
+       * On x86 processors, the clock is the time-stamp counter. Otherwise,
+       * it is the monotonic clock of the system, in nanoseconds.
+       * @return The current value of the clock.
+       */
+      static inline UInt64 ReadClock() {
+#if defined(__x86_64__) || defined(__i386__)
+         return __rdtsc();
+#else
+         ::timespec tTime;
+         ::clock_gettime(CLOCK_MONOTONIC, &tTime);
+         return static_cast<UInt64>(tTime.tv_sec) * 1000000000ULL + tTime.tv_nsec;
+#endif
+      }
+
+      /**
+       * Returns the histogram bucket of a duration.
+       * @param un_duration The duration.
+       * @return The histogram bucket of a duration.
+       */
+      static UInt32 GetBucket(UInt64 un_duration);
+
+      /**
+       * Returns the smallest duration that falls in the given histogram bucket.
+       * @param un_bucket The histogram bucket.
+       * @return The smallest duration that falls in the given histogram bucket.
+       */
+      static UInt64 GetBucketMin(UInt32 un_bucket);
+
+   private:
+
+      static bool m_bStarted;
+
+   };
+
+}
+
+#define ARGOS_PROFILE_CONCAT2(A, B) A ## B
+#define ARGOS_PROFILE_CONCAT(A, B) ARGOS_PROFILE_CONCAT2(A, B)
+
+#ifdef ARGOS_TICK_PROFILER
+/**
+ * Times the rest of the current scope in the zone with the given id.
+ */
+#  define ARGOS_PROFILE_ZONE(ZONE)                                      \
+   argos::CTickProfiler::CScope ARGOS_PROFILE_CONCAT(cTickProfilerScope, __LINE__)(ZONE)
+/**
+ * Times the rest of the current scope in the zone with the given category and name.
+ * The zone id is looked up once, so the category and name must be constant.
+ */
+#  define ARGOS_PROFILE_STATIC_ZONE(CATEGORY, NAME)                     \
+   static const argos::UInt32 ARGOS_PROFILE_CONCAT(unTickProfilerZone, __LINE__) = \
+      argos::CTickProfiler::GetZone(CATEGORY, NAME);                    \
+   ARGOS_PROFILE_ZONE(ARGOS_PROFILE_CONCAT(unTickProfilerZone, __LINE__))
+#else
+#  define ARGOS_PROFILE_ZONE(ZONE)
+#  define ARGOS_PROFILE_STATIC_ZONE(CATEGORY, NAME)
+#endif
+
+#endif
@@ -25,6 +25,7 @@ namespace argos {
       m_pcEmbodiedEntity(nullptr),
       m_bShowRays(false),
       m_pcRNG(nullptr),
+      m_pcCounterRNG(nullptr),
       m_bAddNoise(false),
       m_cSpace(CSimulator::GetInstance().GetSpace()) {}
 
@@ -63,7 +64,19 @@ namespace argos {
          else if(fNoiseLevel > 0.0f) {
             m_bAddNoise = true;
             m_cNoiseRange.Set(-fNoiseLevel, fNoiseLevel);
-            m_pcRNG = CRandom::CreateRNG("argos");
+            /* Parse the type of random number generator */
+            std::string strNoiseRNG = "default";
+            GetNodeAttributeOrDefault(t_tree, "noise_rng", strNoiseRNG, strNoiseRNG);
+            if(strNoiseRNG == "default") {
+               m_pcRNG = CRandom::CreateRNG("argos");
+            }
+            else if(strNoiseRNG == "counter") {
+               /* The id of the sensor entity tells apart the proximity sensors of a robot */
+               m_pcCounterRNG = CRandom::CreateCounterRNG("argos", "epuck_proximity/" + m_pcProximityEntity->GetId());
+            }
+            else {
+               THROW_ARGOSEXCEPTION("Unknown noise_rng \"" << strNoiseRNG << "\" for the proximity sensor; allowed values are \"default\" and \"counter\"");
+            }
          }
       }
       catch(CARGoSException& ex) {
@@ -80,14 +93,10 @@ namespace argos {
       if (IsDisabled()) {
         return;
       }
-      /* Ray used for scanning the environment for obstacles */
-      CRay3 cScanningRay;
+      /* Compute the rays of all the sensors */
+      m_vecRays.resize(m_tReadings.size());
       CVector3 cRayStart, cRayEnd;
-      /* Buffers to contain data about the intersection */
-      SEmbodiedEntityIntersectionItem sIntersection;
-      /* Go through the sensors */
       for(UInt32 i = 0; i < m_tReadings.size(); ++i) {
-         /* Compute ray for sensor i */
          cRayStart = m_pcProximityEntity->GetSensor(i).Offset;
          cRayStart.Rotate(m_pcProximityEntity->GetSensor(i).Anchor.Orientation);
          cRayStart += m_pcProximityEntity->GetSensor(i).Anchor.Position;
@@ -95,12 +104,26 @@ namespace argos {
          cRayEnd += m_pcProximityEntity->GetSensor(i).Direction;
          cRayEnd.Rotate(m_pcProximityEntity->GetSensor(i).Anchor.Orientation);
          cRayEnd += m_pcProximityEntity->GetSensor(i).Anchor.Position;
-         cScanningRay.Set(cRayStart,cRayEnd);
+         m_vecRays[i].Set(cRayStart,cRayEnd);
+      }
+      /* Get the closest intersection of each ray */
+      GetClosestEmbodiedEntitiesIntersectedByRays(m_tIntersections,
+                                                  m_vecRays,
+                                                  *m_pcEmbodiedEntity);
+      /* Draw the noise of all the sensors at once, for this robot and tick.
+         The robot is known by its id, which survives a respawn from a pool. */
+      if(m_pcCounterRNG != nullptr) {
+         m_vecNoise.resize(m_tReadings.size());
+         m_pcCounterRNG->Seek(CRandom::CCounterRNG::Hash(m_pcEmbodiedEntity->GetRootEntity().GetId()),
+                              m_cSpace.GetSimulationClock());
+         m_pcCounterRNG->Uniform(m_vecNoise, m_cNoiseRange);
+      }
+      /* Go through the sensors */
+      for(UInt32 i = 0; i < m_tReadings.size(); ++i) {
+         const CRay3& cScanningRay = m_vecRays[i];
+         const SEmbodiedEntityIntersectionItem& sIntersection = m_tIntersections[i];
          /* Compute reading */
-         /* Get the closest intersection */
-         if(GetClosestEmbodiedEntityIntersectedByRay(sIntersection,
-                                                     cScanningRay,
-                                                     *m_pcEmbodiedEntity)) {
+         if(sIntersection.IntersectedEntity != nullptr) {
             /* There is an intersection */
             if(m_bShowRays) {
                m_pcControllableEntity->AddIntersectionPoint(cScanningRay,
@@ -118,7 +141,10 @@ namespace argos {
             }
          }
          /* Apply noise to the sensor */
-         if(m_bAddNoise)
+         if(m_pcCounterRNG != nullptr) {
+            m_tReadings[i].Value += m_vecNoise[i];
+         }
+         else if(m_bAddNoise)
          {
             m_tReadings[i].Value += m_pcRNG->Uniform(m_cNoiseRange);
          }
@@ -164,7 +190,8 @@ namespace argos {
 
                    "This sensor accesses the epuck proximity sensor. For a complete description\n"
                    "of its usage, refer to the ci_epuck_proximity_sensor.h interface. For the XML\n"
-                   "configuration, refer to the default proximity sensor.\n",
+                   "configuration, refer to the default proximity sensor, including its\n"
+                   "\"noise_rng\" attribute.\n",
 
                    "Usable"
 		  );
@@ -25,6 +25,7 @@ namespace argos {
       m_pcEmbodiedEntity(nullptr),
       m_bShowRays(false),
       m_pcRNG(nullptr),
+      m_pcCounterRNG(nullptr),
       m_bAddNoise(false),
       m_cSpace(CSimulator::GetInstance().GetSpace()) {}
 
@@ -60,7 +61,19 @@ namespace argos {
          else if(fNoiseLevel > 0.0f) {
             m_bAddNoise = true;
             m_cNoiseRange.Set(-fNoiseLevel, fNoiseLevel);
-            m_pcRNG = CRandom::CreateRNG("argos");
+            /* Parse the type of random number generator */
+            std::string strNoiseRNG = "default";
+            GetNodeAttributeOrDefault(t_tree, "noise_rng", strNoiseRNG, strNoiseRNG);
+            if(strNoiseRNG == "default") {
+               m_pcRNG = CRandom::CreateRNG("argos");
+            }
+            else if(strNoiseRNG == "counter") {
+               /* The id of the sensor entity tells apart the proximity sensors of a robot */
+               m_pcCounterRNG = CRandom::CreateCounterRNG("argos", "proximity/" + m_pcProximityEntity->GetId());
+            }
+            else {
+               THROW_ARGOSEXCEPTION("Unknown noise_rng \"" << strNoiseRNG << "\" for the proximity sensor; allowed values are \"default\" and \"counter\"");
+            }
          }
          m_tReadings.resize(m_pcProximityEntity->GetNumSensors());
       }
@@ -79,14 +92,10 @@ namespace argos {
       if (IsDisabled()) {
         return;
       }
-      /* Ray used for scanning the environment for obstacles */
-      CRay3 cScanningRay;
+      /* Compute the rays of all the sensors */
+      m_vecRays.resize(m_tReadings.size());
       CVector3 cRayStart, cRayEnd;
-      /* Buffers to contain data about the intersection */
-      SEmbodiedEntityIntersectionItem sIntersection;
-      /* Go through the sensors */
       for(UInt32 i = 0; i < m_tReadings.size(); ++i) {
-         /* Compute ray for sensor i */
          cRayStart = m_pcProximityEntity->GetSensor(i).Offset;
          cRayStart.Rotate(m_pcProximityEntity->GetSensor(i).Anchor.Orientation);
          cRayStart += m_pcProximityEntity->GetSensor(i).Anchor.Position;
@@ -94,12 +103,26 @@ namespace argos {
          cRayEnd += m_pcProximityEntity->GetSensor(i).Direction;
          cRayEnd.Rotate(m_pcProximityEntity->GetSensor(i).Anchor.Orientation);
          cRayEnd += m_pcProximityEntity->GetSensor(i).Anchor.Position;
-         cScanningRay.Set(cRayStart,cRayEnd);
+         m_vecRays[i].Set(cRayStart,cRayEnd);
+      }
+      /* Get the closest intersection of each ray */
+      GetClosestEmbodiedEntitiesIntersectedByRays(m_tIntersections,
+                                                  m_vecRays,
+                                                  *m_pcEmbodiedEntity);
+      /* Draw the noise of all the sensors at once, for this robot and tick.
+         The robot is known by its id, which survives a respawn from a pool. */
+      if(m_pcCounterRNG != nullptr) {
+         m_vecNoise.resize(m_tReadings.size());
+         m_pcCounterRNG->Seek(CRandom::CCounterRNG::Hash(m_pcEmbodiedEntity->GetRootEntity().GetId()),
+                              m_cSpace.GetSimulationClock());
+         m_pcCounterRNG->Uniform(m_vecNoise, m_cNoiseRange);
+      }
+      /* Go through the sensors */
+      for(UInt32 i = 0; i < m_tReadings.size(); ++i) {
+         const CRay3& cScanningRay = m_vecRays[i];
+         const SEmbodiedEntityIntersectionItem& sIntersection = m_tIntersections[i];
          /* Compute reading */
-         /* Get the closest intersection */
-         if(GetClosestEmbodiedEntityIntersectedByRay(sIntersection,
-                                                     cScanningRay,
-                                                     *m_pcEmbodiedEntity)) {
+         if(sIntersection.IntersectedEntity != nullptr) {
             /* There is an intersection */
             if(m_bShowRays) {
                m_pcControllableEntity->AddIntersectionPoint(cScanningRay,
@@ -116,7 +139,10 @@ namespace argos {
             }
          }
          /* Apply noise to the sensor */
-         if(m_bAddNoise) {
+         if(m_pcCounterRNG != nullptr) {
+            m_tReadings[i] += m_vecNoise[i];
+         }
+         else if(m_bAddNoise) {
             m_tReadings[i] += m_pcRNG->Uniform(m_cNoiseRange);
          }
          /* Trunc the reading between 0 and 1 */
@@ -216,6 +242,30 @@ namespace argos {
                    "      ...\n"
                    "    </my_controller>\n"
                    "    ...\n"
+                   "  </controllers>\n\n"
+
+                   "By default, each sensor draws its noise from its own random number generator.\n"
+                   "With the attribute \"noise_rng\" set to \"counter\", the noise is drawn from a\n"
+                   "counter-based generator as a function of the robot id, the id of the sensor\n"
+                   "entity and the simulation tick. Each sensor then needs a few tens of bytes of\n"
+                   "state instead of 2.5 KB, and the noise of a robot does not depend on when the\n"
+                   "robot was created. Both generators give the same results for any number of\n"
+                   "threads.\n\n"
+
+                   "  <controllers>\n"
+                   "    ...\n"
+                   "    <my_controller ...>\n"
+                   "      ...\n"
+                   "      <sensors>\n"
+                   "        ...\n"
+                   "        <proximity implementation=\"default\"\n"
+                   "                   noise_level=\"0.1\"\n"
+                   "                   noise_rng=\"counter\" />\n"
+                   "        ...\n"
+                   "      </sensors>\n"
+                   "      ...\n"
+                   "    </my_controller>\n"
+                   "    ...\n"
                    "  </controllers>\n\n",
 
                    "Usable"
@@ -80,6 +80,12 @@ namespace argos {
       /** Random number generator */
       CRandom::CRNG* m_pcRNG;
 
+      /** Counter-based random number generator, used instead of m_pcRNG if set */
+      CRandom::CCounterRNG* m_pcCounterRNG;
+
+      /** The noise of each sensor, drawn in a single batch */
+      std::vector<Real> m_vecNoise;
+
       /** Whether to add noise or not */
       bool m_bAddNoise;
 
@@ -88,6 +94,12 @@ namespace argos {
 
       /** Reference to the space */
       CSpace& m_cSpace;
+
+      /** The rays of the sensors, checked in a single batch */
+      std::vector<CRay3> m_vecRays;
+
+      /** The closest intersection of each ray */
+      TEmbodiedEntityIntersectionData m_tIntersections;
    };
 
 }
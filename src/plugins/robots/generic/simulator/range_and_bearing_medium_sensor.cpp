@@ -81,14 +81,14 @@ namespace argos {
       /* Delete old readings */
       m_tReadings.clear();
       /* Get list of communicating RABs */
-      const CSet<CRABEquippedEntity*,SEntityComparator>& setRABs = m_pcRangeAndBearingMedium->GetRABsCommunicatingWith(*m_pcRangeAndBearingEquippedEntity);
+      CRABMedium::SRABView cRABs = m_pcRangeAndBearingMedium->GetRABViewCommunicatingWith(*m_pcRangeAndBearingEquippedEntity);
       /* Buffer for calculating the message--robot distance */
       CVector3 cVectorRobotToMessage;
       /* Buffer for the received packet */
       CCI_RangeAndBearingSensor::SPacket sPacket;
       /* Go through communicating RABs and create packets */
-      for(CSet<CRABEquippedEntity*>::iterator it = setRABs.begin();
-          it != setRABs.end(); ++it) {
+      for(CRABMedium::SRABView::const_iterator it = cRABs.begin();
+          it != cRABs.end(); ++it) {
          /* Should we drop this packet? */
          if(m_pcRNG == nullptr || /* No noise to apply */
             !(m_fPacketDropProb > 0.0f &&
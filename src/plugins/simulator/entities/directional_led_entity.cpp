@@ -155,6 +155,30 @@ namespace argos {
    /****************************************/
    /****************************************/
 
+   CDirectionalLEDEntityFlatGridUpdater::CDirectionalLEDEntityFlatGridUpdater(CFlatGrid<CDirectionalLEDEntity>& c_grid) :
+      m_cGrid(c_grid) {}
+
+   /****************************************/
+   /****************************************/
+
+   bool CDirectionalLEDEntityFlatGridUpdater::operator()(CDirectionalLEDEntity& c_entity) {
+      try {
+         /* Calculate the position of the LED in the flat grid */
+         m_cGrid.PositionToCell(m_nI, m_nJ, m_nK, c_entity.GetPosition());
+         /* Update the corresponding cell */
+         m_cGrid.UpdateCell(m_nI, m_nJ, m_nK, c_entity);
+      }
+      catch(CARGoSException& ex) {
+         THROW_ARGOSEXCEPTION_NESTED("While updating the directional LED flat grid for LED \"" <<
+                                     c_entity.GetContext() + c_entity.GetId() << "\"", ex);
+      }
+      /* Continue with the other entities */
+      return true;
+   }
+
+   /****************************************/
+   /****************************************/
+
    class CSpaceOperationAddCDirectionalLEDEntity : public CSpaceOperationAddEntity {
    public:
       void ApplyTo(CSpace& c_space, CDirectionalLEDEntity& c_entity) {
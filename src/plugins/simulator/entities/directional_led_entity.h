@@ -18,6 +18,7 @@ namespace argos {
 #include <argos3/core/utility/math/vector3.h>
 #include <argos3/core/simulator/space/positional_indices/space_hash.h>
 #include <argos3/core/simulator/space/positional_indices/grid.h>
+#include <argos3/core/simulator/space/positional_indices/flat_grid.h>
 
 namespace argos {
 
@@ -170,6 +171,23 @@ namespace argos {
    /****************************************/
    /****************************************/
 
+   class CDirectionalLEDEntityFlatGridUpdater : public CFlatGrid<CDirectionalLEDEntity>::COperation {
+
+   public:
+
+      CDirectionalLEDEntityFlatGridUpdater(CFlatGrid<CDirectionalLEDEntity>& c_grid);
+      virtual bool operator()(CDirectionalLEDEntity& c_entity);
+
+   private:
+
+      CFlatGrid<CDirectionalLEDEntity>& m_cGrid;
+      SInt32 m_nI, m_nJ, m_nK;
+
+   };
+
+   /****************************************/
+   /****************************************/
+
 }
 
 #endif
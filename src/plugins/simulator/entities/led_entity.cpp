@@ -150,6 +150,34 @@ namespace argos {
    /****************************************/
    /****************************************/
 
+   CLEDEntityFlatGridUpdater::CLEDEntityFlatGridUpdater(CFlatGrid<CLEDEntity>& c_grid,
+                                                        size_t un_stage) :
+      m_cGrid(c_grid),
+      m_unStage(un_stage) {}
+
+   /****************************************/
+   /****************************************/
+
+   bool CLEDEntityFlatGridUpdater::operator()(CLEDEntity& c_entity) {
+      /* Discard disabled and switched off LEDs */
+      if(c_entity.GetColor() != CColor::BLACK) {
+         try {
+            /* Calculate the position of the LED in the flat grid */
+            m_cGrid.PositionToCell(m_nI, m_nJ, m_nK, c_entity.GetPosition());
+            /* Update the corresponding cell */
+            m_cGrid.UpdateCell(m_nI, m_nJ, m_nK, c_entity, m_unStage);
+         }
+         catch(CARGoSException& ex) {
+            THROW_ARGOSEXCEPTION_NESTED("While updating the LED flat grid for LED \"" << c_entity.GetContext() << c_entity.GetId() << "\"", ex);
+         }
+      }
+      /* Continue with the other entities */
+      return true;
+   }
+
+   /****************************************/
+   /****************************************/
+
    class CSpaceOperationAddCLEDEntity : public CSpaceOperationAddEntity {
    public:
       void ApplyTo(CSpace& c_space, CLEDEntity& c_entity) {
@@ -18,6 +18,7 @@ namespace argos {
 #include <argos3/core/utility/math/vector3.h>
 #include <argos3/core/simulator/space/positional_indices/space_hash.h>
 #include <argos3/core/simulator/space/positional_indices/grid.h>
+#include <argos3/core/simulator/space/positional_indices/flat_grid.h>
 
 namespace argos {
 
@@ -159,6 +160,25 @@ namespace argos {
    /****************************************/
    /****************************************/
 
+   class CLEDEntityFlatGridUpdater : public CFlatGrid<CLEDEntity>::COperation {
+
+   public:
+
+      CLEDEntityFlatGridUpdater(CFlatGrid<CLEDEntity>& c_grid,
+                                size_t un_stage = 0);
+      virtual bool operator()(CLEDEntity& c_entity);
+
+   private:
+
+      CFlatGrid<CLEDEntity>& m_cGrid;
+      size_t m_unStage;
+      SInt32 m_nI, m_nJ, m_nK;
+
+   };
+
+   /****************************************/
+   /****************************************/
+
 }
 
 #endif
@@ -395,4 +395,20 @@ namespace argos {
    /****************************************/
    /****************************************/
 
+   CRABEquippedEntityFlatGridEntityUpdater::CRABEquippedEntityFlatGridEntityUpdater(CFlatGrid<CRABEquippedEntity>& c_grid) :
+      m_cGrid(c_grid) {}
+
+   bool CRABEquippedEntityFlatGridEntityUpdater::operator()(CRABEquippedEntity& c_entity) {
+      m_cGrid.UpdateCellsInBoxRange(c_entity.GetPosition(),
+                                    CVector3(c_entity.GetRange(),
+                                             c_entity.GetRange(),
+                                             c_entity.GetRange()),
+                                    c_entity);
+      /* Continue with the other entities */
+      return true;
+   }
+
+   /****************************************/
+   /****************************************/
+
 }
@@ -20,6 +20,7 @@ namespace argos {
 #include <argos3/core/utility/math/vector3.h>
 #include <argos3/core/simulator/space/positional_indices/space_hash.h>
 #include <argos3/core/simulator/space/positional_indices/grid.h>
+#include <argos3/core/simulator/space/positional_indices/flat_grid.h>
 
 namespace argos {
 
@@ -161,6 +162,21 @@ namespace argos {
    /****************************************/
    /****************************************/
 
+   class CRABEquippedEntityFlatGridEntityUpdater : public CFlatGrid<CRABEquippedEntity>::COperation {
+
+   public:
+
+      CRABEquippedEntityFlatGridEntityUpdater(CFlatGrid<CRABEquippedEntity>& c_grid);
+      virtual bool operator()(CRABEquippedEntity& c_entity);
+
+   private:
+
+      CFlatGrid<CRABEquippedEntity>& m_cGrid;
+   };
+
+   /****************************************/
+   /****************************************/
+
 }
 
 #endif
@@ -134,6 +134,30 @@ namespace argos {
    /****************************************/
    /****************************************/
 
+   CRadioEntityFlatGridUpdater::CRadioEntityFlatGridUpdater(CFlatGrid<CRadioEntity>& c_grid) :
+      m_cGrid(c_grid) {}
+
+   /****************************************/
+   /****************************************/
+
+   bool CRadioEntityFlatGridUpdater::operator()(CRadioEntity& c_entity) {
+      try {
+         /* Calculate the position of the radio in the flat grid */
+         m_cGrid.PositionToCell(m_nI, m_nJ, m_nK, c_entity.GetPosition());
+         /* Update the corresponding cell */
+         m_cGrid.UpdateCell(m_nI, m_nJ, m_nK, c_entity);
+      }
+      catch(CARGoSException& ex) {
+         THROW_ARGOSEXCEPTION_NESTED("While updating the radio flat grid for radio \"" <<
+                                     c_entity.GetContext() + c_entity.GetId() << "\"", ex);
+      }
+      /* Continue with the other entities */
+      return true;
+   }
+
+   /****************************************/
+   /****************************************/
+
    class CSpaceOperationAddCRadioEntity : public CSpaceOperationAddEntity {
    public:
       void ApplyTo(CSpace& c_space, CRadioEntity& c_entity) {
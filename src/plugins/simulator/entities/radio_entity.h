@@ -18,6 +18,7 @@ namespace argos {
 #include <argos3/core/utility/datatypes/byte_array.h>
 #include <argos3/core/simulator/space/positional_indices/space_hash.h>
 #include <argos3/core/simulator/space/positional_indices/grid.h>
+#include <argos3/core/simulator/space/positional_indices/flat_grid.h>
 
 namespace argos {
 
@@ -175,6 +176,23 @@ namespace argos {
    /****************************************/
    /****************************************/
 
+   class CRadioEntityFlatGridUpdater : public CFlatGrid<CRadioEntity>::COperation {
+
+   public:
+
+      CRadioEntityFlatGridUpdater(CFlatGrid<CRadioEntity>& c_grid);
+      virtual bool operator()(CRadioEntity& c_entity);
+
+   private:
+
+      CFlatGrid<CRadioEntity>& m_cGrid;
+      SInt32 m_nI, m_nJ, m_nK;
+
+   };
+
+   /****************************************/
+   /****************************************/
+
 }
 
 #endif
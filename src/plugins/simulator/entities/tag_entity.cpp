@@ -157,6 +157,30 @@ namespace argos {
    /****************************************/
    /****************************************/
 
+   CTagEntityFlatGridUpdater::CTagEntityFlatGridUpdater(CFlatGrid<CTagEntity>& c_grid) :
+      m_cGrid(c_grid) {}
+
+   /****************************************/
+   /****************************************/
+
+   bool CTagEntityFlatGridUpdater::operator()(CTagEntity& c_entity) {
+      try {
+         /* Calculate the position of the tag in the flat grid */
+         m_cGrid.PositionToCell(m_nI, m_nJ, m_nK, c_entity.GetPosition());
+         /* Update the corresponding cell */
+         m_cGrid.UpdateCell(m_nI, m_nJ, m_nK, c_entity);
+      }
+      catch(CARGoSException& ex) {
+         THROW_ARGOSEXCEPTION_NESTED("While updating the tag flat grid for tag \"" <<
+                                     c_entity.GetContext() + c_entity.GetId() << "\"", ex);
+      }
+      /* Continue with the other entities */
+      return true;
+   }
+
+   /****************************************/
+   /****************************************/
+
    class CSpaceOperationAddCTagEntity : public CSpaceOperationAddEntity {
    public:
       void ApplyTo(CSpace& c_space, CTagEntity& c_entity) {
@@ -17,6 +17,7 @@ namespace argos {
 #include <argos3/core/utility/math/vector3.h>
 #include <argos3/core/simulator/space/positional_indices/space_hash.h>
 #include <argos3/core/simulator/space/positional_indices/grid.h>
+#include <argos3/core/simulator/space/positional_indices/flat_grid.h>
 
 namespace argos {
 
@@ -180,6 +181,23 @@ namespace argos {
    /****************************************/
    /****************************************/
 
+   class CTagEntityFlatGridUpdater : public CFlatGrid<CTagEntity>::COperation {
+
+   public:
+
+      CTagEntityFlatGridUpdater(CFlatGrid<CTagEntity>& c_grid);
+      virtual bool operator()(CTagEntity& c_entity);
+
+   private:
+
+      CFlatGrid<CTagEntity>& m_cGrid;
+      SInt32 m_nI, m_nJ, m_nK;
+
+   };
+
+   /****************************************/
+   /****************************************/
+
 }
 
 #endif
@@ -65,8 +65,8 @@ namespace argos {
       /** A positional index for the LED entities */
       CPositionalIndex<CDirectionalLEDEntity>* m_pcDirectionalLEDEntityIndex;
 
-      /** The update operation for the grid positional index */
-      CDirectionalLEDEntityGridUpdater* m_pcDirectionalLEDEntityGridUpdateOperation;
+      /** The update operation for the grid positional indices */
+      CPositionalIndex<CDirectionalLEDEntity>::COperation* m_pcDirectionalLEDEntityGridUpdateOperation;
 
    };
 
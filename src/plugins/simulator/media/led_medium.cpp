@@ -1,7 +1,6 @@
 #include "led_medium.h"
 #include <argos3/core/simulator/simulator.h>
 #include <argos3/core/simulator/space/space.h>
-#include <argos3/core/simulator/space/positional_indices/grid.h>
 #include <argos3/core/utility/configuration/argos_exception.h>
 #include <argos3/core/utility/logging/argos_log.h>
 
@@ -10,7 +9,9 @@ namespace argos {
    /****************************************/
    /****************************************/
 
-   CLEDMedium::CLEDMedium() {
+   CLEDMedium::CLEDMedium() :
+      m_pcLEDEntityGridUpdateOperation(nullptr),
+      m_pcFlatGrid(nullptr) {
    }
 
    /****************************************/
@@ -25,38 +26,10 @@ namespace argos {
    void CLEDMedium::Init(TConfigurationNode& t_tree) {
       try {
          CMedium::Init(t_tree);
-         /* Get the positional index method */
-         std::string strPosIndexMethod("grid");
-         GetNodeAttributeOrDefault(t_tree, "index", strPosIndexMethod, strPosIndexMethod);
-         /* Get the arena center and size */
-         CVector3 cArenaCenter;
-         CVector3 cArenaSize;
-         TConfigurationNode& tArena = GetNode(CSimulator::GetInstance().GetConfigurationRoot(), "arena");
-         GetNodeAttribute(tArena, "size", cArenaSize);
-         GetNodeAttributeOrDefault(tArena, "center", cArenaCenter, cArenaCenter);
          /* Create the positional index for LED entities */
-         if(strPosIndexMethod == "grid") {
-            size_t punGridSize[3];
-            if(!NodeAttributeExists(t_tree, "grid_size")) {
-               punGridSize[0] = static_cast<UInt32>(cArenaSize.GetX());
-               punGridSize[1] = static_cast<UInt32>(cArenaSize.GetY());
-               punGridSize[2] = static_cast<UInt32>(cArenaSize.GetZ());
-            }
-            else {
-               std::string strPosGridSize;
-               GetNodeAttribute(t_tree, "grid_size", strPosGridSize);
-               ParseValues<size_t>(strPosGridSize, 3, punGridSize, ',');
-            }
-            CGrid<CLEDEntity>* pcGrid = new CGrid<CLEDEntity>(
-               cArenaCenter - cArenaSize * 0.5f, cArenaCenter + cArenaSize * 0.5f,
-               punGridSize[0], punGridSize[1], punGridSize[2]);
-            m_pcLEDEntityGridUpdateOperation = new CLEDEntityGridUpdater(*pcGrid);
-            pcGrid->SetUpdateEntityOperation(m_pcLEDEntityGridUpdateOperation);
-            m_pcLEDEntityIndex = pcGrid;
-         }
-         else {
-            THROW_ARGOSEXCEPTION("Unknown method \"" << strPosIndexMethod << "\" for the positional index.");
-         }
+         m_pcLEDEntityIndex = CreateGridIndex<CLEDEntity, CLEDEntityGridUpdater, CLEDEntityFlatGridUpdater>(
+            t_tree, m_pcLEDEntityGridUpdateOperation);
+         m_pcFlatGrid = dynamic_cast<CFlatGrid<CLEDEntity>*>(m_pcLEDEntityIndex);
       }
       catch(CARGoSException& ex) {
          THROW_ARGOSEXCEPTION_NESTED("Error in initialization of the LED medium", ex);
@@ -85,6 +58,9 @@ namespace argos {
       if(m_pcLEDEntityGridUpdateOperation != nullptr) {
          delete m_pcLEDEntityGridUpdateOperation;
       }
+      for(size_t i = 0; i < m_vecStageUpdateOperations.size(); ++i) {
+         delete m_vecStageUpdateOperations[i];
+      }
    }
 
    /****************************************/
@@ -97,6 +73,36 @@ namespace argos {
    /****************************************/
    /****************************************/
 
+   size_t CLEDMedium::BeginUpdate() {
+      /* Only the flat grid can be updated in parallel */
+      if(m_pcFlatGrid == nullptr) return 0;
+      /* One stage per thread, each with its own update operation */
+      size_t unStages = Max<UInt32>(1, CSimulator::GetInstance().GetNumThreads());
+      while(m_vecStageUpdateOperations.size() < unStages) {
+         m_vecStageUpdateOperations.push_back(
+            new CLEDEntityFlatGridUpdater(*m_pcFlatGrid, m_vecStageUpdateOperations.size()));
+      }
+      m_pcFlatGrid->BeginUpdate(unStages);
+      return unStages;
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CLEDMedium::UpdateTask(size_t un_task) {
+      m_pcFlatGrid->UpdateStage(un_task, *m_vecStageUpdateOperations[un_task]);
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CLEDMedium::EndUpdate() {
+      m_pcFlatGrid->EndUpdate();
+   }
+
+   /****************************************/
+   /****************************************/
+
    void CLEDMedium::AddEntity(CLEDEntity& c_entity) {
       m_pcLEDEntityIndex->AddEntity(c_entity);
       m_pcLEDEntityIndex->Update();
@@ -125,7 +131,11 @@ namespace argos {
                    "REQUIRED XML CONFIGURATION\n\n"
                    "<led id=\"led\" />\n\n"
                    "OPTIONAL XML CONFIGURATION\n\n"
-                   "None for the time being\n",
+                   "With index=\"flat_grid\", the LED entities are indexed in a flat grid, which is\n"
+                   "faster with many entities. 'grid_size' sets the cells per axis (default: 1/m):\n\n"
+                   "<led id=\"led\" index=\"flat_grid\" grid_size=\"20,20,1\" />\n\n"
+                   "When ARGoS runs with multiple threads, the flat grid is rebuilt by all the\n"
+                   "threads together.\n\n",
                    "Under development"
       );
 
@@ -32,6 +32,12 @@ namespace argos {
       virtual void Destroy();
       virtual void Update();
 
+      virtual size_t BeginUpdate();
+
+      virtual void UpdateTask(size_t un_task);
+
+      virtual void EndUpdate();
+
      /**
       * Adds the specified entity to the list of managed entities.
       * @param c_entity The entity to add.
@@ -57,8 +63,14 @@ namespace argos {
       /** A positional index for the LED entities */
       CPositionalIndex<CLEDEntity>* m_pcLEDEntityIndex;
 
-      /** The update operation for the grid positional index */
-      CLEDEntityGridUpdater* m_pcLEDEntityGridUpdateOperation;
+      /** The update operation for the grid positional indices */
+      CPositionalIndex<CLEDEntity>::COperation* m_pcLEDEntityGridUpdateOperation;
+
+      /** The positional index, if it is a flat grid; the flat grid can be updated in parallel */
+      CFlatGrid<CLEDEntity>* m_pcFlatGrid;
+
+      /** The update operations for the stages of a parallel flat grid update */
+      std::vector<CLEDEntityFlatGridUpdater*> m_vecStageUpdateOperations;
 
    };
 
@@ -2,9 +2,9 @@
 #include <argos3/core/simulator/entity/embodied_entity.h>
 #include <argos3/core/simulator/simulator.h>
 #include <argos3/core/simulator/space/space.h>
-#include <argos3/core/simulator/space/positional_indices/grid.h>
 #include <argos3/core/utility/configuration/argos_exception.h>
 #include <argos3/core/utility/logging/argos_log.h>
+#include <algorithm>
 
 namespace argos {
 
@@ -12,7 +12,11 @@ namespace argos {
    /****************************************/
 
    CRABMedium::CRABMedium() :
-      m_bCheckOcclusions(true) {
+      m_pcRABEquippedEntityGridUpdateOperation(nullptr),
+      m_bCheckOcclusions(true),
+      m_bCellRouting(false),
+      m_fCellRange(-1.0) {
+      m_nCells[0] = m_nCells[1] = m_nCells[2] = 1;
    }
 
    /****************************************/
@@ -29,37 +33,31 @@ namespace argos {
          CMedium::Init(t_tree);
          /* Check occlusions? */
          GetNodeAttributeOrDefault(t_tree, "check_occlusions", m_bCheckOcclusions, m_bCheckOcclusions);
-         /* Get the positional index method */
-         std::string strPosIndexMethod("grid");
-         GetNodeAttributeOrDefault(t_tree, "index", strPosIndexMethod, strPosIndexMethod);
+         /* Get the routing method */
+         std::string strRoutingMethod("pairs");
+         GetNodeAttributeOrDefault(t_tree, "routing", strRoutingMethod, strRoutingMethod);
+         if(strRoutingMethod == "cells") {
+            m_bCellRouting = true;
+         }
+         else if(strRoutingMethod != "pairs") {
+            THROW_ARGOSEXCEPTION("Unknown routing method \"" << strRoutingMethod << "\".");
+         }
          /* Get the arena center and size */
          CVector3 cArenaCenter;
          CVector3 cArenaSize;
          TConfigurationNode& tArena = GetNode(CSimulator::GetInstance().GetConfigurationRoot(), "arena");
          GetNodeAttribute(tArena, "size", cArenaSize);
          GetNodeAttributeOrDefault(tArena, "center", cArenaCenter, cArenaCenter);
+         m_cArenaMinCorner = cArenaCenter - cArenaSize * 0.5f;
+         m_cArenaSize = cArenaSize;
          /* Create the positional index for embodied entities */
-         if(strPosIndexMethod == "grid") {
-            size_t punGridSize[3];
-            if(!NodeAttributeExists(t_tree, "grid_size")) {
-               punGridSize[0] = static_cast<size_t>(cArenaSize.GetX());
-               punGridSize[1] = static_cast<size_t>(cArenaSize.GetY());
-               punGridSize[2] = static_cast<size_t>(cArenaSize.GetZ());
-            }
-            else {
-               std::string strPosGridSize;
-               GetNodeAttribute(t_tree, "grid_size", strPosGridSize);
-               ParseValues<size_t>(strPosGridSize, 3, punGridSize, ',');
-            }
-            CGrid<CRABEquippedEntity>* pcGrid = new CGrid<CRABEquippedEntity>(
-               cArenaCenter - cArenaSize * 0.5f, cArenaCenter + cArenaSize * 0.5f,
-               punGridSize[0], punGridSize[1], punGridSize[2]);
-            m_pcRABEquippedEntityGridUpdateOperation = new CRABEquippedEntityGridEntityUpdater(*pcGrid);
-            pcGrid->SetUpdateEntityOperation(m_pcRABEquippedEntityGridUpdateOperation);
-            m_pcRABEquippedEntityIndex = pcGrid;
+         if(m_bCellRouting) {
+            /* The cell routing method buckets the entities by itself */
+            m_pcRABEquippedEntityIndex = nullptr;
          }
          else {
-            THROW_ARGOSEXCEPTION("Unknown method \"" << strPosIndexMethod << "\" for the positional index.");
+            m_pcRABEquippedEntityIndex = CreateGridIndex<CRABEquippedEntity, CRABEquippedEntityGridEntityUpdater, CRABEquippedEntityFlatGridEntityUpdater>(
+               t_tree, m_pcRABEquippedEntityGridUpdateOperation);
          }
       }
       catch(CARGoSException& ex) {
@@ -79,7 +77,13 @@ namespace argos {
 
    void CRABMedium::Reset() {
       /* Reset positional index of RAB entities */
-      m_pcRABEquippedEntityIndex->Reset();
+      if(m_pcRABEquippedEntityIndex != nullptr) {
+         m_pcRABEquippedEntityIndex->Reset();
+      }
+      /* Delete adjacency list */
+      m_vecAdjacencyStart.assign(m_vecRABs.size(), 0);
+      m_vecAdjacencyEnd.assign(m_vecRABs.size(), 0);
+      m_vecAdjacency.clear();
       /* Delete routing table */
       for(TRoutingTable::iterator it = m_tRoutingTable.begin();
           it != m_tRoutingTable.end();
@@ -101,6 +105,15 @@ namespace argos {
    /****************************************/
    /****************************************/
 
+   /** Cell routing: the cell of a slot that was not bucketed by the last update */
+   static const UInt32 NO_CELL = 0xFFFFFFFF;
+
+   /** Cell routing: an entry of a cell whose entity was removed since the last update */
+   static const UInt32 NO_SLOT = 0xFFFFFFFF;
+
+   /****************************************/
+   /****************************************/
+
    static size_t HashRABPair(const std::pair<CRABEquippedEntity*, CRABEquippedEntity*>& c_pair) {
       return
          reinterpret_cast<size_t>(c_pair.first) ^
@@ -108,6 +121,13 @@ namespace argos {
    }
 
    void CRABMedium::Update() {
+      if(m_bCellRouting) {
+         BucketRABs();
+         SplitCells(1);
+         UpdateTask(0);
+         EndUpdate();
+         return;
+      }
       /* Update positional index of RAB entities */
       m_pcRABEquippedEntityIndex->Update();
       /* Delete routing table */
@@ -137,9 +157,7 @@ namespace argos {
           it != m_tRoutingTable.end();
           ++it) {
          /* Get a reference to the current RAB entity */
-         CRABEquippedEntity& cRAB = *reinterpret_cast<CRABEquippedEntity*>(GetSpace().GetEntityVector()[it->first]);
-         /* Initialize the occlusion check ray start to the position of the robot */
-         cOcclusionCheckRay.SetStart(cRAB.GetPosition());
+         CRABEquippedEntity& cRAB = *reinterpret_cast<CRABEquippedEntity*>(GetSpace().GetEntityByIndex(it->first));
          /* For each RAB entity, get the list of RAB entities in range */
          cOtherRABs.clear();
          m_pcRABEquippedEntityIndex->GetEntitiesAt(cOtherRABs, cRAB.GetPosition());
@@ -170,12 +188,15 @@ namespace argos {
                   /* Proceed if the message size is compatible */
                   if(cRAB.GetMsgSize() == cOtherRAB.GetMsgSize()) {
                      /* Proceed if the two entities are not obstructed by another object */
-                     cOcclusionCheckRay.SetEnd(cOtherRAB.GetPosition());
+                     /* The ray goes from the entity with the lower index, as with the cell routing method */
+                     CRABEquippedEntity& cFrom = (cRAB.GetIndex() < cOtherRAB.GetIndex()) ? cRAB : cOtherRAB;
+                     CRABEquippedEntity& cTo = (&cFrom == &cRAB) ? cOtherRAB : cRAB;
+                     cOcclusionCheckRay.Set(cFrom.GetPosition(), cTo.GetPosition());
                      if((!m_bCheckOcclusions) ||
                         (!GetClosestEmbodiedEntityIntersectedByRay(sIntersectionItem,
                                                                    cOcclusionCheckRay,
-                                                                   cRAB.GetEntityBody())) ||
-                        (&cOtherRAB.GetEntityBody() == sIntersectionItem.IntersectedEntity)) {
+                                                                   cFrom.GetEntityBody())) ||
+                        (&cTo.GetEntityBody() == sIntersectionItem.IntersectedEntity)) {
                         /* If we get here, the two RAB entities are in direct line of sight */
                         /* cRAB can receive cOtherRAB's message if it is in range, and viceversa */
                         /* Calculate square distance */
@@ -200,6 +221,14 @@ namespace argos {
    /****************************************/
 
    void CRABMedium::AddEntity(CRABEquippedEntity& c_entity) {
+      if(m_bCellRouting) {
+         m_mapRABSlots[c_entity.GetIndex()] = m_vecRABs.size();
+         m_vecRABs.push_back(&c_entity);
+         /* The new entity has no senders until the next update */
+         m_vecAdjacencyStart.push_back(0);
+         m_vecAdjacencyEnd.push_back(0);
+         return;
+      }
       m_tRoutingTable.insert(
          std::make_pair<ssize_t, CSet<CRABEquippedEntity*,SEntityComparator> >(
             c_entity.GetIndex(), CSet<CRABEquippedEntity*,SEntityComparator>()));
@@ -211,6 +240,60 @@ namespace argos {
    /****************************************/
 
    void CRABMedium::RemoveEntity(CRABEquippedEntity& c_entity) {
+      if(m_bCellRouting) {
+         unordered_map<ssize_t, UInt32>::iterator it = m_mapRABSlots.find(c_entity.GetIndex());
+         if(it != m_mapRABSlots.end()) {
+            UInt32 unSlot = it->second;
+            UInt32 unLast = m_vecRABs.size() - 1;
+            m_mapRABSlots.erase(it);
+            /*
+             * Keep the senders found by the last update, as the pairs method
+             * does. The entities that received from the removed entity were
+             * in range of it, so in its cell or in the adjacent ones: the
+             * removed entity is taken out of their senders only
+             */
+            if(unSlot < m_vecSlotCells.size() && m_vecSlotCells[unSlot] != NO_CELL) {
+               UInt32 unCell = m_vecSlotCells[unSlot];
+               SInt32 i = unCell % m_nCells[0];
+               SInt32 j = (unCell / m_nCells[0]) % m_nCells[1];
+               SInt32 k = unCell / (m_nCells[0] * m_nCells[1]);
+               for(SInt32 nK = Max(k - 1, 0); nK <= Min(k + 1, m_nCells[2] - 1); ++nK) {
+                  for(SInt32 nJ = Max(j - 1, 0); nJ <= Min(j + 1, m_nCells[1] - 1); ++nJ) {
+                     for(SInt32 nI = Max(i - 1, 0); nI <= Min(i + 1, m_nCells[0] - 1); ++nI) {
+                        UInt32 unOtherCell = nI + m_nCells[0] * (nJ + m_nCells[1] * nK);
+                        for(UInt32 a = m_vecCellStart[unOtherCell]; a < m_vecCellStart[unOtherCell + 1]; ++a) {
+                           if(m_vecCellSlots[a] != NO_SLOT) {
+                              RemoveSender(m_vecCellSlots[a], c_entity);
+                           }
+                        }
+                     }
+                  }
+               }
+               ReplaceCellSlot(unSlot, NO_SLOT);
+            }
+            /* Move the last entity into the freed slot, along with its senders */
+            if(unSlot != unLast) {
+               m_vecRABs[unSlot] = m_vecRABs[unLast];
+               m_mapRABSlots[m_vecRABs[unSlot]->GetIndex()] = unSlot;
+               m_vecAdjacencyStart[unSlot] = m_vecAdjacencyStart[unLast];
+               m_vecAdjacencyEnd[unSlot] = m_vecAdjacencyEnd[unLast];
+               if(unLast < m_vecSlotCells.size() && m_vecSlotCells[unLast] != NO_CELL) {
+                  ReplaceCellSlot(unLast, unSlot);
+                  m_vecSlotCells[unSlot] = m_vecSlotCells[unLast];
+               }
+               else if(unSlot < m_vecSlotCells.size()) {
+                  m_vecSlotCells[unSlot] = NO_CELL;
+               }
+            }
+            m_vecRABs.pop_back();
+            m_vecAdjacencyStart.pop_back();
+            m_vecAdjacencyEnd.pop_back();
+            if(m_vecSlotCells.size() > unLast) {
+               m_vecSlotCells.resize(unLast);
+            }
+         }
+         return;
+      }
       m_pcRABEquippedEntityIndex->RemoveEntity(c_entity);
       m_pcRABEquippedEntityIndex->Update();
       TRoutingTable::iterator it = m_tRoutingTable.find(c_entity.GetIndex());
@@ -222,6 +305,9 @@ namespace argos {
    /****************************************/
 
    const CSet<CRABEquippedEntity*,SEntityComparator>& CRABMedium::GetRABsCommunicatingWith(CRABEquippedEntity& c_entity) const {
+      if(m_bCellRouting) {
+         THROW_ARGOSEXCEPTION("The RAB medium \"" << GetId() << "\" uses the cell routing method: use GetRABViewCommunicatingWith() instead of GetRABsCommunicatingWith()");
+      }
       TRoutingTable::const_iterator it = m_tRoutingTable.find(c_entity.GetIndex());
       if(it != m_tRoutingTable.end()) {
          return it->second;
@@ -234,6 +320,348 @@ namespace argos {
    /****************************************/
    /****************************************/
 
+   CRABMedium::SRABView CRABMedium::GetRABViewCommunicatingWith(CRABEquippedEntity& c_entity) const {
+      if(m_bCellRouting) {
+         unordered_map<ssize_t, UInt32>::const_iterator it = m_mapRABSlots.find(c_entity.GetIndex());
+         if(it != m_mapRABSlots.end()) {
+            if(m_vecAdjacency.empty()) {
+               return SRABView();
+            }
+            CRABEquippedEntity* const* ppcFirst = m_vecAdjacency.data();
+            return SRABView(ppcFirst + m_vecAdjacencyStart[it->second],
+                            ppcFirst + m_vecAdjacencyEnd[it->second]);
+         }
+      }
+      else {
+         TRoutingTable::const_iterator it = m_tRoutingTable.find(c_entity.GetIndex());
+         if(it != m_tRoutingTable.end()) {
+            if(it->second.empty()) {
+               return SRABView();
+            }
+            CRABEquippedEntity* const* ppcFirst = &*it->second.begin();
+            return SRABView(ppcFirst, ppcFirst + it->second.size());
+         }
+      }
+      THROW_ARGOSEXCEPTION("RAB entity \"" << c_entity.GetContext() << c_entity.GetId() << "\" is not managed by the RAB medium \"" << GetId() << "\"");
+   }
+
+   /****************************************/
+   /****************************************/
+
+   size_t CRABMedium::BeginUpdate() {
+      if(!m_bCellRouting) {
+         /* Update positional index of RAB entities */
+         m_pcRABEquippedEntityIndex->Update();
+         /* Each task finds the senders of a range of receivers, so that
+            each entry of the routing table is written by one task only */
+         m_vecPairsReceivers.clear();
+         m_vecPairsSenders.clear();
+         for(TRoutingTable::iterator it = m_tRoutingTable.begin();
+             it != m_tRoutingTable.end();
+             ++it) {
+            it->second.clear();
+            m_vecPairsReceivers.push_back(
+               reinterpret_cast<CRABEquippedEntity*>(GetSpace().GetEntityByIndex(it->first)));
+            m_vecPairsSenders.push_back(&it->second);
+         }
+         size_t unNumRABs = m_vecPairsReceivers.size();
+         size_t unNumTasks = Max<size_t>(1, Min<size_t>(4 * Max<UInt32>(1, CSimulator::GetInstance().GetNumThreads()), unNumRABs));
+         m_vecTaskRABs.resize(unNumTasks + 1);
+         for(size_t t = 0; t <= unNumTasks; ++t) {
+            m_vecTaskRABs[t] = t * unNumRABs / unNumTasks;
+         }
+         return unNumTasks;
+      }
+      BucketRABs();
+      /* Several tasks per thread, for load balancing */
+      return SplitCells(4 * Max<UInt32>(1, CSimulator::GetInstance().GetNumThreads()));
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CRABMedium::UpdateTask(size_t un_task) {
+      if(!m_bCellRouting) {
+         for(size_t i = m_vecTaskRABs[un_task]; i < m_vecTaskRABs[un_task + 1]; ++i) {
+            RouteReceiver(*m_vecPairsReceivers[i], *m_vecPairsSenders[i]);
+         }
+         return;
+      }
+      SEdges& sEdges = m_vecTaskEdges[un_task];
+      sEdges.Receivers.clear();
+      sEdges.Senders.clear();
+      RouteCells(m_vecTaskCells[un_task], m_vecTaskCells[un_task + 1], sEdges);
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CRABMedium::EndUpdate() {
+      /* With the pairs method, the tasks wrote the routing table directly */
+      if(!m_bCellRouting) return;
+      /* Group the edges of all the tasks by receiver */
+      size_t unNumRABs = m_vecRABs.size();
+      size_t unNumTasks = m_vecTaskCells.size() - 1;
+      size_t unNumEdges = 0;
+      m_vecAdjacencyStart.assign(unNumRABs, 0);
+      m_vecAdjacencyEnd.assign(unNumRABs, 0);
+      for(size_t t = 0; t < unNumTasks; ++t) {
+         const std::vector<UInt32>& vecReceivers = m_vecTaskEdges[t].Receivers;
+         for(size_t i = 0; i < vecReceivers.size(); ++i) {
+            ++m_vecAdjacencyEnd[vecReceivers[i]];
+         }
+      }
+      for(size_t i = 0; i < unNumRABs; ++i) {
+         m_vecAdjacencyStart[i] = unNumEdges;
+         unNumEdges += m_vecAdjacencyEnd[i];
+         m_vecAdjacencyEnd[i] = m_vecAdjacencyStart[i];
+      }
+      m_vecAdjacency.resize(unNumEdges);
+      for(size_t t = 0; t < unNumTasks; ++t) {
+         const SEdges& sEdges = m_vecTaskEdges[t];
+         for(size_t i = 0; i < sEdges.Receivers.size(); ++i) {
+            m_vecAdjacency[m_vecAdjacencyEnd[sEdges.Receivers[i]]++] = sEdges.Senders[i];
+         }
+      }
+      /* Sort the senders by index, like the routing table of the pairs
+         method; this also makes the result independent of the tasks */
+      for(size_t i = 0; i < unNumRABs; ++i) {
+         std::sort(m_vecAdjacency.begin() + m_vecAdjacencyStart[i],
+                   m_vecAdjacency.begin() + m_vecAdjacencyEnd[i],
+                   SEntityComparator());
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CRABMedium::BucketRABs() {
+      size_t unNumRABs = m_vecRABs.size();
+      /* The cells must be at least as large as the largest range */
+      Real fMaxRange = 0.0;
+      for(size_t i = 0; i < unNumRABs; ++i) {
+         fMaxRange = Max(fMaxRange, m_vecRABs[i]->GetRange());
+      }
+      if(fMaxRange != m_fCellRange || m_vecSlotCells.size() != unNumRABs) {
+         SetCellSize(fMaxRange);
+         m_vecSlotCells.resize(unNumRABs);
+      }
+      /* Find the cell of each RAB entity; entities outside the arena go in
+         the border cells, which keeps entities in range in adjacent cells */
+      for(size_t i = 0; i < unNumRABs; ++i) {
+         CVector3 cPos = m_vecRABs[i]->GetPosition() - m_cArenaMinCorner;
+         SInt32 nI = Max<SInt32>(0, Min<SInt32>(m_nCells[0] - 1, static_cast<SInt32>(Floor(cPos.GetX() * m_cInvCellSize.GetX()))));
+         SInt32 nJ = Max<SInt32>(0, Min<SInt32>(m_nCells[1] - 1, static_cast<SInt32>(Floor(cPos.GetY() * m_cInvCellSize.GetY()))));
+         SInt32 nK = Max<SInt32>(0, Min<SInt32>(m_nCells[2] - 1, static_cast<SInt32>(Floor(cPos.GetZ() * m_cInvCellSize.GetZ()))));
+         m_vecSlotCells[i] = nI + m_nCells[0] * (nJ + m_nCells[1] * nK);
+      }
+      /* Sort the slots by cell: count, prefix sum, scatter backwards so that
+         the slots of a cell stay in increasing order */
+      size_t unNumCells = m_vecCellStart.size() - 1;
+      std::fill(m_vecCellStart.begin(), m_vecCellStart.end(), 0);
+      for(size_t i = 0; i < unNumRABs; ++i) {
+         ++m_vecCellStart[m_vecSlotCells[i]];
+      }
+      for(size_t i = 1; i < unNumCells; ++i) {
+         m_vecCellStart[i] += m_vecCellStart[i - 1];
+      }
+      m_vecCellStart[unNumCells] = unNumRABs;
+      m_vecCellSlots.resize(unNumRABs);
+      for(size_t i = unNumRABs; i > 0; --i) {
+         m_vecCellSlots[--m_vecCellStart[m_vecSlotCells[i - 1]]] = i - 1;
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   size_t CRABMedium::SplitCells(size_t un_tasks) {
+      size_t unNumRABs = m_vecRABs.size();
+      UInt32 unNumCells = m_vecCellStart.size() - 1;
+      size_t unNumTasks = Max<size_t>(1, Min(un_tasks, unNumRABs));
+      /* Task t starts at the first cell holding the (t * N / T)-th entity */
+      m_vecTaskCells.resize(unNumTasks + 1);
+      m_vecTaskCells[0] = 0;
+      for(size_t t = 1; t < unNumTasks; ++t) {
+         m_vecTaskCells[t] =
+            std::upper_bound(m_vecCellStart.begin(),
+                             m_vecCellStart.begin() + unNumCells,
+                             static_cast<UInt32>(t * unNumRABs / unNumTasks)) -
+            m_vecCellStart.begin() - 1;
+         m_vecTaskCells[t] = Max(m_vecTaskCells[t], m_vecTaskCells[t - 1]);
+      }
+      m_vecTaskCells[unNumTasks] = unNumCells;
+      if(m_vecTaskEdges.size() < unNumTasks) {
+         m_vecTaskEdges.resize(unNumTasks);
+      }
+      return unNumTasks;
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CRABMedium::RouteCells(UInt32 un_first_cell,
+                               UInt32 un_last_cell,
+                               SEdges& s_edges) {
+      for(UInt32 unCell = un_first_cell; unCell < un_last_cell; ++unCell) {
+         UInt32 unStart = m_vecCellStart[unCell];
+         UInt32 unEnd = m_vecCellStart[unCell + 1];
+         if(unStart == unEnd) continue;
+         SInt32 i = unCell % m_nCells[0];
+         SInt32 j = (unCell / m_nCells[0]) % m_nCells[1];
+         SInt32 k = unCell / (m_nCells[0] * m_nCells[1]);
+         /* Pairs within the cell */
+         for(UInt32 a = unStart; a < unEnd; ++a) {
+            for(UInt32 b = a + 1; b < unEnd; ++b) {
+               RoutePair(m_vecCellSlots[a], m_vecCellSlots[b], s_edges);
+            }
+         }
+         /* Pairs with the neighbouring cells that come after this one */
+         for(SInt32 dk = 0; dk <= 1; ++dk) {
+            for(SInt32 dj = (dk > 0 ? -1 : 0); dj <= 1; ++dj) {
+               for(SInt32 di = (dk > 0 || dj > 0 ? -1 : 1); di <= 1; ++di) {
+                  SInt32 nI = i + di, nJ = j + dj, nK = k + dk;
+                  if(nI < 0 || nI >= m_nCells[0] ||
+                     nJ < 0 || nJ >= m_nCells[1] ||
+                     nK >= m_nCells[2]) continue;
+                  UInt32 unOtherCell = nI + m_nCells[0] * (nJ + m_nCells[1] * nK);
+                  UInt32 unOtherStart = m_vecCellStart[unOtherCell];
+                  UInt32 unOtherEnd = m_vecCellStart[unOtherCell + 1];
+                  for(UInt32 a = unStart; a < unEnd; ++a) {
+                     for(UInt32 b = unOtherStart; b < unOtherEnd; ++b) {
+                        RoutePair(m_vecCellSlots[a], m_vecCellSlots[b], s_edges);
+                     }
+                  }
+               }
+            }
+         }
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CRABMedium::SetCellSize(Real f_range) {
+      m_fCellRange = f_range;
+      /* One cell per range along each axis */
+      for(size_t i = 0; i < 3; ++i) {
+         Real fCells = (f_range > 0.0) ? Floor(m_cArenaSize[i] / f_range) : 1.0;
+         m_nCells[i] = static_cast<SInt32>(Max<Real>(1.0, Min<Real>(fCells, 1 << 16)));
+      }
+      /* With short ranges, most cells would be empty: merge cells along the
+         longest axis until there are at most four cells per entity */
+      size_t unMaxCells = Max<size_t>(1, 4 * m_vecRABs.size());
+      while(static_cast<size_t>(m_nCells[0]) * m_nCells[1] * m_nCells[2] > unMaxCells) {
+         SInt32* pnLongest = std::max_element(m_nCells, m_nCells + 3);
+         *pnLongest = (*pnLongest + 1) / 2;
+      }
+      for(size_t i = 0; i < 3; ++i) {
+         m_cInvCellSize[i] = (m_cArenaSize[i] > 0.0) ? m_nCells[i] / m_cArenaSize[i] : 0.0;
+      }
+      m_vecCellStart.resize(m_nCells[0] * m_nCells[1] * m_nCells[2] + 1);
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CRABMedium::RouteReceiver(CRABEquippedEntity& c_rab,
+                                  CSet<CRABEquippedEntity*,SEntityComparator>& c_senders) {
+      /* The entities whose range covers this one are in its cell of the positional index */
+      CSet<CRABEquippedEntity*,SEntityComparator> cOtherRABs;
+      m_pcRABEquippedEntityIndex->GetEntitiesAt(cOtherRABs, c_rab.GetPosition());
+      SEmbodiedEntityIntersectionItem sIntersectionItem;
+      for(CSet<CRABEquippedEntity*,SEntityComparator>::iterator it = cOtherRABs.begin();
+          it != cOtherRABs.end();
+          ++it) {
+         CRABEquippedEntity& cOtherRAB = **it;
+         if(&c_rab == &cOtherRAB ||
+            c_rab.GetMsgSize() != cOtherRAB.GetMsgSize()) continue;
+         /* Same ray as the serial update: from the entity with the lower index */
+         CRABEquippedEntity& cFrom = (c_rab.GetIndex() < cOtherRAB.GetIndex()) ? c_rab : cOtherRAB;
+         CRABEquippedEntity& cTo = (&cFrom == &c_rab) ? cOtherRAB : c_rab;
+         CRay3 cOcclusionCheckRay(cFrom.GetPosition(), cTo.GetPosition());
+         /* c_rab receives cOtherRAB's message if it is in range */
+         if(cOcclusionCheckRay.GetLength() >= cOtherRAB.GetRange()) continue;
+         if(m_bCheckOcclusions &&
+            GetClosestEmbodiedEntityIntersectedByRay(sIntersectionItem,
+                                                     cOcclusionCheckRay,
+                                                     cFrom.GetEntityBody()) &&
+            &cTo.GetEntityBody() != sIntersectionItem.IntersectedEntity) continue;
+         c_senders.insert(&cOtherRAB);
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CRABMedium::RemoveSender(UInt32 un_slot,
+                                 CRABEquippedEntity& c_sender) {
+      std::vector<CRABEquippedEntity*>::iterator itBegin = m_vecAdjacency.begin() + m_vecAdjacencyStart[un_slot];
+      std::vector<CRABEquippedEntity*>::iterator itEnd = m_vecAdjacency.begin() + m_vecAdjacencyEnd[un_slot];
+      /* The senders are sorted by index */
+      std::vector<CRABEquippedEntity*>::iterator it =
+         std::lower_bound(itBegin, itEnd, &c_sender, SEntityComparator());
+      if(it != itEnd && *it == &c_sender) {
+         std::copy(it + 1, itEnd, it);
+         --m_vecAdjacencyEnd[un_slot];
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CRABMedium::ReplaceCellSlot(UInt32 un_slot,
+                                    UInt32 un_new_slot) {
+      UInt32 unCell = m_vecSlotCells[un_slot];
+      for(UInt32 a = m_vecCellStart[unCell]; a < m_vecCellStart[unCell + 1]; ++a) {
+         if(m_vecCellSlots[a] == un_slot) {
+            m_vecCellSlots[a] = un_new_slot;
+            return;
+         }
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CRABMedium::RoutePair(UInt32 un_slot1,
+                              UInt32 un_slot2,
+                              SEdges& s_edges) {
+      CRABEquippedEntity* pcRAB1 = m_vecRABs[un_slot1];
+      CRABEquippedEntity* pcRAB2 = m_vecRABs[un_slot2];
+      /* Proceed if the message size is compatible */
+      if(pcRAB1->GetMsgSize() != pcRAB2->GetMsgSize()) return;
+      /* Always cast the occlusion ray from the entity with the lower index */
+      if(pcRAB2->GetIndex() < pcRAB1->GetIndex()) {
+         std::swap(un_slot1, un_slot2);
+         std::swap(pcRAB1, pcRAB2);
+      }
+      CRay3 cOcclusionCheckRay(pcRAB1->GetPosition(), pcRAB2->GetPosition());
+      Real fDistance = cOcclusionCheckRay.GetLength();
+      /* Skip the occlusion check if neither entity is in range of the other */
+      if(fDistance >= pcRAB1->GetRange() && fDistance >= pcRAB2->GetRange()) return;
+      /* Proceed if the two entities are not obstructed by another object */
+      SEmbodiedEntityIntersectionItem sIntersectionItem;
+      if(m_bCheckOcclusions &&
+         GetClosestEmbodiedEntityIntersectedByRay(sIntersectionItem,
+                                                  cOcclusionCheckRay,
+                                                  pcRAB1->GetEntityBody()) &&
+         &pcRAB2->GetEntityBody() != sIntersectionItem.IntersectedEntity) return;
+      if(fDistance < pcRAB2->GetRange()) {
+         /* pcRAB1 receives pcRAB2's message */
+         s_edges.Receivers.push_back(un_slot1);
+         s_edges.Senders.push_back(pcRAB2);
+      }
+      if(fDistance < pcRAB1->GetRange()) {
+         /* pcRAB2 receives pcRAB1's message */
+         s_edges.Receivers.push_back(un_slot2);
+         s_edges.Senders.push_back(pcRAB1);
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
    REGISTER_MEDIUM(CRABMedium,
                    "range_and_bearing",
                    "Carlo Pinciroli [ilpincy@gmail.com]",
@@ -249,7 +677,24 @@ namespace argos {
                    "By default, the RAB medium requires two robots to be in direct line-of-sight in\n"
                    "order to be able to exchange messages. You can toggle this behavior on or off\n"
                    "through the 'check_occlusions' attribute:\n\n"
-                   "<range_and_bearing id=\"rab\" check_occlusions=\"false\" />\n\n",
+                   "<range_and_bearing id=\"rab\" check_occlusions=\"false\" />\n\n"
+                   "With index=\"flat_grid\", the RAB entities are indexed in a flat grid, which is\n"
+                   "faster with many entities. 'grid_size' sets the cells per axis (default: 1/m):\n\n"
+                   "<range_and_bearing id=\"rab\" index=\"flat_grid\" grid_size=\"20,20,1\" />\n\n"
+                   "The routing method decides how the pairs of RAB entities that could\n"
+                   "communicate are found. By default (routing=\"pairs\"), the positional index\n"
+                   "is queried for each entity, and a hash map makes sure that each pair is\n"
+                   "checked only once. When ARGoS runs with multiple threads, each thread finds\n"
+                   "the senders of a part of the entities instead, which checks the pairs in\n"
+                   "range of each other twice. With routing=\"cells\", the entities are bucketed at every\n"
+                   "step into cells as large as the largest range, and each cell is checked\n"
+                   "against itself and half of its neighbours, which visits each pair once\n"
+                   "without any bookkeeping. In this case, the 'index' and 'grid_size'\n"
+                   "attributes are ignored, and the robot sensors must read the messages through\n"
+                   "CRABMedium::GetRABViewCommunicatingWith(), which the range-and-bearing sensor\n"
+                   "shipped with ARGoS does. With multiple threads, the cells are split among the\n"
+                   "threads:\n\n"
+                   "<range_and_bearing id=\"rab\" routing=\"cells\" />\n\n",
                    "Under development"
       );
 
@@ -10,11 +10,36 @@ namespace argos {
 #include <argos3/core/simulator/space/positional_indices/positional_index.h>
 #include <argos3/plugins/robots/generic/control_interface/ci_range_and_bearing_sensor.h>
 #include <argos3/plugins/simulator/entities/rab_equipped_entity.h>
+#include <vector>
 
 namespace argos {
 
    class CRABMedium : public CMedium {
 
+   public:
+
+      /**
+       * A read-only view on the RAB entities that can communicate with a RAB entity.
+       * The entities are sorted by index. The view is valid until the next
+       * update of the medium.
+       */
+      struct SRABView {
+         typedef CRABEquippedEntity* const* const_iterator;
+
+         const_iterator Begin;
+         const_iterator End;
+
+         SRABView(const_iterator t_begin = nullptr,
+                  const_iterator t_end = nullptr) :
+            Begin(t_begin),
+            End(t_end) {}
+
+         inline const_iterator begin() const { return Begin; }
+         inline const_iterator end() const { return End; }
+         inline size_t size() const { return End - Begin; }
+         inline bool empty() const { return Begin == End; }
+      };
+
    public:
 
       /**
@@ -33,6 +58,12 @@ namespace argos {
       virtual void Destroy();
       virtual void Update();
 
+      virtual size_t BeginUpdate();
+
+      virtual void UpdateTask(size_t un_task);
+
+      virtual void EndUpdate();
+
       /**
        * Adds the specified entity to the list of managed entities.
        * @param c_entity The entity to add.
@@ -53,6 +84,81 @@ namespace argos {
        */
       const CSet<CRABEquippedEntity*,SEntityComparator>& GetRABsCommunicatingWith(CRABEquippedEntity& c_entity) const;
 
+      /**
+       * Returns a view on the RAB entities that can communicate with the given entity.
+       * Unlike GetRABsCommunicatingWith(), this method works with any routing method
+       * and never copies the entities.
+       * @param c_entity The wanted entity.
+       * @return A view on the RAB entities that can communicate with the given entity.
+       * @throws CARGoSException If the passed entity is not managed by this medium.
+       */
+      SRABView GetRABViewCommunicatingWith(CRABEquippedEntity& c_entity) const;
+
+   private:
+
+      /** The edges of the communication graph found by a routing task */
+      struct SEdges {
+         /** The receiver slot of each edge */
+         std::vector<UInt32> Receivers;
+         /** The sender of each edge */
+         std::vector<CRABEquippedEntity*> Senders;
+      };
+
+   private:
+
+      /**
+       * Buckets the RAB entities for the cell routing method.
+       * The cells are at least as large as the largest range, so that two
+       * entities in range are in the same cell or in adjacent cells.
+       */
+      void BucketRABs();
+
+      /**
+       * Splits the cells in ranges with about the same number of entities.
+       * @return The number of ranges, each checked by one routing task.
+       */
+      size_t SplitCells(size_t un_tasks);
+
+      /**
+       * Checks each of the given cells against itself and against half of
+       * its neighbours; over all the cells, this visits every pair once.
+       */
+      void RouteCells(UInt32 un_first_cell,
+                      UInt32 un_last_cell,
+                      SEdges& s_edges);
+
+      /**
+       * Resizes the cells of the cell routing method to the given range.
+       */
+      void SetCellSize(Real f_range);
+
+      /**
+       * Finds the RAB entities a RAB entity receives messages from, for the
+       * pairs method split in tasks.
+       */
+      void RouteReceiver(CRABEquippedEntity& c_rab,
+                         CSet<CRABEquippedEntity*,SEntityComparator>& c_senders);
+
+      /**
+       * Takes a RAB entity out of the senders of the given slot.
+       */
+      void RemoveSender(UInt32 un_slot,
+                        CRABEquippedEntity& c_sender);
+
+      /**
+       * Replaces a slot in the list of its cell.
+       */
+      void ReplaceCellSlot(UInt32 un_slot,
+                           UInt32 un_new_slot);
+
+      /**
+       * Checks whether two RAB entities can communicate, and adds the
+       * corresponding edges to the given list.
+       */
+      void RoutePair(UInt32 un_slot1,
+                     UInt32 un_slot2,
+                     SEdges& s_edges);
+
    private:
 
       /** Defines the routing table */
@@ -64,12 +170,69 @@ namespace argos {
       /** A positional index for the RAB entities */
       CPositionalIndex<CRABEquippedEntity>* m_pcRABEquippedEntityIndex;
 
-      /** The update operation for the grid positional index */
-      CRABEquippedEntityGridEntityUpdater* m_pcRABEquippedEntityGridUpdateOperation;
+      /** The update operation for the grid positional indices */
+      CPositionalIndex<CRABEquippedEntity>::COperation* m_pcRABEquippedEntityGridUpdateOperation;
 
       /* Whether occlusions should be considered or not */
       bool m_bCheckOcclusions;
 
+      /** Pairs routing split in tasks: the RAB entities of the routing table */
+      std::vector<CRABEquippedEntity*> m_vecPairsReceivers;
+
+      /** Pairs routing split in tasks: the entries of the routing table, in the same order */
+      std::vector<CSet<CRABEquippedEntity*,SEntityComparator>*> m_vecPairsSenders;
+
+      /** Pairs routing split in tasks: the first RAB entity of each task, plus the total at the end */
+      std::vector<size_t> m_vecTaskRABs;
+
+      /** Whether the cell routing method is used */
+      bool m_bCellRouting;
+
+      /** Cell routing: the RAB entities, indexed by slot */
+      std::vector<CRABEquippedEntity*> m_vecRABs;
+
+      /** Cell routing: the slot of each RAB entity, indexed by entity index */
+      unordered_map<ssize_t, UInt32> m_mapRABSlots;
+
+      /** Cell routing: the minimum corner of the bucketed area */
+      CVector3 m_cArenaMinCorner;
+
+      /** Cell routing: the size of the bucketed area */
+      CVector3 m_cArenaSize;
+
+      /** Cell routing: the range the cells were sized for */
+      Real m_fCellRange;
+
+      /** Cell routing: the number of cells along each axis */
+      SInt32 m_nCells[3];
+
+      /** Cell routing: the inverse of the cell size along each axis */
+      CVector3 m_cInvCellSize;
+
+      /** Cell routing: the cell of each slot */
+      std::vector<UInt32> m_vecSlotCells;
+
+      /** Cell routing: offset of the first slot of each cell, plus the total at the end */
+      std::vector<UInt32> m_vecCellStart;
+
+      /** Cell routing: the slots of all the cells, grouped by cell */
+      std::vector<UInt32> m_vecCellSlots;
+
+      /** Cell routing: the first cell of each routing task, plus the number of cells at the end */
+      std::vector<UInt32> m_vecTaskCells;
+
+      /** Cell routing: the edges found by each routing task in the current update */
+      std::vector<SEdges> m_vecTaskEdges;
+
+      /** Cell routing: offset of the first sender of each slot */
+      std::vector<UInt32> m_vecAdjacencyStart;
+
+      /** Cell routing: offset past the last sender of each slot */
+      std::vector<UInt32> m_vecAdjacencyEnd;
+
+      /** Cell routing: the senders for all the slots, grouped by receiver slot; removals leave gaps */
+      std::vector<CRABEquippedEntity*> m_vecAdjacency;
+
    };
 
 }
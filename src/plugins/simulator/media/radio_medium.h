@@ -66,8 +66,8 @@ namespace argos {
       /** A positional index for the radio entities */
       CPositionalIndex<CRadioEntity>* m_pcRadioEntityIndex;
 
-      /** The update operation for the grid positional index */
-      CRadioEntityGridUpdater* m_pcRadioEntityGridUpdateOperation;
+      /** The update operation for the grid positional indices */
+      CPositionalIndex<CRadioEntity>::COperation* m_pcRadioEntityGridUpdateOperation;
 
    };
 
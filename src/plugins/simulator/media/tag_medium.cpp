@@ -7,7 +7,6 @@
 #include "tag_medium.h"
 #include <argos3/core/simulator/simulator.h>
 #include <argos3/core/simulator/space/space.h>
-#include <argos3/core/simulator/space/positional_indices/grid.h>
 #include <argos3/core/utility/configuration/argos_exception.h>
 #include <argos3/core/utility/logging/argos_log.h>
 
@@ -19,38 +18,9 @@ namespace argos {
    void CTagMedium::Init(TConfigurationNode& t_tree) {
       try {
          CMedium::Init(t_tree);
-         /* Get the positional index method */
-         std::string strPosIndexMethod("grid");
-         GetNodeAttributeOrDefault(t_tree, "index", strPosIndexMethod, strPosIndexMethod);
-         /* Get the arena center and size */
-         CVector3 cArenaCenter;
-         CVector3 cArenaSize;
-         TConfigurationNode& tArena = GetNode(CSimulator::GetInstance().GetConfigurationRoot(), "arena");
-         GetNodeAttribute(tArena, "size", cArenaSize);
-         GetNodeAttributeOrDefault(tArena, "center", cArenaCenter, cArenaCenter);
          /* Create the positional index for tag entities */
-         if(strPosIndexMethod == "grid") {
-            size_t punGridSize[3];
-            if(!NodeAttributeExists(t_tree, "grid_size")) {
-               punGridSize[0] = static_cast<size_t>(cArenaSize.GetX());
-               punGridSize[1] = static_cast<size_t>(cArenaSize.GetY());
-               punGridSize[2] = static_cast<size_t>(cArenaSize.GetZ());
-            }
-            else {
-               std::string strPosGridSize;
-               GetNodeAttribute(t_tree, "grid_size", strPosGridSize);
-               ParseValues<size_t>(strPosGridSize, 3, punGridSize, ',');
-            }
-            CGrid<CTagEntity>* pcGrid = new CGrid<CTagEntity>(
-               cArenaCenter - cArenaSize * 0.5f, cArenaCenter + cArenaSize * 0.5f,
-               punGridSize[0], punGridSize[1], punGridSize[2]);
-            m_pcTagEntityGridUpdateOperation = new CTagEntityGridUpdater(*pcGrid);
-            pcGrid->SetUpdateEntityOperation(m_pcTagEntityGridUpdateOperation);
-            m_pcTagEntityIndex = pcGrid;
-         }
-         else {
-            THROW_ARGOSEXCEPTION("Unknown method \"" << strPosIndexMethod << "\" for the positional index.");
-         }
+         m_pcTagEntityIndex = CreateGridIndex<CTagEntity, CTagEntityGridUpdater, CTagEntityFlatGridUpdater>(
+            t_tree, m_pcTagEntityGridUpdateOperation);
       }
       catch(CARGoSException& ex) {
          THROW_ARGOSEXCEPTION_NESTED("Error in initialization of the tag medium", ex);
@@ -118,7 +88,9 @@ namespace argos {
                    "REQUIRED XML CONFIGURATION\n\n"
                    "<tag id=\"qrcodes\" />\n\n"
                    "OPTIONAL XML CONFIGURATION\n\n"
-                   "None for the time being\n",
+                   "With index=\"flat_grid\", the tag entities are indexed in a flat grid, which is\n"
+                   "faster with many entities. 'grid_size' sets the cells per axis (default: 1/m):\n\n"
+                   "<tag id=\"qrcodes\" index=\"flat_grid\" grid_size=\"20,20,1\" />\n\n",
                    "Under development"
       );
 
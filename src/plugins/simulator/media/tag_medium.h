@@ -65,8 +65,8 @@ namespace argos {
       /** A positional index for the tag entities */
       CPositionalIndex<CTagEntity>* m_pcTagEntityIndex;
 
-      /** The update operation for the grid positional index */
-      CTagEntityGridUpdater* m_pcTagEntityGridUpdateOperation;
+      /** The update operation for the grid positional indices */
+      CPositionalIndex<CTagEntity>::COperation* m_pcTagEntityGridUpdateOperation;
 
    };
 
@@ -93,7 +93,7 @@ namespace argos {
    void CDynamics2DEngine::Reset() {
       for(auto it = m_tPhysicsModels.begin();
           it != m_tPhysicsModels.end(); ++it) {
-         it->second->Reset();
+         (*it)->Reset();
       }
       cpSpaceReindexStatic(m_ptSpace);
    }
@@ -105,20 +105,20 @@ namespace argos {
       /* Update the physics state from the entities */
       for(auto it = m_tPhysicsModels.begin();
           it != m_tPhysicsModels.end(); ++it) {
-         it->second->UpdateFromEntityStatus();
+         (*it)->UpdateFromEntityStatus();
       }
       /* Perform the step */
       for(size_t i = 0; i < GetIterations(); ++i) {
          for(auto it = m_tPhysicsModels.begin();
              it != m_tPhysicsModels.end(); ++it) {
-            it->second->UpdatePhysics();
+            (*it)->UpdatePhysics();
          }
          cpSpaceStep(m_ptSpace, GetPhysicsClockTick());
       }
       /* Update the simulated space */
       for(auto it = m_tPhysicsModels.begin();
           it != m_tPhysicsModels.end(); ++it) {
-         it->second->UpdateEntityStatus();
+         (*it)->UpdateEntityStatus();
       }
    }
 
@@ -129,9 +129,9 @@ namespace argos {
       /* Empty the physics model map */
       for(auto it = m_tPhysicsModels.begin();
           it != m_tPhysicsModels.end(); ++it) {
-         delete it->second;
+         delete *it;
       }
-      m_tPhysicsModels.clear();
+      m_tPhysicsModels.Clear();
       /* Get rid of the physics space */
       cpSpaceFree(m_ptSpace);
       cpBodyFree(m_ptGroundBody);
@@ -168,6 +168,40 @@ namespace argos {
    /****************************************/
    /****************************************/
 
+   /*
+    * Checks whether a ray hits a shape, given the value of t at which the ray
+    * crosses the shape in 2D. The shape is extruded along Z between the bottom
+    * and top of the bounding box of its model. If the ray hits, the function
+    * returns true and sets f_t to the value of t of the hit in 3D.
+    */
+   static bool Dynamics2DRayHitsShape(cpShape* pt_shape,
+                                      const CRay3& c_ray,
+                                      Real& f_t) {
+      /* Hit found, is f_t it within the limits on Z? */
+      CDynamics2DModel& cModel = *reinterpret_cast<CDynamics2DModel*>(pt_shape->body->data);
+      CVector3 cIntersectionPoint;
+      c_ray.GetPoint(cIntersectionPoint, f_t);
+      if((cIntersectionPoint.GetZ() >= cModel.GetBoundingBox().MinCorner.GetZ()) &&
+         (cIntersectionPoint.GetZ() <= cModel.GetBoundingBox().MaxCorner.GetZ()) ) {
+         /* Side hit */
+         return true;
+      }
+      /* Check top surface */
+      if(cIntersectionPoint.GetZ() > cModel.GetBoundingBox().MaxCorner.GetZ()) {
+         Real fZDiff = c_ray.GetStart().GetZ() - cModel.GetBoundingBox().MaxCorner.GetZ();
+         Real fRayZDiff = c_ray.GetStart().GetZ() - c_ray.GetEnd().GetZ();
+         f_t = fZDiff / fRayZDiff;
+         c_ray.GetPoint(cIntersectionPoint, f_t);
+         return cpShapePointQuery(pt_shape, cpv(cIntersectionPoint.GetX(), cIntersectionPoint.GetY()));
+      }
+      /* Technically I should check the bottom surface, too, but this case never came up so far */
+      /* TODO */
+      return false;
+   }
+
+   /****************************************/
+   /****************************************/
+
    struct SDynamics2DSegmentHitData {
       TEmbodiedEntityIntersectionData& Intersections;
       const CRay3& Ray;
@@ -181,34 +215,14 @@ namespace argos {
    static void Dynamics2DSegmentQueryFunc(cpShape* pt_shape, cpFloat f_t, cpVect, void* pt_data) {
       /* Get the data associated to this query */
       SDynamics2DSegmentHitData& sData = *reinterpret_cast<SDynamics2DSegmentHitData*>(pt_data);
-      /* Hit found, is f_t it within the limits on Z? */
-      CDynamics2DModel& cModel = *reinterpret_cast<CDynamics2DModel*>(pt_shape->body->data);
-      CVector3 cIntersectionPoint;
-      sData.Ray.GetPoint(cIntersectionPoint, f_t);
-      if((cIntersectionPoint.GetZ() >= cModel.GetBoundingBox().MinCorner.GetZ()) &&
-         (cIntersectionPoint.GetZ() <= cModel.GetBoundingBox().MaxCorner.GetZ()) ) {
-         /* Side hit */
+      /* Ghosts are copies of bodies managed by another engine */
+      if(pt_shape->collision_type == CDynamics2DEngine::SHAPE_GHOST) return;
+      Real fT = f_t;
+      if(Dynamics2DRayHitsShape(pt_shape, sData.Ray, fT)) {
          sData.Intersections.push_back(
             SEmbodiedEntityIntersectionItem(
-               &cModel.GetEmbodiedEntity(),
-               f_t));
-      }
-      else {
-         /* Check top surface */
-         if(cIntersectionPoint.GetZ() > cModel.GetBoundingBox().MaxCorner.GetZ()) {
-            Real fZDiff = sData.Ray.GetStart().GetZ() - cModel.GetBoundingBox().MaxCorner.GetZ();
-            Real fRayZDiff = sData.Ray.GetStart().GetZ() - sData.Ray.GetEnd().GetZ();
-            f_t = fZDiff / fRayZDiff;
-            sData.Ray.GetPoint(cIntersectionPoint, f_t);
-            if(cpShapePointQuery(pt_shape, cpv(cIntersectionPoint.GetX(), cIntersectionPoint.GetY()))) {
-               sData.Intersections.push_back(
-                  SEmbodiedEntityIntersectionItem(
-                     &cModel.GetEmbodiedEntity(),
-                     f_t));
-            }
-         }
-         /* Technically I should check the bottom surface, too, but this case never came up so far */
-         /* TODO */
+               &reinterpret_cast<CDynamics2DModel*>(pt_shape->body->data)->GetEmbodiedEntity(),
+               fT));
       }
    }
 
@@ -229,6 +243,121 @@ namespace argos {
    /****************************************/
    /****************************************/
 
+   struct SDynamics2DClosestHitData {
+      SEmbodiedEntityIntersectionItem& Item;
+      const CRay3& Ray;
+      const CEmbodiedEntity* Excluded;
+      cpVect Start;
+      cpVect End;
+
+      SDynamics2DClosestHitData(SEmbodiedEntityIntersectionItem& s_item,
+                                const CRay3& c_ray,
+                                const CEmbodiedEntity* pc_excluded) :
+         Item(s_item),
+         Ray(c_ray),
+         Excluded(pc_excluded),
+         Start(cpv(c_ray.GetStart().GetX(), c_ray.GetStart().GetY())),
+         End(cpv(c_ray.GetEnd().GetX(), c_ray.GetEnd().GetY())) {}
+   };
+
+   static cpFloat Dynamics2DClosestSegmentQueryFunc(void* pt_data, void* pt_shape, void*) {
+      /* Get the data associated to this query */
+      SDynamics2DClosestHitData& sData = *reinterpret_cast<SDynamics2DClosestHitData*>(pt_data);
+      /* Same filter as cpSpaceSegmentQuery() with all layers and no group, without ghosts */
+      cpShape* ptShape = reinterpret_cast<cpShape*>(pt_shape);
+      cpSegmentQueryInfo tInfo;
+      if(ptShape->layers != 0 &&
+         ptShape->collision_type != CDynamics2DEngine::SHAPE_GHOST &&
+         cpShapeSegmentQuery(ptShape, sData.Start, sData.End, &tInfo) &&
+         tInfo.t < sData.Item.TOnRay) {
+         CEmbodiedEntity* pcEntity =
+            &reinterpret_cast<CDynamics2DModel*>(ptShape->body->data)->GetEmbodiedEntity();
+         Real fT = tInfo.t;
+         if(pcEntity != sData.Excluded &&
+            Dynamics2DRayHitsShape(ptShape, sData.Ray, fT) &&
+            sData.Item.TOnRay > fT) {
+            sData.Item = SEmbodiedEntityIntersectionItem(pcEntity, fT);
+         }
+      }
+      /*
+       * A hit in 3D is never closer than the crossing in 2D, so the shapes
+       * beyond the closest hit found so far can be skipped
+       */
+      return sData.Item.TOnRay;
+   }
+
+   void CDynamics2DEngine::CheckClosestIntersectionWithRay(SEmbodiedEntityIntersectionItem& s_item,
+                                                           const CRay3& c_ray,
+                                                           const CEmbodiedEntity* pc_excluded) const {
+      /*
+       * Query the spatial indexes directly, as cpSpaceSegmentQueryFirst() does,
+       * but with the checks on Z and the excluded entity in the callback
+       */
+      SDynamics2DClosestHitData sHitData(s_item, c_ray, pc_excluded);
+      cpSpatialIndexSegmentQuery(m_ptSpace->staticShapes, &sHitData, sHitData.Start, sHitData.End,
+                                 s_item.TOnRay, Dynamics2DClosestSegmentQueryFunc, nullptr);
+      cpSpatialIndexSegmentQuery(m_ptSpace->activeShapes, &sHitData, sHitData.Start, sHitData.End,
+                                 s_item.TOnRay, Dynamics2DClosestSegmentQueryFunc, nullptr);
+   }
+
+   /****************************************/
+   /****************************************/
+
+   static void Dynamics2DBBQueryFunc(void*, void* pt_shape, void* pt_data) {
+      /* Same filter as cpSpaceSegmentQuery() with all layers and no group, without ghosts */
+      cpShape* ptShape = reinterpret_cast<cpShape*>(pt_shape);
+      if(ptShape->layers != 0 &&
+         ptShape->collision_type != CDynamics2DEngine::SHAPE_GHOST) {
+         reinterpret_cast<std::vector<cpShape*>*>(pt_data)->push_back(ptShape);
+      }
+   }
+
+   void CDynamics2DEngine::CheckIntersectionWithRays(TEmbodiedEntityIntersectionData& t_items,
+                                                     const std::vector<CRay3>& vec_rays,
+                                                     const CEmbodiedEntity* pc_excluded) const {
+      if(vec_rays.empty()) return;
+      /* Calculate the bounding box of all the rays */
+      cpBB tBB = cpBBNew(vec_rays[0].GetStart().GetX(), vec_rays[0].GetStart().GetY(),
+                         vec_rays[0].GetStart().GetX(), vec_rays[0].GetStart().GetY());
+      for(size_t i = 0; i < vec_rays.size(); ++i) {
+         tBB = cpBBExpand(tBB, cpv(vec_rays[i].GetStart().GetX(), vec_rays[i].GetStart().GetY()));
+         tBB = cpBBExpand(tBB, cpv(vec_rays[i].GetEnd().GetX(),   vec_rays[i].GetEnd().GetY()  ));
+      }
+      /*
+       * Collect the shapes in the bounding box with a single query on each
+       * spatial index. cpSpaceBBQuery() is not used because it locks the
+       * space, which is not safe when the sensors are updated in parallel.
+       */
+      static thread_local std::vector<cpShape*> vecShapes;
+      vecShapes.clear();
+      cpSpatialIndexQuery(m_ptSpace->staticShapes, &tBB, tBB, Dynamics2DBBQueryFunc, &vecShapes);
+      cpSpatialIndexQuery(m_ptSpace->activeShapes, &tBB, tBB, Dynamics2DBBQueryFunc, &vecShapes);
+      /* Check each ray against the candidate shapes */
+      cpSegmentQueryInfo tInfo;
+      for(size_t i = 0; i < vec_rays.size(); ++i) {
+         cpVect tStart = cpv(vec_rays[i].GetStart().GetX(), vec_rays[i].GetStart().GetY());
+         cpVect tEnd   = cpv(vec_rays[i].GetEnd().GetX(),   vec_rays[i].GetEnd().GetY()  );
+         cpBB tRayBB = cpBBNew(Min(tStart.x, tEnd.x), Min(tStart.y, tEnd.y),
+                               Max(tStart.x, tEnd.x), Max(tStart.y, tEnd.y));
+         for(size_t j = 0; j < vecShapes.size(); ++j) {
+            if(cpBBIntersects(tRayBB, vecShapes[j]->bb) &&
+               cpShapeSegmentQuery(vecShapes[j], tStart, tEnd, &tInfo)) {
+               Real fT = tInfo.t;
+               CEmbodiedEntity* pcEntity =
+                  &reinterpret_cast<CDynamics2DModel*>(vecShapes[j]->body->data)->GetEmbodiedEntity();
+               if(pcEntity != pc_excluded &&
+                  Dynamics2DRayHitsShape(vecShapes[j], vec_rays[i], fT) &&
+                  t_items[i].TOnRay > fT) {
+                  t_items[i] = SEmbodiedEntityIntersectionItem(pcEntity, fT);
+               }
+            }
+         }
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
    void CDynamics2DEngine::PositionPhysicsToSpace(CVector3& c_new_pos,
                                                   const CVector3& c_original_pos,
                                                   const cpBody* pt_body) {
@@ -250,17 +379,16 @@ namespace argos {
 
    void CDynamics2DEngine::AddPhysicsModel(const std::string& str_id,
                                            CDynamics2DModel& c_model) {
-      m_tPhysicsModels[str_id] = &c_model;
+      m_tPhysicsModels.Insert(str_id, &c_model);
    }
 
    /****************************************/
    /****************************************/
 
    void CDynamics2DEngine::RemovePhysicsModel(const std::string& str_id) {
-      auto it = m_tPhysicsModels.find(str_id);
-      if(it != m_tPhysicsModels.end()) {
-         delete it->second;
-         m_tPhysicsModels.erase(it);
+      CDynamics2DModel* pcModel = m_tPhysicsModels.Remove(str_id);
+      if(pcModel != nullptr) {
+         delete pcModel;
       }
       else {
          THROW_ARGOSEXCEPTION("Dynamics2D model id \"" << str_id << "\" not found in dynamics 2D engine \"" << GetId() << "\"");
@@ -16,6 +16,7 @@ namespace argos {
 
 #include <argos3/core/simulator/entity/controllable_entity.h>
 #include <argos3/core/simulator/physics_engine/physics_engine.h>
+#include <argos3/plugins/simulator/physics_engines/physics_model_vector.h>
 #include <argos3/plugins/simulator/physics_engines/dynamics2d/chipmunk-physics/include/chipmunk.h>
 
 namespace argos {
@@ -46,7 +47,8 @@ namespace argos {
       enum EShapeType {
          SHAPE_NORMAL = 0,
          SHAPE_GRIPPABLE,
-         SHAPE_GRIPPER
+         SHAPE_GRIPPER,
+         SHAPE_GHOST
       };
 
       enum ELayerType {
@@ -70,6 +72,14 @@ namespace argos {
       virtual void CheckIntersectionWithRay(TEmbodiedEntityIntersectionData& t_data,
                                             const CRay3& c_ray) const;
 
+      virtual void CheckClosestIntersectionWithRay(SEmbodiedEntityIntersectionItem& s_item,
+                                                   const CRay3& c_ray,
+                                                   const CEmbodiedEntity* pc_excluded) const;
+
+      virtual void CheckIntersectionWithRays(TEmbodiedEntityIntersectionData& t_items,
+                                             const std::vector<CRay3>& vec_rays,
+                                             const CEmbodiedEntity* pc_excluded) const;
+
       inline cpFloat GetBoxLinearFriction() const {
          return m_fBoxLinearFriction;
       }
@@ -137,6 +147,14 @@ namespace argos {
                             CDynamics2DModel& c_model);
       void RemovePhysicsModel(const std::string& str_id);
 
+      inline CPhysicsModelVector<CDynamics2DModel>& GetPhysicsModels() {
+         return m_tPhysicsModels;
+      }
+
+      inline const CPhysicsModelVector<CDynamics2DModel>& GetPhysicsModels() const {
+         return m_tPhysicsModels;
+      }
+
    private:
 
       cpFloat m_fBoxLinearFriction;
@@ -149,7 +167,7 @@ namespace argos {
       Real m_fElevation;
 
       CControllableEntity::TMap m_tControllableEntities;
-      std::map<std::string, CDynamics2DModel*> m_tPhysicsModels;
+      CPhysicsModelVector<CDynamics2DModel> m_tPhysicsModels;
 
    };
 
@@ -68,6 +68,15 @@ namespace argos {
    /****************************************/
    /****************************************/
 
+   void CDynamics2DGripper::SetAnchor(const cpVect& t_anchor,
+                                      cpFloat f_rest_length) {
+      m_tGrippeeAnchor = t_anchor;
+      m_fRestLength = f_rest_length;
+   }
+
+   /****************************************/
+   /****************************************/
+
    static cpFloat GRIPPING_SPRING_DAMPING = 0.99;
    
    void CDynamics2DGripper::Grip(CDynamics2DGrippable* pc_grippee) {
@@ -73,6 +73,15 @@ namespace argos {
 
       void CalculateAnchor(cpArbiter* pt_arb);
 
+      /**
+       * Sets the anchor point on the grippable body and the rest length of the constraint.
+       * This is used to grip again without a contact, as when an entity moves to another engine.
+       * @param t_anchor The anchor point, in world coordinates.
+       * @param f_rest_length The rest length.
+       */
+      void SetAnchor(const cpVect& t_anchor,
+                     cpFloat f_rest_length);
+
       void Grip(CDynamics2DGrippable* pc_grippee);
 
       void Release();
@@ -113,6 +122,10 @@ namespace argos {
          return !m_listGrippers.empty();
       }
 
+      inline const CDynamics2DGripper::TList& GetGrippers() const {
+         return m_listGrippers;
+      }
+
       void Attach(CDynamics2DGripper& c_gripper);
 
       void Remove(CDynamics2DGripper& c_gripper);
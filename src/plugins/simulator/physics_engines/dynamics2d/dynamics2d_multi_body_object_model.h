@@ -89,6 +89,14 @@ namespace argos {
          return m_cEntity;
       }
 
+      /**
+       * Returns the number of bodies associated to the model.
+       * @return The number of bodies associated to the model.
+       */
+      inline size_t GetNumBodies() const {
+         return m_vecBodies.size();
+      }
+
       /**
        * Returns the i-th body associated to the model.
        * @return The i-th body associated to the model.
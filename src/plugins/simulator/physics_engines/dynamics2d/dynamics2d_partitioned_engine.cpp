@@ -0,0 +1,1390 @@
+/**
+ * @file <argos3/plugins/simulator/physics_engines/dynamics2d/dynamics2d_partitioned_engine.cpp>
+ */
+
+#include "dynamics2d_partitioned_engine.h"
+#include "dynamics2d_model.h"
+#include "dynamics2d_gripping.h"
+#include "dynamics2d_single_body_object_model.h"
+#include "dynamics2d_multi_body_object_model.h"
+
+#include <argos3/core/simulator/simulator.h>
+#include <argos3/core/simulator/space/space.h>
+#include <argos3/core/simulator/entity/composable_entity.h>
+#include <argos3/core/simulator/entity/embodied_entity.h>
+#include <argos3/core/utility/string_utilities.h>
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <unistd.h>
+
+namespace argos {
+
+   /****************************************/
+   /****************************************/
+
+   static const Real INFINITE_BOUND = std::numeric_limits<Real>::infinity();
+
+   /****************************************/
+   /****************************************/
+
+   /* All the ghosts share a group, so they do not collide with each other */
+   static const cpGroup GHOST_GROUP = 1;
+
+   /****************************************/
+   /****************************************/
+
+   /*
+    * Ghosts only touch the bodies that are simulated in their region. Their
+    * contacts with the static bodies are solved in the region of the
+    * original body. A contact between two bodies of different regions is
+    * seen by both regions, and only the region with the lower index solves
+    * it. The data of a ghost body is the region of the original body.
+    */
+   static cpBool BeginCollisionWithGhost(cpArbiter* pt_arb,
+                                         cpSpace*,
+                                         void* pt_data) {
+      cpBody* ptGhostBody;
+      cpBody* ptOtherBody;
+      cpArbiterGetBodies(pt_arb, &ptGhostBody, &ptOtherBody);
+      return
+         !cpBodyIsStatic(ptOtherBody) &&
+         !cpBodyIsRogue(ptOtherBody) &&
+         reinterpret_cast<CDynamics2DRegionEngine*>(pt_data)->GetIndex() <
+         reinterpret_cast<CDynamics2DRegionEngine*>(ptGhostBody->data)->GetIndex();
+   }
+
+   /****************************************/
+   /****************************************/
+
+   /*
+    * Makes a copy of the given shape, attached to the given body.
+    * Returns nullptr if the shape type is unknown.
+    */
+   static cpShape* CloneShape(cpBody* pt_body,
+                              cpShape* pt_shape) {
+      cpShape* ptClone;
+      switch(pt_shape->klass->type) {
+         case CP_CIRCLE_SHAPE:
+            ptClone = cpCircleShapeNew(pt_body,
+                                       cpCircleShapeGetRadius(pt_shape),
+                                       cpCircleShapeGetOffset(pt_shape));
+            break;
+         case CP_SEGMENT_SHAPE:
+            ptClone = cpSegmentShapeNew(pt_body,
+                                        cpSegmentShapeGetA(pt_shape),
+                                        cpSegmentShapeGetB(pt_shape),
+                                        cpSegmentShapeGetRadius(pt_shape));
+            break;
+         case CP_POLY_SHAPE: {
+            std::vector<cpVect> vecVerts(cpPolyShapeGetNumVerts(pt_shape));
+            for(size_t i = 0; i < vecVerts.size(); ++i) {
+               vecVerts[i] = cpPolyShapeGetVert(pt_shape, i);
+            }
+            ptClone = cpPolyShapeNew(pt_body,
+                                     vecVerts.size(),
+                                     &vecVerts[0],
+                                     cpvzero);
+            break;
+         }
+         default:
+            return nullptr;
+      }
+      ptClone->e = pt_shape->e;
+      ptClone->u = pt_shape->u;
+      ptClone->group = GHOST_GROUP;
+      ptClone->collision_type = CDynamics2DEngine::SHAPE_GHOST;
+      return ptClone;
+   }
+
+   /****************************************/
+   /****************************************/
+
+   /*
+    * Returns true if a body of the model is linked by a constraint to a body
+    * of another model, as it happens when an entity grips another.
+    */
+   static bool IsAttachedToOtherModels(const CDynamics2DModel* pc_model,
+                                       const std::vector<cpBody*>& vec_bodies) {
+      for(size_t i = 0; i < vec_bodies.size(); ++i) {
+         cpBody* ptBody = vec_bodies[i];
+         for(cpConstraint* ptConstraint = ptBody->constraintList;
+             ptConstraint != nullptr;
+             ptConstraint = (ptConstraint->a == ptBody) ? ptConstraint->next_a : ptConstraint->next_b) {
+            cpBody* ptOther = (ptConstraint->a == ptBody) ? ptConstraint->b : ptConstraint->a;
+            /* The ground body and the control bodies are not in the space */
+            if(!cpBodyIsRogue(ptOther) && ptOther->data != pc_model) {
+               return true;
+            }
+         }
+      }
+      return false;
+   }
+
+   /****************************************/
+   /****************************************/
+
+   /*
+    * Collects the grippers and the grippables of the given bodies, in the
+    * order of the bodies and of their shapes.
+    */
+   static void GetGrippingParts(const std::vector<cpBody*>& vec_bodies,
+                                std::vector<CDynamics2DGripper*>& vec_grippers,
+                                std::vector<CDynamics2DGrippable*>& vec_grippables) {
+      vec_grippers.clear();
+      vec_grippables.clear();
+      for(size_t i = 0; i < vec_bodies.size(); ++i) {
+         for(cpShape* ptShape = vec_bodies[i]->shapeList;
+             ptShape != nullptr;
+             ptShape = ptShape->next) {
+            if(ptShape->collision_type == CDynamics2DEngine::SHAPE_GRIPPER) {
+               vec_grippers.push_back(reinterpret_cast<CDynamics2DGripper*>(ptShape->data));
+            }
+            else if(ptShape->collision_type == CDynamics2DEngine::SHAPE_GRIPPABLE) {
+               vec_grippables.push_back(reinterpret_cast<CDynamics2DGrippable*>(ptShape->data));
+            }
+         }
+      }
+   }
+
+   /*
+    * Collects the grippers and the grippables of the model of the given entity
+    * in the given region. Returns false if the region has no such model.
+    */
+   static bool GetGrippingParts(CDynamics2DRegionEngine& c_region,
+                                const std::string& str_id,
+                                std::vector<CDynamics2DGripper*>& vec_grippers,
+                                std::vector<CDynamics2DGrippable*>& vec_grippables) {
+      CDynamics2DModel* pcModel = c_region.GetPhysicsModels().Find(str_id);
+      std::vector<cpBody*> vecBodies;
+      if(pcModel == nullptr ||
+         !CDynamics2DRegionEngine::GetBodies(*pcModel, vecBodies)) {
+         return false;
+      }
+      GetGrippingParts(vecBodies, vec_grippers, vec_grippables);
+      return true;
+   }
+
+   /****************************************/
+   /****************************************/
+
+   CDynamics2DRegionEngine::CDynamics2DRegionEngine(CDynamics2DPartitionedEngine& c_owner,
+                                                    UInt32 un_index) :
+      m_cOwner(c_owner),
+      m_unIndex(un_index),
+      m_cTileX(-INFINITE_BOUND, INFINITE_BOUND),
+      m_cTileY(-INFINITE_BOUND, INFINITE_BOUND),
+      m_fHysteresis(0.0) {}
+
+   /****************************************/
+   /****************************************/
+
+   void CDynamics2DRegionEngine::Init(TConfigurationNode& t_tree) {
+      CDynamics2DEngine::Init(t_tree);
+      cpSpaceAddCollisionHandler(GetPhysicsSpace(),
+                                 SHAPE_GHOST, SHAPE_NORMAL,
+                                 BeginCollisionWithGhost, nullptr, nullptr, nullptr,
+                                 this);
+      cpSpaceAddCollisionHandler(GetPhysicsSpace(),
+                                 SHAPE_GHOST, SHAPE_GRIPPABLE,
+                                 BeginCollisionWithGhost, nullptr, nullptr, nullptr,
+                                 this);
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CDynamics2DRegionEngine::Destroy() {
+      DiscardParkedEntities();
+      RemoveAllGhosts();
+      CDynamics2DEngine::Destroy();
+   }
+
+   /****************************************/
+   /****************************************/
+
+   bool CDynamics2DRegionEngine::RemoveEntity(CEntity& c_entity) {
+      /* The ghosts of the model in the other regions must go before the model */
+      CDynamics2DModel* pcModel = GetPhysicsModels().Find(c_entity.GetId());
+      if(pcModel != nullptr) {
+         m_cOwner.RemoveGhostsOf(pcModel);
+      }
+      /* The parked models of the entity in the other regions are useless now */
+      m_cOwner.DiscardParkedEntity(c_entity.GetId());
+      return CDynamics2DEngine::RemoveEntity(c_entity);
+   }
+
+   /****************************************/
+   /****************************************/
+
+   bool CDynamics2DRegionEngine::IsPointContained(const CVector3& c_point) {
+      return
+         CDynamics2DEngine::IsPointContained(c_point) &&
+         c_point.GetX() >= m_cTileX.GetMin() - m_fHysteresis &&
+         c_point.GetX() <  m_cTileX.GetMax() + m_fHysteresis &&
+         c_point.GetY() >= m_cTileY.GetMin() - m_fHysteresis &&
+         c_point.GetY() <  m_cTileY.GetMax() + m_fHysteresis;
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CDynamics2DRegionEngine::ScheduleEntityForTransfer(CEmbodiedEntity& c_entity) {
+      /* A gripped entity moves with the entity that grips it */
+      std::vector<CDynamics2DGripper*> vecGrippers;
+      std::vector<CDynamics2DGrippable*> vecGrippables;
+      if(GetGrippingParts(*this, c_entity.GetRootEntity().GetId(), vecGrippers, vecGrippables)) {
+         for(size_t i = 0; i < vecGrippables.size(); ++i) {
+            if(vecGrippables[i]->HasGrippers()) return;
+         }
+      }
+      m_vecMigrations.push_back(&c_entity);
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CDynamics2DRegionEngine::TransferEntities() {
+      std::vector<CEmbodiedEntity*> vecMigrations;
+      vecMigrations.swap(m_vecMigrations);
+      for(size_t i = 0; i < vecMigrations.size(); ++i) {
+         m_cOwner.MigrateEntity(*this, *vecMigrations[i]);
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   bool CDynamics2DRegionEngine::ParkEntity(CEntity& c_entity) {
+      CDynamics2DModel* pcModel = GetPhysicsModels().Find(c_entity.GetId());
+      if(pcModel == nullptr) return false;
+      SParkedModel sParked;
+      sParked.Model = pcModel;
+      if(!GetBodies(*pcModel, sParked.Bodies) ||
+         IsAttachedToOtherModels(pcModel, sParked.Bodies)) {
+         return false;
+      }
+      /* Collect the shapes and the constraints of the bodies */
+      for(size_t i = 0; i < sParked.Bodies.size(); ++i) {
+         cpBody* ptBody = sParked.Bodies[i];
+         if(cpBodyIsStatic(ptBody)) return false;
+         for(cpShape* ptShape = ptBody->shapeList;
+             ptShape != nullptr;
+             ptShape = ptShape->next) {
+            sParked.Shapes.push_back(ptShape);
+         }
+         for(cpConstraint* ptConstraint = ptBody->constraintList;
+             ptConstraint != nullptr;
+             ptConstraint = (ptConstraint->a == ptBody) ? ptConstraint->next_a : ptConstraint->next_b) {
+            /* A constraint between two bodies of the model is found twice */
+            if(std::find(sParked.Constraints.begin(),
+                         sParked.Constraints.end(),
+                         ptConstraint) == sParked.Constraints.end()) {
+               sParked.Constraints.push_back(ptConstraint);
+            }
+         }
+      }
+      /* Take everything out of the space */
+      m_cOwner.RemoveGhostsOf(pcModel);
+      for(size_t i = 0; i < sParked.Constraints.size(); ++i) {
+         cpSpaceRemoveConstraint(GetPhysicsSpace(), sParked.Constraints[i]);
+      }
+      for(size_t i = 0; i < sParked.Shapes.size(); ++i) {
+         cpSpaceRemoveShape(GetPhysicsSpace(), sParked.Shapes[i]);
+      }
+      for(size_t i = 0; i < sParked.Bodies.size(); ++i) {
+         cpSpaceRemoveBody(GetPhysicsSpace(), sParked.Bodies[i]);
+      }
+      /* Detach the model from this engine and from the entity */
+      GetPhysicsModels().Remove(c_entity.GetId());
+      pcModel->GetEmbodiedEntity().RemovePhysicsModel(GetId());
+      DiscardParkedEntity(c_entity.GetId());
+      m_mapParkedModels.insert(std::make_pair(c_entity.GetId(), sParked));
+      return true;
+   }
+
+   /****************************************/
+   /****************************************/
+
+   bool CDynamics2DRegionEngine::UnparkEntity(CEntity& c_entity) {
+      auto itParked = m_mapParkedModels.find(c_entity.GetId());
+      if(itParked == m_mapParkedModels.end()) return false;
+      SParkedModel& sParked = itParked->second;
+      PutBackInSpace(sParked);
+      GetPhysicsModels().Insert(c_entity.GetId(), sParked.Model);
+      sParked.Model->GetEmbodiedEntity().AddPhysicsModel(GetId(), *sParked.Model);
+      m_mapParkedModels.erase(itParked);
+      return true;
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CDynamics2DRegionEngine::DiscardParkedEntity(const std::string& str_id) {
+      auto itParked = m_mapParkedModels.find(str_id);
+      if(itParked == m_mapParkedModels.end()) return;
+      /* The model removes its objects from the space when it is deleted */
+      PutBackInSpace(itParked->second);
+      delete itParked->second.Model;
+      m_mapParkedModels.erase(itParked);
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CDynamics2DRegionEngine::DiscardParkedEntities() {
+      for(auto it = m_mapParkedModels.begin(); it != m_mapParkedModels.end(); ++it) {
+         PutBackInSpace(it->second);
+         delete it->second.Model;
+      }
+      m_mapParkedModels.clear();
+   }
+
+   /****************************************/
+   /****************************************/
+
+   bool CDynamics2DRegionEngine::GetBodies(CDynamics2DModel& c_model,
+                                           std::vector<cpBody*>& vec_bodies) {
+      vec_bodies.clear();
+      auto* pcSingleBodyModel = dynamic_cast<CDynamics2DSingleBodyObjectModel*>(&c_model);
+      if(pcSingleBodyModel != nullptr) {
+         vec_bodies.push_back(pcSingleBodyModel->GetBody());
+         return true;
+      }
+      auto* pcMultiBodyModel = dynamic_cast<CDynamics2DMultiBodyObjectModel*>(&c_model);
+      if(pcMultiBodyModel != nullptr) {
+         for(size_t i = 0; i < pcMultiBodyModel->GetNumBodies(); ++i) {
+            vec_bodies.push_back(pcMultiBodyModel->GetBody(i).Body);
+         }
+         return true;
+      }
+      return false;
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CDynamics2DRegionEngine::PutBackInSpace(SParkedModel& s_parked) {
+      for(size_t i = 0; i < s_parked.Bodies.size(); ++i) {
+         cpSpaceAddBody(GetPhysicsSpace(), s_parked.Bodies[i]);
+      }
+      /* Adding puts shapes and constraints at the head of the body lists, go backwards to keep the order */
+      for(size_t i = s_parked.Shapes.size(); i > 0; --i) {
+         cpSpaceAddShape(GetPhysicsSpace(), s_parked.Shapes[i - 1]);
+      }
+      for(size_t i = s_parked.Constraints.size(); i > 0; --i) {
+         cpSpaceAddConstraint(GetPhysicsSpace(), s_parked.Constraints[i - 1]);
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CDynamics2DRegionEngine::UpdateGhost(cpBody* pt_body,
+                                             CDynamics2DRegionEngine& c_source_region,
+                                             UInt32 un_stamp) {
+      auto itIndex = m_mapGhostIndices.find(pt_body);
+      if(itIndex == m_mapGhostIndices.end()) {
+         /* Make a new ghost, as heavy as the original body */
+         SGhost sGhost;
+         sGhost.Body = cpBodyNew(pt_body->m, pt_body->i);
+         sGhost.Body->data = &c_source_region;
+         sGhost.Source = pt_body;
+         sGhost.Model = reinterpret_cast<const CDynamics2DModel*>(pt_body->data);
+         cpBodySetPos(sGhost.Body, pt_body->p);
+         cpBodySetAngle(sGhost.Body, pt_body->a);
+         for(cpShape* ptShape = pt_body->shapeList;
+             ptShape != nullptr;
+             ptShape = ptShape->next) {
+            if(ptShape->sensor) continue;
+            cpShape* ptClone = CloneShape(sGhost.Body, ptShape);
+            if(ptClone != nullptr) {
+               ptClone->layers = ptShape->layers;
+               cpSpaceAddShape(GetPhysicsSpace(), ptClone);
+               sGhost.Shapes.push_back(std::make_pair(ptShape, ptClone));
+            }
+         }
+         itIndex = m_mapGhostIndices.insert(std::make_pair(pt_body, m_vecGhosts.size())).first;
+         m_vecGhosts.push_back(sGhost);
+      }
+      SGhost& sGhost = m_vecGhosts[itIndex->second];
+      SyncGhost(sGhost);
+      for(size_t i = 0; i < sGhost.Shapes.size(); ++i) {
+         sGhost.Shapes[i].second->layers = sGhost.Shapes[i].first->layers;
+      }
+      sGhost.Stamp = un_stamp;
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CDynamics2DRegionEngine::SyncGhost(SGhost& s_ghost) {
+      cpBodySetPos(s_ghost.Body, s_ghost.Source->p);
+      cpBodySetAngle(s_ghost.Body, s_ghost.Source->a);
+      cpBodySetVel(s_ghost.Body, s_ghost.Source->v);
+      cpBodySetAngVel(s_ghost.Body, s_ghost.Source->w);
+      s_ghost.Velocity = s_ghost.Source->v;
+      s_ghost.AngularVelocity = s_ghost.Source->w;
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CDynamics2DRegionEngine::SyncGhosts() {
+      for(size_t i = 0; i < m_vecGhosts.size(); ++i) {
+         SyncGhost(m_vecGhosts[i]);
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CDynamics2DRegionEngine::UpdateIterations(UInt32 un_first,
+                                                  UInt32 un_last) {
+      CPhysicsModelVector<CDynamics2DModel>& tModels = GetPhysicsModels();
+      /* Update the physics state from the entities */
+      if(un_first == 0) {
+         for(auto it = tModels.begin(); it != tModels.end(); ++it) {
+            (*it)->UpdateFromEntityStatus();
+         }
+      }
+      /* Perform the iterations */
+      for(UInt32 i = un_first; i < un_last; ++i) {
+         for(auto it = tModels.begin(); it != tModels.end(); ++it) {
+            (*it)->UpdatePhysics();
+         }
+         cpSpaceStep(GetPhysicsSpace(), GetPhysicsClockTick());
+      }
+      /* Update the simulated space */
+      if(un_last == GetIterations()) {
+         for(auto it = tModels.begin(); it != tModels.end(); ++it) {
+            (*it)->UpdateEntityStatus();
+         }
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CDynamics2DRegionEngine::ApplyGhostImpulses() {
+      /* The ghosts are not integrated, so their change of velocity comes from the contacts only */
+      for(size_t i = 0; i < m_vecGhosts.size(); ++i) {
+         SGhost& sGhost = m_vecGhosts[i];
+         cpBodySetVel(sGhost.Source, cpvadd(sGhost.Source->v, cpvsub(sGhost.Body->v, sGhost.Velocity)));
+         cpBodySetAngVel(sGhost.Source, sGhost.Source->w + sGhost.Body->w - sGhost.AngularVelocity);
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CDynamics2DRegionEngine::RemoveStaleGhosts(UInt32 un_stamp) {
+      /* Keep the order of creation, so that the simulation is repeatable */
+      size_t unKept = 0;
+      for(size_t i = 0; i < m_vecGhosts.size(); ++i) {
+         if(m_vecGhosts[i].Stamp == un_stamp) {
+            if(unKept != i) {
+               m_vecGhosts[unKept] = m_vecGhosts[i];
+               m_mapGhostIndices[m_vecGhosts[unKept].Source] = unKept;
+            }
+            ++unKept;
+         }
+         else {
+            m_mapGhostIndices.erase(m_vecGhosts[i].Source);
+            FreeGhost(m_vecGhosts[i]);
+         }
+      }
+      m_vecGhosts.resize(unKept);
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CDynamics2DRegionEngine::RemoveGhostsOf(const CDynamics2DModel* pc_model) {
+      size_t unKept = 0;
+      for(size_t i = 0; i < m_vecGhosts.size(); ++i) {
+         if(m_vecGhosts[i].Model != pc_model) {
+            if(unKept != i) {
+               m_vecGhosts[unKept] = m_vecGhosts[i];
+               m_mapGhostIndices[m_vecGhosts[unKept].Source] = unKept;
+            }
+            ++unKept;
+         }
+         else {
+            m_mapGhostIndices.erase(m_vecGhosts[i].Source);
+            FreeGhost(m_vecGhosts[i]);
+         }
+      }
+      m_vecGhosts.resize(unKept);
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CDynamics2DRegionEngine::RemoveAllGhosts() {
+      for(size_t i = 0; i < m_vecGhosts.size(); ++i) {
+         FreeGhost(m_vecGhosts[i]);
+      }
+      m_vecGhosts.clear();
+      m_mapGhostIndices.clear();
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CDynamics2DRegionEngine::FreeGhost(SGhost& s_ghost) {
+      for(size_t i = 0; i < s_ghost.Shapes.size(); ++i) {
+         cpSpaceRemoveShape(GetPhysicsSpace(), s_ghost.Shapes[i].second);
+         cpShapeFree(s_ghost.Shapes[i].second);
+      }
+      cpBodyFree(s_ghost.Body);
+   }
+
+   /****************************************/
+   /****************************************/
+
+   static void* LaunchDynamics2DRegionThread(void* p_data) {
+      LOG.AddThreadSafeBuffer();
+      LOGERR.AddThreadSafeBuffer();
+      auto* psData = reinterpret_cast<CDynamics2DPartitionedEngine::SUpdateThreadData*>(p_data);
+      psData->Engine->UpdateThread(psData->Region);
+      return nullptr;
+   }
+
+   /****************************************/
+   /****************************************/
+
+   CDynamics2DPartitionedEngine::CDynamics2DPartitionedEngine() :
+      m_unRebalancePeriod(100),
+      m_unTicksSinceRebalance(0),
+      m_fHalo(0.1),
+      m_fHysteresis(0.05),
+      m_unGhostStamp(0),
+      m_unUpdateRound(0),
+      m_unFirstIteration(0),
+      m_unLastIteration(0),
+      m_unRegionsDone(0),
+      m_bStopThreads(false) {
+      pthread_mutex_init(&m_tUpdateMutex, nullptr);
+      pthread_cond_init(&m_tUpdateStartCond, nullptr);
+      pthread_cond_init(&m_tUpdateDoneCond, nullptr);
+   }
+
+   /****************************************/
+   /****************************************/
+
+   CDynamics2DPartitionedEngine::~CDynamics2DPartitionedEngine() {
+      pthread_cond_destroy(&m_tUpdateDoneCond);
+      pthread_cond_destroy(&m_tUpdateStartCond);
+      pthread_mutex_destroy(&m_tUpdateMutex);
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CDynamics2DPartitionedEngine::Init(TConfigurationNode& t_tree) {
+      try {
+         /* Init parent */
+         CPhysicsEngine::Init(t_tree);
+         if(GetVolume().IsActive()) {
+            THROW_ARGOSEXCEPTION("The partitioned dynamics 2D engine does not support <boundaries>, it always covers the entire arena");
+         }
+         /* Parse XML */
+         std::string strPartitions = "auto";
+         GetNodeAttributeOrDefault(t_tree, "partitions", strPartitions, strPartitions);
+         UInt32 unPartitions;
+         if(strPartitions == "auto") {
+            /* One partition per thread */
+            unPartitions = CSimulator::GetInstance().GetNumThreads();
+            if(unPartitions == 0) {
+               long nCores = ::sysconf(_SC_NPROCESSORS_ONLN);
+               unPartitions = (nCores > 0) ? nCores : 1;
+            }
+         }
+         else {
+            unPartitions = FromString<UInt32>(strPartitions);
+            if(unPartitions == 0) {
+               THROW_ARGOSEXCEPTION("The number of partitions must be greater than zero");
+            }
+         }
+         GetNodeAttributeOrDefault(t_tree, "rebalance_period", m_unRebalancePeriod, m_unRebalancePeriod);
+         GetNodeAttributeOrDefault(t_tree, "halo", m_fHalo, m_fHalo);
+         GetNodeAttributeOrDefault(t_tree, "hysteresis", m_fHysteresis, m_fHysteresis);
+         /*
+          * Make the configuration of the regions: a copy of this engine's configuration,
+          * without the attributes that only concern the partitioning
+          */
+         TConfigurationNode tRegionTree("dynamics2d");
+         TConfigurationAttributeIterator itAttribute;
+         std::string strKey, strValue;
+         for(itAttribute = itAttribute.begin(&t_tree);
+             itAttribute != itAttribute.end();
+             ++itAttribute) {
+            itAttribute.Get()->GetName(&strKey);
+            if(strKey != "partitions" &&
+               strKey != "rebalance_period" &&
+               strKey != "halo" &&
+               strKey != "hysteresis") {
+               itAttribute.Get()->GetValue(&strValue);
+               SetNodeAttribute(tRegionTree, strKey, strValue);
+            }
+         }
+         TConfigurationNodeIterator itChild;
+         for(itChild = itChild.begin(&t_tree);
+             itChild != itChild.end();
+             ++itChild) {
+            AddChildNode(tRegionTree, *itChild);
+         }
+         /* Create the regions */
+         LOG << "[INFO] The physics engine \""
+             << GetId()
+             << "\" will use "
+             << unPartitions
+             << " partitions"
+             << std::endl;
+         for(UInt32 i = 0; i < unPartitions; ++i) {
+            SetNodeAttribute(tRegionTree, "id", GetId() + "_" + ToString(i));
+            auto* pcRegion = new CDynamics2DRegionEngine(*this, i);
+            m_vecRegions.push_back(pcRegion);
+            pcRegion->Init(tRegionTree);
+            pcRegion->SetHysteresis(m_fHysteresis);
+            /*
+             * Until the space is initialized, the first region covers the whole plane. This way,
+             * the collision checks made while distributing the entities see all the entities.
+             */
+            if(i > 0) {
+               pcRegion->SetTile(CRange<Real>(0.0, 0.0), CRange<Real>(0.0, 0.0));
+            }
+         }
+         m_vecRegionErrors.resize(unPartitions);
+         /* Start the threads */
+         StartThreads();
+      }
+      catch(CARGoSException& ex) {
+         THROW_ARGOSEXCEPTION_NESTED("Error initializing the partitioned dynamics 2D engine \"" << GetId() << "\"", ex);
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CDynamics2DPartitionedEngine::PostSpaceInit() {
+      for(size_t i = 0; i < m_vecRegions.size(); ++i) {
+         m_vecRegions[i]->PostSpaceInit();
+      }
+      /* Now that the entities are in place, make the tiles */
+      Rebalance();
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CDynamics2DPartitionedEngine::Reset() {
+      for(size_t i = 0; i < m_vecRegions.size(); ++i) {
+         m_vecRegions[i]->Reset();
+      }
+      /* The entities are back to their initial positions */
+      m_unTicksSinceRebalance = 0;
+      Rebalance();
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CDynamics2DPartitionedEngine::Update() {
+      /* Recalculate the tiles, if it's time */
+      if(m_unRebalancePeriod > 0 &&
+         ++m_unTicksSinceRebalance >= m_unRebalancePeriod) {
+         Rebalance();
+         m_unTicksSinceRebalance = 0;
+      }
+      /* Mirror the bodies close to the border of their tile */
+      UpdateGhosts();
+      if(m_fHalo > 0.0 && m_vecRegions.size() > 1) {
+         /*
+          * The contacts with the ghosts are exchanged after each iteration,
+          * so that the bodies on both sides of a border push each other
+          * within the same step
+          */
+         for(UInt32 i = 0; i < GetIterations(); ++i) {
+            if(i > 0) {
+               for(size_t j = 0; j < m_vecRegions.size(); ++j) {
+                  m_vecRegions[j]->SyncGhosts();
+               }
+            }
+            UpdateRegions(i, i + 1);
+            for(size_t j = 0; j < m_vecRegions.size(); ++j) {
+               m_vecRegions[j]->ApplyGhostImpulses();
+            }
+         }
+      }
+      else {
+         /* No ghosts, the regions perform the whole step at once */
+         UpdateRegions(0, GetIterations());
+      }
+      /* Move the entities that left their tile */
+      TransferEntitiesAmongRegions();
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CDynamics2DPartitionedEngine::Destroy() {
+      StopThreads();
+      while(!m_vecRegions.empty()) {
+         m_vecRegions.back()->Destroy();
+         delete m_vecRegions.back();
+         m_vecRegions.pop_back();
+      }
+      m_vecRegionErrors.clear();
+   }
+
+   /****************************************/
+   /****************************************/
+
+   size_t CDynamics2DPartitionedEngine::GetNumPhysicsModels() {
+      size_t unModels = 0;
+      for(size_t i = 0; i < m_vecRegions.size(); ++i) {
+         unModels += m_vecRegions[i]->GetNumPhysicsModels();
+      }
+      return unModels;
+   }
+
+   /****************************************/
+   /****************************************/
+
+   bool CDynamics2DPartitionedEngine::AddEntity(CEntity& c_entity) {
+      auto* pcComposable = dynamic_cast<CComposableEntity*>(&c_entity);
+      if(pcComposable == nullptr || !pcComposable->HasComponent("body")) {
+         return m_vecRegions[0]->AddEntity(c_entity);
+      }
+      CEmbodiedEntity& cBody = pcComposable->GetComponent<CEmbodiedEntity>("body");
+      if(cBody.IsMovable()) {
+         /* A movable entity goes to the region whose tile contains it */
+         return GetRegionAt(cBody.GetOriginAnchor().Position).AddEntity(c_entity);
+      }
+      /* A non-movable entity goes to all the regions, the movable entities of any tile can touch it */
+      bool bAdded = false;
+      for(size_t i = 0; i < m_vecRegions.size(); ++i) {
+         bAdded |= m_vecRegions[i]->AddEntity(c_entity);
+      }
+      return bAdded;
+   }
+
+   /****************************************/
+   /****************************************/
+
+   bool CDynamics2DPartitionedEngine::RemoveEntity(CEntity& c_entity) {
+      auto* pcComposable = dynamic_cast<CComposableEntity*>(&c_entity);
+      if(pcComposable == nullptr || !pcComposable->HasComponent("body")) {
+         return m_vecRegions[0]->RemoveEntity(c_entity);
+      }
+      CEmbodiedEntity& cBody = pcComposable->GetComponent<CEmbodiedEntity>("body");
+      bool bRemoved = false;
+      for(size_t i = 0; i < m_vecRegions.size(); ++i) {
+         for(size_t j = 0; j < cBody.GetPhysicsModelsNum(); ++j) {
+            if(&cBody.GetPhysicsModel(j).GetEngine() == m_vecRegions[i]) {
+               bRemoved |= m_vecRegions[i]->RemoveEntity(c_entity);
+               break;
+            }
+         }
+      }
+      return bRemoved;
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CDynamics2DPartitionedEngine::CheckIntersectionWithRay(TEmbodiedEntityIntersectionData& t_data,
+                                                               const CRay3& c_ray) const {
+      m_vecRegions[0]->CheckIntersectionWithRay(t_data, c_ray);
+      for(size_t i = 1; i < m_vecRegions.size(); ++i) {
+         size_t unFirst = t_data.size();
+         m_vecRegions[i]->CheckIntersectionWithRay(t_data, c_ray);
+         /* The non-movable entities are in every region, keep those found in the first region only */
+         t_data.erase(
+            std::remove_if(t_data.begin() + unFirst,
+                           t_data.end(),
+                           [](const SEmbodiedEntityIntersectionItem& s_item) {
+                              return !s_item.IntersectedEntity->IsMovable();
+                           }),
+            t_data.end());
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CDynamics2DPartitionedEngine::CheckClosestIntersectionWithRay(SEmbodiedEntityIntersectionItem& s_item,
+                                                                      const CRay3& c_ray,
+                                                                      const CEmbodiedEntity* pc_excluded) const {
+      for(size_t i = 0; i < m_vecRegions.size(); ++i) {
+         m_vecRegions[i]->CheckClosestIntersectionWithRay(s_item, c_ray, pc_excluded);
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CDynamics2DPartitionedEngine::CheckIntersectionWithRays(TEmbodiedEntityIntersectionData& t_items,
+                                                                const std::vector<CRay3>& vec_rays,
+                                                                const CEmbodiedEntity* pc_excluded) const {
+      for(size_t i = 0; i < m_vecRegions.size(); ++i) {
+         m_vecRegions[i]->CheckIntersectionWithRays(t_items, vec_rays, pc_excluded);
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CDynamics2DPartitionedEngine::Rebalance() {
+      /* With the new tiles, the entities are unlikely to go back where they were */
+      for(size_t i = 0; i < m_vecRegions.size(); ++i) {
+         m_vecRegions[i]->DiscardParkedEntities();
+      }
+      /* Collect the positions of the movable entities */
+      std::vector<CVector2> vecPositions;
+      for(size_t i = 0; i < m_vecRegions.size(); ++i) {
+         const CPhysicsModelVector<CDynamics2DModel>& tModels = m_vecRegions[i]->GetPhysicsModels();
+         for(auto it = tModels.begin(); it != tModels.end(); ++it) {
+            const CEmbodiedEntity& cBody = (*it)->GetEmbodiedEntity();
+            if(cBody.IsMovable()) {
+               vecPositions.push_back(CVector2(cBody.GetOriginAnchor().Position.GetX(),
+                                               cBody.GetOriginAnchor().Position.GetY()));
+            }
+         }
+      }
+      /* Make the tiles */
+      const CRange<CVector3>& cArenaLimits = CSimulator::GetInstance().GetSpace().GetArenaLimits();
+      m_cArenaX.Set(cArenaLimits.GetMin().GetX(), cArenaLimits.GetMax().GetX());
+      m_cArenaY.Set(cArenaLimits.GetMin().GetY(), cArenaLimits.GetMax().GetY());
+      Bisect(0, m_vecRegions.size(),
+             CRange<Real>(-INFINITE_BOUND, INFINITE_BOUND),
+             CRange<Real>(-INFINITE_BOUND, INFINITE_BOUND),
+             vecPositions.begin(), vecPositions.end());
+      /* Move the entities that are now in another tile */
+      for(size_t i = 0; i < m_vecRegions.size(); ++i) {
+         const CPhysicsModelVector<CDynamics2DModel>& tModels = m_vecRegions[i]->GetPhysicsModels();
+         for(auto it = tModels.begin(); it != tModels.end(); ++it) {
+            CEmbodiedEntity& cBody = (*it)->GetEmbodiedEntity();
+            if(cBody.IsMovable() &&
+               !m_vecRegions[i]->IsInTile(cBody.GetOriginAnchor().Position)) {
+               m_vecRegions[i]->ScheduleEntityForTransfer(cBody);
+            }
+         }
+      }
+      TransferEntitiesAmongRegions();
+   }
+
+   /****************************************/
+   /****************************************/
+
+   static void CollectBody(cpBody* pt_body,
+                           void* pt_data) {
+      reinterpret_cast<std::vector<cpBody*>*>(pt_data)->push_back(pt_body);
+   }
+
+   void CDynamics2DPartitionedEngine::UpdateGhosts() {
+      if(m_fHalo <= 0.0 || m_vecRegions.size() < 2) return;
+      ++m_unGhostStamp;
+      /*
+       * Collect the bodies of each region and their bounding boxes.
+       * The halo of a region is the bounding box of its bodies, grown by the margin.
+       */
+      std::vector<std::vector<cpBody*> > vecBodies(m_vecRegions.size());
+      std::vector<std::vector<cpBB> > vecBodyBBs(m_vecRegions.size());
+      std::vector<cpBB> vecHalos(m_vecRegions.size());
+      for(size_t i = 0; i < m_vecRegions.size(); ++i) {
+         cpSpaceEachBody(m_vecRegions[i]->GetPhysicsSpace(), CollectBody, &vecBodies[i]);
+         vecBodyBBs[i].resize(vecBodies[i].size());
+         bool bHaloEmpty = true;
+         for(size_t j = 0; j < vecBodies[i].size(); ++j) {
+            bool bBBEmpty = true;
+            for(cpShape* ptShape = vecBodies[i][j]->shapeList;
+                ptShape != nullptr;
+                ptShape = ptShape->next) {
+               if(ptShape->sensor) continue;
+               vecBodyBBs[i][j] = bBBEmpty ? ptShape->bb : cpBBMerge(vecBodyBBs[i][j], ptShape->bb);
+               bBBEmpty = false;
+            }
+            if(bBBEmpty) {
+               /* Nothing to mirror, mark the body to skip it */
+               vecBodies[i][j] = nullptr;
+               continue;
+            }
+            vecHalos[i] = bHaloEmpty ? vecBodyBBs[i][j] : cpBBMerge(vecHalos[i], vecBodyBBs[i][j]);
+            bHaloEmpty = false;
+         }
+         if(bHaloEmpty) {
+            /* An empty region needs no ghosts */
+            vecHalos[i] = cpBBNew(INFINITY, INFINITY, -INFINITY, -INFINITY);
+         }
+         else {
+            vecHalos[i] = cpBBNew(vecHalos[i].l - m_fHalo, vecHalos[i].b - m_fHalo,
+                                  vecHalos[i].r + m_fHalo, vecHalos[i].t + m_fHalo);
+         }
+      }
+      /* Mirror the bodies that fall in the halo of another region */
+      for(size_t i = 0; i < m_vecRegions.size(); ++i) {
+         for(size_t j = 0; j < vecBodies[i].size(); ++j) {
+            if(vecBodies[i][j] == nullptr) continue;
+            for(size_t k = 0; k < m_vecRegions.size(); ++k) {
+               if(k != i && cpBBIntersects(vecHalos[k], vecBodyBBs[i][j])) {
+                  m_vecRegions[k]->UpdateGhost(vecBodies[i][j], *m_vecRegions[i], m_unGhostStamp);
+               }
+            }
+         }
+      }
+      for(size_t i = 0; i < m_vecRegions.size(); ++i) {
+         m_vecRegions[i]->RemoveStaleGhosts(m_unGhostStamp);
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CDynamics2DPartitionedEngine::RemoveGhostsOf(const CDynamics2DModel* pc_model) {
+      for(size_t i = 0; i < m_vecRegions.size(); ++i) {
+         m_vecRegions[i]->RemoveGhostsOf(pc_model);
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CDynamics2DPartitionedEngine::DiscardParkedEntity(const std::string& str_id) {
+      for(size_t i = 0; i < m_vecRegions.size(); ++i) {
+         m_vecRegions[i]->DiscardParkedEntity(str_id);
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CDynamics2DPartitionedEngine::UpdateThread(UInt32 un_region) {
+      UInt32 unRound = 0;
+      while(true) {
+         /* Wait for the next update */
+         pthread_mutex_lock(&m_tUpdateMutex);
+         while(!m_bStopThreads && m_unUpdateRound == unRound) {
+            pthread_cond_wait(&m_tUpdateStartCond, &m_tUpdateMutex);
+         }
+         if(m_bStopThreads) {
+            pthread_mutex_unlock(&m_tUpdateMutex);
+            return;
+         }
+         unRound = m_unUpdateRound;
+         pthread_mutex_unlock(&m_tUpdateMutex);
+         /* Update the region */
+         UpdateRegion(un_region);
+         /* Tell the engine the region is done */
+         pthread_mutex_lock(&m_tUpdateMutex);
+         ++m_unRegionsDone;
+         if(m_unRegionsDone == m_vecThreads.size()) {
+            pthread_cond_signal(&m_tUpdateDoneCond);
+         }
+         pthread_mutex_unlock(&m_tUpdateMutex);
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CDynamics2DPartitionedEngine::Bisect(UInt32 un_first_region,
+                                             UInt32 un_num_regions,
+                                             const CRange<Real>& c_tile_x,
+                                             const CRange<Real>& c_tile_y,
+                                             std::vector<CVector2>::iterator it_first,
+                                             std::vector<CVector2>::iterator it_last) {
+      if(un_num_regions == 1) {
+         m_vecRegions[un_first_region]->SetTile(c_tile_x, c_tile_y);
+         return;
+      }
+      /* Split the regions in two groups, and the tile along its longest side within the arena */
+      UInt32 unLeftRegions = un_num_regions / 2;
+      CRange<Real> cSpanX(Min(Max(c_tile_x.GetMin(), m_cArenaX.GetMin()), c_tile_x.GetMax()),
+                          Max(Min(c_tile_x.GetMax(), m_cArenaX.GetMax()), c_tile_x.GetMin()));
+      CRange<Real> cSpanY(Min(Max(c_tile_y.GetMin(), m_cArenaY.GetMin()), c_tile_y.GetMax()),
+                          Max(Min(c_tile_y.GetMax(), m_cArenaY.GetMax()), c_tile_y.GetMin()));
+      if(cSpanX.GetMax() < cSpanX.GetMin()) cSpanX.Set(cSpanX.GetMin(), cSpanX.GetMin());
+      if(cSpanY.GetMax() < cSpanY.GetMin()) cSpanY.Set(cSpanY.GetMin(), cSpanY.GetMin());
+      bool bAlongX = (cSpanX.GetSpan() >= cSpanY.GetSpan());
+      const CRange<Real>& cTile = bAlongX ? c_tile_x : c_tile_y;
+      const CRange<Real>& cSpan = bAlongX ? cSpanX : cSpanY;
+      auto fGetCoord = [bAlongX](const CVector2& c_pos) {
+         return bAlongX ? c_pos.GetX() : c_pos.GetY();
+      };
+      auto fCompare = [&fGetCoord](const CVector2& c_a, const CVector2& c_b) {
+         return fGetCoord(c_a) < fGetCoord(c_b);
+      };
+      /* Place the cut so that each group gets entities in proportion to its number of regions */
+      size_t unPositions = it_last - it_first;
+      size_t unLeftPositions = unPositions * unLeftRegions / un_num_regions;
+      Real fCut;
+      if(unLeftPositions > 0 && unLeftPositions < unPositions) {
+         std::nth_element(it_first, it_first + unLeftPositions, it_last, fCompare);
+         Real fRight = fGetCoord(*(it_first + unLeftPositions));
+         Real fLeft = fGetCoord(*std::max_element(it_first, it_first + unLeftPositions, fCompare));
+         fCut = (fLeft + fRight) * 0.5;
+      }
+      else {
+         /* Too few entities, cut the tile in proportion to the number of regions */
+         fCut = cSpan.GetMin() + cSpan.GetSpan() * unLeftRegions / un_num_regions;
+      }
+      fCut = Max(cTile.GetMin(), Min(cTile.GetMax(), fCut));
+      auto itMiddle = std::partition(it_first, it_last,
+                                     [&fGetCoord, fCut](const CVector2& c_pos) {
+                                        return fGetCoord(c_pos) < fCut;
+                                     });
+      /* Recurse on the two halves */
+      CRange<Real> cLeft(cTile.GetMin(), fCut);
+      CRange<Real> cRight(fCut, cTile.GetMax());
+      Bisect(un_first_region, unLeftRegions,
+             bAlongX ? cLeft : c_tile_x,
+             bAlongX ? c_tile_y : cLeft,
+             it_first, itMiddle);
+      Bisect(un_first_region + unLeftRegions, un_num_regions - unLeftRegions,
+             bAlongX ? cRight : c_tile_x,
+             bAlongX ? c_tile_y : cRight,
+             itMiddle, it_last);
+   }
+
+   /****************************************/
+   /****************************************/
+
+   CDynamics2DRegionEngine& CDynamics2DPartitionedEngine::GetRegionAt(const CVector3& c_point) {
+      for(size_t i = 0; i < m_vecRegions.size(); ++i) {
+         if(m_vecRegions[i]->IsInTile(c_point)) {
+            return *m_vecRegions[i];
+         }
+      }
+      /* The tiles cover the plane, this only happens with invalid coordinates */
+      return *m_vecRegions[0];
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CDynamics2DPartitionedEngine::UpdateRegions(UInt32 un_first_iteration,
+                                                    UInt32 un_last_iteration) {
+      m_unFirstIteration = un_first_iteration;
+      m_unLastIteration = un_last_iteration;
+      /* Wake up the threads, and update the first region meanwhile */
+      if(!m_vecThreads.empty()) {
+         pthread_mutex_lock(&m_tUpdateMutex);
+         ++m_unUpdateRound;
+         m_unRegionsDone = 0;
+         pthread_cond_broadcast(&m_tUpdateStartCond);
+         pthread_mutex_unlock(&m_tUpdateMutex);
+      }
+      UpdateRegion(0);
+      /* Wait for the threads to be done */
+      if(!m_vecThreads.empty()) {
+         pthread_mutex_lock(&m_tUpdateMutex);
+         while(m_unRegionsDone < m_vecThreads.size()) {
+            pthread_cond_wait(&m_tUpdateDoneCond, &m_tUpdateMutex);
+         }
+         pthread_mutex_unlock(&m_tUpdateMutex);
+      }
+      /* Report the errors of the regions */
+      for(size_t i = 0; i < m_vecRegionErrors.size(); ++i) {
+         if(!m_vecRegionErrors[i].empty()) {
+            std::string strError;
+            strError.swap(m_vecRegionErrors[i]);
+            THROW_ARGOSEXCEPTION("Error updating region \"" << m_vecRegions[i]->GetId() << "\": " << strError);
+         }
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CDynamics2DPartitionedEngine::UpdateRegion(UInt32 un_region) {
+      try {
+         m_vecRegions[un_region]->UpdateIterations(m_unFirstIteration, m_unLastIteration);
+      }
+      catch(CARGoSException& ex) {
+         m_vecRegionErrors[un_region] = ex.what();
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CDynamics2DPartitionedEngine::TransferEntitiesAmongRegions() {
+      /* The regions hand their entities to MigrateEntity() */
+      for(size_t i = 0; i < m_vecRegions.size(); ++i) {
+         m_vecRegions[i]->TransferEntities();
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   struct SDynamics2DBodyState {
+      cpVect Position;
+      cpFloat Angle;
+      cpVect Velocity;
+      cpFloat AngularVelocity;
+   };
+
+   void CDynamics2DPartitionedEngine::MigrateEntity(CDynamics2DRegionEngine& c_from,
+                                                    CEmbodiedEntity& c_entity) {
+      CEntity& cRoot = c_entity.GetRootEntity();
+      CDynamics2DRegionEngine& cTo = GetRegionAt(c_entity.GetOriginAnchor().Position);
+      /* The entity might have been scheduled twice, or moved with an entity it grips */
+      if(&cTo == &c_from || c_from.GetPhysicsModels().Find(cRoot.GetId()) == nullptr) return;
+      /* The entities held together by grips move together */
+      std::vector<CEntity*> vecGroup(1, &cRoot);
+      std::vector<SGrip> vecGrips;
+      CollectGrips(c_from, vecGroup, vecGrips);
+      /* Release the grips, so that the models can be parked */
+      for(size_t i = 0; i < vecGrips.size(); ++i) {
+         vecGrips[i].Gripper->Release();
+      }
+      for(size_t i = 0; i < vecGroup.size(); ++i) {
+         MoveEntity(c_from, cTo, *vecGroup[i]);
+      }
+      RestoreGrips(cTo, vecGrips);
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CDynamics2DPartitionedEngine::CollectGrips(CDynamics2DRegionEngine& c_region,
+                                                   std::vector<CEntity*>& vec_group,
+                                                   std::vector<SGrip>& vec_grips) {
+      /* The group grows as the grips are found */
+      for(size_t i = 0; i < vec_group.size(); ++i) {
+         std::vector<CDynamics2DGripper*> vecGrippers;
+         std::vector<CDynamics2DGrippable*> vecGrippables;
+         if(!GetGrippingParts(c_region, vec_group[i]->GetId(), vecGrippers, vecGrippables)) continue;
+         /* The entities this one grips */
+         for(size_t j = 0; j < vecGrippers.size(); ++j) {
+            if(vecGrippers[j]->IsGripping()) {
+               AddGrip(c_region, *vecGrippers[j], vec_group, vec_grips);
+            }
+         }
+         /* The entities that grip this one */
+         for(size_t j = 0; j < vecGrippables.size(); ++j) {
+            const CDynamics2DGripper::TList& tGrippers = vecGrippables[j]->GetGrippers();
+            for(auto it = tGrippers.begin(); it != tGrippers.end(); ++it) {
+               AddGrip(c_region, **it, vec_group, vec_grips);
+            }
+         }
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CDynamics2DPartitionedEngine::AddGrip(CDynamics2DRegionEngine& c_region,
+                                              CDynamics2DGripper& c_gripper,
+                                              std::vector<CEntity*>& vec_group,
+                                              std::vector<SGrip>& vec_grips) {
+      /* A grip is found from both of its entities */
+      for(size_t i = 0; i < vec_grips.size(); ++i) {
+         if(vec_grips[i].Gripper == &c_gripper) return;
+      }
+      SGrip sGrip;
+      sGrip.Gripper = &c_gripper;
+      sGrip.GripperEntity = &c_gripper.GetGripperEntity().GetRootEntity();
+      sGrip.GrippeeEntity = &c_gripper.GetGrippee()->GetEmbodiedEntity().GetRootEntity();
+      /* Find the gripper and the grippable among the parts of their models */
+      std::vector<CDynamics2DGripper*> vecGrippers;
+      std::vector<CDynamics2DGrippable*> vecGrippables;
+      GetGrippingParts(c_region, sGrip.GripperEntity->GetId(), vecGrippers, vecGrippables);
+      sGrip.GripperIndex =
+         std::find(vecGrippers.begin(), vecGrippers.end(), &c_gripper) - vecGrippers.begin();
+      GetGrippingParts(c_region, sGrip.GrippeeEntity->GetId(), vecGrippers, vecGrippables);
+      sGrip.GrippableIndex =
+         std::find(vecGrippables.begin(), vecGrippables.end(), c_gripper.GetGrippee()) - vecGrippables.begin();
+      /* Save the anchor as a point in the world, since the bodies keep their state */
+      cpConstraint* ptConstraint = c_gripper.GetConstraint();
+      sGrip.Anchor = cpBodyLocal2World(cpShapeGetBody(c_gripper.GetGrippee()->GetShape()),
+                                       cpDampedSpringGetAnchr2(ptConstraint));
+      sGrip.RestLength = cpDampedSpringGetRestLength(ptConstraint);
+      vec_grips.push_back(sGrip);
+      /* Add the entities to the group */
+      if(std::find(vec_group.begin(), vec_group.end(), sGrip.GripperEntity) == vec_group.end()) {
+         vec_group.push_back(sGrip.GripperEntity);
+      }
+      if(std::find(vec_group.begin(), vec_group.end(), sGrip.GrippeeEntity) == vec_group.end()) {
+         vec_group.push_back(sGrip.GrippeeEntity);
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CDynamics2DPartitionedEngine::RestoreGrips(CDynamics2DRegionEngine& c_region,
+                                                   const std::vector<SGrip>& vec_grips) {
+      for(size_t i = 0; i < vec_grips.size(); ++i) {
+         const SGrip& sGrip = vec_grips[i];
+         std::vector<CDynamics2DGripper*> vecGrippers;
+         std::vector<CDynamics2DGrippable*> vecGrippables;
+         std::vector<CDynamics2DGripper*> vecUnusedGrippers;
+         std::vector<CDynamics2DGrippable*> vecUnusedGrippables;
+         if(GetGrippingParts(c_region, sGrip.GripperEntity->GetId(), vecGrippers, vecUnusedGrippables) &&
+            GetGrippingParts(c_region, sGrip.GrippeeEntity->GetId(), vecUnusedGrippers, vecGrippables) &&
+            sGrip.GripperIndex < vecGrippers.size() &&
+            sGrip.GrippableIndex < vecGrippables.size()) {
+            vecGrippers[sGrip.GripperIndex]->SetAnchor(sGrip.Anchor, sGrip.RestLength);
+            vecGrippers[sGrip.GripperIndex]->Grip(vecGrippables[sGrip.GrippableIndex]);
+         }
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CDynamics2DPartitionedEngine::MoveEntity(CDynamics2DRegionEngine& c_from,
+                                                 CDynamics2DRegionEngine& c_to,
+                                                 CEntity& c_entity) {
+      CDynamics2DModel* pcModel = c_from.GetPhysicsModels().Find(c_entity.GetId());
+      if(pcModel == nullptr) return;
+      /* Save the state of the bodies */
+      std::vector<cpBody*> vecBodies;
+      std::vector<SDynamics2DBodyState> vecStates;
+      if(CDynamics2DRegionEngine::GetBodies(*pcModel, vecBodies)) {
+         for(size_t i = 0; i < vecBodies.size(); ++i) {
+            SDynamics2DBodyState sState;
+            sState.Position = vecBodies[i]->p;
+            sState.Angle = vecBodies[i]->a;
+            sState.Velocity = vecBodies[i]->v;
+            sState.AngularVelocity = vecBodies[i]->w;
+            vecStates.push_back(sState);
+         }
+      }
+      /* Take the entity out of its region, keeping the model in case it comes back */
+      if(!c_from.ParkEntity(c_entity)) {
+         c_from.RemoveEntity(c_entity);
+      }
+      /* Put the entity in its new region, reusing the model it left there if possible */
+      if(!c_to.UnparkEntity(c_entity)) {
+         c_to.AddEntity(c_entity);
+      }
+      /* Restore the state of the bodies */
+      CDynamics2DModel* pcNewModel = c_to.GetPhysicsModels().Find(c_entity.GetId());
+      if(pcNewModel != nullptr &&
+         CDynamics2DRegionEngine::GetBodies(*pcNewModel, vecBodies) &&
+         vecBodies.size() == vecStates.size()) {
+         for(size_t i = 0; i < vecBodies.size(); ++i) {
+            cpBodySetPos(vecBodies[i], vecStates[i].Position);
+            cpBodySetAngle(vecBodies[i], vecStates[i].Angle);
+            cpBodySetVel(vecBodies[i], vecStates[i].Velocity);
+            cpBodySetAngVel(vecBodies[i], vecStates[i].AngularVelocity);
+            cpBodyResetForces(vecBodies[i]);
+            cpSpaceReindexShapesForBody(c_to.GetPhysicsSpace(), vecBodies[i]);
+         }
+         pcNewModel->UpdateEntityStatus();
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CDynamics2DPartitionedEngine::StartThreads() {
+      int nErrors;
+      m_bStopThreads = false;
+      m_vecThreads.resize(m_vecRegions.size() - 1);
+      for(size_t i = 0; i < m_vecThreads.size(); ++i) {
+         m_vecThreadData.push_back(new SUpdateThreadData(i + 1, this));
+         if((nErrors = pthread_create(&m_vecThreads[i],
+                                      nullptr,
+                                      LaunchDynamics2DRegionThread,
+                                      reinterpret_cast<void*>(m_vecThreadData.back())))) {
+            m_vecThreads.resize(i);
+            THROW_ARGOSEXCEPTION("Error creating thread: " << ::strerror(nErrors));
+         }
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CDynamics2DPartitionedEngine::StopThreads() {
+      pthread_mutex_lock(&m_tUpdateMutex);
+      m_bStopThreads = true;
+      pthread_cond_broadcast(&m_tUpdateStartCond);
+      pthread_mutex_unlock(&m_tUpdateMutex);
+      for(size_t i = 0; i < m_vecThreads.size(); ++i) {
+         pthread_join(m_vecThreads[i], nullptr);
+      }
+      m_vecThreads.clear();
+      while(!m_vecThreadData.empty()) {
+         delete m_vecThreadData.back();
+         m_vecThreadData.pop_back();
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   REGISTER_PHYSICS_ENGINE(CDynamics2DPartitionedEngine,
+                           "dynamics2d_partitioned",
+                           "Carlo Pinciroli [ilpincy@gmail.com]",
+                           "1.0",
+                           "A 2D dynamics physics engine that splits the arena among threads.",
+                           "This physics engine splits the arena into rectangular tiles, and simulates\n"
+                           "each tile with a separate dynamics 2D engine, updated by its own thread.\n"
+                           "This achieves the same effect as specifying several dynamics2d engines with\n"
+                           "<boundaries>, but the tiles are calculated automatically. The tiles are made\n"
+                           "by recursively cutting the arena in two, so that each tile contains about the\n"
+                           "same number of movable entities. As the entities move, the tiles are\n"
+                           "periodically recalculated, and the entities that end up in another tile are\n"
+                           "transferred to it. An entity that leaves its tile keeps its velocity, and the\n"
+                           "tile keeps its model for a while in case it comes back. An entity gripped by\n"
+                           "another follows the entity that grips it: the two are transferred together,\n"
+                           "and the grip is kept. Non-movable entities, such as walls, are added to every\n"
+                           "tile. The bodies that are close to\n"
+                           "the border of their tile are mirrored in the neighbouring tiles as ghosts,\n"
+                           "which are copies of the bodies with the same mass. A contact between two\n"
+                           "entities in different tiles is solved once, in the tile with the lower index.\n"
+                           "After each of the 'iterations' of a step, the impulse received by the ghost is\n"
+                           "passed to the original body, and the ghost takes the new state of the body.\n"
+                           "This way, entities in different tiles push each other, with the delay of one\n"
+                           "iteration on one side. The tiles wait for each other after every iteration,\n"
+                           "so a lower number of iterations makes the engine faster. An entity cannot\n"
+                           "grip an entity of another tile.\n\n"
+                           "REQUIRED XML CONFIGURATION\n\n"
+                           "  <physics_engines>\n"
+                           "    ...\n"
+                           "    <dynamics2d_partitioned id=\"dyn2d\" />\n"
+                           "    ...\n"
+                           "  </physics_engines>\n\n"
+                           "The 'id' attribute is necessary and must be unique among the physics engines.\n"
+                           "If two engines share the same id, initialization aborts. The engines of the\n"
+                           "tiles get the same id followed by an underscore and the index of the tile.\n\n"
+                           "OPTIONAL XML CONFIGURATION\n\n"
+                           "The 'partitions' attribute sets the number of tiles. When set to 'auto', which\n"
+                           "is the default, the number of tiles is the number of threads set in the\n"
+                           "<system> section of the configuration file or, if no threads are set there,\n"
+                           "the number of cores of the machine. The 'rebalance_period' attribute sets\n"
+                           "how many ticks pass between two recalculations of the tiles. The default\n"
+                           "value is 100; setting it to 0 keeps the tiles calculated at the beginning of\n"
+                           "the experiment. The 'halo' attribute sets how close, in meters, a body must be\n"
+                           "to the bodies of another tile to be mirrored in it. The margin must cover the\n"
+                           "distance a body travels in a simulation step. The default value is 0.1; setting\n"
+                           "it to 0 disables the ghosts, so that entities in different tiles do not\n"
+                           "collide. The 'hysteresis' attribute sets how far, in meters, an entity must go\n"
+                           "beyond the border of its tile before it is transferred to the next tile. This\n"
+                           "avoids transferring back and forth the entities that move along a border. The\n"
+                           "default value is 0.05:\n\n"
+                           "  <physics_engines>\n"
+                           "    ...\n"
+                           "    <dynamics2d_partitioned id=\"dyn2d\"\n"
+                           "                            partitions=\"8\"\n"
+                           "                            rebalance_period=\"50\"\n"
+                           "                            halo=\"0.05\"\n"
+                           "                            hysteresis=\"0.1\" />\n"
+                           "    ...\n"
+                           "  </physics_engines>\n\n"
+                           "All the other attributes and nodes of the dynamics2d engine, such as\n"
+                           "'iterations', 'elevation' and <friction>, are accepted and passed to the\n"
+                           "engines of the tiles. The <boundaries> node is not supported.\n",
+                           "Under development"
+      );
+
+}
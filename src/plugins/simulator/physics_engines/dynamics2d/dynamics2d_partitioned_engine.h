@@ -0,0 +1,468 @@
+/**
+ * @file <argos3/plugins/simulator/physics_engines/dynamics2d/dynamics2d_partitioned_engine.h>
+ */
+
+#ifndef DYNAMICS2D_PARTITIONED_ENGINE_H
+#define DYNAMICS2D_PARTITIONED_ENGINE_H
+
+namespace argos {
+   class CDynamics2DPartitionedEngine;
+   class CDynamics2DRegionEngine;
+   class CDynamics2DGripper;
+}
+
+#include <argos3/core/utility/math/range.h>
+#include <argos3/plugins/simulator/physics_engines/dynamics2d/dynamics2d_engine.h>
+#include <pthread.h>
+#include <unordered_map>
+
+namespace argos {
+
+   /****************************************/
+   /****************************************/
+
+   /**
+    * A dynamics 2D engine that only houses the movable entities in a rectangular tile.
+    * The tile is half-open: it includes its minimum bounds and excludes its maximum bounds.
+    * The tiles on the border of the partition extend to infinity, so that the tiles
+    * cover the whole plane.
+    * The bodies of the neighbouring tiles that are close to this tile are mirrored by
+    * ghosts. A ghost is a copy of a body with the same mass, whose position and velocity
+    * are copied from the original body at every iteration of the step. A contact between
+    * bodies of two regions is solved by the region with the lower index only, and the
+    * impulse received by the ghost is passed to the original body after the iteration. Ghosts do not collide
+    * with each other or with static bodies, and they are invisible to ray queries.
+    * When an entity leaves the tile, its model is parked rather than deleted: its bodies,
+    * shapes and constraints are taken out of the space, but kept in memory. If the entity
+    * comes back, the parked model is put back in the space, which is cheaper than
+    * making a new one.
+    */
+   class CDynamics2DRegionEngine : public CDynamics2DEngine {
+
+   public:
+
+      CDynamics2DRegionEngine(CDynamics2DPartitionedEngine& c_owner,
+                              UInt32 un_index);
+
+      virtual ~CDynamics2DRegionEngine() {}
+
+      virtual void Init(TConfigurationNode& t_tree);
+      virtual void Destroy();
+
+      virtual bool RemoveEntity(CEntity& c_entity);
+
+      /**
+       * Returns <tt>true</tt> if the given point falls within the tile, grown by the hysteresis band.
+       * @param c_point The point.
+       * @return <tt>true</tt> if the given point falls within the tile, grown by the hysteresis band.
+       */
+      virtual bool IsPointContained(const CVector3& c_point);
+
+      /**
+       * Schedules an entity for migration to another region.
+       * The entities that are gripped by another entity are not scheduled: they migrate
+       * together with the entity that grips them.
+       * @param c_entity The entity.
+       */
+      virtual void ScheduleEntityForTransfer(CEmbodiedEntity& c_entity);
+
+      /**
+       * Migrates the scheduled entities to their new regions.
+       */
+      virtual void TransferEntities();
+
+      /**
+       * Returns <tt>true</tt> if the given point falls within the tile.
+       * @param c_point The point.
+       * @return <tt>true</tt> if the given point falls within the tile.
+       */
+      inline bool IsInTile(const CVector3& c_point) const {
+         return
+            m_cTileX.WithinMinBoundIncludedMaxBoundExcluded(c_point.GetX()) &&
+            m_cTileY.WithinMinBoundIncludedMaxBoundExcluded(c_point.GetY());
+      }
+
+      /**
+       * Sets the tile.
+       * @param c_x The range of the tile along the X axis.
+       * @param c_y The range of the tile along the Y axis.
+       */
+      inline void SetTile(const CRange<Real>& c_x,
+                          const CRange<Real>& c_y) {
+         m_cTileX = c_x;
+         m_cTileY = c_y;
+      }
+
+      inline UInt32 GetIndex() const {
+         return m_unIndex;
+      }
+
+      inline const CRange<Real>& GetTileX() const {
+         return m_cTileX;
+      }
+
+      inline const CRange<Real>& GetTileY() const {
+         return m_cTileY;
+      }
+
+      /**
+       * Sets the width of the band around the tile within which an entity is still considered inside.
+       * @param f_hysteresis The width of the band.
+       */
+      inline void SetHysteresis(Real f_hysteresis) {
+         m_fHysteresis = f_hysteresis;
+      }
+
+      /**
+       * Takes the given entity out of this region, keeping its model for later.
+       * @param c_entity The entity.
+       * @return <tt>false</tt> if the model cannot be parked; in this case, nothing is done.
+       */
+      bool ParkEntity(CEntity& c_entity);
+
+      /**
+       * Puts the given entity back in this region, using the model parked in ParkEntity().
+       * The bodies of the model are not moved: this is left to the caller.
+       * @param c_entity The entity.
+       * @return <tt>false</tt> if the entity has no parked model in this region.
+       */
+      bool UnparkEntity(CEntity& c_entity);
+
+      /**
+       * Deletes the parked model of the given entity, if any.
+       * @param str_id The id of the entity.
+       */
+      void DiscardParkedEntity(const std::string& str_id);
+
+      /**
+       * Deletes all the parked models.
+       */
+      void DiscardParkedEntities();
+
+      inline size_t GetNumParkedEntities() const {
+         return m_mapParkedModels.size();
+      }
+
+      /**
+       * Collects the bodies of the given model.
+       * @param c_model The model.
+       * @param vec_bodies The bodies, in the order in which the model created them.
+       * @return <tt>false</tt> if the model type is not known.
+       */
+      static bool GetBodies(CDynamics2DModel& c_model,
+                            std::vector<cpBody*>& vec_bodies);
+
+      /**
+       * Creates or moves the ghost of the given body.
+       * The ghost takes the position, velocity and layers of the body.
+       * @param pt_body A body of another region.
+       * @param c_source_region The region of the body.
+       * @param un_stamp The stamp of the current ghost update.
+       */
+      void UpdateGhost(cpBody* pt_body,
+                       CDynamics2DRegionEngine& c_source_region,
+                       UInt32 un_stamp);
+
+      /**
+       * Adds the change of velocity of each ghost during the last step to its original body.
+       * This must be called after all the regions are updated.
+       */
+      void ApplyGhostImpulses();
+
+      /**
+       * Copies the state of the original bodies into their ghosts.
+       * This must be called while no region is being updated.
+       */
+      void SyncGhosts();
+
+      /**
+       * Performs the iterations of the step in the given range.
+       * The first iteration of the step reads the state of the entities, the last one writes it back.
+       * @param un_first The first iteration.
+       * @param un_last The iteration after the last one.
+       */
+      void UpdateIterations(UInt32 un_first,
+                            UInt32 un_last);
+
+      /**
+       * Removes the ghosts that were not updated with the given stamp.
+       * @param un_stamp The stamp of the current ghost update.
+       */
+      void RemoveStaleGhosts(UInt32 un_stamp);
+
+      /**
+       * Removes the ghosts of the bodies of the given model.
+       * @param pc_model A model of another region.
+       */
+      void RemoveGhostsOf(const CDynamics2DModel* pc_model);
+
+      /**
+       * Removes all the ghosts.
+       */
+      void RemoveAllGhosts();
+
+      inline size_t GetNumGhosts() const {
+         return m_vecGhosts.size();
+      }
+
+   private:
+
+      struct SGhost {
+         /* The body of the ghost, which is not added to the space */
+         cpBody* Body;
+         /* The original body and its model */
+         cpBody* Source;
+         const CDynamics2DModel* Model;
+         /* The original shapes and their copies */
+         std::vector<std::pair<cpShape*, cpShape*> > Shapes;
+         /* The velocity copied from the original body */
+         cpVect Velocity;
+         cpFloat AngularVelocity;
+         /* The stamp of the last update */
+         UInt32 Stamp;
+      };
+
+      void FreeGhost(SGhost& s_ghost);
+
+      void SyncGhost(SGhost& s_ghost);
+
+      struct SParkedModel {
+         CDynamics2DModel* Model;
+         std::vector<cpBody*> Bodies;
+         std::vector<cpShape*> Shapes;
+         std::vector<cpConstraint*> Constraints;
+      };
+
+      void PutBackInSpace(SParkedModel& s_parked);
+
+   private:
+
+      CDynamics2DPartitionedEngine& m_cOwner;
+
+      /** The index of this region in the partitioned engine */
+      UInt32 m_unIndex;
+
+      CRange<Real> m_cTileX;
+      CRange<Real> m_cTileY;
+
+      /** The width of the band around the tile within which an entity is still considered inside */
+      Real m_fHysteresis;
+
+      /** The entities scheduled for migration */
+      std::vector<CEmbodiedEntity*> m_vecMigrations;
+
+      /** The parked models, by entity id */
+      std::unordered_map<std::string, SParkedModel> m_mapParkedModels;
+
+      /** The ghosts, in order of creation */
+      std::vector<SGhost> m_vecGhosts;
+
+      /** The index of the ghost of each original body */
+      std::unordered_map<cpBody*, size_t> m_mapGhostIndices;
+
+   };
+
+   /****************************************/
+   /****************************************/
+
+   /**
+    * A physics engine that splits the arena into tiles, each managed by a dynamics 2D engine.
+    * The tiles are obtained by recursive bisection, so that each tile contains about the
+    * same number of movable entities. Every few ticks, the tiles are recalculated from the
+    * current positions of the entities, and the entities that end up in another tile are
+    * transferred. Each tile is updated by its own thread. Before each step, the bodies
+    * that are within a margin of another tile are mirrored in it as ghosts, so that
+    * bodies in different tiles collide.
+    */
+   class CDynamics2DPartitionedEngine : public CPhysicsEngine {
+
+   public:
+
+      CDynamics2DPartitionedEngine();
+
+      virtual ~CDynamics2DPartitionedEngine();
+
+      virtual void Init(TConfigurationNode& t_tree);
+      virtual void PostSpaceInit();
+      virtual void Reset();
+      virtual void Update();
+      virtual void Destroy();
+
+      virtual size_t GetNumPhysicsModels();
+      virtual bool AddEntity(CEntity& c_entity);
+      virtual bool RemoveEntity(CEntity& c_entity);
+
+      virtual void CheckIntersectionWithRay(TEmbodiedEntityIntersectionData& t_data,
+                                            const CRay3& c_ray) const;
+
+      virtual void CheckClosestIntersectionWithRay(SEmbodiedEntityIntersectionItem& s_item,
+                                                   const CRay3& c_ray,
+                                                   const CEmbodiedEntity* pc_excluded) const;
+
+      virtual void CheckIntersectionWithRays(TEmbodiedEntityIntersectionData& t_items,
+                                             const std::vector<CRay3>& vec_rays,
+                                             const CEmbodiedEntity* pc_excluded) const;
+
+      /**
+       * Returns the engines that manage the tiles.
+       * @return The engines that manage the tiles.
+       */
+      inline const std::vector<CDynamics2DRegionEngine*>& GetRegions() const {
+         return m_vecRegions;
+      }
+
+      /**
+       * Recalculates the tiles from the current positions of the movable entities.
+       * The entities that end up in another tile are transferred to it.
+       */
+      void Rebalance();
+
+      /**
+       * Mirrors the bodies that are close to another tile as ghosts in that tile.
+       */
+      void UpdateGhosts();
+
+      /**
+       * Removes the ghosts of the bodies of the given model from all the regions.
+       * @param pc_model The model.
+       */
+      void RemoveGhostsOf(const CDynamics2DModel* pc_model);
+
+      /**
+       * Deletes the parked models of the given entity from all the regions.
+       * @param str_id The id of the entity.
+       */
+      void DiscardParkedEntity(const std::string& str_id);
+
+      /**
+       * Moves an entity from the given region to the region whose tile contains it.
+       * The state of the bodies, such as their velocity, is carried over. If the entity
+       * was in the destination region before, its parked model is reused. The entities
+       * held to the given one by grips move with it, and the grips are made again in the
+       * destination region.
+       * @param c_from The region that currently houses the entity.
+       * @param c_entity The entity.
+       */
+      void MigrateEntity(CDynamics2DRegionEngine& c_from,
+                         CEmbodiedEntity& c_entity);
+
+      /**
+       * The body of the thread that updates the given region.
+       * @param un_region The index of the region.
+       */
+      void UpdateThread(UInt32 un_region);
+
+   private:
+
+      void Bisect(UInt32 un_first_region,
+                  UInt32 un_num_regions,
+                  const CRange<Real>& c_tile_x,
+                  const CRange<Real>& c_tile_y,
+                  std::vector<CVector2>::iterator it_first,
+                  std::vector<CVector2>::iterator it_last);
+
+      CDynamics2DRegionEngine& GetRegionAt(const CVector3& c_point);
+
+      void UpdateRegion(UInt32 un_region);
+
+      /** A grip between two entities, saved while the entities migrate */
+      struct SGrip {
+         /* The gripper, valid until the entities migrate */
+         CDynamics2DGripper* Gripper;
+         /* The gripping entity and the index of the gripper in its model */
+         CEntity* GripperEntity;
+         size_t GripperIndex;
+         /* The gripped entity and the index of the grippable in its model */
+         CEntity* GrippeeEntity;
+         size_t GrippableIndex;
+         /* The anchor on the gripped body, in world coordinates, and the rest length */
+         cpVect Anchor;
+         cpFloat RestLength;
+      };
+
+      void CollectGrips(CDynamics2DRegionEngine& c_region,
+                        std::vector<CEntity*>& vec_group,
+                        std::vector<SGrip>& vec_grips);
+
+      void AddGrip(CDynamics2DRegionEngine& c_region,
+                   CDynamics2DGripper& c_gripper,
+                   std::vector<CEntity*>& vec_group,
+                   std::vector<SGrip>& vec_grips);
+
+      void RestoreGrips(CDynamics2DRegionEngine& c_region,
+                        const std::vector<SGrip>& vec_grips);
+
+      void MoveEntity(CDynamics2DRegionEngine& c_from,
+                      CDynamics2DRegionEngine& c_to,
+                      CEntity& c_entity);
+
+      void UpdateRegions(UInt32 un_first_iteration,
+                         UInt32 un_last_iteration);
+
+      void TransferEntitiesAmongRegions();
+
+      void StartThreads();
+
+      void StopThreads();
+
+   public:
+
+      struct SUpdateThreadData {
+         UInt32 Region;
+         CDynamics2DPartitionedEngine* Engine;
+
+         SUpdateThreadData(UInt32 un_region,
+                           CDynamics2DPartitionedEngine* pc_engine) :
+            Region(un_region),
+            Engine(pc_engine) {}
+      };
+
+   private:
+
+      /** The engines that manage the tiles */
+      std::vector<CDynamics2DRegionEngine*> m_vecRegions;
+
+      /** The error raised by the update of each region, if any */
+      std::vector<std::string> m_vecRegionErrors;
+
+      /** The number of ticks between two recalculations of the tiles; 0 means never */
+      UInt32 m_unRebalancePeriod;
+
+      /** The number of ticks since the last recalculation of the tiles */
+      UInt32 m_unTicksSinceRebalance;
+
+      /** The margin around the bodies of a tile within which the bodies of other tiles are mirrored; 0 means no ghosts */
+      Real m_fHalo;
+
+      /** The width of the band around the tiles within which entities do not migrate */
+      Real m_fHysteresis;
+
+      /** The stamp of the current ghost update */
+      UInt32 m_unGhostStamp;
+
+      /** The extent of the arena on the XY plane, used to place the cuts of empty tiles */
+      CRange<Real> m_cArenaX;
+      CRange<Real> m_cArenaY;
+
+      /** The threads that update the regions, the first region is updated by the caller */
+      std::vector<pthread_t> m_vecThreads;
+      std::vector<SUpdateThreadData*> m_vecThreadData;
+
+      /** Thread synchronization */
+      pthread_mutex_t m_tUpdateMutex;
+      pthread_cond_t m_tUpdateStartCond;
+      pthread_cond_t m_tUpdateDoneCond;
+      UInt32 m_unUpdateRound;
+      UInt32 m_unFirstIteration;
+      UInt32 m_unLastIteration;
+      UInt32 m_unRegionsDone;
+      bool m_bStopThreads;
+
+   };
+
+   /****************************************/
+   /****************************************/
+
+}
+
+#endif
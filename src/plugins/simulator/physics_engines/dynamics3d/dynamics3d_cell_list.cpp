@@ -0,0 +1,91 @@
+/**
+ * @file <argos3/plugins/simulator/physics_engines/dynamics3d/dynamics3d_cell_list.cpp>
+ */
+
+#include "dynamics3d_cell_list.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace argos {
+
+   /****************************************/
+   /****************************************/
+
+   /* The largest cell coordinate, so that three coordinates fit in 64 bits. The cells of
+      the points are kept one short of it, so that their neighbours fit too */
+   static const SInt32 MAX_CELL = (1 << 20) - 1;
+
+   static SInt64 PackCellCoordinates(SInt32 n_x,
+                                     SInt32 n_y,
+                                     SInt32 n_z) {
+      return
+         (static_cast<SInt64>(n_x + MAX_CELL + 1) << 42) |
+         (static_cast<SInt64>(n_y + MAX_CELL + 1) << 21) |
+          static_cast<SInt64>(n_z + MAX_CELL + 1);
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CDynamics3DCellList::Build(const std::vector<btVector3>& vec_points,
+                                   btScalar f_cell_size) {
+      /* calculate the cell of each point */
+      m_vecPointCells.resize(vec_points.size());
+      for(UInt32 i = 0; i < vec_points.size(); ++i) {
+         for(int j = 0; j < 3; ++j) {
+            btScalar fCell = std::floor(vec_points[i][j] / f_cell_size);
+            m_vecPointCells[i].Coordinates[j] =
+               static_cast<SInt32>(btClamped(fCell, btScalar(1 - MAX_CELL), btScalar(MAX_CELL - 1)));
+         }
+      }
+      /* sort the points by cell */
+      m_vecCellPoints.resize(vec_points.size());
+      for(UInt32 i = 0; i < vec_points.size(); ++i) {
+         m_vecCellPoints[i] = i;
+      }
+      std::sort(std::begin(m_vecCellPoints), std::end(m_vecCellPoints),
+                [this] (UInt32 un_point0, UInt32 un_point1) {
+                   const SInt32* pnCell0 = m_vecPointCells[un_point0].Coordinates;
+                   const SInt32* pnCell1 = m_vecPointCells[un_point1].Coordinates;
+                   return std::lexicographical_compare(pnCell0, pnCell0 + 3,
+                                                       pnCell1, pnCell1 + 3);
+                });
+      /* index the cells */
+      m_mapCells.clear();
+      for(UInt32 i = 0; i < m_vecCellPoints.size(); ++i) {
+         const SInt32* pnCell = m_vecPointCells[m_vecCellPoints[i]].Coordinates;
+         auto itCell = m_mapCells.emplace(PackCellCoordinates(pnCell[0], pnCell[1], pnCell[2]),
+                                          std::make_pair(i, UInt32(0))).first;
+         ++itCell->second.second;
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CDynamics3DCellList::GetNeighbours(UInt32 un_point,
+                                           std::vector<UInt32>& vec_neighbours) const {
+      vec_neighbours.clear();
+      const SInt32* pnCell = m_vecPointCells[un_point].Coordinates;
+      for(SInt32 nX = pnCell[0] - 1; nX <= pnCell[0] + 1; ++nX) {
+         for(SInt32 nY = pnCell[1] - 1; nY <= pnCell[1] + 1; ++nY) {
+            for(SInt32 nZ = pnCell[2] - 1; nZ <= pnCell[2] + 1; ++nZ) {
+               auto itCell = m_mapCells.find(PackCellCoordinates(nX, nY, nZ));
+               if(itCell == std::end(m_mapCells)) continue;
+               for(UInt32 k = 0; k < itCell->second.second; ++k) {
+                  UInt32 unPoint = m_vecCellPoints[itCell->second.first + k];
+                  if(unPoint > un_point) {
+                     vec_neighbours.push_back(unPoint);
+                  }
+               }
+            }
+         }
+      }
+      std::sort(std::begin(vec_neighbours), std::end(vec_neighbours));
+   }
+
+   /****************************************/
+   /****************************************/
+
+}
@@ -0,0 +1,73 @@
+/**
+ * @file <argos3/plugins/simulator/physics_engines/dynamics3d/dynamics3d_cell_list.h>
+ */
+
+#ifndef DYNAMICS3D_CELL_LIST_H
+#define DYNAMICS3D_CELL_LIST_H
+
+namespace argos {
+   class CDynamics3DCellList;
+}
+
+#include <argos3/core/utility/datatypes/datatypes.h>
+#include <argos3/plugins/simulator/physics_engines/dynamics3d/bullet/LinearMath/btVector3.h>
+#include <unordered_map>
+#include <vector>
+
+namespace argos {
+
+   /****************************************/
+   /****************************************/
+
+   /**
+    * Sorts points into cubic cells, to find the points that are close to each other.
+    * The points closer to a point than the size of the cells are in the 27 cells around
+    * it, so only these cells need to be checked. The points too far away to be stored
+    * in a cell are clamped to the border cells, which is harmless as long as the caller
+    * checks the distance of the neighbours it gets.
+    */
+   class CDynamics3DCellList {
+
+   public:
+
+      /**
+       * Sorts the given points into cells of the given size.
+       * @param vec_points The points.
+       * @param f_cell_size The size of the cells.
+       */
+      void Build(const std::vector<btVector3>& vec_points,
+                 btScalar f_cell_size);
+
+      /**
+       * Collects the points in the cells around the given point.
+       * Only the points whose index is greater than that of the given point are returned,
+       * in ascending order, so that each pair is found once and always in the same order.
+       * @param un_point The index of the point.
+       * @param vec_neighbours The indices of the neighbours.
+       */
+      void GetNeighbours(UInt32 un_point,
+                         std::vector<UInt32>& vec_neighbours) const;
+
+   private:
+
+      struct SCell {
+         SInt32 Coordinates[3];
+      };
+
+      /** The cell of each point */
+      std::vector<SCell> m_vecPointCells;
+
+      /** The indices of the points, sorted by cell */
+      std::vector<UInt32> m_vecCellPoints;
+
+      /** The first index in m_vecCellPoints and the number of points of each cell */
+      std::unordered_map<SInt64, std::pair<UInt32, UInt32> > m_mapCells;
+
+   };
+
+   /****************************************/
+   /****************************************/
+
+}
+
+#endif
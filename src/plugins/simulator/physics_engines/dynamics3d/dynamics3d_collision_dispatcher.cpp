@@ -0,0 +1,219 @@
+/**
+ * @file <argos3/plugins/simulator/physics_engines/dynamics3d/dynamics3d_collision_dispatcher.cpp>
+ */
+
+#include "dynamics3d_collision_dispatcher.h"
+
+#include <argos3/plugins/simulator/physics_engines/dynamics3d/dynamics3d_task_scheduler.h>
+#include <argos3/plugins/simulator/physics_engines/dynamics3d/bullet/BulletCollision/BroadphaseCollision/btOverlappingPairCache.h>
+#include <argos3/plugins/simulator/physics_engines/dynamics3d/bullet/BulletCollision/CollisionShapes/btCollisionShape.h>
+#include <argos3/plugins/simulator/physics_engines/dynamics3d/bullet/BulletCollision/NarrowPhaseCollision/btPersistentManifold.h>
+#include <argos3/plugins/simulator/physics_engines/dynamics3d/bullet/LinearMath/btPoolAllocator.h>
+
+#include <algorithm>
+
+namespace argos {
+
+   /****************************************/
+   /****************************************/
+
+   /* The number of pairs processed by a thread at a time */
+   static const int PAIRS_PER_CHUNK = 40;
+
+   /****************************************/
+   /****************************************/
+
+   struct SDynamics3DPairProcessor : public btIParallelForBody {
+      CDynamics3DCollisionDispatcher& Dispatcher;
+
+      SDynamics3DPairProcessor(CDynamics3DCollisionDispatcher& c_dispatcher) :
+         Dispatcher(c_dispatcher) {}
+
+      virtual void forLoop(int n_begin, int n_end) const {
+         Dispatcher.ProcessPairs(n_begin, n_end);
+      }
+   };
+
+   /****************************************/
+   /****************************************/
+
+   CDynamics3DCollisionDispatcher::CDynamics3DCollisionDispatcher(btCollisionConfiguration* pc_configuration,
+                                                                  CDynamics3DTaskScheduler* pc_task_scheduler) :
+      btCollisionDispatcher(pc_configuration),
+      m_pcTaskScheduler(pc_task_scheduler),
+      m_bParallel(false),
+      m_psPairs(nullptr),
+      m_pcDispatchInfo(nullptr) {
+      pthread_mutex_init(&m_tPoolMutex, nullptr);
+   }
+
+   /****************************************/
+   /****************************************/
+
+   CDynamics3DCollisionDispatcher::~CDynamics3DCollisionDispatcher() {
+      pthread_mutex_destroy(&m_tPoolMutex);
+   }
+
+   /****************************************/
+   /****************************************/
+
+   btPersistentManifold* CDynamics3DCollisionDispatcher::getNewManifold(const btCollisionObject* pc_body0,
+                                                                        const btCollisionObject* pc_body1) {
+      if(!m_bParallel) {
+         return btCollisionDispatcher::getNewManifold(pc_body0, pc_body1);
+      }
+      /* Same as btCollisionDispatcher, but the manifold is added to the dispatcher later */
+      btScalar fContactBreakingThreshold =
+         (m_dispatcherFlags & btCollisionDispatcher::CD_USE_RELATIVE_CONTACT_BREAKING_THRESHOLD) ?
+         btMin(pc_body0->getCollisionShape()->getContactBreakingThreshold(gContactBreakingThreshold),
+               pc_body1->getCollisionShape()->getContactBreakingThreshold(gContactBreakingThreshold)) :
+         gContactBreakingThreshold;
+      btScalar fContactProcessingThreshold =
+         btMin(pc_body0->getContactProcessingThreshold(), pc_body1->getContactProcessingThreshold());
+      pthread_mutex_lock(&m_tPoolMutex);
+      void* ptMemory = m_persistentManifoldPoolAllocator->allocate(sizeof(btPersistentManifold));
+      pthread_mutex_unlock(&m_tPoolMutex);
+      if(ptMemory == nullptr) {
+         if((m_dispatcherFlags & CD_DISABLE_CONTACTPOOL_DYNAMIC_ALLOCATION) != 0) {
+            return nullptr;
+         }
+         ptMemory = btAlignedAlloc(sizeof(btPersistentManifold), 16);
+      }
+      auto* pcManifold = new (ptMemory) btPersistentManifold(pc_body0,
+                                                             pc_body1,
+                                                             0,
+                                                             fContactBreakingThreshold,
+                                                             fContactProcessingThreshold);
+      SThreadData& sThreadData = m_vecThreadData[CDynamics3DTaskScheduler::GetThreadSlot()];
+      sThreadData.Records.emplace_back(sThreadData.Pair, pcManifold, true);
+      return pcManifold;
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CDynamics3DCollisionDispatcher::releaseManifold(btPersistentManifold* pc_manifold) {
+      if(!m_bParallel) {
+         btCollisionDispatcher::releaseManifold(pc_manifold);
+         return;
+      }
+      /* The manifold is removed from the dispatcher and deleted later */
+      clearManifold(pc_manifold);
+      SThreadData& sThreadData = m_vecThreadData[CDynamics3DTaskScheduler::GetThreadSlot()];
+      sThreadData.Records.emplace_back(sThreadData.Pair, pc_manifold, false);
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CDynamics3DCollisionDispatcher::dispatchAllCollisionPairs(btOverlappingPairCache* pc_pair_cache,
+                                                                  const btDispatcherInfo& c_dispatch_info,
+                                                                  btDispatcher* pc_dispatcher) {
+      /* The sorted order of the pairs is only implemented by the serial dispatcher */
+      if(m_pcTaskScheduler == nullptr ||
+         c_dispatch_info.m_deterministicOverlappingPairs) {
+         btCollisionDispatcher::dispatchAllCollisionPairs(pc_pair_cache, c_dispatch_info, pc_dispatcher);
+         return;
+      }
+      int nNumPairs = pc_pair_cache->getNumOverlappingPairs();
+      if(nNumPairs == 0) return;
+      m_vecThreadData.resize(m_pcTaskScheduler->getNumThreads());
+      m_psPairs = pc_pair_cache->getOverlappingPairArrayPtr();
+      m_pcDispatchInfo = &c_dispatch_info;
+      m_bParallel = true;
+      m_pcTaskScheduler->parallelFor(0, nNumPairs, PAIRS_PER_CHUNK, SDynamics3DPairProcessor(*this));
+      m_bParallel = false;
+      ReplayManifoldRecords();
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void* CDynamics3DCollisionDispatcher::allocateCollisionAlgorithm(int n_size) {
+      if(!m_bParallel) {
+         return btCollisionDispatcher::allocateCollisionAlgorithm(n_size);
+      }
+      pthread_mutex_lock(&m_tPoolMutex);
+      void* ptMemory = btCollisionDispatcher::allocateCollisionAlgorithm(n_size);
+      pthread_mutex_unlock(&m_tPoolMutex);
+      return ptMemory;
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CDynamics3DCollisionDispatcher::freeCollisionAlgorithm(void* pt_memory) {
+      if(!m_bParallel) {
+         btCollisionDispatcher::freeCollisionAlgorithm(pt_memory);
+         return;
+      }
+      pthread_mutex_lock(&m_tPoolMutex);
+      btCollisionDispatcher::freeCollisionAlgorithm(pt_memory);
+      pthread_mutex_unlock(&m_tPoolMutex);
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CDynamics3DCollisionDispatcher::ProcessPairs(int n_begin,
+                                                     int n_end) {
+      SThreadData& sThreadData = m_vecThreadData[CDynamics3DTaskScheduler::GetThreadSlot()];
+      btNearCallback tNearCallback = getNearCallback();
+      for(int i = n_begin; i < n_end; ++i) {
+         sThreadData.Pair = i;
+         tNearCallback(m_psPairs[i], *this, *m_pcDispatchInfo);
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CDynamics3DCollisionDispatcher::ReplayManifoldRecords() {
+      /* Put the records of all the threads in the order of the pairs. The records of a
+         pair are made by a single thread, so the stable sort keeps them in order */
+      std::vector<SManifoldRecord> vecRecords;
+      for(size_t i = 0; i < m_vecThreadData.size(); ++i) {
+         vecRecords.insert(vecRecords.end(),
+                           m_vecThreadData[i].Records.begin(),
+                           m_vecThreadData[i].Records.end());
+         m_vecThreadData[i].Records.clear();
+      }
+      if(vecRecords.empty()) return;
+      std::stable_sort(vecRecords.begin(), vecRecords.end(),
+                       [] (const SManifoldRecord& s_a, const SManifoldRecord& s_b) {
+                          return s_a.Pair < s_b.Pair;
+                       });
+      /* Update the manifolds as btCollisionDispatcher would have */
+      for(size_t i = 0; i < vecRecords.size(); ++i) {
+         btPersistentManifold* pcManifold = vecRecords[i].Manifold;
+         if(vecRecords[i].Created) {
+            pcManifold->m_index1a = m_manifoldsPtr.size();
+            m_manifoldsPtr.push_back(pcManifold);
+         }
+         else {
+            int nIndex = pcManifold->m_index1a;
+            m_manifoldsPtr.swap(nIndex, m_manifoldsPtr.size() - 1);
+            m_manifoldsPtr[nIndex]->m_index1a = nIndex;
+            m_manifoldsPtr.pop_back();
+            FreeManifold(pcManifold);
+         }
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CDynamics3DCollisionDispatcher::FreeManifold(btPersistentManifold* pc_manifold) {
+      pc_manifold->~btPersistentManifold();
+      if(m_persistentManifoldPoolAllocator->validPtr(pc_manifold)) {
+         m_persistentManifoldPoolAllocator->freeMemory(pc_manifold);
+      }
+      else {
+         btAlignedFree(pc_manifold);
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+}
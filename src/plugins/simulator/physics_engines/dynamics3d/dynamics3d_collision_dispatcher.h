@@ -0,0 +1,141 @@
+/**
+ * @file <argos3/plugins/simulator/physics_engines/dynamics3d/dynamics3d_collision_dispatcher.h>
+ */
+
+#ifndef DYNAMICS3D_COLLISION_DISPATCHER_H
+#define DYNAMICS3D_COLLISION_DISPATCHER_H
+
+namespace argos {
+   class CDynamics3DCollisionDispatcher;
+   class CDynamics3DTaskScheduler;
+}
+
+#include <argos3/core/utility/datatypes/datatypes.h>
+
+#ifdef __APPLE__
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wreorder"
+#else
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wreorder"
+#endif
+
+#include <argos3/plugins/simulator/physics_engines/dynamics3d/bullet/BulletCollision/CollisionDispatch/btCollisionDispatcher.h>
+
+#ifdef __APPLE__
+#pragma clang diagnostic pop
+#else
+#pragma GCC diagnostic pop
+#endif
+
+#include <pthread.h>
+#include <vector>
+
+namespace argos {
+
+   /****************************************/
+   /****************************************/
+
+   /**
+    * A collision dispatcher that runs the narrow phase in parallel.
+    * Without a task scheduler, it behaves exactly like btCollisionDispatcher. With a task
+    * scheduler, the overlapping pairs are spread among the threads of the scheduler. The
+    * manifolds that are created and released while the pairs are processed are recorded
+    * per thread, and the records are replayed in the order of the pairs once all the
+    * pairs are processed. This way, the manifolds end up in the same order as with the
+    * serial dispatcher, and the simulation does not depend on the number of threads.
+    * Only the narrow phase is parallel: the constraint solver of the multi-body world
+    * still runs in the thread that steps the world.
+    */
+   class CDynamics3DCollisionDispatcher : public btCollisionDispatcher {
+
+   public:
+
+      /**
+       * Class constructor.
+       * @param pc_configuration The collision configuration.
+       * @param pc_task_scheduler The task scheduler, or <tt>nullptr</tt> to run the narrow phase serially.
+       */
+      CDynamics3DCollisionDispatcher(btCollisionConfiguration* pc_configuration,
+                                     CDynamics3DTaskScheduler* pc_task_scheduler = nullptr);
+
+      virtual ~CDynamics3DCollisionDispatcher();
+
+      inline void SetTaskScheduler(CDynamics3DTaskScheduler* pc_task_scheduler) {
+         m_pcTaskScheduler = pc_task_scheduler;
+      }
+
+      virtual btPersistentManifold* getNewManifold(const btCollisionObject* pc_body0,
+                                                   const btCollisionObject* pc_body1);
+
+      virtual void releaseManifold(btPersistentManifold* pc_manifold);
+
+      virtual void dispatchAllCollisionPairs(btOverlappingPairCache* pc_pair_cache,
+                                             const btDispatcherInfo& c_dispatch_info,
+                                             btDispatcher* pc_dispatcher);
+
+      virtual void* allocateCollisionAlgorithm(int n_size);
+
+      virtual void freeCollisionAlgorithm(void* pt_memory);
+
+      /**
+       * Processes the given overlapping pairs.
+       * This method is called by the threads of the task scheduler.
+       * @param n_begin The index of the first pair.
+       * @param n_end The index past the last pair.
+       */
+      void ProcessPairs(int n_begin,
+                        int n_end);
+
+   private:
+
+      struct SManifoldRecord {
+         /* The pair being processed when the manifold was created or released */
+         int Pair;
+         btPersistentManifold* Manifold;
+         bool Created;
+
+         SManifoldRecord(int n_pair,
+                         btPersistentManifold* pc_manifold,
+                         bool b_created) :
+            Pair(n_pair),
+            Manifold(pc_manifold),
+            Created(b_created) {}
+      };
+
+      struct SThreadData {
+         /* The pair being processed by the thread */
+         int Pair;
+         /* The manifolds created and released by the thread, in order */
+         std::vector<SManifoldRecord> Records;
+      };
+
+      void ReplayManifoldRecords();
+
+      void FreeManifold(btPersistentManifold* pc_manifold);
+
+   private:
+
+      CDynamics3DTaskScheduler* m_pcTaskScheduler;
+
+      /** The data of each thread of the task scheduler */
+      std::vector<SThreadData> m_vecThreadData;
+
+      /** Whether the pairs are being processed in parallel */
+      bool m_bParallel;
+
+      /** The pairs being processed, and the information to process them */
+      btBroadphasePair* m_psPairs;
+      const btDispatcherInfo* m_pcDispatchInfo;
+
+      /** Protects the memory pools of the manifolds and of the collision algorithms */
+      pthread_mutex_t m_tPoolMutex;
+
+   };
+
+   /****************************************/
+   /****************************************/
+
+}
+
+#endif
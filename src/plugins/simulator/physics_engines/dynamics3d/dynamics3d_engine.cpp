@@ -23,6 +23,7 @@ namespace argos {
       m_pcRNG(nullptr),
       m_cRandomSeedRange(0,1000),
       m_fDefaultFriction(1.0f),
+      m_pcTaskScheduler(nullptr),
       m_cBroadphase(),
       m_cConfiguration(),
       m_cDispatcher(&m_cConfiguration),
@@ -56,6 +57,13 @@ namespace argos {
       }
       GetNodeAttributeOrDefault(t_tree, "debug_file", m_strDebugFilename, m_strDebugFilename);
       GetNodeAttributeOrDefault(t_tree, "default_friction", m_fDefaultFriction, m_fDefaultFriction);
+      /* Start the threads for the narrow phase */
+      UInt32 unThreads = 0;
+      GetNodeAttributeOrDefault(t_tree, "threads", unThreads, unThreads);
+      if(unThreads > 1) {
+         m_pcTaskScheduler = new CDynamics3DTaskScheduler(unThreads);
+         m_cDispatcher.SetTaskScheduler(m_pcTaskScheduler);
+      }
    }
 
    /****************************************/
@@ -78,23 +86,23 @@ namespace argos {
          for(auto itPlugin = std::begin(m_tPhysicsPlugins);
              itPlugin != std::end(m_tPhysicsPlugins);
              ++itPlugin) {
-            itPlugin->second->UnregisterModel(*itModel->second);
+            itPlugin->second->UnregisterModel(**itModel);
          }
          /* Remove model from world */
-         itModel->second->RemoveFromWorld(m_cWorld);
+         (*itModel)->RemoveFromWorld(m_cWorld);
          /* Reset the model */
-         itModel->second->Reset();
+         (*itModel)->Reset();
       }
       /* Run the destructors on bullet's components */
       m_cWorld.~btMultiBodyDynamicsWorld();
       m_cSolver.~btMultiBodyConstraintSolver();
-      m_cDispatcher.~btCollisionDispatcher();
+      m_cDispatcher.~CDynamics3DCollisionDispatcher();
       m_cConfiguration.~btDefaultCollisionConfiguration();
       m_cBroadphase.~btDbvtBroadphase();
       /* Rerun the constructors for the bullet's components */
       new (&m_cBroadphase) btDbvtBroadphase;
       new (&m_cConfiguration) btDefaultCollisionConfiguration;
-      new (&m_cDispatcher) btCollisionDispatcher(&m_cConfiguration);
+      new (&m_cDispatcher) CDynamics3DCollisionDispatcher(&m_cConfiguration, m_pcTaskScheduler);
       new (&m_cSolver) btMultiBodyConstraintSolver;
       new (&m_cWorld) btMultiBodyDynamicsWorld(&m_cDispatcher,
                                                &m_cBroadphase,
@@ -125,10 +133,10 @@ namespace argos {
          for(auto itPlugin = std::begin(m_tPhysicsPlugins);
              itPlugin != std::end(m_tPhysicsPlugins);
              ++itPlugin) {
-            itPlugin->second->RegisterModel(*itModel->second);
+            itPlugin->second->RegisterModel(**itModel);
          }
          /* Add model to world */
-         itModel->second->AddToWorld(m_cWorld);
+         (*itModel)->AddToWorld(m_cWorld);
       }
       /* Initialize any multi-body constraints */
       for (SInt32 i = 0; i < m_cWorld.getNumMultiBodyConstraints(); i++) {
@@ -148,11 +156,11 @@ namespace argos {
          for(auto itPlugin = std::begin(m_tPhysicsPlugins);
              itPlugin != std::end(m_tPhysicsPlugins);
              ++itPlugin) {
-            itPlugin->second->UnregisterModel(*itModel->second);
+            itPlugin->second->UnregisterModel(**itModel);
          }
          /* Destroy the model */
-         itModel->second->RemoveFromWorld(m_cWorld);
-         delete itModel->second;
+         (*itModel)->RemoveFromWorld(m_cWorld);
+         delete *itModel;
       }
       /* Destroy all plug-ins */
       for(auto itPlugin = std::begin(m_tPhysicsPlugins);
@@ -161,9 +169,15 @@ namespace argos {
          itPlugin->second->Destroy();
          delete itPlugin->second;
       }
-      /* Empty the maps */
+      /* Empty the models and plugins */
       m_tPhysicsPlugins.clear();
-      m_tPhysicsModels.clear();
+      m_tPhysicsModels.Clear();
+      /* Stop the threads */
+      if(m_pcTaskScheduler != nullptr) {
+         m_cDispatcher.SetTaskScheduler(nullptr);
+         delete m_pcTaskScheduler;
+         m_pcTaskScheduler = nullptr;
+      }
    }
 
    /****************************************/
@@ -173,7 +187,7 @@ namespace argos {
       /* Update the physics state from the entities */
       for(auto it = m_tPhysicsModels.begin();
           it != std::end(m_tPhysicsModels); ++it) {
-         it->second->UpdateFromEntityStatus();
+         (*it)->UpdateFromEntityStatus();
       }
       /* Step the simuation forwards */
       m_cWorld.stepSimulation(GetSimulationClockTick(),
@@ -183,7 +197,7 @@ namespace argos {
       for(auto it = std::begin(m_tPhysicsModels);
           it != std::end(m_tPhysicsModels);
           ++it) {
-         it->second->UpdateEntityStatus();
+         (*it)->UpdateEntityStatus();
       }
       /* Dump the state of the world to a bullet file (if requested) */
       if(!m_strDebugFilename.empty()) {
@@ -228,6 +242,110 @@ namespace argos {
    /****************************************/
    /****************************************/
 
+   void CDynamics3DEngine::CheckClosestIntersectionWithRay(SEmbodiedEntityIntersectionItem& s_item,
+                                                           const CRay3& c_ray,
+                                                           const CEmbodiedEntity* pc_excluded) const {
+      /* The ray test keeps the closest hit only, so no intersection data is built */
+      btVector3 cRayStart(c_ray.GetStart().GetX(), c_ray.GetStart().GetZ(), -c_ray.GetStart().GetY());
+      btVector3 cRayEnd(c_ray.GetEnd().GetX(), c_ray.GetEnd().GetZ(), -c_ray.GetEnd().GetY());
+      btCollisionWorld::ClosestRayResultCallback cResult(cRayStart, cRayEnd);
+      m_cWorld.rayTest(cRayStart, cRayEnd, cResult);
+      if (cResult.hasHit() && cResult.m_collisionObject->getUserPointer() != nullptr) {
+         Real f_t = (cResult.m_hitPointWorld - cRayStart).length() / c_ray.GetLength();
+         auto* pcModel =
+            static_cast<CDynamics3DModel*>(cResult.m_collisionObject->getUserPointer());
+         if(&(pcModel->GetEmbodiedEntity()) != pc_excluded && s_item.TOnRay > f_t) {
+            s_item = SEmbodiedEntityIntersectionItem(&(pcModel->GetEmbodiedEntity()), f_t);
+         }
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   struct SDynamics3DBroadphaseQuery : public btBroadphaseAabbCallback {
+      std::vector<btBroadphaseProxy*> Proxies;
+
+      virtual bool process(const btBroadphaseProxy* pc_proxy) {
+         Proxies.push_back(const_cast<btBroadphaseProxy*>(pc_proxy));
+         return true;
+      }
+   };
+
+   void CDynamics3DEngine::CheckIntersectionWithRays(TEmbodiedEntityIntersectionData& t_items,
+                                                     const std::vector<CRay3>& vec_rays,
+                                                     const CEmbodiedEntity* pc_excluded) const {
+      if(vec_rays.empty()) return;
+      /* Convert the rays to the bullet coordinate system and calculate their bounding box */
+      static thread_local std::vector<btVector3> vecRayPoints;
+      vecRayPoints.clear();
+      vecRayPoints.reserve(2 * vec_rays.size());
+      btVector3 cMin(BT_LARGE_FLOAT, BT_LARGE_FLOAT, BT_LARGE_FLOAT);
+      btVector3 cMax(-BT_LARGE_FLOAT, -BT_LARGE_FLOAT, -BT_LARGE_FLOAT);
+      for(size_t i = 0; i < vec_rays.size(); ++i) {
+         const CRay3& cRay = vec_rays[i];
+         vecRayPoints.emplace_back(cRay.GetStart().GetX(), cRay.GetStart().GetZ(), -cRay.GetStart().GetY());
+         vecRayPoints.emplace_back(cRay.GetEnd().GetX(), cRay.GetEnd().GetZ(), -cRay.GetEnd().GetY());
+         cMin.setMin(vecRayPoints[2*i]);
+         cMin.setMin(vecRayPoints[2*i+1]);
+         cMax.setMax(vecRayPoints[2*i]);
+         cMax.setMax(vecRayPoints[2*i+1]);
+      }
+      /* Collect the collision objects in the bounding box with a single broadphase query.
+         The query only reads the broadphase trees, so it is safe to run it in parallel */
+      static thread_local SDynamics3DBroadphaseQuery sQuery;
+      sQuery.Proxies.clear();
+      const_cast<btDbvtBroadphase&>(m_cBroadphase).aabbTest(cMin, cMax, sQuery);
+      /* Run the ray tests on the collected objects, as btCollisionWorld::rayTest() would */
+      for(size_t i = 0; i < vec_rays.size(); ++i) {
+         const btVector3& cRayStart = vecRayPoints[2*i];
+         const btVector3& cRayEnd = vecRayPoints[2*i+1];
+         btTransform cRayStartTransform(btQuaternion::getIdentity(), cRayStart);
+         btTransform cRayEndTransform(btQuaternion::getIdentity(), cRayEnd);
+         /* Ray data for the culling with the broadphase volumes, as in btSingleRayCallback */
+         btVector3 cRayDirection = (cRayEnd - cRayStart).normalized();
+         btVector3 cRayDirectionInverse;
+         unsigned int punSigns[3];
+         for(int j = 0; j < 3; ++j) {
+            cRayDirectionInverse[j] =
+               (cRayDirection[j] == btScalar(0)) ? btScalar(BT_LARGE_FLOAT) : btScalar(1) / cRayDirection[j];
+            punSigns[j] = cRayDirectionInverse[j] < btScalar(0);
+         }
+         btScalar fLambdaMax = cRayDirection.dot(cRayEnd - cRayStart);
+         btCollisionWorld::ClosestRayResultCallback cResult(cRayStart, cRayEnd);
+         for(size_t j = 0; j < sQuery.Proxies.size(); ++j) {
+            btBroadphaseProxy* pcProxy = sQuery.Proxies[j];
+            if(cResult.m_closestHitFraction == btScalar(0)) break;
+            /* Skip the objects whose volume in the broadphase is not crossed by the ray */
+            const btDbvtVolume& cVolume = static_cast<btDbvtProxy*>(pcProxy)->leaf->volume;
+            btVector3 pcBounds[2] = { cVolume.Mins(), cVolume.Maxs() };
+            btScalar fTMin = 1, fLambdaMin = 0;
+            if(!btRayAabb2(cRayStart, cRayDirectionInverse, punSigns, pcBounds, fTMin, fLambdaMin, fLambdaMax) ||
+               !cResult.needsCollision(pcProxy)) continue;
+            btCollisionObject* pcObject =
+               static_cast<btCollisionObject*>(pcProxy->m_clientObject);
+            btCollisionWorld::rayTestSingle(cRayStartTransform,
+                                            cRayEndTransform,
+                                            pcObject,
+                                            pcObject->getCollisionShape(),
+                                            pcObject->getWorldTransform(),
+                                            cResult);
+         }
+         /* Examine the results */
+         if (cResult.hasHit() && cResult.m_collisionObject->getUserPointer() != nullptr) {
+            Real f_t = (cResult.m_hitPointWorld - cRayStart).length() / vec_rays[i].GetLength();
+            auto* pcModel =
+               static_cast<CDynamics3DModel*>(cResult.m_collisionObject->getUserPointer());
+            if(&(pcModel->GetEmbodiedEntity()) != pc_excluded && t_items[i].TOnRay > f_t) {
+               t_items[i] = SEmbodiedEntityIntersectionItem(&(pcModel->GetEmbodiedEntity()), f_t);
+            }
+         }
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
    size_t CDynamics3DEngine::GetNumPhysicsModels() {
       return m_tPhysicsModels.size();
    }
@@ -265,28 +383,27 @@ namespace argos {
           ++itPlugin) {
          itPlugin->second->RegisterModel(c_model);
       }
-      /* Add a pointer to the model to the map of models */
-      m_tPhysicsModels[str_id] = &c_model;
+      /* Add a pointer to the model to the models */
+      m_tPhysicsModels.Insert(str_id, &c_model);
    }
 
    /****************************************/
    /****************************************/
 
    void CDynamics3DEngine::RemovePhysicsModel(const std::string& str_id) {
-      auto itModel = m_tPhysicsModels.find(str_id);
-      if(itModel != std::end(m_tPhysicsModels)) {
+      /* Remove the model from the models */
+      CDynamics3DModel* pcModel = m_tPhysicsModels.Remove(str_id);
+      if(pcModel != nullptr) {
          /* Notify the plugins of model removal */
          for(auto itPlugin = std::begin(m_tPhysicsPlugins);
              itPlugin != std::end(m_tPhysicsPlugins);
              ++itPlugin) {
-            itPlugin->second->UnregisterModel(*(itModel->second));
+            itPlugin->second->UnregisterModel(*pcModel);
          }
          /* Remove the model from world */
-         itModel->second->RemoveFromWorld(m_cWorld);
+         pcModel->RemoveFromWorld(m_cWorld);
          /* Destroy the model */
-         delete itModel->second;
-         /* Remove the model from the map */
-         m_tPhysicsModels.erase(itModel);
+         delete pcModel;
       }
       else {
          THROW_ARGOSEXCEPTION("The model \"" << str_id <<
@@ -360,6 +477,24 @@ namespace argos {
                            "    ...\n"
                            "  </physics_engines>\n\n"
 
+                           "The collision detection between the pairs of bodies that are close to each\n"
+                           "other (the narrow phase) can be spread among several threads using the threads\n"
+                           "attribute. Only the narrow phase runs in parallel: the broad phase, the\n"
+                           "constraint solver, the integration and the plugins, such as magnetism, remain\n"
+                           "serial, so the speedup is bounded by the share of the step spent in the narrow\n"
+                           "phase. The threads are owned by the physics engine and are separate from the\n"
+                           "threads set in the <system> section of the configuration file. By default, or\n"
+                           "when the attribute is set to 0 or 1, the collision detection runs in the\n"
+                           "thread that updates the engine. The results do not depend on the number of\n"
+                           "threads.\n\n"
+
+                           "  <physics_engines>\n"
+                           "    ...\n"
+                           "    <dynamics3d id=\"dyn3d\"\n"
+                           "                threads=\"4\"/>\n"
+                           "    ...\n"
+                           "  </physics_engines>\n\n"
+
                            "The physics engine supports a number of plugins that add features to the\n"
                            "simulation. In the example below, a floor plane has been added which has a\n"
                            "height of 1 cm and the dimensions of the floor as specified by the arena\n"
@@ -371,8 +506,12 @@ namespace argos {
                            "Finally, there is a magnetism plugin. This plugin applies forces and\n"
                            "torques to bodies in the simulation that contains magnetic dipoles. The\n"
                            "'max_distance' attribute is an optional optimization that sets the maximum\n"
-                           "distance at which two magnetic dipoles will interact with each other. In\n"
-                           "the example below, this distance has been set to 4 cm.\n\n"
+                           "distance at which two magnetic dipoles will interact with each other. When\n"
+                           "it is set, the dipoles are sorted into cells of this size at each step, and\n"
+                           "only the dipoles in neighbouring cells are checked against each other. This\n"
+                           "keeps experiments with thousands of magnets tractable. Without this attribute,\n"
+                           "or when it is not positive, every pair of dipoles interacts. In the example\n"
+                           "below, this distance has been set to 4 cm.\n\n"
 
                            "  <physics_engines>\n"
                            "    ...\n"
@@ -26,6 +26,9 @@ namespace argos {
 #pragma GCC diagnostic ignored "-Wreorder"
 #endif
 
+#include <argos3/plugins/simulator/physics_engines/physics_model_vector.h>
+#include <argos3/plugins/simulator/physics_engines/dynamics3d/dynamics3d_collision_dispatcher.h>
+#include <argos3/plugins/simulator/physics_engines/dynamics3d/dynamics3d_task_scheduler.h>
 #include <argos3/plugins/simulator/physics_engines/dynamics3d/bullet/btBulletDynamicsCommon.h>
 #include <argos3/plugins/simulator/physics_engines/dynamics3d/bullet/BulletCollision/NarrowPhaseCollision/btRaycastCallback.h>
 #include <argos3/plugins/simulator/physics_engines/dynamics3d/bullet/BulletDynamics/Featherstone/btMultiBodyConstraintSolver.h>
@@ -69,6 +72,14 @@ namespace argos {
       virtual void CheckIntersectionWithRay(TEmbodiedEntityIntersectionData& t_data,
                                             const CRay3& c_ray) const;
 
+      virtual void CheckClosestIntersectionWithRay(SEmbodiedEntityIntersectionItem& s_item,
+                                                   const CRay3& c_ray,
+                                                   const CEmbodiedEntity* pc_excluded) const;
+
+      virtual void CheckIntersectionWithRays(TEmbodiedEntityIntersectionData& t_items,
+                                             const std::vector<CRay3>& vec_rays,
+                                             const CEmbodiedEntity* pc_excluded) const;
+
       inline btMultiBodyDynamicsWorld& GetWorld() {
          return m_cWorld;
       }
@@ -100,8 +111,8 @@ namespace argos {
       void RemovePhysicsPlugin(const std::string& str_id);
 
    private:
-      /* Maps of models and plugins */
-      std::map<std::string, CDynamics3DModel*> m_tPhysicsModels;
+      /* Models and plugins */
+      CPhysicsModelVector<CDynamics3DModel> m_tPhysicsModels;
       std::map<std::string, CDynamics3DPlugin*> m_tPhysicsPlugins;
       /* Random number generation */
       CRandom::CRNG* m_pcRNG;
@@ -110,10 +121,12 @@ namespace argos {
       std::string m_strDebugFilename;
       /* Default friction */
       btScalar m_fDefaultFriction;
+      /* Threads that run the narrow phase, nullptr when single-threaded */
+      CDynamics3DTaskScheduler* m_pcTaskScheduler;
       /* Bullet Physics World Data */
       btDbvtBroadphase                m_cBroadphase;
       btDefaultCollisionConfiguration m_cConfiguration;
-      btCollisionDispatcher           m_cDispatcher;
+      CDynamics3DCollisionDispatcher  m_cDispatcher;
       btMultiBodyConstraintSolver     m_cSolver;
       btMultiBodyDynamicsWorld        m_cWorld;
    };
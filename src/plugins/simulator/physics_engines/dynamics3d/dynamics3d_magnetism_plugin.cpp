@@ -20,6 +20,10 @@ namespace argos {
    void CDynamics3DMagnetismPlugin::Init(TConfigurationNode& t_tree) {
       GetNodeAttributeOrDefault(t_tree, "force_constant", m_fForceConstant, m_fForceConstant);
       GetNodeAttributeOrDefault(t_tree, "max_distance", m_fMaxDistance, m_fMaxDistance);
+      /* without a positive maximum distance, all the dipoles interact with each other */
+      if(m_fMaxDistance <= 0) {
+         m_fMaxDistance = std::numeric_limits<btScalar>::infinity();
+      }
    }
 
    /****************************************/
@@ -57,68 +61,93 @@ namespace argos {
          /* Nothing to do */
          return;
       }
-      for(auto itDipole0 = std::begin(m_vecDipoles);
-          itDipole0 != (std::end(m_vecDipoles) - 1);
-          ++itDipole0) {
-         for(auto itDipole1 = std::next(itDipole0, 1);
-             itDipole1 != std::end(m_vecDipoles);
-             ++itDipole1) {
-            const btTransform& cTransformDipole0 = itDipole0->Offset * itDipole0->Body->GetTransform();
-            const btTransform& cTransformDipole1 = itDipole1->Offset * itDipole1->Body->GetTransform();
-            const btVector3& cPositionDipole0 = cTransformDipole0.getOrigin();
-            const btVector3& cPositionDipole1 = cTransformDipole1.getOrigin();
-            /* calculate the distance between the two magnetic bodies */
-            btScalar fDistance = cPositionDipole0.distance(cPositionDipole1);
-            /* optimization - don't calculate magnetism for dipoles more than m_fMaxDistance apart */
-            if(fDistance > m_fMaxDistance) {
-               continue;
+      /* calculate the position and the rotated field of each dipole once */
+      for(SMagneticDipole& s_dipole : m_vecDipoles) {
+         const btTransform& cTransformBody = s_dipole.Body->GetTransform();
+         s_dipole.Position = (s_dipole.Offset * cTransformBody).getOrigin();
+         s_dipole.Moment = cTransformBody.getBasis() * s_dipole.GetField();
+      }
+      if(m_fMaxDistance == std::numeric_limits<btScalar>::infinity()) {
+         /* all the dipoles interact with each other */
+         for(UInt32 i = 0; i < m_vecDipoles.size() - 1; ++i) {
+            for(UInt32 j = i + 1; j < m_vecDipoles.size(); ++j) {
+               Interact(i, j);
             }
-            /* perform Barnes-hut algorithm */
-            /* calculate the normalized seperation between the two dipoles, pointing from Dipole1 to Dipole0*/
-            const btVector3& cNormalizedSeparation =
-               btVector3(cPositionDipole0 - cPositionDipole1) / fDistance;
-            /* calculate the rotated field of dipole 0 */
-            const btVector3& cRotatedFieldDipole0 =
-               itDipole0->Body->GetTransform().getBasis() * itDipole0->GetField();
-            /* calculate the rotated field of dipole 1 */
-            const btVector3& cRotatedFieldDipole1 =
-               itDipole1->Body->GetTransform().getBasis() * itDipole1->GetField();
-            /* We now have cRotatedFieldDipole0 and cRotatedFieldDipole1 as the magnetic moments
-               (i.e., m0, m1), cNormalizedSeparation as the direction unit vector from Dipole 1
-               to Dipole 0 (i.e., n), fDistance is the scalar distance between the dipoles (i.e.,
-               d), and B0 is the magnetic flux density at Dipole 0.
-                  B0 = u0/4pi * [3n(n.m1) - m1] / d^3
-                  T0 = m0 * B0
-                     = u0.4pi/d^3 * [3 (m1.n)(m0 * n) - m0 * m1]
-
-                  F0 = grad(m0.B0)
-                     = u0.4pi/d^4 * [-15n(m0.n)(m1.n) + 3n(m0.m1) + 3(m0(m1.n)+m1(m0.n))]
-            */
-            /* calculate the intermediate cross and dot products */
-            const btVector3& cCrossProduct01 = cRotatedFieldDipole0.cross(cRotatedFieldDipole1);
-            const btVector3& cCrossProduct0 = cRotatedFieldDipole0.cross(cNormalizedSeparation);
-            const btVector3& cCrossProduct1 = cRotatedFieldDipole1.cross(cNormalizedSeparation);
-            btScalar fDotProduct01 = cRotatedFieldDipole0.dot(cRotatedFieldDipole1);
-            btScalar fDotProduct0 = cRotatedFieldDipole0.dot(cNormalizedSeparation);
-            btScalar fDotProduct1 = cRotatedFieldDipole1.dot(cNormalizedSeparation);
-            /* calculate the magnetic force and torque */
-            const btVector3& cTorque0 =
-               ((3 * fDotProduct1 * cCrossProduct0) - cCrossProduct01) *
-               m_fForceConstant / btPow(fDistance, 3);
-            const btVector3& cTorque1 =
-               ((3 * fDotProduct0 * cCrossProduct1) + cCrossProduct01) *
-               m_fForceConstant / btPow(fDistance, 3);
-            const btVector3& cForce = (m_fForceConstant / btPow(fDistance, 4)) *
-               ((-15 * cNormalizedSeparation * fDotProduct1 * fDotProduct0) +
-                (3 * cNormalizedSeparation * fDotProduct01) +
-                (3 * (fDotProduct1 * cRotatedFieldDipole0 + fDotProduct0 * cRotatedFieldDipole1)));
-            /* apply torques and forces to the bodies */
-            itDipole0->Body->ApplyForce(cForce, (itDipole0->Offset).getOrigin());
-            itDipole0->Body->ApplyTorque(cTorque0);
-            itDipole1->Body->ApplyForce(-cForce, (itDipole1->Offset).getOrigin());
-            itDipole1->Body->ApplyTorque(cTorque1);
          }
       }
+      else {
+         /* only the dipoles in neighbouring cells can be closer than m_fMaxDistance. The
+            pairs are visited in the same order as above, so that the forces are summed in
+            the same order */
+         m_vecPositions.resize(m_vecDipoles.size());
+         for(UInt32 i = 0; i < m_vecDipoles.size(); ++i) {
+            m_vecPositions[i] = m_vecDipoles[i].Position;
+         }
+         m_cCells.Build(m_vecPositions, m_fMaxDistance);
+         for(UInt32 i = 0; i < m_vecDipoles.size() - 1; ++i) {
+            m_cCells.GetNeighbours(i, m_vecNeighbours);
+            for(UInt32 unDipole : m_vecNeighbours) {
+               Interact(i, unDipole);
+            }
+         }
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CDynamics3DMagnetismPlugin::Interact(UInt32 un_dipole0,
+                                             UInt32 un_dipole1) {
+      SMagneticDipole& sDipole0 = m_vecDipoles[un_dipole0];
+      SMagneticDipole& sDipole1 = m_vecDipoles[un_dipole1];
+      const btVector3& cPositionDipole0 = sDipole0.Position;
+      const btVector3& cPositionDipole1 = sDipole1.Position;
+      /* calculate the distance between the two magnetic bodies */
+      btScalar fDistance = cPositionDipole0.distance(cPositionDipole1);
+      /* optimization - don't calculate magnetism for dipoles more than m_fMaxDistance apart */
+      if(fDistance > m_fMaxDistance) {
+         return;
+      }
+      /* calculate the normalized seperation between the two dipoles, pointing from Dipole1 to Dipole0*/
+      const btVector3& cNormalizedSeparation =
+         btVector3(cPositionDipole0 - cPositionDipole1) / fDistance;
+      /* the rotated fields of the dipoles */
+      const btVector3& cRotatedFieldDipole0 = sDipole0.Moment;
+      const btVector3& cRotatedFieldDipole1 = sDipole1.Moment;
+      /* We now have cRotatedFieldDipole0 and cRotatedFieldDipole1 as the magnetic moments
+         (i.e., m0, m1), cNormalizedSeparation as the direction unit vector from Dipole 1
+         to Dipole 0 (i.e., n), fDistance is the scalar distance between the dipoles (i.e.,
+         d), and B0 is the magnetic flux density at Dipole 0.
+            B0 = u0/4pi * [3n(n.m1) - m1] / d^3
+            T0 = m0 * B0
+               = u0.4pi/d^3 * [3 (m1.n)(m0 * n) - m0 * m1]
+
+            F0 = grad(m0.B0)
+               = u0.4pi/d^4 * [-15n(m0.n)(m1.n) + 3n(m0.m1) + 3(m0(m1.n)+m1(m0.n))]
+      */
+      /* calculate the intermediate cross and dot products */
+      const btVector3& cCrossProduct01 = cRotatedFieldDipole0.cross(cRotatedFieldDipole1);
+      const btVector3& cCrossProduct0 = cRotatedFieldDipole0.cross(cNormalizedSeparation);
+      const btVector3& cCrossProduct1 = cRotatedFieldDipole1.cross(cNormalizedSeparation);
+      btScalar fDotProduct01 = cRotatedFieldDipole0.dot(cRotatedFieldDipole1);
+      btScalar fDotProduct0 = cRotatedFieldDipole0.dot(cNormalizedSeparation);
+      btScalar fDotProduct1 = cRotatedFieldDipole1.dot(cNormalizedSeparation);
+      /* calculate the magnetic force and torque */
+      const btVector3& cTorque0 =
+         ((3 * fDotProduct1 * cCrossProduct0) - cCrossProduct01) *
+         m_fForceConstant / btPow(fDistance, 3);
+      const btVector3& cTorque1 =
+         ((3 * fDotProduct0 * cCrossProduct1) + cCrossProduct01) *
+         m_fForceConstant / btPow(fDistance, 3);
+      const btVector3& cForce = (m_fForceConstant / btPow(fDistance, 4)) *
+         ((-15 * cNormalizedSeparation * fDotProduct1 * fDotProduct0) +
+          (3 * cNormalizedSeparation * fDotProduct01) +
+          (3 * (fDotProduct1 * cRotatedFieldDipole0 + fDotProduct0 * cRotatedFieldDipole1)));
+      /* apply torques and forces to the bodies */
+      sDipole0.Body->ApplyForce(cForce, (sDipole0.Offset).getOrigin());
+      sDipole0.Body->ApplyTorque(cTorque0);
+      sDipole1.Body->ApplyForce(-cForce, (sDipole1.Offset).getOrigin());
+      sDipole1.Body->ApplyTorque(cTorque1);
    }
 
    /****************************************/
@@ -11,6 +11,7 @@
 
 #include <argos3/plugins/simulator/physics_engines/dynamics3d/dynamics3d_plugin.h>
 #include <argos3/plugins/simulator/physics_engines/dynamics3d/dynamics3d_model.h>
+#include <argos3/plugins/simulator/physics_engines/dynamics3d/dynamics3d_cell_list.h>
 #include <argos3/plugins/simulator/entities/magnet_equipped_entity.h>
 #include <argos3/core/utility/datatypes/datatypes.h>
 #include <functional>
@@ -42,6 +43,16 @@ namespace argos {
       
       virtual void Update();
 
+   private:
+
+      /**
+       * Applies the forces and torques between two dipoles.
+       * @param un_dipole0 The index of the first dipole.
+       * @param un_dipole1 The index of the second dipole.
+       */
+      void Interact(UInt32 un_dipole0,
+                    UInt32 un_dipole1);
+
    private:
       
       btScalar m_fForceConstant;
@@ -59,9 +70,19 @@ namespace argos {
          std::shared_ptr<CDynamics3DModel::CAbstractBody> Body;
          std::function<btVector3()> GetField;
          btTransform Offset;
+         /* The position and the rotated field of the dipole, updated once per step */
+         btVector3 Position;
+         btVector3 Moment;
       };    
 
       std::vector<SMagneticDipole> m_vecDipoles;
+
+      /** The positions of the dipoles, sorted into cells as large as the maximum distance */
+      std::vector<btVector3> m_vecPositions;
+      CDynamics3DCellList m_cCells;
+
+      /** The dipoles close to the current one, reused across steps */
+      std::vector<UInt32> m_vecNeighbours;
    };
    
    /****************************************/
@@ -0,0 +1,231 @@
+/**
+ * @file <argos3/plugins/simulator/physics_engines/dynamics3d/dynamics3d_task_scheduler.cpp>
+ */
+
+#include "dynamics3d_task_scheduler.h"
+
+#include <argos3/core/utility/configuration/argos_exception.h>
+#include <argos3/core/utility/logging/argos_log.h>
+#include <cstring>
+
+namespace argos {
+
+   /****************************************/
+   /****************************************/
+
+   static thread_local UInt32 THREAD_SLOT = 0;
+
+   static void* LaunchDynamics3DWorkerThread(void* p_data) {
+      LOG.AddThreadSafeBuffer();
+      LOGERR.AddThreadSafeBuffer();
+      auto* psData = reinterpret_cast<CDynamics3DTaskScheduler::SWorkerThreadData*>(p_data);
+      THREAD_SLOT = psData->Slot;
+      psData->Scheduler->WorkerThread(psData->Slot);
+      return nullptr;
+   }
+
+   /****************************************/
+   /****************************************/
+
+   CDynamics3DTaskScheduler::CDynamics3DTaskScheduler(UInt32 un_num_threads) :
+      btITaskScheduler("ARGoS"),
+      m_pcForBody(nullptr),
+      m_pcSumBody(nullptr),
+      m_nBegin(0),
+      m_nEnd(0),
+      m_nGrainSize(1),
+      m_nNumChunks(0),
+      m_nNextChunk(0),
+      m_bRunning(false),
+      m_unJobRound(0),
+      m_unWorkersDone(0),
+      m_bStopThreads(false) {
+      pthread_mutex_init(&m_tJobMutex, nullptr);
+      pthread_cond_init(&m_tJobStartCond, nullptr);
+      pthread_cond_init(&m_tJobDoneCond, nullptr);
+      /* The calling thread is the first one */
+      int nErrors;
+      for(UInt32 i = 1; i < un_num_threads; ++i) {
+         m_vecThreadData.push_back(new SWorkerThreadData(i, this));
+         m_vecThreads.push_back(pthread_t());
+         if((nErrors = pthread_create(&m_vecThreads.back(),
+                                      nullptr,
+                                      LaunchDynamics3DWorkerThread,
+                                      reinterpret_cast<void*>(m_vecThreadData.back())))) {
+            m_vecThreads.pop_back();
+            StopThreads();
+            pthread_cond_destroy(&m_tJobDoneCond);
+            pthread_cond_destroy(&m_tJobStartCond);
+            pthread_mutex_destroy(&m_tJobMutex);
+            THROW_ARGOSEXCEPTION("Error creating thread: " << ::strerror(nErrors));
+         }
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   CDynamics3DTaskScheduler::~CDynamics3DTaskScheduler() {
+      StopThreads();
+      pthread_cond_destroy(&m_tJobDoneCond);
+      pthread_cond_destroy(&m_tJobStartCond);
+      pthread_mutex_destroy(&m_tJobMutex);
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CDynamics3DTaskScheduler::parallelFor(int n_begin,
+                                              int n_end,
+                                              int n_grain_size,
+                                              const btIParallelForBody& c_body) {
+      if(!BeginJob(n_begin, n_end, n_grain_size)) {
+         c_body.forLoop(n_begin, n_end);
+         return;
+      }
+      m_pcForBody = &c_body;
+      m_pcSumBody = nullptr;
+      RunJob();
+      m_bRunning = false;
+   }
+
+   /****************************************/
+   /****************************************/
+
+   btScalar CDynamics3DTaskScheduler::parallelSum(int n_begin,
+                                                  int n_end,
+                                                  int n_grain_size,
+                                                  const btIParallelSumBody& c_body) {
+      if(!BeginJob(n_begin, n_end, n_grain_size)) {
+         return c_body.sumLoop(n_begin, n_end);
+      }
+      m_pcForBody = nullptr;
+      m_pcSumBody = &c_body;
+      m_vecChunkSums.assign(m_nNumChunks, 0);
+      RunJob();
+      btScalar fSum = 0;
+      for(size_t i = 0; i < m_vecChunkSums.size(); ++i) {
+         fSum += m_vecChunkSums[i];
+      }
+      m_bRunning = false;
+      return fSum;
+   }
+
+   /****************************************/
+   /****************************************/
+
+   UInt32 CDynamics3DTaskScheduler::GetThreadSlot() {
+      return THREAD_SLOT;
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CDynamics3DTaskScheduler::WorkerThread(UInt32 un_slot) {
+      UInt32 unRound = 0;
+      while(true) {
+         /* Wait for the next job */
+         pthread_mutex_lock(&m_tJobMutex);
+         while(!m_bStopThreads && m_unJobRound == unRound) {
+            pthread_cond_wait(&m_tJobStartCond, &m_tJobMutex);
+         }
+         if(m_bStopThreads) {
+            pthread_mutex_unlock(&m_tJobMutex);
+            return;
+         }
+         unRound = m_unJobRound;
+         pthread_mutex_unlock(&m_tJobMutex);
+         /* Take part in the job */
+         RunChunks();
+         /* Tell the caller this thread is done */
+         pthread_mutex_lock(&m_tJobMutex);
+         ++m_unWorkersDone;
+         if(m_unWorkersDone == m_vecThreads.size()) {
+            pthread_cond_signal(&m_tJobDoneCond);
+         }
+         pthread_mutex_unlock(&m_tJobMutex);
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   bool CDynamics3DTaskScheduler::BeginJob(int n_begin,
+                                           int n_end,
+                                           int n_grain_size) {
+      if(n_grain_size < 1) n_grain_size = 1;
+      int nNumChunks = (n_end - n_begin + n_grain_size - 1) / n_grain_size;
+      /* Small jobs, and jobs issued while another job is running, are run by the calling thread */
+      if(nNumChunks <= 1 ||
+         m_vecThreads.empty() ||
+         THREAD_SLOT != 0 ||
+         m_bRunning.exchange(true)) {
+         return false;
+      }
+      m_nBegin = n_begin;
+      m_nEnd = n_end;
+      m_nGrainSize = n_grain_size;
+      m_nNumChunks = nNumChunks;
+      m_nNextChunk = 0;
+      return true;
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CDynamics3DTaskScheduler::RunJob() {
+      /* Wake up the workers, and take part in the job meanwhile */
+      pthread_mutex_lock(&m_tJobMutex);
+      ++m_unJobRound;
+      m_unWorkersDone = 0;
+      pthread_cond_broadcast(&m_tJobStartCond);
+      pthread_mutex_unlock(&m_tJobMutex);
+      RunChunks();
+      /* Wait for the workers to be done */
+      pthread_mutex_lock(&m_tJobMutex);
+      while(m_unWorkersDone < m_vecThreads.size()) {
+         pthread_cond_wait(&m_tJobDoneCond, &m_tJobMutex);
+      }
+      pthread_mutex_unlock(&m_tJobMutex);
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CDynamics3DTaskScheduler::RunChunks() {
+      for(int nChunk = m_nNextChunk++;
+          nChunk < m_nNumChunks;
+          nChunk = m_nNextChunk++) {
+         int nBegin = m_nBegin + nChunk * m_nGrainSize;
+         int nEnd = (nBegin + m_nGrainSize < m_nEnd) ? nBegin + m_nGrainSize : m_nEnd;
+         if(m_pcForBody != nullptr) {
+            m_pcForBody->forLoop(nBegin, nEnd);
+         }
+         else {
+            m_vecChunkSums[nChunk] = m_pcSumBody->sumLoop(nBegin, nEnd);
+         }
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CDynamics3DTaskScheduler::StopThreads() {
+      pthread_mutex_lock(&m_tJobMutex);
+      m_bStopThreads = true;
+      pthread_cond_broadcast(&m_tJobStartCond);
+      pthread_mutex_unlock(&m_tJobMutex);
+      for(size_t i = 0; i < m_vecThreads.size(); ++i) {
+         pthread_join(m_vecThreads[i], nullptr);
+      }
+      m_vecThreads.clear();
+      while(!m_vecThreadData.empty()) {
+         delete m_vecThreadData.back();
+         m_vecThreadData.pop_back();
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+}
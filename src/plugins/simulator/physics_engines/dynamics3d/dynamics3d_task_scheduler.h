@@ -0,0 +1,147 @@
+/**
+ * @file <argos3/plugins/simulator/physics_engines/dynamics3d/dynamics3d_task_scheduler.h>
+ */
+
+#ifndef DYNAMICS3D_TASK_SCHEDULER_H
+#define DYNAMICS3D_TASK_SCHEDULER_H
+
+namespace argos {
+   class CDynamics3DTaskScheduler;
+}
+
+#include <argos3/core/utility/datatypes/datatypes.h>
+#include <argos3/plugins/simulator/physics_engines/dynamics3d/bullet/LinearMath/btThreads.h>
+#include <atomic>
+#include <pthread.h>
+#include <vector>
+
+namespace argos {
+
+   /****************************************/
+   /****************************************/
+
+   /**
+    * A Bullet task scheduler backed by a pool of pthreads.
+    * The thread that calls parallelFor() or parallelSum() takes part in the work, so a
+    * scheduler with N threads starts N-1 workers. Each thread has a slot: the calling
+    * thread has slot 0, and the workers have slots 1 to N-1. The work done in parallel
+    * can use the slot to index per-thread data.
+    * Unlike Bullet's own schedulers, this one does not rely on the thread indices that
+    * Bullet assigns, which are shared with the threads of ARGoS.
+    */
+   class CDynamics3DTaskScheduler : public btITaskScheduler {
+
+   public:
+
+      /**
+       * Class constructor.
+       * @param un_num_threads The number of threads, including the calling one.
+       */
+      CDynamics3DTaskScheduler(UInt32 un_num_threads);
+
+      virtual ~CDynamics3DTaskScheduler();
+
+      virtual int getMaxNumThreads() const {
+         return m_vecThreads.size() + 1;
+      }
+
+      virtual int getNumThreads() const {
+         return m_vecThreads.size() + 1;
+      }
+
+      /**
+       * The number of threads is set at construction.
+       */
+      virtual void setNumThreads(int n_num_threads) {}
+
+      virtual void parallelFor(int n_begin,
+                               int n_end,
+                               int n_grain_size,
+                               const btIParallelForBody& c_body);
+
+      /**
+       * Returns the sum of the partial sums of the chunks of the range.
+       * The partial sums are added in the order of the chunks, so the result does not
+       * depend on how the chunks are spread among the threads.
+       */
+      virtual btScalar parallelSum(int n_begin,
+                                   int n_end,
+                                   int n_grain_size,
+                                   const btIParallelSumBody& c_body);
+
+      /**
+       * Returns the slot of the calling thread.
+       * The threads that do not belong to a scheduler have slot 0.
+       * @return The slot of the calling thread.
+       */
+      static UInt32 GetThreadSlot();
+
+      /**
+       * The body of a worker thread.
+       * @param un_slot The slot of the thread.
+       */
+      void WorkerThread(UInt32 un_slot);
+
+   private:
+
+      /**
+       * Sets up a job on the given range.
+       * @return <tt>false</tt> if the job must be run by the calling thread alone.
+       */
+      bool BeginJob(int n_begin,
+                    int n_end,
+                    int n_grain_size);
+
+      void RunJob();
+
+      void RunChunks();
+
+      void StopThreads();
+
+   public:
+
+      struct SWorkerThreadData {
+         UInt32 Slot;
+         CDynamics3DTaskScheduler* Scheduler;
+
+         SWorkerThreadData(UInt32 un_slot,
+                           CDynamics3DTaskScheduler* pc_scheduler) :
+            Slot(un_slot),
+            Scheduler(pc_scheduler) {}
+      };
+
+   private:
+
+      /** The worker threads */
+      std::vector<pthread_t> m_vecThreads;
+      std::vector<SWorkerThreadData*> m_vecThreadData;
+
+      /** The current job */
+      const btIParallelForBody* m_pcForBody;
+      const btIParallelSumBody* m_pcSumBody;
+      int m_nBegin;
+      int m_nEnd;
+      int m_nGrainSize;
+      int m_nNumChunks;
+      std::atomic<int> m_nNextChunk;
+      std::vector<btScalar> m_vecChunkSums;
+
+      /** Whether a job is running, to run nested or concurrent jobs serially */
+      std::atomic<bool> m_bRunning;
+
+      /** Thread synchronization */
+      pthread_mutex_t m_tJobMutex;
+      pthread_cond_t m_tJobStartCond;
+      pthread_cond_t m_tJobDoneCond;
+      UInt32 m_unJobRound;
+      UInt32 m_unWorkersDone;
+      bool m_bStopThreads;
+
+   };
+
+   /****************************************/
+   /****************************************/
+
+}
+
+#endif
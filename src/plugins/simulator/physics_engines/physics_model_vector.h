@@ -0,0 +1,140 @@
+/**
+ * @file <argos3/plugins/simulator/physics_engines/physics_model_vector.h>
+ */
+
+#ifndef PHYSICS_MODEL_VECTOR_H
+#define PHYSICS_MODEL_VECTOR_H
+
+#include <argos3/core/config.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace argos {
+
+   /**
+    * The models of a physics engine, stored contiguously.
+    * The engines go through all their models several times per step, so the
+    * models are kept in a vector that can be scanned linearly. The ids are
+    * only needed when models are added or removed, and they are kept in a
+    * separate index from id to slot. Removal moves the last model into the
+    * slot of the removed one, so the order of the models is the order in
+    * which they were added, only up to the first removal.
+    */
+   template <class MODEL>
+   class CPhysicsModelVector {
+
+   public:
+
+      typedef typename std::vector<MODEL*>::iterator iterator;
+      typedef typename std::vector<MODEL*>::const_iterator const_iterator;
+
+   public:
+
+      inline iterator begin() {
+         return m_vecModels.begin();
+      }
+
+      inline iterator end() {
+         return m_vecModels.end();
+      }
+
+      inline const_iterator begin() const {
+         return m_vecModels.begin();
+      }
+
+      inline const_iterator end() const {
+         return m_vecModels.end();
+      }
+
+      inline size_t size() const {
+         return m_vecModels.size();
+      }
+
+      inline bool empty() const {
+         return m_vecModels.empty();
+      }
+
+      inline MODEL* operator[](size_t un_slot) const {
+         return m_vecModels[un_slot];
+      }
+
+      /**
+       * Adds a model.
+       * If a model with the same id is already present, it is replaced.
+       * @param str_id The id of the model.
+       * @param pc_model The model.
+       */
+      void Insert(const std::string& str_id,
+                  MODEL* pc_model) {
+         auto itSlot = m_mapSlots.find(str_id);
+         if(itSlot != m_mapSlots.end()) {
+            m_vecModels[itSlot->second] = pc_model;
+         }
+         else {
+            m_mapSlots.emplace(str_id, m_vecModels.size());
+            m_vecModels.push_back(pc_model);
+            m_vecIds.push_back(str_id);
+         }
+      }
+
+      /**
+       * Returns the model with the given id.
+       * @param str_id The id of the model.
+       * @return The model, or <tt>nullptr</tt> if not found.
+       */
+      MODEL* Find(const std::string& str_id) const {
+         auto itSlot = m_mapSlots.find(str_id);
+         return (itSlot != m_mapSlots.end()) ? m_vecModels[itSlot->second] : nullptr;
+      }
+
+      /**
+       * Removes the model with the given id.
+       * The model is not deleted.
+       * @param str_id The id of the model.
+       * @return The removed model, or <tt>nullptr</tt> if not found.
+       */
+      MODEL* Remove(const std::string& str_id) {
+         auto itSlot = m_mapSlots.find(str_id);
+         if(itSlot == m_mapSlots.end()) return nullptr;
+         size_t unSlot = itSlot->second;
+         MODEL* pcModel = m_vecModels[unSlot];
+         m_mapSlots.erase(itSlot);
+         /* Move the last model into the freed slot */
+         size_t unLast = m_vecModels.size() - 1;
+         if(unSlot != unLast) {
+            m_vecModels[unSlot] = m_vecModels[unLast];
+            m_vecIds[unSlot].swap(m_vecIds[unLast]);
+            m_mapSlots[m_vecIds[unSlot]] = unSlot;
+         }
+         m_vecModels.pop_back();
+         m_vecIds.pop_back();
+         return pcModel;
+      }
+
+      /**
+       * Removes all the models.
+       * The models are not deleted.
+       */
+      void Clear() {
+         m_vecModels.clear();
+         m_vecIds.clear();
+         m_mapSlots.clear();
+      }
+
+   private:
+
+      /** The models */
+      std::vector<MODEL*> m_vecModels;
+
+      /** The ids of the models, in the same order */
+      std::vector<std::string> m_vecIds;
+
+      /** The slot of each model, by id */
+      std::unordered_map<std::string, size_t> m_mapSlots;
+
+   };
+
+}
+
+#endif
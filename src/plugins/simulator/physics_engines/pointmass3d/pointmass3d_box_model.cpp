@@ -16,21 +16,47 @@ namespace argos {
    CPointMass3DBoxModel::CPointMass3DBoxModel(CPointMass3DEngine& c_engine,
                                               CBoxEntity& c_box) :
       CPointMass3DModel(c_engine, c_box.GetEmbodiedEntity()),
-      m_cBoxEntity(c_box) {}
+      m_cBoxEntity(c_box),
+      m_cOrientation(c_box.GetEmbodiedEntity().GetOriginAnchor().Orientation) {
+      /* The box does not move by itself, so its bounding box is calculated once */
+      CalculateBoundingBox();
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CPointMass3DBoxModel::MoveTo(const CVector3& c_position,
+                                     const CQuaternion& c_orientation) {
+      /* The entity is not updated at each step, so update it here */
+      m_cPosition = c_position;
+      m_cOrientation = c_orientation;
+      CPhysicsModel::UpdateEntityStatus();
+      /* The BVH is refitted at the end of Update() only */
+      GetPM3DEngine().MarkBVHOutdated();
+   }
 
    /****************************************/
    /****************************************/
 
    void CPointMass3DBoxModel::CalculateBoundingBox() {
+      /* Take the orientation into account, as the ray intersection test does */
+      const SAnchor& sOrigin = GetEmbodiedEntity().GetOriginAnchor();
       CVector3 cHalfSize = 0.5f * m_cBoxEntity.GetSize();
-      GetBoundingBox().MinCorner.Set(
-         GetEmbodiedEntity().GetOriginAnchor().Position.GetX() - cHalfSize.GetX(),
-         GetEmbodiedEntity().GetOriginAnchor().Position.GetY() - cHalfSize.GetY(),
-         GetEmbodiedEntity().GetOriginAnchor().Position.GetZ());
-      GetBoundingBox().MaxCorner.Set(
-         GetEmbodiedEntity().GetOriginAnchor().Position.GetX() + cHalfSize.GetX(),
-         GetEmbodiedEntity().GetOriginAnchor().Position.GetY() + cHalfSize.GetY(),
-         GetEmbodiedEntity().GetOriginAnchor().Position.GetZ() + m_cBoxEntity.GetSize().GetZ());
+      GetBoundingBox().MinCorner = sOrigin.Position;
+      GetBoundingBox().MaxCorner = sOrigin.Position;
+      for(UInt32 i = 0; i < 8; ++i) {
+         CVector3 cCorner((i & 1) ? cHalfSize.GetX() : -cHalfSize.GetX(),
+                          (i & 2) ? cHalfSize.GetY() : -cHalfSize.GetY(),
+                          (i & 4) ? m_cBoxEntity.GetSize().GetZ() : 0.0f);
+         cCorner.Rotate(sOrigin.Orientation);
+         cCorner += sOrigin.Position;
+         GetBoundingBox().MinCorner.Set(Min(GetBoundingBox().MinCorner.GetX(), cCorner.GetX()),
+                                        Min(GetBoundingBox().MinCorner.GetY(), cCorner.GetY()),
+                                        Min(GetBoundingBox().MinCorner.GetZ(), cCorner.GetZ()));
+         GetBoundingBox().MaxCorner.Set(Max(GetBoundingBox().MaxCorner.GetX(), cCorner.GetX()),
+                                        Max(GetBoundingBox().MaxCorner.GetY(), cCorner.GetY()),
+                                        Max(GetBoundingBox().MaxCorner.GetZ(), cCorner.GetZ()));
+      }
    }
 
    /****************************************/
@@ -47,6 +73,14 @@ namespace argos {
    /****************************************/
    /****************************************/
 
+   void CPointMass3DBoxModel::UpdateOriginAnchor(SAnchor& s_anchor) {
+      s_anchor.Position = m_cPosition;
+      s_anchor.Orientation = m_cOrientation;
+   }
+
+   /****************************************/
+   /****************************************/
+
    REGISTER_STANDARD_POINTMASS3D_OPERATIONS_ON_ENTITY(CBoxEntity, CPointMass3DBoxModel);
 
    /****************************************/
@@ -27,18 +27,26 @@ namespace argos {
                            CBoxEntity& c_box);
       virtual ~CPointMass3DBoxModel() {}
       
+      virtual void MoveTo(const CVector3& c_position,
+                          const CQuaternion& c_orientation);
+
       virtual void UpdateFromEntityStatus() {}
       virtual void Step() {}
       virtual void UpdateEntityStatus() {}
 
       virtual void CalculateBoundingBox();
 
+      virtual void UpdateOriginAnchor(SAnchor& s_anchor);
+
       virtual bool CheckIntersectionWithRay(Real& f_t_on_ray,
                                             const CRay3& c_ray) const;
 
    private:
 
       CBoxEntity& m_cBoxEntity;
+
+      /** The orientation of the box, set when the box is moved */
+      CQuaternion m_cOrientation;
    };
 
 }
@@ -0,0 +1,189 @@
+/**
+ * @file <argos3/plugins/simulator/physics_engines/pointmass3d/pointmass3d_bvh.cpp>
+ */
+
+#include "pointmass3d_bvh.h"
+#include "pointmass3d_model.h"
+#include <algorithm>
+
+namespace argos {
+
+   /****************************************/
+   /****************************************/
+
+   /* Margin added to the leaf boxes, so that rays grazing a model are not lost to rounding */
+   static const Real BVH_MARGIN = 1e-6;
+
+   /* Rebuild when the total area of the refitted boxes exceeds that of the build by this factor */
+   static const Real BVH_REBUILD_AREA_RATIO = 2.0;
+
+   /****************************************/
+   /****************************************/
+
+   CPointMass3DBVH::CPointMass3DBVH() :
+      m_fBuildArea(0.0),
+      m_fArea(0.0) {}
+
+   /****************************************/
+   /****************************************/
+
+   void CPointMass3DBVH::Build(const std::vector<CPointMass3DModel*>& vec_models) {
+      m_vecModels = vec_models;
+      m_vecNodes.clear();
+      if(m_vecModels.empty()) {
+         m_fBuildArea = m_fArea = 0.0;
+         return;
+      }
+      m_vecNodes.reserve(2 * m_vecModels.size() / LEAF_SIZE + 1);
+      m_vecNodes.resize(1);
+      BuildNode(0, 0, m_vecModels.size());
+      Refit();
+      m_fBuildArea = m_fArea;
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CPointMass3DBVH::Refit() {
+      /* The children come after their parent, so a reverse pass updates them first */
+      for(size_t i = m_vecNodes.size(); i > 0; --i) {
+         SNode& sNode = m_vecNodes[i-1];
+         if(sNode.Count > 0) {
+            sNode.BoundingBox = GetBoundingBox(*m_vecModels[sNode.First]);
+            for(UInt32 j = sNode.First + 1; j < sNode.First + sNode.Count; ++j) {
+               Merge(sNode.BoundingBox, GetBoundingBox(*m_vecModels[j]));
+            }
+            sNode.BoundingBox.MinCorner -= CVector3(BVH_MARGIN, BVH_MARGIN, BVH_MARGIN);
+            sNode.BoundingBox.MaxCorner += CVector3(BVH_MARGIN, BVH_MARGIN, BVH_MARGIN);
+         }
+         else {
+            sNode.BoundingBox = m_vecNodes[sNode.First].BoundingBox;
+            Merge(sNode.BoundingBox, m_vecNodes[sNode.First + 1].BoundingBox);
+         }
+      }
+      m_fArea = CalculateArea();
+   }
+
+   /****************************************/
+   /****************************************/
+
+   bool CPointMass3DBVH::NeedsRebuild() const {
+      return m_fArea > BVH_REBUILD_AREA_RATIO * m_fBuildArea;
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CPointMass3DBVH::Clear() {
+      m_vecNodes.clear();
+      m_vecModels.clear();
+      m_fBuildArea = m_fArea = 0.0;
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CPointMass3DBVH::BuildNode(UInt32 un_node,
+                                   UInt32 un_first,
+                                   UInt32 un_count) {
+      if(un_count <= LEAF_SIZE) {
+         m_vecNodes[un_node].First = un_first;
+         m_vecNodes[un_node].Count = un_count;
+         return;
+      }
+      /* Calculate the bounds of the centers of the models */
+      CVector3 cMin, cMax;
+      for(UInt32 i = un_first; i < un_first + un_count; ++i) {
+         const SBoundingBox& sBox = GetBoundingBox(*m_vecModels[i]);
+         CVector3 cCenter = (sBox.MinCorner + sBox.MaxCorner) * 0.5;
+         if(i == un_first) {
+            cMin = cCenter;
+            cMax = cCenter;
+         }
+         else {
+            cMin.Set(Min(cMin.GetX(), cCenter.GetX()),
+                     Min(cMin.GetY(), cCenter.GetY()),
+                     Min(cMin.GetZ(), cCenter.GetZ()));
+            cMax.Set(Max(cMax.GetX(), cCenter.GetX()),
+                     Max(cMax.GetY(), cCenter.GetY()),
+                     Max(cMax.GetZ(), cCenter.GetZ()));
+         }
+      }
+      /* Split the models in two halves along the longest axis */
+      CVector3 cExtent = cMax - cMin;
+      UInt32 unAxis = 0;
+      if(cExtent.GetY() > cExtent.GetX()) unAxis = 1;
+      if(cExtent.GetZ() > (unAxis == 0 ? cExtent.GetX() : cExtent.GetY())) unAxis = 2;
+      UInt32 unHalf = un_count / 2;
+      std::nth_element(
+         m_vecModels.begin() + un_first,
+         m_vecModels.begin() + un_first + unHalf,
+         m_vecModels.begin() + un_first + un_count,
+         [unAxis](const CPointMass3DModel* pc_a, const CPointMass3DModel* pc_b) {
+            const SBoundingBox& sA = GetBoundingBox(*pc_a);
+            const SBoundingBox& sB = GetBoundingBox(*pc_b);
+            switch(unAxis) {
+               case 0:  return sA.MinCorner.GetX() + sA.MaxCorner.GetX() < sB.MinCorner.GetX() + sB.MaxCorner.GetX();
+               case 1:  return sA.MinCorner.GetY() + sA.MaxCorner.GetY() < sB.MinCorner.GetY() + sB.MaxCorner.GetY();
+               default: return sA.MinCorner.GetZ() + sA.MaxCorner.GetZ() < sB.MinCorner.GetZ() + sB.MaxCorner.GetZ();
+            }
+         });
+      /* Create the children next to each other */
+      UInt32 unChild = m_vecNodes.size();
+      m_vecNodes[un_node].First = unChild;
+      m_vecNodes[un_node].Count = 0;
+      m_vecNodes.resize(unChild + 2);
+      BuildNode(unChild,     un_first,          unHalf);
+      BuildNode(unChild + 1, un_first + unHalf, un_count - unHalf);
+   }
+
+   /****************************************/
+   /****************************************/
+
+   Real CPointMass3DBVH::CalculateArea() const {
+      Real fArea = 0.0;
+      for(size_t i = 0; i < m_vecNodes.size(); ++i) {
+         CVector3 cSize = m_vecNodes[i].BoundingBox.MaxCorner - m_vecNodes[i].BoundingBox.MinCorner;
+         fArea +=
+            cSize.GetX() * cSize.GetY() +
+            cSize.GetY() * cSize.GetZ() +
+            cSize.GetZ() * cSize.GetX();
+      }
+      return fArea;
+   }
+
+   /****************************************/
+   /****************************************/
+
+   const SBoundingBox& CPointMass3DBVH::GetBoundingBox(const CPointMass3DModel& c_model) {
+      return c_model.GetBoundingBox();
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CPointMass3DBVH::Merge(SBoundingBox& s_box,
+                               const SBoundingBox& s_other) {
+      s_box.MinCorner.Set(Min(s_box.MinCorner.GetX(), s_other.MinCorner.GetX()),
+                          Min(s_box.MinCorner.GetY(), s_other.MinCorner.GetY()),
+                          Min(s_box.MinCorner.GetZ(), s_other.MinCorner.GetZ()));
+      s_box.MaxCorner.Set(Max(s_box.MaxCorner.GetX(), s_other.MaxCorner.GetX()),
+                          Max(s_box.MaxCorner.GetY(), s_other.MaxCorner.GetY()),
+                          Max(s_box.MaxCorner.GetZ(), s_other.MaxCorner.GetZ()));
+   }
+
+   /****************************************/
+   /****************************************/
+
+   bool CPointMass3DBVH::Overlap(const SBoundingBox& s_box1,
+                                 const SBoundingBox& s_box2) {
+      return
+         s_box1.MinCorner.GetX() <= s_box2.MaxCorner.GetX() && s_box1.MaxCorner.GetX() >= s_box2.MinCorner.GetX() &&
+         s_box1.MinCorner.GetY() <= s_box2.MaxCorner.GetY() && s_box1.MaxCorner.GetY() >= s_box2.MinCorner.GetY() &&
+         s_box1.MinCorner.GetZ() <= s_box2.MaxCorner.GetZ() && s_box1.MaxCorner.GetZ() >= s_box2.MinCorner.GetZ();
+   }
+
+   /****************************************/
+   /****************************************/
+
+}
@@ -0,0 +1,214 @@
+/**
+ * @file <argos3/plugins/simulator/physics_engines/pointmass3d/pointmass3d_bvh.h>
+ */
+
+#ifndef POINTMASS3D_BVH_H
+#define POINTMASS3D_BVH_H
+
+namespace argos {
+   class CPointMass3DBVH;
+   class CPointMass3DModel;
+}
+
+#include <argos3/core/simulator/physics_engine/physics_model.h>
+#include <argos3/core/utility/math/ray3.h>
+#include <algorithm>
+#include <vector>
+
+namespace argos {
+
+   /**
+    * A bounding volume hierarchy over the bounding boxes of the point-mass models.
+    * The hierarchy is built top-down, splitting the models of each node in two
+    * halves along the longest axis of their centers. The nodes are stored in a
+    * flat array, in which the children of a node always come after it.
+    * When the models move, Refit() updates the boxes of the nodes without
+    * changing the structure of the hierarchy. This keeps the queries correct,
+    * but the boxes grow as the models drift apart from their original
+    * neighbours. NeedsRebuild() tells when the boxes have grown enough that
+    * Build() should be called again.
+    */
+   class CPointMass3DBVH {
+
+   public:
+
+      CPointMass3DBVH();
+
+      /**
+       * Builds the hierarchy over the given models.
+       * The bounding boxes of the models must be up to date.
+       * @param vec_models The models.
+       */
+      void Build(const std::vector<CPointMass3DModel*>& vec_models);
+
+      /**
+       * Updates the boxes of the nodes to the current bounding boxes of the models.
+       */
+      void Refit();
+
+      /**
+       * Returns <tt>true</tt> if the refitted boxes have grown enough to make a new build worthwhile.
+       * @return <tt>true</tt> if the refitted boxes have grown enough to make a new build worthwhile.
+       */
+      bool NeedsRebuild() const;
+
+      /**
+       * Removes all the models from the hierarchy.
+       */
+      void Clear();
+
+      /**
+       * Calls the visitor for each model whose bounding box intersects the given box.
+       * @param s_box The box.
+       * @param c_visitor A callable taking a <tt>CPointMass3DModel&</tt>.
+       */
+      template <class VISITOR>
+      void ForModelsInBox(const SBoundingBox& s_box,
+                          VISITOR c_visitor) const;
+
+      /**
+       * Calls the visitor for each model whose bounding box is crossed by the ray.
+       * The visitor returns the largest value of t on the ray that is still of
+       * interest, so that the nodes beyond it are skipped. A visitor that
+       * collects all the intersections returns 1.
+       * @param c_ray The ray.
+       * @param c_visitor A callable taking a <tt>CPointMass3DModel&</tt> and returning a <tt>Real</tt>.
+       */
+      template <class VISITOR>
+      void ForModelsAlongRay(const CRay3& c_ray,
+                             VISITOR c_visitor) const;
+
+   private:
+
+      struct SNode {
+         SBoundingBox BoundingBox;
+         /* For a leaf, the first model; otherwise, the first child */
+         UInt32 First;
+         /* For a leaf, the number of models; otherwise, zero */
+         UInt32 Count;
+      };
+
+      void BuildNode(UInt32 un_node,
+                     UInt32 un_first,
+                     UInt32 un_count);
+
+      Real CalculateArea() const;
+
+      static const SBoundingBox& GetBoundingBox(const CPointMass3DModel& c_model);
+
+      static void Merge(SBoundingBox& s_box,
+                        const SBoundingBox& s_other);
+
+      static bool Overlap(const SBoundingBox& s_box1,
+                          const SBoundingBox& s_box2);
+
+   private:
+
+      /** The maximum number of models in a leaf */
+      static const UInt32 LEAF_SIZE = 4;
+
+      /** The maximum depth of the hierarchy, more than enough for the median split */
+      static const UInt32 MAX_DEPTH = 64;
+
+      std::vector<SNode> m_vecNodes;
+      std::vector<CPointMass3DModel*> m_vecModels;
+
+      /** The total area of the node boxes after the last build */
+      Real m_fBuildArea;
+
+      /** The total area of the node boxes after the last refit */
+      Real m_fArea;
+
+   };
+
+   /****************************************/
+   /****************************************/
+
+   template <class VISITOR>
+   void CPointMass3DBVH::ForModelsInBox(const SBoundingBox& s_box,
+                                        VISITOR c_visitor) const {
+      if(m_vecNodes.empty()) return;
+      UInt32 punStack[MAX_DEPTH];
+      UInt32 unStackSize = 0;
+      punStack[unStackSize++] = 0;
+      while(unStackSize > 0) {
+         const SNode& sNode = m_vecNodes[punStack[--unStackSize]];
+         if(!Overlap(sNode.BoundingBox, s_box)) continue;
+         if(sNode.Count > 0) {
+            for(UInt32 i = sNode.First; i < sNode.First + sNode.Count; ++i) {
+               if(Overlap(GetBoundingBox(*m_vecModels[i]), s_box)) {
+                  c_visitor(*m_vecModels[i]);
+               }
+            }
+         }
+         else {
+            punStack[unStackSize++] = sNode.First + 1;
+            punStack[unStackSize++] = sNode.First;
+         }
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   template <class VISITOR>
+   void CPointMass3DBVH::ForModelsAlongRay(const CRay3& c_ray,
+                                           VISITOR c_visitor) const {
+      if(m_vecNodes.empty()) return;
+      /* The ray is parameterized as start + t * (end - start), with t in [0,1] */
+      Real pfStart[3] = { c_ray.GetStart().GetX(), c_ray.GetStart().GetY(), c_ray.GetStart().GetZ() };
+      Real pfDir[3] = { c_ray.GetEnd().GetX() - pfStart[0],
+                        c_ray.GetEnd().GetY() - pfStart[1],
+                        c_ray.GetEnd().GetZ() - pfStart[2] };
+      Real pfInvDir[3];
+      for(UInt32 i = 0; i < 3; ++i) {
+         pfInvDir[i] = (pfDir[i] != 0.0) ? 1.0 / pfDir[i] : 0.0;
+      }
+      Real fMaxT = 1.0;
+      UInt32 punStack[MAX_DEPTH];
+      UInt32 unStackSize = 0;
+      punStack[unStackSize++] = 0;
+      while(unStackSize > 0) {
+         const SNode& sNode = m_vecNodes[punStack[--unStackSize]];
+         /* Slab test */
+         const Real pfMin[3] = { sNode.BoundingBox.MinCorner.GetX(),
+                                 sNode.BoundingBox.MinCorner.GetY(),
+                                 sNode.BoundingBox.MinCorner.GetZ() };
+         const Real pfMax[3] = { sNode.BoundingBox.MaxCorner.GetX(),
+                                 sNode.BoundingBox.MaxCorner.GetY(),
+                                 sNode.BoundingBox.MaxCorner.GetZ() };
+         Real fTNear = 0.0, fTFar = fMaxT;
+         bool bHit = true;
+         for(UInt32 i = 0; i < 3 && bHit; ++i) {
+            if(pfDir[i] == 0.0) {
+               /* The ray is parallel to the slab */
+               bHit = (pfStart[i] >= pfMin[i] && pfStart[i] <= pfMax[i]);
+            }
+            else {
+               Real fT1 = (pfMin[i] - pfStart[i]) * pfInvDir[i];
+               Real fT2 = (pfMax[i] - pfStart[i]) * pfInvDir[i];
+               if(fT1 > fT2) std::swap(fT1, fT2);
+               if(fT1 > fTNear) fTNear = fT1;
+               if(fT2 < fTFar) fTFar = fT2;
+               bHit = (fTNear <= fTFar);
+            }
+         }
+         if(!bHit) continue;
+         if(sNode.Count > 0) {
+            for(UInt32 i = sNode.First; i < sNode.First + sNode.Count; ++i) {
+               fMaxT = c_visitor(*m_vecModels[i]);
+            }
+         }
+         else {
+            punStack[unStackSize++] = sNode.First + 1;
+            punStack[unStackSize++] = sNode.First;
+         }
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+}
+
+#endif
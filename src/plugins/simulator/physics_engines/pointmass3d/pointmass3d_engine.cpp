@@ -15,7 +15,10 @@ namespace argos {
    /****************************************/
 
    CPointMass3DEngine::CPointMass3DEngine() :
-      m_fGravity(-9.81f) {
+      m_fGravity(-9.81f),
+      m_bUseBVH(false),
+      m_bBVHValid(false),
+      m_bBVHOutdated(false) {
    }
 
    /****************************************/
@@ -32,6 +35,15 @@ namespace argos {
       CPhysicsEngine::Init(t_tree);
       /* Set gravity */
       GetNodeAttributeOrDefault(t_tree, "gravity", m_fGravity, m_fGravity);
+      /* Set the method for the ray queries */
+      std::string strRayQueries = "linear";
+      GetNodeAttributeOrDefault(t_tree, "ray_queries", strRayQueries, strRayQueries);
+      if(strRayQueries == "bvh") {
+         m_bUseBVH = true;
+      }
+      else if(strRayQueries != "linear") {
+         THROW_ARGOSEXCEPTION("Unknown ray query method \"" << strRayQueries << "\" for point-mass 3D engine \"" << GetId() << "\". Use \"linear\" or \"bvh\".");
+      }
    }
 
    /****************************************/
@@ -40,8 +52,10 @@ namespace argos {
    void CPointMass3DEngine::Reset() {
       for(auto it = m_tPhysicsModels.begin();
           it != m_tPhysicsModels.end(); ++it) {
-         it->second->Reset();
+         (*it)->Reset();
       }
+      m_bBVHValid = false;
+      UpdateBVH();
    }
 
    /****************************************/
@@ -51,9 +65,11 @@ namespace argos {
       /* Empty the physics entity map */
       for(auto it = m_tPhysicsModels.begin();
           it != m_tPhysicsModels.end(); ++it) {
-         delete it->second;
+         delete *it;
       }
-      m_tPhysicsModels.clear();
+      m_tPhysicsModels.Clear();
+      m_cBVH.Clear();
+      m_bBVHValid = false;
    }
 
    /****************************************/
@@ -63,24 +79,26 @@ namespace argos {
       /* Update the physics state from the entities */
       for(auto it = m_tPhysicsModels.begin();
           it != m_tPhysicsModels.end(); ++it) {
-         it->second->UpdateFromEntityStatus();
+         (*it)->UpdateFromEntityStatus();
       }
       for(size_t i = 0; i < GetIterations(); ++i) {
          /* Perform the step */
          for(auto it = m_tPhysicsModels.begin();
              it != m_tPhysicsModels.end(); ++it) {
-            it->second->UpdatePhysics();
+            (*it)->UpdatePhysics();
          }
       }
       for(auto it = m_tPhysicsModels.begin();
           it != m_tPhysicsModels.end(); ++it) {
-         it->second->Step();
+         (*it)->Step();
       }
       /* Update the simulated space */
       for(auto it = m_tPhysicsModels.begin();
           it != m_tPhysicsModels.end(); ++it) {
-         it->second->UpdateEntityStatus();
+         (*it)->UpdateEntityStatus();
       }
+      /* Update the BVH to the new bounding boxes */
+      UpdateBVH();
    }
 
    /****************************************/
@@ -136,13 +154,27 @@ namespace argos {
    void CPointMass3DEngine::CheckIntersectionWithRay(TEmbodiedEntityIntersectionData& t_data,
                                                      const CRay3& c_ray) const {
       Real fTOnRay;
+      if(m_bBVHValid && !m_bBVHOutdated) {
+         m_cBVH.ForModelsAlongRay(
+            c_ray,
+            [&t_data, &c_ray, &fTOnRay](CPointMass3DModel& c_model) {
+               if(c_model.CheckIntersectionWithRay(fTOnRay, c_ray)) {
+                  t_data.push_back(
+                     SEmbodiedEntityIntersectionItem(
+                        &c_model.GetEmbodiedEntity(),
+                        fTOnRay));
+               }
+               return 1.0;
+            });
+         return;
+      }
       for(auto it = m_tPhysicsModels.begin();
           it != m_tPhysicsModels.end();
           ++it) {
-         if(it->second->CheckIntersectionWithRay(fTOnRay, c_ray)) {
+         if((*it)->CheckIntersectionWithRay(fTOnRay, c_ray)) {
             t_data.push_back(
                SEmbodiedEntityIntersectionItem(
-                  &it->second->GetEmbodiedEntity(),
+                  &(*it)->GetEmbodiedEntity(),
                   fTOnRay));
          }
       }
@@ -151,19 +183,155 @@ namespace argos {
    /****************************************/
    /****************************************/
 
+   /*
+    * Returns true if the ray crosses the box for a value of t between 0 and f_max_t.
+    */
+   static bool RayCrossesBox(const CRay3& c_ray,
+                             const SBoundingBox& s_box,
+                             Real f_max_t) {
+      const Real pfStart[3] = { c_ray.GetStart().GetX(), c_ray.GetStart().GetY(), c_ray.GetStart().GetZ() };
+      const Real pfEnd[3]   = { c_ray.GetEnd().GetX(),   c_ray.GetEnd().GetY(),   c_ray.GetEnd().GetZ()   };
+      const Real pfMin[3]   = { s_box.MinCorner.GetX(),  s_box.MinCorner.GetY(),  s_box.MinCorner.GetZ()  };
+      const Real pfMax[3]   = { s_box.MaxCorner.GetX(),  s_box.MaxCorner.GetY(),  s_box.MaxCorner.GetZ()  };
+      Real fTNear = 0.0, fTFar = f_max_t;
+      for(UInt32 i = 0; i < 3; ++i) {
+         Real fDir = pfEnd[i] - pfStart[i];
+         if(fDir == 0.0) {
+            /* The ray is parallel to the slab */
+            if(pfStart[i] < pfMin[i] || pfStart[i] > pfMax[i]) return false;
+         }
+         else {
+            Real fT1 = (pfMin[i] - pfStart[i]) / fDir;
+            Real fT2 = (pfMax[i] - pfStart[i]) / fDir;
+            if(fT1 > fT2) std::swap(fT1, fT2);
+            if(fT1 > fTNear) fTNear = fT1;
+            if(fT2 < fTFar) fTFar = fT2;
+            if(fTNear > fTFar) return false;
+         }
+      }
+      return true;
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CPointMass3DEngine::CheckClosestIntersectionWithRay(SEmbodiedEntityIntersectionItem& s_item,
+                                                            const CRay3& c_ray,
+                                                            const CEmbodiedEntity* pc_excluded) const {
+      Real fTOnRay;
+      if(m_bBVHValid && !m_bBVHOutdated) {
+         /* The nodes beyond the closest intersection found so far are skipped */
+         m_cBVH.ForModelsAlongRay(
+            c_ray,
+            [&s_item, &c_ray, &fTOnRay, pc_excluded](CPointMass3DModel& c_model) {
+               if(&c_model.GetEmbodiedEntity() != pc_excluded &&
+                  c_model.CheckIntersectionWithRay(fTOnRay, c_ray) &&
+                  s_item.TOnRay > fTOnRay) {
+                  s_item = SEmbodiedEntityIntersectionItem(&c_model.GetEmbodiedEntity(), fTOnRay);
+               }
+               return s_item.TOnRay;
+            });
+         return;
+      }
+      /* Skip the models whose box is not crossed before the closest intersection found so far */
+      for(auto it = m_tPhysicsModels.begin();
+          it != m_tPhysicsModels.end();
+          ++it) {
+         if(&(*it)->GetEmbodiedEntity() != pc_excluded &&
+            RayCrossesBox(c_ray, (*it)->GetBoundingBox(), s_item.TOnRay) &&
+            (*it)->CheckIntersectionWithRay(fTOnRay, c_ray) &&
+            s_item.TOnRay > fTOnRay) {
+            s_item = SEmbodiedEntityIntersectionItem(&(*it)->GetEmbodiedEntity(), fTOnRay);
+         }
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   /*
+    * Checks a batch of rays against a model, keeping the closest intersection of each ray.
+    */
+   static void CheckIntersectionWithRaysOnModel(const CPointMass3DModel& c_model,
+                                                TEmbodiedEntityIntersectionData& t_items,
+                                                const std::vector<CRay3>& vec_rays,
+                                                const CEmbodiedEntity* pc_excluded) {
+      if(&c_model.GetEmbodiedEntity() == pc_excluded) return;
+      Real fTOnRay;
+      for(size_t i = 0; i < vec_rays.size(); ++i) {
+         if(c_model.CheckIntersectionWithRay(fTOnRay, vec_rays[i]) &&
+            t_items[i].TOnRay > fTOnRay) {
+            t_items[i] =
+               SEmbodiedEntityIntersectionItem(
+                  const_cast<CEmbodiedEntity*>(&c_model.GetEmbodiedEntity()),
+                  fTOnRay);
+         }
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
+   void CPointMass3DEngine::CheckIntersectionWithRays(TEmbodiedEntityIntersectionData& t_items,
+                                                      const std::vector<CRay3>& vec_rays,
+                                                      const CEmbodiedEntity* pc_excluded) const {
+      if(vec_rays.empty()) return;
+      /* Calculate the bounding box of all the rays */
+      SBoundingBox sRaysBB;
+      sRaysBB.MinCorner = vec_rays[0].GetStart();
+      sRaysBB.MaxCorner = vec_rays[0].GetStart();
+      for(size_t i = 0; i < vec_rays.size(); ++i) {
+         const CVector3* pcPoints[2] = { &vec_rays[i].GetStart(), &vec_rays[i].GetEnd() };
+         for(size_t j = 0; j < 2; ++j) {
+            sRaysBB.MinCorner.Set(Min(sRaysBB.MinCorner.GetX(), pcPoints[j]->GetX()),
+                                  Min(sRaysBB.MinCorner.GetY(), pcPoints[j]->GetY()),
+                                  Min(sRaysBB.MinCorner.GetZ(), pcPoints[j]->GetZ()));
+            sRaysBB.MaxCorner.Set(Max(sRaysBB.MaxCorner.GetX(), pcPoints[j]->GetX()),
+                                  Max(sRaysBB.MaxCorner.GetY(), pcPoints[j]->GetY()),
+                                  Max(sRaysBB.MaxCorner.GetZ(), pcPoints[j]->GetZ()));
+         }
+      }
+      /* Test the rays only on the models close to them */
+      if(m_bBVHValid && !m_bBVHOutdated) {
+         m_cBVH.ForModelsInBox(
+            sRaysBB,
+            [&t_items, &vec_rays, pc_excluded](CPointMass3DModel& c_model) {
+               CheckIntersectionWithRaysOnModel(c_model, t_items, vec_rays, pc_excluded);
+            });
+         return;
+      }
+      for(auto it = m_tPhysicsModels.begin();
+          it != m_tPhysicsModels.end();
+          ++it) {
+         const SBoundingBox& sModelBB = (*it)->GetBoundingBox();
+         if(sModelBB.MinCorner.GetX() <= sRaysBB.MaxCorner.GetX() &&
+            sModelBB.MinCorner.GetY() <= sRaysBB.MaxCorner.GetY() &&
+            sModelBB.MinCorner.GetZ() <= sRaysBB.MaxCorner.GetZ() &&
+            sModelBB.MaxCorner.GetX() >= sRaysBB.MinCorner.GetX() &&
+            sModelBB.MaxCorner.GetY() >= sRaysBB.MinCorner.GetY() &&
+            sModelBB.MaxCorner.GetZ() >= sRaysBB.MinCorner.GetZ()) {
+            CheckIntersectionWithRaysOnModel(**it, t_items, vec_rays, pc_excluded);
+         }
+      }
+   }
+
+   /****************************************/
+   /****************************************/
+
    void CPointMass3DEngine::AddPhysicsModel(const std::string& str_id,
                                             CPointMass3DModel& c_model) {
-      m_tPhysicsModels[str_id] = &c_model;
+      m_tPhysicsModels.Insert(str_id, &c_model);
+      m_bBVHValid = false;
    }
 
    /****************************************/
    /****************************************/
 
    void CPointMass3DEngine::RemovePhysicsModel(const std::string& str_id) {
-      auto it = m_tPhysicsModels.find(str_id);
-      if(it != m_tPhysicsModels.end()) {
-         delete it->second;
-         m_tPhysicsModels.erase(it);
+      CPointMass3DModel* pcModel = m_tPhysicsModels.Remove(str_id);
+      if(pcModel != nullptr) {
+         delete pcModel;
+         m_bBVHValid = false;
       }
       else {
          THROW_ARGOSEXCEPTION("PointMass3D model id \"" << str_id << "\" not found in point-mass 3D engine \"" << GetId() << "\"");
@@ -173,6 +341,28 @@ namespace argos {
    /****************************************/
    /****************************************/
 
+   void CPointMass3DEngine::UpdateBVH() {
+      if(!m_bUseBVH) return;
+      m_bBVHOutdated = false;
+      if(m_bBVHValid) {
+         /* Same models, update the boxes */
+         m_cBVH.Refit();
+         if(!m_cBVH.NeedsRebuild()) return;
+      }
+      /* The models changed, or the boxes grew too much */
+      std::vector<CPointMass3DModel*> vecModels;
+      vecModels.reserve(m_tPhysicsModels.size());
+      for(auto it = m_tPhysicsModels.begin();
+          it != m_tPhysicsModels.end(); ++it) {
+         vecModels.push_back(*it);
+      }
+      m_cBVH.Build(vecModels);
+      m_bBVHValid = true;
+   }
+
+   /****************************************/
+   /****************************************/
+
    REGISTER_PHYSICS_ENGINE(CPointMass3DEngine,
                            "pointmass3d",
                            "Carlo Pinciroli [ilpincy@gmail.com]",
@@ -202,6 +392,18 @@ namespace argos {
                            "    ...\n"
                            "  </physics_engines>\n\n"
 
+                           "By default, the ray queries of the sensors test every model in the engine.\n"
+                           "With many models, this makes the sensing phase quadratic in the number of\n"
+                           "robots. Setting the 'ray_queries' attribute to 'bvh' makes the engine keep a\n"
+                           "bounding volume hierarchy over the models, refitted at every step, so that\n"
+                           "each ray only tests the models close to it. The default value is 'linear':\n\n"
+
+                           "  <physics_engines>\n"
+                           "    ...\n"
+                           "    <pointmass3d id=\"pm3d\" ray_queries=\"bvh\"/>\n"
+                           "    ...\n"
+                           "  </physics_engines>\n\n"
+
                            "Multiple physics engines can also be used. If multiple physics engines are used,\n"
                            "the disjoint union of the 3D volumes within the arena assigned to each engine must cover\n"
                            "the entire arena without overlapping. If the entire arena is not covered, robots can\n"
@@ -16,6 +16,8 @@ namespace argos {
 #include <argos3/core/utility/math/ray2.h>
 #include <argos3/core/simulator/entity/controllable_entity.h>
 #include <argos3/core/simulator/physics_engine/physics_engine.h>
+#include <argos3/plugins/simulator/physics_engines/physics_model_vector.h>
+#include <argos3/plugins/simulator/physics_engines/pointmass3d/pointmass3d_bvh.h>
 
 namespace argos {
 
@@ -45,15 +47,23 @@ namespace argos {
       virtual void CheckIntersectionWithRay(TEmbodiedEntityIntersectionData& t_data,
                                             const CRay3& c_ray) const;
 
+      virtual void CheckClosestIntersectionWithRay(SEmbodiedEntityIntersectionItem& s_item,
+                                                   const CRay3& c_ray,
+                                                   const CEmbodiedEntity* pc_excluded) const;
+
+      virtual void CheckIntersectionWithRays(TEmbodiedEntityIntersectionData& t_items,
+                                             const std::vector<CRay3>& vec_rays,
+                                             const CEmbodiedEntity* pc_excluded) const;
+
       void AddPhysicsModel(const std::string& str_id,
                            CPointMass3DModel& c_model);
       void RemovePhysicsModel(const std::string& str_id);
 
-      std::map<std::string, CPointMass3DModel*>& GetPhysicsModels() {
+      CPhysicsModelVector<CPointMass3DModel>& GetPhysicsModels() {
          return m_tPhysicsModels;
       }
 
-      const std::map<std::string, CPointMass3DModel*>& GetPhysicsModels() const {
+      const CPhysicsModelVector<CPointMass3DModel>& GetPhysicsModels() const {
          return m_tPhysicsModels;
       }
 
@@ -61,12 +71,37 @@ namespace argos {
          return m_fGravity;
       }
 
+      /**
+       * Tells the engine that a model was moved outside of Update().
+       * The ray queries scan the models linearly until the next Update()
+       * refits the BVH.
+       */
+      inline void MarkBVHOutdated() {
+         m_bBVHOutdated = true;
+      }
+
+   private:
+
+      void UpdateBVH();
+
    private:
 
       CControllableEntity::TMap m_tControllableEntities;
-      std::map<std::string, CPointMass3DModel*> m_tPhysicsModels;
+      CPhysicsModelVector<CPointMass3DModel> m_tPhysicsModels;
       Real m_fGravity;
 
+      /** True if the ray queries go through the BVH */
+      bool m_bUseBVH;
+
+      /** True if the BVH matches the current models */
+      bool m_bBVHValid;
+
+      /** True if a model was moved since the BVH was last updated */
+      bool m_bBVHOutdated;
+
+      /** The bounding volume hierarchy over the models, for the ray queries */
+      CPointMass3DBVH m_cBVH;
+
    };
 
    /****************************************/
@@ -34,6 +34,8 @@ namespace argos {
                                   const CQuaternion& c_orientation) {
       m_cPosition = c_position;
       UpdateEntityStatus();
+      /* The BVH is refitted at the end of Update() only */
+      GetPM3DEngine().MarkBVHOutdated();
    }
 
    /****************************************/
@@ -43,8 +45,8 @@ namespace argos {
       /* Go through other objects and check if the BB intersect */
       for(auto it = GetPM3DEngine().GetPhysicsModels().begin();
           it != GetPM3DEngine().GetPhysicsModels().end(); ++it) {
-         if((it->second != this) &&
-            GetBoundingBox().Intersects(it->second->GetBoundingBox()))
+         if((*it != this) &&
+            GetBoundingBox().Intersects((*it)->GetBoundingBox()))
             return true;
       }
       return false;
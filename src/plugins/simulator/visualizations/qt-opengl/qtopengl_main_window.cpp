@@ -501,6 +501,7 @@ namespace argos {
       /* Create a textual window to be used as a buffer */
       m_pcDockLogBuffer = new QTextEdit();
       m_pcDockLogBuffer->setReadOnly(true);
+      LOG.StopDrainThread(); /* The widget must be written from this thread */
       LOG.Flush(); /* Write all the pending stuff */
       LOG.DisableColoredOutput(); /* Colors are not necessary */
       m_pcDockLogBuffer->append("<b>[t=0]</b> Log started."); /* Write something in the buffer */
@@ -520,6 +521,7 @@ namespace argos {
       /* Create a textual window to be used as a buffer */
       m_pcDockLogErrBuffer = new QTextEdit();
       m_pcDockLogErrBuffer->setReadOnly(true);
+      LOGERR.StopDrainThread(); /* The widget must be written from this thread */
       LOGERR.Flush(); /* Write all the pending stuff */
       LOGERR.DisableColoredOutput(); /* Colors are not necessary */
       m_pcDockLogErrBuffer->append("<b>[t=0]</b> LogErr started."); /* Write something in the buffer */
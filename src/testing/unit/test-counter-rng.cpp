@@ -0,0 +1,382 @@
+/**
+ * @file <argos3/testing/unit/test-counter-rng.cpp>
+ *
+ * Checks the counter-based RNG and compares its speed and size with CRNG.
+ *
+ * The test fails if the Philox function does not match the known answers of
+ * its reference implementation, if the bulk functions do not return the same
+ * values as the single draws, if the values drawn for a set of entities over
+ * a number of ticks depend on the number of threads or on the order of the
+ * entities, if resetting the category does not change the seed, if entity
+ * keys, ticks or streams that differ only in their upper bits give the same
+ * values, or if the moments of the distributions are off. For each generator, the time per
+ * value is printed.
+ *
+ * Example:
+ *
+ *   test-counter-rng
+ *   test-counter-rng 10000000
+ */
+#include <argos3/core/utility/math/rng.h>
+#include <argos3/core/utility/string_utilities.h>
+#include <sys/time.h>
+#include <pthread.h>
+#include <cmath>
+#include <cstring>
+
+using namespace argos;
+
+/****************************************/
+/****************************************/
+
+static const UInt32 ENTITIES = 1000;
+static const UInt32 TICKS = 50;
+static const UInt32 VALUES_PER_TICK = 24;
+static const CRange<Real> NOISE_RANGE(-0.1, 0.1);
+
+/****************************************/
+/****************************************/
+
+static Real Now() {
+   ::timeval tTime;
+   ::gettimeofday(&tTime, nullptr);
+   return tTime.tv_sec + tTime.tv_usec / 1e6;
+}
+
+/****************************************/
+/****************************************/
+
+/*
+ * Checks the Philox function against the known answers of Random123.
+ */
+static bool CheckKnownAnswers() {
+   const UInt32 punCases[3][10] = {
+      { 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8 },
+      { 0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff,
+        0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd },
+      { 0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344, 0xa4093822, 0x299f31d0,
+        0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1 }
+   };
+   for(UInt32 i = 0; i < 3; ++i) {
+      UInt32 punCounter[4];
+      ::memcpy(punCounter, punCases[i], sizeof(punCounter));
+      CRandom::CCounterRNG::Philox(punCounter, punCases[i] + 4);
+      if(::memcmp(punCounter, punCases[i] + 6, sizeof(punCounter)) != 0) {
+         std::cout << "Philox does not match the known answer #" << i << std::endl;
+         return false;
+      }
+   }
+   return true;
+}
+
+/****************************************/
+/****************************************/
+
+/*
+ * Checks that the bulk functions return the same values as the single draws,
+ * whatever is left from the previous draws.
+ */
+static bool CheckBulk() {
+   CRandom::CCounterRNG* pcBulk = CRandom::CreateCounterRNG("testing", "bulk");
+   CRandom::CCounterRNG* pcSingle = CRandom::CreateCounterRNG("testing", "bulk");
+   std::vector<Real> vecValues;
+   for(UInt32 unCount = 0; unCount < 20; ++unCount) {
+      for(UInt32 unSkip = 0; unSkip < 5; ++unSkip) {
+         vecValues.resize(unCount);
+         /* Uniform */
+         pcBulk->Seek(unCount, unSkip);
+         pcSingle->Seek(unCount, unSkip);
+         for(UInt32 i = 0; i < unSkip; ++i) {
+            pcBulk->Uniform(NOISE_RANGE);
+            pcSingle->Uniform(NOISE_RANGE);
+         }
+         pcBulk->Uniform(vecValues, NOISE_RANGE);
+         for(UInt32 i = 0; i < unCount; ++i) {
+            if(vecValues[i] != pcSingle->Uniform(NOISE_RANGE)) {
+               std::cout << "Bulk uniform value " << i << " of " << unCount
+                         << " differs after " << unSkip << " draws" << std::endl;
+               return false;
+            }
+         }
+         /* Gaussian */
+         pcBulk->Seek(unCount, unSkip);
+         pcSingle->Seek(unCount, unSkip);
+         for(UInt32 i = 0; i < unSkip; ++i) {
+            pcBulk->Gaussian(1.0);
+            pcSingle->Gaussian(1.0);
+         }
+         pcBulk->Gaussian(vecValues, 2.0, 1.0);
+         for(UInt32 i = 0; i < unCount; ++i) {
+            if(vecValues[i] != pcSingle->Gaussian(2.0, 1.0)) {
+               std::cout << "Bulk Gaussian value " << i << " of " << unCount
+                         << " differs after " << unSkip << " draws" << std::endl;
+               return false;
+            }
+         }
+         if(pcBulk->Uniform(NOISE_RANGE) != pcSingle->Uniform(NOISE_RANGE)) {
+            std::cout << "The RNGs diverge after a bulk draw of " << unCount << " values" << std::endl;
+            return false;
+         }
+      }
+   }
+   return true;
+}
+
+/****************************************/
+/****************************************/
+
+struct SWorker {
+   pthread_t Thread;
+   UInt32 Id;
+   UInt32 Threads;
+   std::vector<Real>* Values;
+};
+
+/*
+ * Draws the noise of the entities of a worker, as a sensor would.
+ * The workers take the entities in turn, starting from the last.
+ */
+static void* DrawNoise(void* pt_worker) {
+   SWorker& sWorker = *reinterpret_cast<SWorker*>(pt_worker);
+   CRandom::CCounterRNG* pcRNG = CRandom::CreateCounterRNG("testing", "proximity");
+   for(UInt32 t = 0; t < TICKS; ++t) {
+      for(UInt32 e = ENTITIES - 1 - sWorker.Id; e < ENTITIES; e -= sWorker.Threads) {
+         pcRNG->Seek(e, t);
+         pcRNG->Uniform(&(*sWorker.Values)[(t * ENTITIES + e) * VALUES_PER_TICK],
+                        VALUES_PER_TICK,
+                        NOISE_RANGE);
+      }
+   }
+   return nullptr;
+}
+
+/*
+ * Returns a checksum of the noise of all the entities at all the ticks.
+ */
+static UInt64 DrawNoiseChecksum(UInt32 un_threads) {
+   std::vector<Real> vecValues(TICKS * ENTITIES * VALUES_PER_TICK);
+   std::vector<SWorker> vecWorkers(un_threads);
+   for(UInt32 i = 0; i < un_threads; ++i) {
+      vecWorkers[i].Id = i;
+      vecWorkers[i].Threads = un_threads;
+      vecWorkers[i].Values = &vecValues;
+      pthread_create(&vecWorkers[i].Thread, nullptr, &DrawNoise, &vecWorkers[i]);
+   }
+   for(UInt32 i = 0; i < un_threads; ++i) {
+      pthread_join(vecWorkers[i].Thread, nullptr);
+   }
+   UInt64 unChecksum = 14695981039346656037ULL;
+   for(size_t i = 0; i < vecValues.size(); ++i) {
+      UInt64 unBits = 0;
+      ::memcpy(&unBits, &vecValues[i], sizeof(Real));
+      unChecksum = (unChecksum ^ unBits) * 1099511628211ULL;
+   }
+   return unChecksum;
+}
+
+/*
+ * Checks that the noise does not depend on the number of threads.
+ */
+static bool CheckThreads() {
+   UInt64 unReference = 0;
+   for(UInt32 unThreads = 1; unThreads <= 8; unThreads *= 2) {
+      UInt64 unChecksum = DrawNoiseChecksum(unThreads);
+      std::cout << "threads " << unThreads << "\t"
+                << ENTITIES << " entities\t"
+                << TICKS << " ticks\t"
+                << "checksum " << unChecksum
+                << std::endl;
+      if(unThreads == 1) {
+         unReference = unChecksum;
+      }
+      else if(unChecksum != unReference) {
+         std::cout << "The noise depends on the number of threads" << std::endl;
+         return false;
+      }
+   }
+   return true;
+}
+
+/****************************************/
+/****************************************/
+
+/*
+ * Checks that resetting the category changes the seed of the counter-based RNGs.
+ */
+static bool CheckReset() {
+   CRandom::CCounterRNG* pcRNG = CRandom::CreateCounterRNG("testing", "reset");
+   pcRNG->Seek(1, 1);
+   Real fBefore = pcRNG->Uniform(NOISE_RANGE);
+   CRandom::SetSeedOf("testing", 54321);
+   CRandom::GetCategory("testing").ResetRNGs();
+   if(pcRNG->GetSeed() != 54321) {
+      std::cout << "Resetting the category did not change the seed" << std::endl;
+      return false;
+   }
+   pcRNG->Seek(1, 1);
+   if(pcRNG->Uniform(NOISE_RANGE) == fBefore) {
+      std::cout << "Different seeds give the same value" << std::endl;
+      return false;
+   }
+   CRandom::SetSeedOf("testing", 12345);
+   CRandom::GetCategory("testing").ResetRNGs();
+   pcRNG->Seek(1, 1);
+   if(pcRNG->Uniform(NOISE_RANGE) != fBefore) {
+      std::cout << "Resetting to the old seed did not give the same value" << std::endl;
+      return false;
+   }
+   return true;
+}
+
+/****************************************/
+/****************************************/
+
+/*
+ * Returns the first value drawn for the given entity and tick.
+ */
+static UInt32 FirstValue(CRandom::CCounterRNG& c_rng,
+                         UInt64 un_entity,
+                         UInt64 un_tick) {
+   c_rng.Seek(un_entity, un_tick);
+   return c_rng.Uniform(CRange<UInt32>(0, 0xFFFFFFFF));
+}
+
+/*
+ * Checks that all the bits of the entity key and of the tick are used, and
+ * that the id of a sensor changes the stream.
+ */
+static bool CheckKeys() {
+   CRandom::CCounterRNG* pcRNG = CRandom::CreateCounterRNG("testing", "keys");
+   UInt64 unHigh = 1ULL << 32;
+   if(FirstValue(*pcRNG, 1, 1) == FirstValue(*pcRNG, 1 + unHigh, 1)) {
+      std::cout << "Entity keys that differ in their upper bits give the same value" << std::endl;
+      return false;
+   }
+   if(FirstValue(*pcRNG, 1, 1) == FirstValue(*pcRNG, 1, 1 + unHigh)) {
+      std::cout << "Ticks that differ in their upper bits give the same value" << std::endl;
+      return false;
+   }
+   CRandom::CCounterRNG* pcSensor0 = CRandom::CreateCounterRNG("testing", "proximity/proximity_0");
+   CRandom::CCounterRNG* pcSensor1 = CRandom::CreateCounterRNG("testing", "proximity/proximity_1");
+   if(FirstValue(*pcSensor0, 1, 1) == FirstValue(*pcSensor1, 1, 1)) {
+      std::cout << "Two sensors of the same entity give the same value" << std::endl;
+      return false;
+   }
+   return true;
+}
+
+/****************************************/
+/****************************************/
+
+/*
+ * Checks the mean, variance, skewness and excess kurtosis of some values.
+ */
+static bool CheckMoments(const std::string& str_name,
+                         const std::vector<Real>& vec_values,
+                         Real f_mean,
+                         Real f_variance,
+                         Real f_kurtosis) {
+   Real fMean = 0.0;
+   for(size_t i = 0; i < vec_values.size(); ++i) {
+      fMean += vec_values[i];
+   }
+   fMean /= vec_values.size();
+   Real fM2 = 0.0, fM3 = 0.0, fM4 = 0.0;
+   for(size_t i = 0; i < vec_values.size(); ++i) {
+      Real fDiff = vec_values[i] - fMean;
+      fM2 += fDiff * fDiff;
+      fM3 += fDiff * fDiff * fDiff;
+      fM4 += fDiff * fDiff * fDiff * fDiff;
+   }
+   fM2 /= vec_values.size();
+   fM3 /= vec_values.size();
+   fM4 /= vec_values.size();
+   Real fSkewness = fM3 / std::pow(fM2, 1.5);
+   Real fKurtosis = fM4 / (fM2 * fM2) - 3.0;
+   std::cout << str_name << "\t"
+             << "mean " << fMean << "\t"
+             << "variance " << fM2 << "\t"
+             << "skewness " << fSkewness << "\t"
+             << "kurtosis " << fKurtosis
+             << std::endl;
+   Real fTolerance = 10.0 / std::sqrt(static_cast<Real>(vec_values.size()));
+   if(std::fabs(fMean - f_mean) > fTolerance * std::sqrt(f_variance) ||
+      std::fabs(fM2 / f_variance - 1.0) > fTolerance ||
+      std::fabs(fSkewness) > fTolerance ||
+      std::fabs(fKurtosis - f_kurtosis) > 2.0 * fTolerance) {
+      std::cout << "The moments of the " << str_name << " values are off" << std::endl;
+      return false;
+   }
+   return true;
+}
+
+/****************************************/
+/****************************************/
+
+/*
+ * Prints the time per value of each generator, and checks the moments.
+ */
+static bool Benchmark(UInt32 un_values) {
+   std::vector<Real> vecValues(un_values);
+   CRandom::CRNG* pcRNG = CRandom::CreateRNG("testing");
+   CRandom::CCounterRNG* pcCounterRNG = CRandom::CreateCounterRNG("testing", "benchmark");
+   std::cout << "state\tCRNG " << sizeof(CRandom::CRNG) + 624 * sizeof(UInt32) << " bytes\t"
+             << "CCounterRNG " << sizeof(CRandom::CCounterRNG) << " bytes"
+             << std::endl;
+   Real fStart;
+   /* Uniform */
+   fStart = Now();
+   for(UInt32 i = 0; i < un_values; ++i) {
+      vecValues[i] = pcRNG->Uniform(NOISE_RANGE);
+   }
+   std::cout << "uniform\tCRNG\t" << 1e9 * (Now() - fStart) / un_values << " ns per value" << std::endl;
+   fStart = Now();
+   for(UInt32 i = 0; i < un_values; ++i) {
+      vecValues[i] = pcCounterRNG->Uniform(NOISE_RANGE);
+   }
+   std::cout << "uniform\tCCounterRNG\t" << 1e9 * (Now() - fStart) / un_values << " ns per value" << std::endl;
+   fStart = Now();
+   for(UInt32 i = 0; i < un_values; i += VALUES_PER_TICK) {
+      pcCounterRNG->Seek(i, 0);
+      pcCounterRNG->Uniform(&vecValues[i], std::min(VALUES_PER_TICK, un_values - i), NOISE_RANGE);
+   }
+   std::cout << "uniform\tCCounterRNG bulk\t" << 1e9 * (Now() - fStart) / un_values << " ns per value" << std::endl;
+   if(!CheckMoments("uniform", vecValues, 0.0, 0.04 / 12.0, -1.2)) return false;
+   /* Gaussian */
+   fStart = Now();
+   for(UInt32 i = 0; i < un_values; ++i) {
+      vecValues[i] = pcRNG->Gaussian(1.0);
+   }
+   std::cout << "gaussian\tCRNG\t" << 1e9 * (Now() - fStart) / un_values << " ns per value" << std::endl;
+   fStart = Now();
+   for(UInt32 i = 0; i < un_values; ++i) {
+      vecValues[i] = pcCounterRNG->Gaussian(1.0);
+   }
+   std::cout << "gaussian\tCCounterRNG\t" << 1e9 * (Now() - fStart) / un_values << " ns per value" << std::endl;
+   fStart = Now();
+   for(UInt32 i = 0; i < un_values; i += VALUES_PER_TICK) {
+      pcCounterRNG->Seek(i, 1);
+      pcCounterRNG->Gaussian(&vecValues[i], std::min(VALUES_PER_TICK, un_values - i), 1.0);
+   }
+   std::cout << "gaussian\tCCounterRNG bulk\t" << 1e9 * (Now() - fStart) / un_values << " ns per value" << std::endl;
+   if(!CheckMoments("gaussian", vecValues, 0.0, 1.0, 0.0)) return false;
+   return true;
+}
+
+/****************************************/
+/****************************************/
+
+int main(int n_argc, char** ppch_argv) {
+   UInt32 unValues = (n_argc > 1) ? FromString<UInt32>(ppch_argv[1]) : 1000000;
+   CRandom::CreateCategory("testing", 12345);
+   bool bOK =
+      CheckKnownAnswers() &&
+      CheckBulk() &&
+      CheckThreads() &&
+      CheckReset() &&
+      CheckKeys() &&
+      Benchmark(unValues);
+   CRandom::RemoveCategory("testing");
+   return bOK ? 0 : 1;
+}
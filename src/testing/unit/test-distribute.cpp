@@ -0,0 +1,240 @@
+/**
+ * @file <argos3/testing/unit/test-distribute.cpp>
+ *
+ * Checks <distribute> in a crowded arena.
+ *
+ * An arena is filled with foot-bots through <distribute>, once for each
+ * position method given on the command line. Each run happens in a separate
+ * process, so that the simulator singleton starts clean. The methods are
+ * 'uniform' and 'poisson_disk'. With 'poisson_disk', the positions are drawn
+ * at least a foot-bot diameter apart. With the suffix '_move', the colliding
+ * robots are moved rather than created anew (move_on_retry="true").
+ *
+ * The test fails if:
+ * - the robots are not back at the positions they were placed at after a
+ *   reset;
+ * - the robots placed with '_move' are not at the same positions as those
+ *   placed without it;
+ * - the robots placed with 'poisson_disk' are closer than the minimum
+ *   distance.
+ *
+ * Example:
+ *
+ *   test-distribute
+ *   test-distribute 2000 10
+ *   test-distribute 2000 10 uniform poisson_disk
+ *   test-distribute 2000 10 uniform uniform_move
+ */
+#include "test_experiment.h"
+#include <argos3/core/simulator/simulator.h>
+#include <argos3/core/simulator/space/space.h>
+#include <argos3/core/control_interface/ci_controller.h>
+#include <argos3/core/utility/string_utilities.h>
+#include <argos3/plugins/robots/generic/control_interface/ci_differential_steering_actuator.h>
+#include <argos3/plugins/robots/foot-bot/simulator/footbot_entity.h>
+#include <cmath>
+#include <map>
+
+using namespace argos;
+
+/****************************************/
+/****************************************/
+
+class CBenchDistributeController : public CCI_Controller {
+
+public:
+
+   virtual void Init(TConfigurationNode& t_tree) {
+      m_pcWheels = GetActuator<CCI_DifferentialSteeringActuator>("differential_steering");
+   }
+
+   virtual void ControlStep() {
+      m_pcWheels->SetLinearVelocity(10.0, 5.0);
+   }
+
+private:
+
+   CCI_DifferentialSteeringActuator* m_pcWheels;
+
+};
+
+REGISTER_CONTROLLER(CBenchDistributeController, "bench_distribute_controller");
+
+/****************************************/
+/****************************************/
+
+static const Real MIN_DISTANCE = 0.18;
+
+/****************************************/
+/****************************************/
+
+static std::string MakeExperiment(const std::string& str_method,
+                                  UInt32 un_robots,
+                                  Real f_density) {
+   std::string strMethod = str_method;
+   std::string strMoveOnRetry = "false";
+   if(strMethod.size() > 5 && strMethod.compare(strMethod.size() - 5, 5, "_move") == 0) {
+      strMethod.erase(strMethod.size() - 5);
+      strMoveOnRetry = "true";
+   }
+   Real fSide = std::sqrt(un_robots / f_density);
+   std::string strMin = ToString(-fSide * 0.5) + "," + ToString(-fSide * 0.5) + ",0";
+   std::string strMax = ToString(fSide * 0.5) + "," + ToString(fSide * 0.5) + ",0";
+   std::string strPosition =
+      (strMethod == "poisson_disk") ?
+      "      <position method=\"poisson_disk\" min=\"" + strMin + "\" max=\"" + strMax + "\" min_distance=\"" + ToString(MIN_DISTANCE) + "\" />" :
+      "      <position method=\"" + strMethod + "\" min=\"" + strMin + "\" max=\"" + strMax + "\" />";
+   return
+      "<argos-configuration>"
+      "  <framework>"
+      "    <experiment length=\"0\" ticks_per_second=\"10\" random_seed=\"12345\" />"
+      "  </framework>"
+      "  <controllers>"
+      "    <bench_distribute_controller id=\"bench\">"
+      "      <actuators>"
+      "        <differential_steering implementation=\"default\" />"
+      "      </actuators>"
+      "      <sensors />"
+      "      <params />"
+      "    </bench_distribute_controller>"
+      "  </controllers>"
+      "  <arena size=\"" + ToString(fSide + 1) + "," + ToString(fSide + 1) + ",2\" center=\"0,0,0.75\">"
+      "    <distribute>"
+      + strPosition +
+      "      <orientation method=\"uniform\" min=\"0,0,0\" max=\"360,0,0\" />"
+      "      <entity quantity=\"" + ToString(un_robots) + "\" max_trials=\"1000\" move_on_retry=\"" + strMoveOnRetry + "\">"
+      "        <foot-bot id=\"fb\"><controller config=\"bench\" /></foot-bot>"
+      "      </entity>"
+      "    </distribute>"
+      "  </arena>"
+      "  <physics_engines>"
+      "    <dynamics2d id=\"dyn2d\" />"
+      "  </physics_engines>"
+      "  <media />"
+      "</argos-configuration>";
+}
+
+/****************************************/
+/****************************************/
+
+static std::vector<CVector3> GetPositions() {
+   std::vector<CVector3> vecPositions;
+   CSpace::TMapPerType& tRobots = CSimulator::GetInstance().GetSpace().GetEntitiesByType("foot-bot");
+   for(CSpace::TMapPerType::iterator it = tRobots.begin(); it != tRobots.end(); ++it) {
+      vecPositions.push_back(any_cast<CFootBotEntity*>(it->second)->GetEmbodiedEntity().GetOriginAnchor().Position);
+   }
+   return vecPositions;
+}
+
+/****************************************/
+/****************************************/
+
+/*
+ * Returns true if no two of the given positions are closer than the given distance.
+ */
+static bool AreApart(const std::vector<CVector3>& vec_positions,
+                     Real f_distance) {
+   for(size_t i = 0; i < vec_positions.size(); ++i) {
+      for(size_t j = i + 1; j < vec_positions.size(); ++j) {
+         if(Distance(vec_positions[i], vec_positions[j]) < f_distance) {
+            return false;
+         }
+      }
+   }
+   return true;
+}
+
+/****************************************/
+/****************************************/
+
+/*
+ * Loads the experiment with the given method and sets the checksum of the
+ * positions of the robots after loading.
+ * Returns false if the robots are misplaced, or not back at their initial
+ * positions after a reset.
+ */
+static bool RunMethod(const std::string& str_method,
+                      UInt32 un_robots,
+                      Real f_density,
+                      UInt64& un_checksum) {
+   LoadExperiment(MakeExperiment(str_method, un_robots, f_density));
+   CSimulator& cSimulator = CSimulator::GetInstance();
+   std::vector<CVector3> vecLoaded = GetPositions();
+   un_checksum = CHECKSUM_SEED;
+   for(size_t i = 0; i < vecLoaded.size(); ++i) {
+      Real pfPosition[3] = { vecLoaded[i].GetX(), vecLoaded[i].GetY(), vecLoaded[i].GetZ() };
+      AddToChecksum(un_checksum, pfPosition, sizeof(pfPosition));
+   }
+   for(UInt32 i = 0; i < 20; ++i) {
+      cSimulator.UpdateSpace();
+   }
+   cSimulator.Reset();
+   std::vector<CVector3> vecReset = GetPositions();
+   cSimulator.Destroy();
+   if(vecLoaded.size() != un_robots) {
+      std::cout << str_method << ": " << vecLoaded.size()
+                << " robots placed instead of " << un_robots
+                << std::endl;
+      return false;
+   }
+   /* The engine recomputes the poses on reset, so they match up to rounding */
+   for(size_t i = 0; i < vecLoaded.size(); ++i) {
+      if(Distance(vecLoaded[i], vecReset[i]) > 1e-9) {
+         std::cout << str_method
+                   << ": the robots are not back at their initial positions after a reset"
+                   << std::endl;
+         return false;
+      }
+   }
+   if(str_method.compare(0, 12, "poisson_disk") == 0 &&
+      !AreApart(vecLoaded, MIN_DISTANCE)) {
+      std::cout << str_method
+                << ": the robots are closer than " << MIN_DISTANCE
+                << std::endl;
+      return false;
+   }
+   return true;
+}
+
+/****************************************/
+/****************************************/
+
+int main(int n_argc, char** ppch_argv) {
+   UInt32 unRobots = (n_argc > 1) ? FromString<UInt32>(ppch_argv[1]) : 2000;
+   Real fDensity   = (n_argc > 2) ? FromString<Real>(ppch_argv[2]) : 10;
+   std::vector<std::string> vecMethods;
+   for(int i = 3; i < n_argc; ++i) {
+      vecMethods.push_back(ppch_argv[i]);
+   }
+   if(vecMethods.empty()) {
+      vecMethods = { "uniform", "uniform_move", "poisson_disk" };
+   }
+   /* The checksum of the positions placed by each method */
+   std::map<std::string, UInt64> mapChecksums;
+   for(size_t i = 0; i < vecMethods.size(); ++i) {
+      UInt64 unChecksum;
+      if(!RunInChildProcess(
+            [&vecMethods, i, unRobots, fDensity](UInt64& un_checksum) {
+               return RunMethod(vecMethods[i], unRobots, fDensity, un_checksum);
+            },
+            unChecksum)) {
+         std::cout << vecMethods[i] << ": the run failed" << std::endl;
+         return 1;
+      }
+      mapChecksums[vecMethods[i]] = unChecksum;
+   }
+   /* Moving the colliding robots must not change their positions */
+   for(std::map<std::string, UInt64>::iterator it = mapChecksums.begin(); it != mapChecksums.end(); ++it) {
+      const std::string& strMethod = it->first;
+      if(strMethod.size() > 5 && strMethod.compare(strMethod.size() - 5, 5, "_move") == 0) {
+         std::map<std::string, UInt64>::iterator itDefault =
+            mapChecksums.find(strMethod.substr(0, strMethod.size() - 5));
+         if(itDefault != mapChecksums.end() && itDefault->second != it->second) {
+            std::cout << strMethod << ": the robots are not at the positions placed by "
+                      << itDefault->first << std::endl;
+            return 1;
+         }
+      }
+   }
+   return 0;
+}
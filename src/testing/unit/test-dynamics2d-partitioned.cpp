@@ -0,0 +1,375 @@
+/**
+ * @file <argos3/testing/unit/test-dynamics2d-partitioned.cpp>
+ *
+ * Checks that the partitioned dynamics 2D engine keeps track of its entities.
+ *
+ * An arena is filled with foot-bots that wander around and avoid each other
+ * with their proximity sensors. The experiment is run with a partitioned
+ * engine that recalculates its tiles every few ticks, once for each number
+ * of partitions. Each run happens in a separate process, so that the
+ * simulator singleton starts clean. After every tick, the test fails if a
+ * foot-bot is not owned by exactly one region, if that region does not
+ * contain it, or if the regions hold more or fewer models than there are
+ * entities.
+ *
+ * A second experiment checks that a foot-bot carrying an object across the
+ * border between two tiles takes the object along, and keeps gripping it.
+ *
+ * Example:
+ *
+ *   test-dynamics2d-partitioned
+ *   test-dynamics2d-partitioned 2000 100
+ *   test-dynamics2d-partitioned 2000 100 4 16
+ */
+#include "test_experiment.h"
+#include <argos3/core/simulator/simulator.h>
+#include <argos3/core/simulator/space/space.h>
+#include <argos3/core/control_interface/ci_controller.h>
+#include <argos3/core/utility/string_utilities.h>
+#include <argos3/plugins/robots/generic/control_interface/ci_differential_steering_actuator.h>
+#include <argos3/plugins/robots/foot-bot/control_interface/ci_footbot_gripper_actuator.h>
+#include <argos3/plugins/robots/foot-bot/control_interface/ci_footbot_proximity_sensor.h>
+#include <argos3/plugins/robots/foot-bot/simulator/footbot_entity.h>
+#include <argos3/plugins/simulator/entities/gripper_equipped_entity.h>
+#include <argos3/plugins/simulator/physics_engines/dynamics2d/dynamics2d_partitioned_engine.h>
+#include <cmath>
+
+using namespace argos;
+
+/****************************************/
+/****************************************/
+
+class CBenchPartitionController : public CCI_Controller {
+
+public:
+
+   virtual void Init(TConfigurationNode& t_tree) {
+      m_pcWheels    = GetActuator<CCI_DifferentialSteeringActuator>("differential_steering");
+      m_pcProximity = GetSensor  <CCI_FootBotProximitySensor      >("footbot_proximity"    );
+   }
+
+   virtual void ControlStep() {
+      /* Obstacle avoidance */
+      const CCI_FootBotProximitySensor::TReadings& tProxReads = m_pcProximity->GetReadings();
+      CVector2 cAccumulator;
+      for(size_t i = 0; i < tProxReads.size(); ++i) {
+         cAccumulator += CVector2(tProxReads[i].Value, tProxReads[i].Angle);
+      }
+      if(cAccumulator.Length() < 0.1) {
+         m_pcWheels->SetLinearVelocity(10.0, 10.0);
+      }
+      else if(cAccumulator.Angle().GetValue() > 0.0) {
+         m_pcWheels->SetLinearVelocity(10.0, 0.0);
+      }
+      else {
+         m_pcWheels->SetLinearVelocity(0.0, 10.0);
+      }
+   }
+
+private:
+
+   CCI_DifferentialSteeringActuator* m_pcWheels;
+   CCI_FootBotProximitySensor* m_pcProximity;
+
+};
+
+REGISTER_CONTROLLER(CBenchPartitionController, "bench_partition_controller");
+
+/****************************************/
+/****************************************/
+
+/*
+ * Grips what is in front of the robot and goes straight.
+ */
+class CBenchCarryController : public CCI_Controller {
+
+public:
+
+   virtual void Init(TConfigurationNode& t_tree) {
+      m_pcWheels  = GetActuator<CCI_DifferentialSteeringActuator>("differential_steering");
+      m_pcGripper = GetActuator<CCI_FootBotGripperActuator      >("footbot_gripper"      );
+   }
+
+   virtual void ControlStep() {
+      m_pcGripper->LockPositive();
+      m_pcWheels->SetLinearVelocity(10.0, 10.0);
+   }
+
+private:
+
+   CCI_DifferentialSteeringActuator* m_pcWheels;
+   CCI_FootBotGripperActuator* m_pcGripper;
+
+};
+
+REGISTER_CONTROLLER(CBenchCarryController, "bench_carry_controller");
+
+/****************************************/
+/****************************************/
+
+static std::string MakeExperiment(UInt32 un_partitions,
+                                  UInt32 un_robots) {
+   Real fSide = Max<Real>(2.0, 0.4 * std::sqrt(static_cast<Real>(un_robots)));
+   return
+      "<argos-configuration>"
+      "  <framework>"
+      "    <experiment length=\"0\" ticks_per_second=\"10\" random_seed=\"12345\" />"
+      "  </framework>"
+      "  <controllers>"
+      "    <bench_partition_controller id=\"bench\">"
+      "      <actuators>"
+      "        <differential_steering implementation=\"default\" />"
+      "      </actuators>"
+      "      <sensors>"
+      "        <footbot_proximity implementation=\"default\" show_rays=\"false\" />"
+      "      </sensors>"
+      "      <params />"
+      "    </bench_partition_controller>"
+      "  </controllers>"
+      "  <arena size=\"" + ToString(fSide) + "," + ToString(fSide) + ",2\" center=\"0,0,0.75\">"
+      "    <box id=\"wall_north\" size=\"" + ToString(fSide) + ",0.1,0.5\" movable=\"false\">"
+      "      <body position=\"0," + ToString(fSide * 0.5 - 0.05) + ",0\" orientation=\"0,0,0\" />"
+      "    </box>"
+      "    <box id=\"wall_south\" size=\"" + ToString(fSide) + ",0.1,0.5\" movable=\"false\">"
+      "      <body position=\"0," + ToString(-fSide * 0.5 + 0.05) + ",0\" orientation=\"0,0,0\" />"
+      "    </box>"
+      "    <box id=\"wall_east\" size=\"0.1," + ToString(fSide) + ",0.5\" movable=\"false\">"
+      "      <body position=\"" + ToString(fSide * 0.5 - 0.05) + ",0,0\" orientation=\"0,0,0\" />"
+      "    </box>"
+      "    <box id=\"wall_west\" size=\"0.1," + ToString(fSide) + ",0.5\" movable=\"false\">"
+      "      <body position=\"" + ToString(-fSide * 0.5 + 0.05) + ",0,0\" orientation=\"0,0,0\" />"
+      "    </box>"
+      "    <distribute>"
+      "      <position method=\"uniform\" min=\"" + ToString(-fSide * 0.45) + "," + ToString(-fSide * 0.45) + ",0\""
+      "                max=\"" + ToString(fSide * 0.45) + "," + ToString(fSide * 0.45) + ",0\" />"
+      "      <orientation method=\"uniform\" min=\"0,0,0\" max=\"360,0,0\" />"
+      "      <entity quantity=\"" + ToString(un_robots) + "\" max_trials=\"100\">"
+      "        <foot-bot id=\"fb\"><controller config=\"bench\" /></foot-bot>"
+      "      </entity>"
+      "    </distribute>"
+      "  </arena>"
+      "  <physics_engines>"
+      "    <dynamics2d_partitioned id=\"dyn2d\" partitions=\"" + ToString(un_partitions) + "\""
+      "                            rebalance_period=\"10\" />"
+      "  </physics_engines>"
+      "  <media />"
+      "</argos-configuration>";
+}
+
+/****************************************/
+/****************************************/
+
+/*
+ * A foot-bot in the left tile, with a cylinder in its gripper. The two
+ * cylinders on the right place the border between the tiles at x=0.07.
+ */
+static std::string MakeCarryExperiment() {
+   return
+      "<argos-configuration>"
+      "  <framework>"
+      "    <experiment length=\"0\" ticks_per_second=\"10\" random_seed=\"12345\" />"
+      "  </framework>"
+      "  <controllers>"
+      "    <bench_carry_controller id=\"carry\">"
+      "      <actuators>"
+      "        <differential_steering implementation=\"default\" />"
+      "        <footbot_gripper implementation=\"default\" />"
+      "      </actuators>"
+      "      <sensors />"
+      "      <params />"
+      "    </bench_carry_controller>"
+      "  </controllers>"
+      "  <arena size=\"4,3,2\" center=\"0,0,0.75\">"
+      "    <foot-bot id=\"fb\">"
+      "      <body position=\"-0.6,0,0\" orientation=\"0,0,0\" />"
+      "      <controller config=\"carry\" />"
+      "    </foot-bot>"
+      "    <cylinder id=\"object\" radius=\"0.05\" height=\"0.1\" mass=\"0.1\" movable=\"true\">"
+      "      <body position=\"-0.469,0,0\" orientation=\"0,0,0\" />"
+      "    </cylinder>"
+      "    <cylinder id=\"north\" radius=\"0.05\" height=\"0.1\" mass=\"0.1\" movable=\"true\">"
+      "      <body position=\"0.6,1,0\" orientation=\"0,0,0\" />"
+      "    </cylinder>"
+      "    <cylinder id=\"south\" radius=\"0.05\" height=\"0.1\" mass=\"0.1\" movable=\"true\">"
+      "      <body position=\"0.6,-1,0\" orientation=\"0,0,0\" />"
+      "    </cylinder>"
+      "  </arena>"
+      "  <physics_engines>"
+      "    <dynamics2d_partitioned id=\"dyn2d\" partitions=\"2\" rebalance_period=\"0\" />"
+      "  </physics_engines>"
+      "  <media />"
+      "</argos-configuration>";
+}
+
+/****************************************/
+/****************************************/
+
+/*
+ * Returns the region that owns the given entity, or nullptr if the entity is
+ * not owned by exactly one region.
+ */
+static CDynamics2DRegionEngine* GetOwner(const std::vector<CDynamics2DRegionEngine*>& vec_regions,
+                                         const std::string& str_id) {
+   CDynamics2DRegionEngine* pcOwner = nullptr;
+   for(size_t i = 0; i < vec_regions.size(); ++i) {
+      if(vec_regions[i]->GetPhysicsModels().Find(str_id) != nullptr) {
+         if(pcOwner != nullptr) return nullptr;
+         pcOwner = vec_regions[i];
+      }
+   }
+   return pcOwner;
+}
+
+/****************************************/
+/****************************************/
+
+/*
+ * Returns true if each foot-bot is owned by the region that contains it, and
+ * if the regions hold one model per foot-bot plus one per wall and region.
+ */
+static bool CheckOwnership(UInt32 un_tick) {
+   CSimulator& cSimulator = CSimulator::GetInstance();
+   const std::vector<CDynamics2DRegionEngine*>& vecRegions =
+      dynamic_cast<CDynamics2DPartitionedEngine&>(cSimulator.GetPhysicsEngine("dyn2d")).GetRegions();
+   CSpace::TMapPerType& tFootBots = cSimulator.GetSpace().GetEntitiesByType("foot-bot");
+   for(CSpace::TMapPerType::iterator it = tFootBots.begin(); it != tFootBots.end(); ++it) {
+      CEmbodiedEntity& cBody = any_cast<CFootBotEntity*>(it->second)->GetEmbodiedEntity();
+      UInt32 unOwners = 0;
+      CDynamics2DRegionEngine* pcOwner = nullptr;
+      for(size_t i = 0; i < vecRegions.size(); ++i) {
+         if(vecRegions[i]->GetPhysicsModels().Find(it->first) != nullptr) {
+            ++unOwners;
+            pcOwner = vecRegions[i];
+         }
+      }
+      if(unOwners != 1) {
+         std::cout << "Tick " << un_tick << ": \"" << it->first << "\" is owned by "
+                   << unOwners << " regions" << std::endl;
+         return false;
+      }
+      if(!pcOwner->IsPointContained(cBody.GetOriginAnchor().Position)) {
+         std::cout << "Tick " << un_tick << ": \"" << it->first << "\" is at "
+                   << cBody.GetOriginAnchor().Position << ", outside the region \""
+                   << pcOwner->GetId() << "\" that owns it" << std::endl;
+         return false;
+      }
+      if(cBody.GetPhysicsModelsNum() != 1 ||
+         &cBody.GetPhysicsModel(0).GetEngine() != pcOwner) {
+         std::cout << "Tick " << un_tick << ": the body of \"" << it->first
+                   << "\" does not point to the model of the region that owns it" << std::endl;
+         return false;
+      }
+   }
+   size_t unModels = 0;
+   for(size_t i = 0; i < vecRegions.size(); ++i) {
+      unModels += vecRegions[i]->GetNumPhysicsModels();
+   }
+   size_t unExpected = tFootBots.size() + 4 * vecRegions.size();
+   if(unModels != unExpected) {
+      std::cout << "Tick " << un_tick << ": the regions hold " << unModels
+                << " models instead of " << unExpected << std::endl;
+      return false;
+   }
+   return true;
+}
+
+/****************************************/
+/****************************************/
+
+/*
+ * Runs the experiment with the given number of partitions in a separate
+ * process. Returns false if a check failed.
+ */
+static bool Run(UInt32 un_partitions,
+                UInt32 un_robots,
+                UInt32 un_ticks) {
+   return RunInChildProcess(
+      [un_partitions, un_robots, un_ticks]() {
+         LoadExperiment(MakeExperiment(un_partitions, un_robots));
+         CSimulator& cSimulator = CSimulator::GetInstance();
+         size_t unRobots = cSimulator.GetSpace().GetEntitiesByType("foot-bot").size();
+         bool bOK = CheckOwnership(0);
+         for(UInt32 i = 1; bOK && i <= un_ticks; ++i) {
+            cSimulator.UpdateSpace();
+            bOK = CheckOwnership(i);
+         }
+         if(bOK && cSimulator.GetSpace().GetEntitiesByType("foot-bot").size() != unRobots) {
+            std::cout << "The space lost foot-bots" << std::endl;
+            bOK = false;
+         }
+         cSimulator.Destroy();
+         return bOK;
+      });
+}
+
+/****************************************/
+/****************************************/
+
+/*
+ * Runs the carry experiment in a separate process. Returns false if the
+ * foot-bot and the cylinder end up in different regions, if the foot-bot
+ * does not grip the cylinder or loses it, or if the foot-bot does not reach
+ * the other tile.
+ */
+static bool RunCarry(UInt32 un_ticks) {
+   return RunInChildProcess(
+      [un_ticks]() {
+         LoadExperiment(MakeCarryExperiment());
+         CSimulator& cSimulator = CSimulator::GetInstance();
+         const std::vector<CDynamics2DRegionEngine*>& vecRegions =
+            dynamic_cast<CDynamics2DPartitionedEngine&>(cSimulator.GetPhysicsEngine("dyn2d")).GetRegions();
+         CFootBotEntity& cFootBot = dynamic_cast<CFootBotEntity&>(cSimulator.GetSpace().GetEntity("fb"));
+         CGripperEquippedEntity& cGripper = cFootBot.GetGripperEquippedEntity();
+         CDynamics2DRegionEngine* pcFirstOwner = GetOwner(vecRegions, "fb");
+         bool bGripped = false;
+         bool bOK = true;
+         for(UInt32 i = 1; bOK && i <= un_ticks; ++i) {
+            cSimulator.UpdateSpace();
+            CDynamics2DRegionEngine* pcOwner = GetOwner(vecRegions, "fb");
+            if(pcOwner == nullptr ||
+               pcOwner != GetOwner(vecRegions, "object") ||
+               !pcOwner->IsPointContained(cFootBot.GetEmbodiedEntity().GetOriginAnchor().Position)) {
+               std::cout << "Tick " << i << ": the foot-bot and the cylinder are not owned by the region of the foot-bot" << std::endl;
+               bOK = false;
+            }
+            else if(cGripper.IsGripping() &&
+                    cGripper.GetGrippedEntity().GetRootEntity().GetId() == "object") {
+               bGripped = true;
+            }
+            else if(bGripped) {
+               std::cout << "Tick " << i << ": the foot-bot lost the cylinder" << std::endl;
+               bOK = false;
+            }
+         }
+         if(bOK && !bGripped) {
+            std::cout << "The foot-bot never gripped the cylinder" << std::endl;
+            bOK = false;
+         }
+         if(bOK && GetOwner(vecRegions, "fb") == pcFirstOwner) {
+            std::cout << "The foot-bot did not change region" << std::endl;
+            bOK = false;
+         }
+         cSimulator.Destroy();
+         return bOK;
+      });
+}
+
+/****************************************/
+/****************************************/
+
+int main(int n_argc, char** ppch_argv) {
+   UInt32 unRobots = (n_argc > 1) ? FromString<UInt32>(ppch_argv[1]) : 500;
+   UInt32 unTicks  = (n_argc > 2) ? FromString<UInt32>(ppch_argv[2]) : 100;
+   std::vector<UInt32> vecPartitions;
+   for(int i = 3; i < n_argc; ++i) {
+      vecPartitions.push_back(FromString<UInt32>(ppch_argv[i]));
+   }
+   if(vecPartitions.empty()) {
+      vecPartitions = { 1, 2, 4, 8 };
+   }
+   for(size_t i = 0; i < vecPartitions.size(); ++i) {
+      if(!Run(vecPartitions[i], unRobots, unTicks)) return 1;
+   }
+   if(!RunCarry(150)) return 1;
+   return 0;
+}
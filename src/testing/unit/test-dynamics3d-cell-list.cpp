@@ -0,0 +1,123 @@
+/**
+ * @file <argos3/testing/unit/test-dynamics3d-cell-list.cpp>
+ *
+ * Checks the cell list of the magnetism plugin of the dynamics 3D engine
+ * against a search of all the pairs.
+ *
+ * For a number of rounds, random dipoles are placed in a cluster, some of
+ * them on the borders of the cells and some of them so far away that their
+ * cells are clamped. For each dipole, the neighbours returned by the cell list
+ * that are within the maximum distance are compared with the dipoles within
+ * the maximum distance found by checking all the pairs.
+ *
+ * The test fails if the two searches find different pairs, or if the cell
+ * list does not return the neighbours in ascending order.
+ *
+ * Example:
+ *
+ *   test-dynamics3d-cell-list
+ *   test-dynamics3d-cell-list 5000 20
+ */
+#include <argos3/plugins/simulator/physics_engines/dynamics3d/dynamics3d_cell_list.h>
+#include <argos3/core/utility/logging/argos_log.h>
+#include <argos3/core/utility/math/rng.h>
+#include <argos3/core/utility/string_utilities.h>
+#include <algorithm>
+#include <vector>
+
+using namespace argos;
+
+/****************************************/
+/****************************************/
+
+static const btScalar MAX_DISTANCE = 0.04;
+
+/****************************************/
+/****************************************/
+
+static btVector3 MakeDipole(CRandom::CRNG& c_rng,
+                            const CRange<Real>& c_range) {
+   Real fChoice = c_rng.Uniform(CRange<Real>(0.0, 1.0));
+   btVector3 cPosition(c_rng.Uniform(c_range),
+                       c_rng.Uniform(c_range),
+                       c_rng.Uniform(CRange<Real>(0.0, 0.1)));
+   if(fChoice < 0.1) {
+      /* On the border of a cell */
+      cPosition.setX(std::floor(cPosition.getX() / MAX_DISTANCE) * MAX_DISTANCE);
+   }
+   else if(fChoice < 0.15) {
+      /* Far away, in a clamped cell, with a few dipoles close to each other */
+      cPosition += btVector3(1e12, -1e12, 0.0);
+   }
+   return cPosition;
+}
+
+/****************************************/
+/****************************************/
+
+/*
+ * Returns true if the cell list finds the same pairs as the search of all
+ * the pairs, in every round.
+ */
+static bool Compare(UInt32 un_dipoles,
+                    UInt32 un_rounds) {
+   CRandom::CRNG* pcRNG = CRandom::CreateRNG("testing");
+   /* About ten dipoles within the maximum distance of each other */
+   Real fSide = MAX_DISTANCE * Sqrt(static_cast<Real>(un_dipoles) / 10.0);
+   CRange<Real> cRange(-fSide / 2.0, fSide / 2.0);
+   CDynamics3DCellList cCells;
+   std::vector<btVector3> vecDipoles(un_dipoles);
+   std::vector<UInt32> vecNeighbours, vecExpected;
+   for(UInt32 r = 0; r < un_rounds; ++r) {
+      for(UInt32 i = 0; i < un_dipoles; ++i) {
+         vecDipoles[i] = MakeDipole(*pcRNG, cRange);
+      }
+      cCells.Build(vecDipoles, MAX_DISTANCE);
+      for(UInt32 i = 0; i < un_dipoles; ++i) {
+         /* All the pairs */
+         vecExpected.clear();
+         for(UInt32 j = i + 1; j < un_dipoles; ++j) {
+            if(vecDipoles[i].distance(vecDipoles[j]) <= MAX_DISTANCE) {
+               vecExpected.push_back(j);
+            }
+         }
+         /* The cell list */
+         cCells.GetNeighbours(i, vecNeighbours);
+         if(!std::is_sorted(vecNeighbours.begin(), vecNeighbours.end())) {
+            LOGERR << "Round " << r
+                   << ": the neighbours of dipole " << i
+                   << " are not sorted"
+                   << std::endl;
+            return false;
+         }
+         vecNeighbours.erase(
+            std::remove_if(vecNeighbours.begin(), vecNeighbours.end(),
+                           [&vecDipoles, i](UInt32 un_dipole) {
+                              return vecDipoles[i].distance(vecDipoles[un_dipole]) > MAX_DISTANCE;
+                           }),
+            vecNeighbours.end());
+         if(vecNeighbours != vecExpected) {
+            LOGERR << "Round " << r
+                   << ": the cell list finds " << vecNeighbours.size()
+                   << " neighbours of dipole " << i
+                   << " instead of " << vecExpected.size()
+                   << std::endl;
+            return false;
+         }
+      }
+   }
+   return true;
+}
+
+/****************************************/
+/****************************************/
+
+int main(int n_argc, char** ppch_argv) {
+   UInt32 unDipoles = (n_argc > 1) ? FromString<UInt32>(ppch_argv[1]) : 2000;
+   UInt32 unRounds  = (n_argc > 2) ? FromString<UInt32>(ppch_argv[2]) : 20;
+   CRandom::CreateCategory("testing", 12345);
+   bool bOK = Compare(unDipoles, unRounds);
+   CRandom::RemoveCategory("testing");
+   LOGERR.Flush();
+   return bOK ? 0 : 1;
+}
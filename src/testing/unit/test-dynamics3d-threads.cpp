@@ -0,0 +1,122 @@
+/**
+ * @file <argos3/testing/unit/test-dynamics3d-threads.cpp>
+ *
+ * Compares the dynamics 3D engine running with different numbers of threads.
+ *
+ * An arena is filled with prototype modules that carry a magnet, so that they
+ * pull each other into clusters. The experiment is run once for each number
+ * of threads given to the engine. Each run happens in a separate process, so
+ * that the simulator singleton starts clean. The test fails if the final poses
+ * of the modules differ from those of the first run.
+ *
+ * Example:
+ *
+ *   test-dynamics3d-threads
+ *   test-dynamics3d-threads 400 100
+ *   test-dynamics3d-threads 400 100 0 2 4
+ */
+#include "test_experiment.h"
+#include <argos3/core/simulator/simulator.h>
+#include <argos3/core/utility/string_utilities.h>
+#include <cmath>
+
+using namespace argos;
+
+/****************************************/
+/****************************************/
+
+static std::string MakeExperiment(UInt32 un_threads,
+                                  UInt32 un_modules) {
+   UInt32 unSide = static_cast<UInt32>(std::ceil(std::sqrt(static_cast<Real>(un_modules))));
+   Real fArena = 0.05 * unSide + 0.2;
+   return
+      "<argos-configuration>"
+      "  <framework>"
+      "    <experiment length=\"0\" ticks_per_second=\"25\" random_seed=\"12345\" />"
+      "  </framework>"
+      "  <controllers />"
+      "  <arena size=\"" + ToString(fArena) + "," + ToString(fArena) + ",0.5\" center=\"0,0,0.25\">"
+      "    <distribute>"
+      "      <position method=\"grid\" center=\"0,0,0\" distances=\"0.05,0.05,0\""
+      "                layout=\"" + ToString(unSide) + "," + ToString(unSide) + ",1\" />"
+      "      <orientation method=\"uniform\" min=\"0,0,0\" max=\"360,0,0\" />"
+      "      <entity quantity=\"" + ToString(un_modules) + "\" max_trials=\"1\">"
+      "        <prototype id=\"module\" movable=\"true\">"
+      "          <links ref=\"base\">"
+      "            <link id=\"base\" geometry=\"box\" size=\".03,.03,.03\" mass=\"0.15\""
+      "                  position=\"0,0,0\" orientation=\"0,0,0\" />"
+      "          </links>"
+      "          <devices>"
+      "            <magnets>"
+      "              <magnet id=\"magnet\" passive_field=\"-1000,0,0\" anchor=\"base\" offset=\"0,0,.015\" />"
+      "            </magnets>"
+      "          </devices>"
+      "        </prototype>"
+      "      </entity>"
+      "    </distribute>"
+      "  </arena>"
+      "  <physics_engines>"
+      "    <dynamics3d id=\"dyn3d\" iterations=\"10\" default_friction=\"0.25\""
+      "                threads=\"" + ToString(un_threads) + "\">"
+      "      <gravity g=\"9.8\" />"
+      "      <floor />"
+      "      <magnetism max_distance=\"0.08\" />"
+      "    </dynamics3d>"
+      "  </physics_engines>"
+      "  <media />"
+      "</argos-configuration>";
+}
+
+/****************************************/
+/****************************************/
+
+/*
+ * Runs the experiment with the given number of threads in a separate process,
+ * and returns the checksum of the final poses. Returns false if the run failed.
+ */
+static bool Run(UInt32 un_threads,
+                UInt32 un_modules,
+                UInt32 un_ticks,
+                UInt64& un_checksum) {
+   return RunInChildProcess(
+      [un_threads, un_modules, un_ticks](UInt64& un_result) {
+         LoadExperiment(MakeExperiment(un_threads, un_modules));
+         CSimulator& cSimulator = CSimulator::GetInstance();
+         for(UInt32 i = 0; i < un_ticks; ++i) {
+            cSimulator.UpdateSpace();
+         }
+         un_result = ComputePoseChecksum("prototype");
+         cSimulator.Destroy();
+         return true;
+      },
+      un_checksum);
+}
+
+/****************************************/
+/****************************************/
+
+int main(int n_argc, char** ppch_argv) {
+   UInt32 unModules = (n_argc > 1) ? FromString<UInt32>(ppch_argv[1]) : 400;
+   UInt32 unTicks   = (n_argc > 2) ? FromString<UInt32>(ppch_argv[2]) : 100;
+   std::vector<UInt32> vecThreads;
+   for(int i = 3; i < n_argc; ++i) {
+      vecThreads.push_back(FromString<UInt32>(ppch_argv[i]));
+   }
+   if(vecThreads.empty()) {
+      vecThreads = { 0, 2, 4, 8 };
+   }
+   UInt64 unReference = 0;
+   for(size_t i = 0; i < vecThreads.size(); ++i) {
+      UInt64 unChecksum;
+      if(!Run(vecThreads[i], unModules, unTicks, unChecksum)) return 1;
+      if(i == 0) {
+         unReference = unChecksum;
+      }
+      else if(unChecksum != unReference) {
+         std::cout << "The runs with " << vecThreads[0] << " and " << vecThreads[i]
+                   << " threads produced different results" << std::endl;
+         return 1;
+      }
+   }
+   return 0;
+}
@@ -0,0 +1,328 @@
+/**
+ * @file <argos3/testing/unit/test-entity-pool.cpp>
+ *
+ * Checks the spawning and removal of foot-bots while an experiment is
+ * running, with and without entity pools.
+ *
+ * The arena is filled with foot-bots equipped with LEDs, a range-and-bearing
+ * system and proximity sensors. Then, at every tick, random robots are removed
+ * and new ones are spawned elsewhere. In mode 'new', the robots are created
+ * and destroyed with CLoopFunctions::AddEntity() and RemoveEntity(). In mode
+ * 'pool', they go through CLoopFunctions::SpawnFromPool() and ReturnToPool().
+ * Each mode runs in a separate process, so that the simulator singleton
+ * starts clean.
+ *
+ * The controllers count their steps. After the run, the test fails if the
+ * step count or the id of a controller do not match its robot, which would
+ * mean that a spawned robot was not reset or not stepped. In mode 'pool', it
+ * also fails if a robot is reused for a configuration that differs from the
+ * one it was created with, or if a robot that fails to spawn does not stay
+ * in the pool with its id and initial pose.
+ *
+ * Example:
+ *
+ *   test-entity-pool
+ *   test-entity-pool 500 100 20
+ *   test-entity-pool 500 100 20 pool
+ */
+#include "test_experiment.h"
+#include <argos3/core/simulator/simulator.h>
+#include <argos3/core/simulator/space/space.h>
+#include <argos3/core/simulator/loop_functions.h>
+#include <argos3/core/control_interface/ci_controller.h>
+#include <argos3/core/utility/math/rng.h>
+#include <argos3/core/utility/string_utilities.h>
+#include <argos3/plugins/robots/foot-bot/simulator/footbot_entity.h>
+#include <cmath>
+
+using namespace argos;
+
+/****************************************/
+/****************************************/
+
+class CBenchPoolController : public CCI_Controller {
+
+public:
+
+   virtual void Init(TConfigurationNode& t_tree) {
+      m_unSteps = 0;
+   }
+
+   virtual void Reset() {
+      m_unSteps = 0;
+   }
+
+   virtual void ControlStep() {
+      ++m_unSteps;
+   }
+
+   UInt32 GetSteps() const {
+      return m_unSteps;
+   }
+
+private:
+
+   UInt32 m_unSteps;
+
+};
+
+REGISTER_CONTROLLER(CBenchPoolController, "bench_pool_controller");
+
+/****************************************/
+/****************************************/
+
+static std::string MakeExperiment(Real f_side) {
+   return
+      "<argos-configuration>"
+      "  <framework>"
+      "    <experiment length=\"0\" ticks_per_second=\"10\" random_seed=\"12345\" />"
+      "  </framework>"
+      "  <controllers>"
+      "    <bench_pool_controller id=\"bench\">"
+      "      <actuators>"
+      "        <differential_steering implementation=\"default\" />"
+      "        <leds implementation=\"default\" medium=\"leds\" />"
+      "        <range_and_bearing implementation=\"default\" />"
+      "      </actuators>"
+      "      <sensors>"
+      "        <footbot_proximity implementation=\"default\" show_rays=\"false\" />"
+      "        <range_and_bearing implementation=\"medium\" medium=\"rab\" show_rays=\"false\" />"
+      "      </sensors>"
+      "      <params />"
+      "    </bench_pool_controller>"
+      "  </controllers>"
+      "  <arena size=\"" + ToString(f_side + 1) + "," + ToString(f_side + 1) + ",2\" center=\"0,0,0.75\" />"
+      "  <physics_engines>"
+      "    <dynamics2d id=\"dyn2d\" />"
+      "  </physics_engines>"
+      "  <media>"
+      "    <led id=\"leds\" />"
+      "    <range_and_bearing id=\"rab\" />"
+      "  </media>"
+      "</argos-configuration>";
+}
+
+/****************************************/
+/****************************************/
+
+/*
+ * Writes the id and a random position in the configuration of a foot-bot.
+ */
+static void SetRobotConfiguration(ticpp::Element& t_robot,
+                                  UInt32 un_id,
+                                  Real f_side,
+                                  CRandom::CRNG& c_rng) {
+   CRange<Real> cRange(-f_side * 0.5, f_side * 0.5);
+   t_robot.SetAttribute("id", "fb" + ToString(un_id));
+   t_robot.FirstChildElement("body")->SetAttribute(
+      "position",
+      ToString(c_rng.Uniform(cRange)) + "," + ToString(c_rng.Uniform(cRange)) + ",0");
+}
+
+/****************************************/
+/****************************************/
+
+struct SRobot {
+   CFootBotEntity* Entity;
+   UInt32 SpawnTick;
+};
+
+/****************************************/
+/****************************************/
+
+/*
+ * Checks that every controller was reset when its robot was spawned and
+ * stepped at every tick since.
+ */
+static bool CheckControllers(const std::vector<SRobot>& vec_robots,
+                             UInt32 un_tick) {
+   for(size_t i = 0; i < vec_robots.size(); ++i) {
+      CCI_Controller& cController = vec_robots[i].Entity->GetControllableEntity().GetController();
+      if(cController.GetId() != vec_robots[i].Entity->GetId()) {
+         std::cout << "Robot \"" << vec_robots[i].Entity->GetId()
+                   << "\" has the controller of \"" << cController.GetId() << "\"" << std::endl;
+         return false;
+      }
+      UInt32 unSteps = dynamic_cast<CBenchPoolController&>(cController).GetSteps();
+      if(unSteps != un_tick - vec_robots[i].SpawnTick) {
+         std::cout << "Robot \"" << vec_robots[i].Entity->GetId() << "\" made " << unSteps
+                   << " steps instead of " << (un_tick - vec_robots[i].SpawnTick) << std::endl;
+         return false;
+      }
+   }
+   return true;
+}
+
+/****************************************/
+/****************************************/
+
+/*
+ * Checks that a pooled robot is reused only for its own configuration.
+ */
+static bool CheckPoolConfigurations(CLoopFunctions& c_loop_functions,
+                                    ticpp::Element& t_robot,
+                                    SRobot& s_robot) {
+   CEntity* pcPooled = s_robot.Entity;
+   c_loop_functions.ReturnToPool(*pcPooled);
+   /* Another range-and-bearing range, this must be a new robot */
+   t_robot.SetAttribute("id", "fb_other");
+   t_robot.SetAttribute("rab_range", "1.5");
+   CEntity& cOther = c_loop_functions.SpawnFromPool("foot-bot", t_robot);
+   t_robot.RemoveAttribute("rab_range");
+   if(&cOther == pcPooled) {
+      std::cout << "A pooled robot was reused for another configuration" << std::endl;
+      return false;
+   }
+   /* The same configuration, this must be the pooled robot */
+   t_robot.SetAttribute("id", "fb_same");
+   CEntity& cSame = c_loop_functions.SpawnFromPool("foot-bot", t_robot);
+   if(&cSame != pcPooled) {
+      std::cout << "A pooled robot was not reused for its own configuration" << std::endl;
+      return false;
+   }
+   s_robot.Entity = &dynamic_cast<CFootBotEntity&>(cSame);
+   return true;
+}
+
+/****************************************/
+/****************************************/
+
+/*
+ * Checks that a pooled robot that fails to spawn stays in the pool as it was.
+ * The spawn fails because the id is taken by another robot.
+ */
+static bool CheckFailedSpawn(CLoopFunctions& c_loop_functions,
+                             ticpp::Element& t_robot,
+                             SRobot& s_robot,
+                             const SRobot& s_other) {
+   CFootBotEntity* pcPooled = s_robot.Entity;
+   std::string strPooledId = pcPooled->GetId();
+   CVector3 cPooledPosition = pcPooled->GetEmbodiedEntity().GetInitOriginPosition();
+   c_loop_functions.ReturnToPool(*pcPooled);
+   size_t unPoolSize = CSimulator::GetInstance().GetSpace().GetPoolSize("foot-bot");
+   t_robot.SetAttribute("id", s_other.Entity->GetId());
+   t_robot.FirstChildElement("body")->SetAttribute("position", "0.5,0.5,0");
+   bool bThrown = false;
+   try {
+      c_loop_functions.SpawnFromPool("foot-bot", t_robot);
+   }
+   catch(CARGoSException& ex) {
+      bThrown = true;
+   }
+   if(!bThrown) {
+      std::cout << "A robot was spawned with the id of another robot" << std::endl;
+      return false;
+   }
+   if(CSimulator::GetInstance().GetSpace().GetPoolSize("foot-bot") != unPoolSize) {
+      std::cout << "A robot that failed to spawn left the pool" << std::endl;
+      return false;
+   }
+   if(pcPooled->GetId() != strPooledId) {
+      std::cout << "A robot that failed to spawn is called \"" << pcPooled->GetId()
+                << "\" instead of \"" << strPooledId << "\"" << std::endl;
+      return false;
+   }
+   if(pcPooled->GetEmbodiedEntity().GetInitOriginPosition() != cPooledPosition) {
+      std::cout << "A robot that failed to spawn starts at "
+                << pcPooled->GetEmbodiedEntity().GetInitOriginPosition()
+                << " instead of " << cPooledPosition << std::endl;
+      return false;
+   }
+   /* Spawn it again, for the next checks */
+   t_robot.SetAttribute("id", "fb_back");
+   s_robot.Entity = &dynamic_cast<CFootBotEntity&>(c_loop_functions.SpawnFromPool("foot-bot", t_robot));
+   if(s_robot.Entity != pcPooled) {
+      std::cout << "A robot that failed to spawn was not reused" << std::endl;
+      return false;
+   }
+   return true;
+}
+
+/****************************************/
+/****************************************/
+
+static bool RunMode(const std::string& str_mode,
+                    UInt32 un_robots,
+                    UInt32 un_ticks,
+                    UInt32 un_per_tick) {
+   Real fSide = std::sqrt(un_robots / 2.0);
+   LoadExperiment(MakeExperiment(fSide));
+   CSimulator& cSimulator = CSimulator::GetInstance();
+   CLoopFunctions& cLoopFunctions = cSimulator.GetLoopFunctions();
+   CRandom::CRNG* pcRNG = CRandom::CreateRNG("argos");
+   bool bPool = (str_mode == "pool");
+   /* The configuration of the robots */
+   ticpp::Document tRobotDoc;
+   tRobotDoc.Parse("<foot-bot id=\"fb\"><body position=\"0,0,0\" orientation=\"0,0,0\" />"
+                   "<controller config=\"bench\" /></foot-bot>");
+   ticpp::Element& tRobot = *tRobotDoc.FirstChildElement();
+   /* Fill the arena */
+   UInt32 unNextId = 0;
+   std::vector<SRobot> vecRobots;
+   for(UInt32 i = 0; i < un_robots; ++i) {
+      SetRobotConfiguration(tRobot, unNextId++, fSide, *pcRNG);
+      SRobot sRobot;
+      sRobot.Entity = &dynamic_cast<CFootBotEntity&>(cLoopFunctions.SpawnFromPool("foot-bot", tRobot));
+      sRobot.SpawnTick = 0;
+      vecRobots.push_back(sRobot);
+   }
+   /* Replace random robots at every tick */
+   for(UInt32 t = 0; t < un_ticks; ++t) {
+      for(UInt32 i = 0; i < un_per_tick; ++i) {
+         SRobot& sRobot = vecRobots[pcRNG->Uniform(CRange<UInt32>(0, vecRobots.size()))];
+         SetRobotConfiguration(tRobot, unNextId++, fSide, *pcRNG);
+         if(bPool) {
+            cLoopFunctions.ReturnToPool(*sRobot.Entity);
+            sRobot.Entity = &dynamic_cast<CFootBotEntity&>(cLoopFunctions.SpawnFromPool("foot-bot", tRobot));
+         }
+         else {
+            cLoopFunctions.RemoveEntity(*sRobot.Entity);
+            sRobot.Entity = new CFootBotEntity;
+            sRobot.Entity->Init(tRobot);
+            cLoopFunctions.AddEntity(*sRobot.Entity);
+         }
+         sRobot.SpawnTick = t;
+      }
+      cSimulator.UpdateSpace();
+   }
+   bool bOK = CheckControllers(vecRobots, un_ticks);
+   if(bOK && cSimulator.GetSpace().GetEntitiesByType("foot-bot").size() != un_robots) {
+      std::cout << "The space has " << cSimulator.GetSpace().GetEntitiesByType("foot-bot").size()
+                << " robots instead of " << un_robots << std::endl;
+      bOK = false;
+   }
+   if(bOK && bPool && un_robots > 1) {
+      bOK = CheckFailedSpawn(cLoopFunctions, tRobot, vecRobots[0], vecRobots[1]);
+   }
+   if(bOK && bPool) {
+      bOK = CheckPoolConfigurations(cLoopFunctions, tRobot, vecRobots[0]);
+   }
+   cSimulator.Destroy();
+   return bOK;
+}
+
+/****************************************/
+/****************************************/
+
+int main(int n_argc, char** ppch_argv) {
+   UInt32 unRobots  = (n_argc > 1) ? FromString<UInt32>(ppch_argv[1]) : 500;
+   UInt32 unTicks   = (n_argc > 2) ? FromString<UInt32>(ppch_argv[2]) : 100;
+   UInt32 unPerTick = (n_argc > 3) ? FromString<UInt32>(ppch_argv[3]) : 20;
+   std::vector<std::string> vecModes;
+   for(int i = 4; i < n_argc; ++i) {
+      vecModes.push_back(ppch_argv[i]);
+   }
+   if(vecModes.empty()) {
+      vecModes = { "new", "pool" };
+   }
+   for(size_t i = 0; i < vecModes.size(); ++i) {
+      if(!RunInChildProcess(
+            [&vecModes, i, unRobots, unTicks, unPerTick]() {
+               return RunMode(vecModes[i], unRobots, unTicks, unPerTick);
+            })) {
+         std::cout << "The run in mode '" << vecModes[i] << "' failed" << std::endl;
+         return 1;
+      }
+   }
+   return 0;
+}
@@ -0,0 +1,313 @@
+/**
+ * @file <argos3/testing/unit/test-flat-grid.cpp>
+ *
+ * Checks that the flat grid returns the same entities as the grid for all
+ * the positional index queries, and compares the cost of an update followed
+ * by a box query around each entity, which is what the sensors do at every
+ * step. Also checks that an update split in stages gives the same cells as
+ * a plain update.
+ */
+#include <argos3/core/simulator/entity/positional_entity.h>
+#include <argos3/core/simulator/space/positional_indices/grid.h>
+#include <argos3/core/simulator/space/positional_indices/flat_grid.h>
+#include <argos3/core/utility/math/rng.h>
+#include <sys/time.h>
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+using namespace argos;
+
+/****************************************/
+/****************************************/
+
+template<class GRID>
+class CTestGridUpdater : public CPositionalIndex<CPositionalEntity>::COperation {
+
+public:
+
+   CTestGridUpdater(GRID& c_grid) : m_cGrid(c_grid) {}
+
+   virtual bool operator()(CPositionalEntity& c_entity) {
+      m_cGrid.PositionToCell(m_nI, m_nJ, m_nK, c_entity.GetPosition());
+      m_cGrid.UpdateCell(m_nI, m_nJ, m_nK, c_entity);
+      return true;
+   }
+
+private:
+
+   GRID& m_cGrid;
+   SInt32 m_nI, m_nJ, m_nK;
+
+};
+
+/****************************************/
+/****************************************/
+
+class CTestFlatGridStageUpdater : public CPositionalIndex<CPositionalEntity>::COperation {
+
+public:
+
+   CTestFlatGridStageUpdater(CFlatGrid<CPositionalEntity>& c_grid,
+                             size_t un_stage) :
+      m_cGrid(c_grid),
+      m_unStage(un_stage) {}
+
+   virtual bool operator()(CPositionalEntity& c_entity) {
+      m_cGrid.PositionToCell(m_nI, m_nJ, m_nK, c_entity.GetPosition());
+      m_cGrid.UpdateCell(m_nI, m_nJ, m_nK, c_entity, m_unStage);
+      return true;
+   }
+
+private:
+
+   CFlatGrid<CPositionalEntity>& m_cGrid;
+   size_t m_unStage;
+   SInt32 m_nI, m_nJ, m_nK;
+
+};
+
+/****************************************/
+/****************************************/
+
+class CCollect : public CPositionalIndex<CPositionalEntity>::COperation {
+
+public:
+
+   virtual bool operator()(CPositionalEntity& c_entity) {
+      Found.push_back(c_entity.GetIndex());
+      return true;
+   }
+
+   std::vector<ssize_t> Found;
+
+};
+
+/****************************************/
+/****************************************/
+
+static Real GetTime() {
+   ::timeval tTime;
+   ::gettimeofday(&tTime, nullptr);
+   return tTime.tv_sec + tTime.tv_usec / 1e6;
+}
+
+/****************************************/
+/****************************************/
+
+static const CVector3 AREA_MIN(-5.0, -5.0, 0.0);
+static const CVector3 AREA_MAX( 5.0,  5.0, 1.0);
+
+static CRandom::CRNG* RNG = nullptr;
+
+CVector3 RandomPosition() {
+   return CVector3(RNG->Uniform(CRange<Real>(AREA_MIN.GetX(), AREA_MAX.GetX())),
+                   RNG->Uniform(CRange<Real>(AREA_MIN.GetY(), AREA_MAX.GetY())),
+                   RNG->Uniform(CRange<Real>(AREA_MIN.GetZ(), AREA_MAX.GetZ())));
+}
+
+/****************************************/
+/****************************************/
+
+/*
+ * Returns the number of queries whose results differ.
+ * The ray queries return the entities in the cells along the ray, so
+ * the order matters; for the other queries only the content does.
+ */
+UInt32 Compare(CGrid<CPositionalEntity>& c_grid,
+               CFlatGrid<CPositionalEntity>& c_flat_grid,
+               UInt32 un_queries) {
+   UInt32 unErrors = 0;
+   CCollect cGridFound, cFlatGridFound;
+#define COMPARE_QUERY(NAME, SORT, ...)                                  \
+   cGridFound.Found.clear();                                            \
+   cFlatGridFound.Found.clear();                                        \
+   c_grid.NAME(__VA_ARGS__, cGridFound);                                \
+   c_flat_grid.NAME(__VA_ARGS__, cFlatGridFound);                       \
+   if(SORT) {                                                           \
+      std::sort(cGridFound.Found.begin(), cGridFound.Found.end());      \
+      std::sort(cFlatGridFound.Found.begin(), cFlatGridFound.Found.end()); \
+   }                                                                    \
+   if(cGridFound.Found != cFlatGridFound.Found) {                       \
+      fprintf(stdout, "%s: %zu entities in grid, %zu in flat grid\n",   \
+              #NAME, cGridFound.Found.size(), cFlatGridFound.Found.size()); \
+      ++unErrors;                                                       \
+   }
+   for(UInt32 i = 0; i < un_queries; ++i) {
+      CVector3 cCenter = RandomPosition();
+      Real fRadius = RNG->Uniform(CRange<Real>(0.1, 2.0));
+      COMPARE_QUERY(ForEntitiesInSphereRange, true, cCenter, fRadius);
+      COMPARE_QUERY(ForEntitiesInBoxRange, true, cCenter, CVector3(fRadius, fRadius * 0.5, fRadius));
+      COMPARE_QUERY(ForEntitiesInCircleRange, true, cCenter, fRadius);
+      COMPARE_QUERY(ForEntitiesInRectangleRange, true, cCenter, CVector2(fRadius, fRadius * 0.5));
+      CRay3 cRay(cCenter, RandomPosition());
+      COMPARE_QUERY(ForEntitiesAlongRay, false, cRay);
+      CSet<CPositionalEntity*,SEntityComparator> cGridAt, cFlatGridAt;
+      c_grid.GetEntitiesAt(cGridAt, cCenter);
+      c_flat_grid.GetEntitiesAt(cFlatGridAt, cCenter);
+      if(cGridAt.size() != cFlatGridAt.size()) {
+         fprintf(stdout, "GetEntitiesAt: %zu entities in grid, %zu in flat grid\n",
+                 cGridAt.size(), cFlatGridAt.size());
+         ++unErrors;
+      }
+   }
+#undef COMPARE_QUERY
+   return unErrors;
+}
+
+/****************************************/
+/****************************************/
+
+/*
+ * Returns the number of cells whose content changes when the update of the
+ * flat grid is split in the given number of stages.
+ */
+UInt32 CompareStages(CFlatGrid<CPositionalEntity>& c_flat_grid,
+                     size_t un_stages) {
+   /* Take the cell contents of a plain update */
+   c_flat_grid.Update();
+   std::vector<std::vector<CPositionalEntity*> > vecCells;
+   CPositionalEntity* const* ppcEntities;
+   for(SInt32 k = 0; k < c_flat_grid.GetSizeK(); ++k) {
+      for(SInt32 j = 0; j < c_flat_grid.GetSizeJ(); ++j) {
+         for(SInt32 i = 0; i < c_flat_grid.GetSizeI(); ++i) {
+            size_t unNum = c_flat_grid.GetCellEntities(i, j, k, ppcEntities);
+            vecCells.push_back(std::vector<CPositionalEntity*>(ppcEntities, ppcEntities + unNum));
+         }
+      }
+   }
+   /* Update again in stages, running the stages in reverse order */
+   std::vector<CTestFlatGridStageUpdater*> vecUpdaters;
+   for(size_t s = 0; s < un_stages; ++s) {
+      vecUpdaters.push_back(new CTestFlatGridStageUpdater(c_flat_grid, s));
+   }
+   c_flat_grid.BeginUpdate(un_stages);
+   for(size_t s = un_stages; s > 0; --s) {
+      c_flat_grid.UpdateStage(s - 1, *vecUpdaters[s - 1]);
+   }
+   c_flat_grid.EndUpdate();
+   /* Compare */
+   UInt32 unErrors = 0;
+   size_t unCell = 0;
+   for(SInt32 k = 0; k < c_flat_grid.GetSizeK(); ++k) {
+      for(SInt32 j = 0; j < c_flat_grid.GetSizeJ(); ++j) {
+         for(SInt32 i = 0; i < c_flat_grid.GetSizeI(); ++i) {
+            size_t unNum = c_flat_grid.GetCellEntities(i, j, k, ppcEntities);
+            if(std::vector<CPositionalEntity*>(ppcEntities, ppcEntities + unNum) != vecCells[unCell]) {
+               ++unErrors;
+            }
+            ++unCell;
+         }
+      }
+   }
+   if(unErrors > 0) {
+      fprintf(stdout, "%u cells differ with %zu update stages\n", unErrors, un_stages);
+   }
+   for(size_t s = 0; s < un_stages; ++s) {
+      delete vecUpdaters[s];
+   }
+   return unErrors;
+}
+
+/****************************************/
+/****************************************/
+
+class CCount : public CPositionalIndex<CPositionalEntity>::COperation {
+
+public:
+
+   CCount() : Found(0) {}
+
+   virtual bool operator()(CPositionalEntity&) {
+      ++Found;
+      return true;
+   }
+
+   size_t Found;
+
+};
+
+/****************************************/
+/****************************************/
+
+template<class GRID>
+Real BenchmarkUpdate(GRID& c_grid,
+                     std::vector<CPositionalEntity*>& vec_entities,
+                     const CVector3& c_half_size,
+                     UInt32 un_rounds) {
+   CCount cCount;
+   Real fStart = GetTime();
+   for(UInt32 r = 0; r < un_rounds; ++r) {
+      c_grid.Update();
+      for(size_t i = 0; i < vec_entities.size(); ++i) {
+         c_grid.ForEntitiesInBoxRange(vec_entities[i]->GetPosition(), c_half_size, cCount);
+      }
+   }
+   Real fElapsed = GetTime() - fStart;
+   /* Keep the compiler from removing the queries */
+   if(cCount.Found == 0) fprintf(stdout, "no entities found\n");
+   return 1e3 * fElapsed / un_rounds;
+}
+
+/****************************************/
+/****************************************/
+
+bool Run(UInt32 un_entities, SInt32 n_cells, UInt32 un_rounds) {
+   /* Make the entities */
+   std::vector<CPositionalEntity*> vecEntities;
+   for(UInt32 i = 0; i < un_entities; ++i) {
+      vecEntities.push_back(new CPositionalEntity(nullptr, "e" + ToString(i), RandomPosition()));
+      vecEntities.back()->SetIndex(i);
+   }
+   /* Make the indices */
+   CGrid<CPositionalEntity> cGrid(AREA_MIN, AREA_MAX, n_cells, n_cells, 1);
+   CTestGridUpdater<CGrid<CPositionalEntity> > cGridUpdater(cGrid);
+   cGrid.SetUpdateEntityOperation(&cGridUpdater);
+   CFlatGrid<CPositionalEntity> cFlatGrid(AREA_MIN, AREA_MAX, n_cells, n_cells, 1);
+   CTestGridUpdater<CFlatGrid<CPositionalEntity> > cFlatGridUpdater(cFlatGrid);
+   cFlatGrid.SetUpdateEntityOperation(&cFlatGridUpdater);
+   for(UInt32 i = 0; i < un_entities; ++i) {
+      cGrid.AddEntity(*vecEntities[i]);
+      cFlatGrid.AddEntity(*vecEntities[i]);
+   }
+   /* Compare the query results, twice to check that the update works */
+   cGrid.Update();
+   cFlatGrid.Update();
+   UInt32 unErrors = Compare(cGrid, cFlatGrid, 200);
+   for(UInt32 i = 0; i < un_entities; ++i) {
+      vecEntities[i]->SetPosition(RandomPosition());
+   }
+   cGrid.Update();
+   cFlatGrid.Update();
+   unErrors += Compare(cGrid, cFlatGrid, 200);
+   unErrors += CompareStages(cFlatGrid, 3);
+   unErrors += CompareStages(cFlatGrid, 16);
+   /* Benchmark */
+   CVector3 cHalfSize((AREA_MAX - AREA_MIN) / n_cells);
+   cHalfSize.SetZ(0.0);
+   Real fGrid = BenchmarkUpdate(cGrid, vecEntities, cHalfSize, un_rounds);
+   Real fFlatGrid = BenchmarkUpdate(cFlatGrid, vecEntities, cHalfSize, un_rounds);
+   fprintf(stdout, "%6u entities, %3dx%-3d cells: grid %8.3f ms/step, flat grid %8.3f ms/step, %u mismatches\n",
+           un_entities, n_cells, n_cells, fGrid, fFlatGrid, unErrors);
+   /* Cleanup */
+   for(UInt32 i = 0; i < un_entities; ++i) {
+      delete vecEntities[i];
+   }
+   return unErrors == 0;
+}
+
+/****************************************/
+/****************************************/
+
+int main() {
+   CRandom::CreateCategory("testing", 12345);
+   RNG = CRandom::CreateRNG("testing");
+   bool bOK = true;
+   bOK &= Run(  100,  10, 100);
+   bOK &= Run( 1000,  10,  20);
+   bOK &= Run( 1000,  50,  20);
+   bOK &= Run( 5000,  50,  10);
+   bOK &= Run(20000, 100,   5);
+   CRandom::RemoveCategory("testing");
+   return bOK ? 0 : 1;
+}
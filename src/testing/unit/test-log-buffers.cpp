@@ -0,0 +1,360 @@
+/**
+ * @file <argos3/testing/unit/test-log-buffers.cpp>
+ *
+ * Measures how long threads take to write to LOG, and checks that the
+ * output keeps the order of the lines of each thread.
+ *
+ * Several threads write numbered lines to LOG while the main thread asks
+ * for flushes, as the space does at every tick. The drain thread writes the
+ * buffers to a string. In mode 'block', a thread whose buffer is full waits,
+ * and no line may be lost. In mode 'drop', the line is dropped and counted,
+ * and the written and dropped lines must add up. Each mode runs in a
+ * separate process. For each mode, the time per line is printed.
+ *
+ * Mode 'instances' creates more logs than there are fast slots, both one
+ * after the other and all alive together, and checks that each log writes
+ * only its own lines.
+ *
+ * Mode 'exits' checks the buffers of the threads that exit: the unfinished
+ * message of a thread that exited is written once and does not end up in
+ * the messages of the next thread, and a log can be destroyed before the
+ * threads that wrote to it exit.
+ *
+ * Example:
+ *
+ *   test-log-buffers
+ *   test-log-buffers 4 100000 4096
+ *   test-log-buffers 4 100000 4096 drop
+ *   test-log-buffers 4 100000 4096 instances
+ *   test-log-buffers 4 100000 4096 exits
+ */
+#include <argos3/core/utility/logging/argos_log.h>
+#include <argos3/core/utility/string_utilities.h>
+#include <argos3/core/utility/datatypes/datatypes.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <atomic>
+#include <sstream>
+
+using namespace argos;
+
+/****************************************/
+/****************************************/
+
+struct SWriter {
+   pthread_t Thread;
+   UInt32 Id;
+   UInt32 Lines;
+   Real Elapsed;
+};
+
+static std::atomic<UInt32> WRITERS_DONE(0);
+
+static void* WriteLines(void* pt_writer) {
+   SWriter& sWriter = *reinterpret_cast<SWriter*>(pt_writer);
+   ::timeval tStart, tEnd;
+   ::gettimeofday(&tStart, nullptr);
+   for(UInt32 i = 0; i < sWriter.Lines; ++i) {
+      LOG << "line " << sWriter.Id << " " << i << std::endl;
+   }
+   ::gettimeofday(&tEnd, nullptr);
+   sWriter.Elapsed =
+      (tEnd.tv_sec - tStart.tv_sec) +
+      (tEnd.tv_usec - tStart.tv_usec) / 1e6;
+   ++WRITERS_DONE;
+   return nullptr;
+}
+
+/****************************************/
+/****************************************/
+
+/*
+ * Checks that the lines of each thread are in order, and counts them.
+ */
+static bool CheckOutput(const std::string& str_output,
+                        std::vector<UInt32>& vec_counts) {
+   std::istringstream cInput(str_output);
+   std::string strLine;
+   while(std::getline(cInput, strLine)) {
+      std::vector<std::string> vecFields;
+      Tokenize(strLine, vecFields, " ");
+      if(vecFields.size() != 3 || vecFields[0] != "line") continue;
+      UInt32 unId = FromString<UInt32>(vecFields[1]);
+      UInt32 unLine = FromString<UInt32>(vecFields[2]);
+      if(unId >= vec_counts.size()) {
+         std::cout << "Unexpected line \"" << strLine << "\"" << std::endl;
+         return false;
+      }
+      if(unLine < vec_counts[unId]) {
+         std::cout << "Line " << unLine << " of thread " << unId << " is out of order" << std::endl;
+         return false;
+      }
+      vec_counts[unId] = unLine + 1;
+   }
+   return true;
+}
+
+/****************************************/
+/****************************************/
+
+static bool RunMode(const std::string& str_mode,
+                    UInt32 un_threads,
+                    UInt32 un_lines,
+                    size_t un_buffer_size) {
+   /* Write the log to a string */
+   std::ostringstream cOutput;
+   std::streambuf* pcOldStream = LOG.GetStream().rdbuf(cOutput.rdbuf());
+   LOG.DisableColoredOutput();
+   LOG.SetBufferSize(un_buffer_size);
+   LOG.SetDropOnOverflow(str_mode == "drop");
+   LOG.StartDrainThread();
+   /* Write from the threads, and ask for flushes as the space does */
+   std::vector<SWriter> vecWriters(un_threads);
+   for(UInt32 i = 0; i < un_threads; ++i) {
+      vecWriters[i].Id = i;
+      vecWriters[i].Lines = un_lines;
+      pthread_create(&vecWriters[i].Thread, nullptr, &WriteLines, &vecWriters[i]);
+   }
+   while(WRITERS_DONE < un_threads) {
+      LOG.RequestFlush();
+      ::usleep(100);
+   }
+   Real fElapsed = 0.0;
+   for(UInt32 i = 0; i < un_threads; ++i) {
+      pthread_join(vecWriters[i].Thread, nullptr);
+      fElapsed += vecWriters[i].Elapsed;
+   }
+   LOG.StopDrainThread();
+   LOG.Flush();
+   LOG.GetStream().rdbuf(pcOldStream);
+   /* Check the output */
+   std::vector<UInt32> vecCounts(un_threads, 0);
+   if(!CheckOutput(cOutput.str(), vecCounts)) return false;
+   UInt64 unWritten = 0;
+   for(UInt32 i = 0; i < un_threads; ++i) {
+      if(str_mode == "block" && vecCounts[i] != un_lines) {
+         std::cout << "Thread " << i << " wrote " << vecCounts[i] << " lines instead of " << un_lines << std::endl;
+         return false;
+      }
+      unWritten += vecCounts[i];
+   }
+   std::cout << str_mode << "\t"
+             << un_threads << " threads\t"
+             << un_buffer_size << " bytes per buffer\t"
+             << 1e9 * fElapsed / (un_threads * un_lines) << " ns per line\t"
+             << LOG.GetDroppedMessages() << " dropped"
+             << std::endl;
+   if(str_mode == "drop") {
+      /* The last written line of a thread tells how many it tried to write */
+      UInt64 unExpected = static_cast<UInt64>(un_threads) * un_lines;
+      if(unWritten > unExpected) {
+         std::cout << "More lines were written than sent" << std::endl;
+         return false;
+      }
+      std::istringstream cInput(cOutput.str());
+      std::string strLine;
+      UInt64 unLines = 0;
+      while(std::getline(cInput, strLine)) {
+         if(strLine.compare(0, 5, "line ") == 0) ++unLines;
+      }
+      if(unLines + LOG.GetDroppedMessages() != unExpected) {
+         std::cout << unLines << " lines written and " << LOG.GetDroppedMessages()
+                   << " dropped instead of " << unExpected << std::endl;
+         return false;
+      }
+   }
+   return true;
+}
+
+/****************************************/
+/****************************************/
+
+/*
+ * Writes a line to each log from the calling thread and checks what each
+ * log wrote.
+ */
+static bool CheckLogs(std::vector<CARGoSLog*>& vec_logs,
+                      std::vector<std::ostringstream*>& vec_outputs) {
+   for(size_t i = 0; i < vec_logs.size(); ++i) {
+      *vec_logs[i] << "log " << i << std::endl;
+   }
+   for(size_t i = 0; i < vec_logs.size(); ++i) {
+      vec_logs[i]->Flush();
+      std::string strExpected = "log " + ToString(i) + "\n";
+      if(vec_outputs[i]->str() != strExpected) {
+         std::cout << "Log " << i << " wrote \"" << vec_outputs[i]->str()
+                   << "\" instead of \"" << strExpected << "\"" << std::endl;
+         return false;
+      }
+   }
+   return true;
+}
+
+/****************************************/
+/****************************************/
+
+static bool RunInstances(UInt32 un_logs) {
+   /* One after the other */
+   for(UInt32 i = 0; i < un_logs; ++i) {
+      std::ostringstream cOutput;
+      CARGoSLog* pcLog = new CARGoSLog(cOutput, SLogColor(), false);
+      *pcLog << "instance " << i << std::endl;
+      pcLog->Flush();
+      delete pcLog;
+      if(cOutput.str() != "instance " + ToString(i) + "\n") {
+         std::cout << "Instance " << i << " wrote \"" << cOutput.str() << "\"" << std::endl;
+         return false;
+      }
+   }
+   /* All alive together */
+   std::vector<std::ostringstream*> vecOutputs;
+   std::vector<CARGoSLog*> vecLogs;
+   for(UInt32 i = 0; i < un_logs; ++i) {
+      vecOutputs.push_back(new std::ostringstream);
+      vecLogs.push_back(new CARGoSLog(*vecOutputs.back(), SLogColor(), false));
+   }
+   bool bOK = CheckLogs(vecLogs, vecOutputs);
+   for(UInt32 i = 0; i < un_logs; ++i) {
+      delete vecLogs[i];
+      delete vecOutputs[i];
+   }
+   std::cout << "instances\t" << un_logs << " logs" << std::endl;
+   return bOK;
+}
+
+/****************************************/
+/****************************************/
+
+struct SExitingWriter {
+   CARGoSLog* Log;
+   std::string Text;
+   /* Whether the message is ended */
+   bool End;
+   /* Set when the text is written */
+   std::atomic<bool> Written;
+   /* Set when the thread may exit */
+   std::atomic<bool> Exit;
+};
+
+static void* WriteAndExit(void* pt_writer) {
+   SExitingWriter& sWriter = *reinterpret_cast<SExitingWriter*>(pt_writer);
+   *sWriter.Log << sWriter.Text;
+   if(sWriter.End) {
+      *sWriter.Log << std::endl;
+   }
+   sWriter.Written = true;
+   while(!sWriter.Exit) {
+      ::usleep(100);
+   }
+   return nullptr;
+}
+
+/*
+ * Starts a thread that writes the given text to the given log, and waits
+ * until it is written. The thread exits right away if asked to, or once
+ * s_writer.Exit is set otherwise.
+ */
+static void StartWriter(SExitingWriter& s_writer,
+                        pthread_t& t_thread,
+                        CARGoSLog& c_log,
+                        const std::string& str_text,
+                        bool b_end,
+                        bool b_exit) {
+   s_writer.Log = &c_log;
+   s_writer.Text = str_text;
+   s_writer.End = b_end;
+   s_writer.Written = false;
+   s_writer.Exit = b_exit;
+   pthread_create(&t_thread, nullptr, &WriteAndExit, &s_writer);
+   while(!s_writer.Written) {
+      ::usleep(100);
+   }
+}
+
+/****************************************/
+/****************************************/
+
+static bool RunExits() {
+   SExitingWriter sWriter;
+   pthread_t tThread;
+   /* The unfinished message of a thread that exited */
+   std::ostringstream cOutput;
+   CARGoSLog* pcLog = new CARGoSLog(cOutput, SLogColor(), false);
+   StartWriter(sWriter, tThread, *pcLog, "unfinished", false, true);
+   pthread_join(tThread, nullptr);
+   /* The next thread takes the buffer of the thread that exited */
+   StartWriter(sWriter, tThread, *pcLog, "next", true, true);
+   pthread_join(tThread, nullptr);
+   pcLog->Flush();
+   if(cOutput.str() != "unfinishednext\n") {
+      std::cout << "The threads that exited wrote \"" << cOutput.str()
+                << "\" instead of \"unfinishednext\n\"" << std::endl;
+      delete pcLog;
+      return false;
+   }
+   delete pcLog;
+   /* A log destroyed before the thread that wrote to it */
+   std::ostringstream cEarlyOutput;
+   pcLog = new CARGoSLog(cEarlyOutput, SLogColor(), false);
+   StartWriter(sWriter, tThread, *pcLog, "early", true, false);
+   delete pcLog;
+   sWriter.Exit = true;
+   pthread_join(tThread, nullptr);
+   if(cEarlyOutput.str() != "early\n") {
+      std::cout << "The destroyed log wrote \"" << cEarlyOutput.str()
+                << "\" instead of \"early\n\"" << std::endl;
+      return false;
+   }
+   return true;
+}
+
+/****************************************/
+/****************************************/
+
+/*
+ * Runs the given mode in a separate process.
+ * Returns false if the run failed.
+ */
+bool Run(const std::string& str_mode,
+         UInt32 un_threads,
+         UInt32 un_lines,
+         size_t un_buffer_size) {
+   pid_t tPid = ::fork();
+   if(tPid == 0) {
+      bool bOK;
+      if(str_mode == "instances") {
+         bOK = RunInstances(40);
+      }
+      else if(str_mode == "exits") {
+         bOK = RunExits();
+      }
+      else {
+         bOK = RunMode(str_mode, un_threads, un_lines, un_buffer_size);
+      }
+      ::_exit(bOK ? 0 : 1);
+   }
+   int nStatus;
+   ::waitpid(tPid, &nStatus, 0);
+   return WIFEXITED(nStatus) && WEXITSTATUS(nStatus) == 0;
+}
+
+/****************************************/
+/****************************************/
+
+int main(int n_argc, char** ppch_argv) {
+   UInt32 unThreads    = (n_argc > 1) ? FromString<UInt32>(ppch_argv[1]) : 4;
+   UInt32 unLines      = (n_argc > 2) ? FromString<UInt32>(ppch_argv[2]) : 100000;
+   size_t unBufferSize = (n_argc > 3) ? FromString<size_t>(ppch_argv[3]) : 65536;
+   std::vector<std::string> vecModes;
+   for(int i = 4; i < n_argc; ++i) {
+      vecModes.push_back(ppch_argv[i]);
+   }
+   if(vecModes.empty()) {
+      vecModes = { "block", "drop", "instances", "exits" };
+   }
+   for(size_t i = 0; i < vecModes.size(); ++i) {
+      if(!Run(vecModes[i], unThreads, unLines, unBufferSize)) return 1;
+   }
+   return 0;
+}
@@ -0,0 +1,184 @@
+/**
+ * @file <argos3/testing/unit/test-parallel-init.cpp>
+ *
+ * Compares the initialization of an experiment with and without parallel
+ * initialization of the controllers.
+ *
+ * An arena is filled with foot-bots whose controllers do some work when they
+ * are initialized, to stand for the parsing of a script, draw a random bias
+ * in Init(), and then wander around with a random walk. The sensors and
+ * actuators add noise. The robots are crowded, so that <distribute> discards
+ * some of the robots it creates. The experiment is loaded once serially, and
+ * then with parallel initialization on each number of threads given. Each run
+ * happens in a separate process, so that the simulator singleton starts
+ * clean. The test fails if the poses of the robots after a few ticks differ
+ * from those of the serial run, because the random numbers must not depend
+ * on how the controllers were initialized.
+ *
+ * Example:
+ *
+ *   test-parallel-init
+ *   test-parallel-init 1000 200000
+ *   test-parallel-init 1000 200000 2 4
+ */
+#include "test_experiment.h"
+#include <argos3/core/simulator/simulator.h>
+#include <argos3/core/control_interface/ci_controller.h>
+#include <argos3/core/utility/math/rng.h>
+#include <argos3/core/utility/string_utilities.h>
+#include <argos3/plugins/robots/generic/control_interface/ci_differential_steering_actuator.h>
+#include <argos3/plugins/robots/foot-bot/control_interface/ci_footbot_proximity_sensor.h>
+#include <cmath>
+
+using namespace argos;
+
+/****************************************/
+/****************************************/
+
+class CBenchInitController : public CCI_Controller {
+
+public:
+
+   virtual void Init(TConfigurationNode& t_tree) {
+      m_pcWheels    = GetActuator<CCI_DifferentialSteeringActuator>("differential_steering");
+      m_pcProximity = GetSensor  <CCI_FootBotProximitySensor      >("footbot_proximity"    );
+      m_pcRNG = CRandom::CreateRNG("argos");
+      /* Stand for the work done to set up a controller, such as parsing a script */
+      UInt32 unWork = 0;
+      GetNodeAttributeOrDefault(t_tree, "work", unWork, unWork);
+      Real fSum = 0;
+      for(UInt32 i = 0; i < unWork; ++i) {
+         fSum += std::sin(static_cast<Real>(i));
+      }
+      /* A number drawn in Init() must not depend on the initialization either */
+      m_fBias = fSum * 1e-12 + m_pcRNG->Uniform(CRange<Real>(-1.0, 1.0));
+   }
+
+   virtual void ControlStep() {
+      /* Random walk, turning away from obstacles */
+      const CCI_FootBotProximitySensor::TReadings& tProxReads = m_pcProximity->GetReadings();
+      CVector2 cAccumulator;
+      for(size_t i = 0; i < tProxReads.size(); ++i) {
+         cAccumulator += CVector2(tProxReads[i].Value, tProxReads[i].Angle);
+      }
+      Real fTurn = m_pcRNG->Uniform(CRange<Real>(-2.0, 2.0)) + m_fBias;
+      if(cAccumulator.Length() > 0.1) {
+         fTurn += (cAccumulator.Angle().GetValue() > 0.0) ? 5.0 : -5.0;
+      }
+      m_pcWheels->SetLinearVelocity(8.0 + fTurn, 8.0 - fTurn);
+   }
+
+private:
+
+   CCI_DifferentialSteeringActuator* m_pcWheels;
+   CCI_FootBotProximitySensor* m_pcProximity;
+   CRandom::CRNG* m_pcRNG;
+   Real m_fBias;
+
+};
+
+REGISTER_CONTROLLER(CBenchInitController, "bench_init_controller");
+
+/****************************************/
+/****************************************/
+
+static std::string MakeExperiment(UInt32 un_threads,
+                                  UInt32 un_robots,
+                                  UInt32 un_work) {
+   Real fSide = std::sqrt(un_robots / 4.0);
+   std::string strSystem =
+      (un_threads == 0) ?
+      "    <system threads=\"0\" />" :
+      "    <system threads=\"" + ToString(un_threads) + "\" parallel_init=\"true\" />";
+   return
+      "<argos-configuration>"
+      "  <framework>"
+      + strSystem +
+      "    <experiment length=\"0\" ticks_per_second=\"10\" random_seed=\"12345\" />"
+      "  </framework>"
+      "  <controllers>"
+      "    <bench_init_controller id=\"bench\">"
+      "      <actuators>"
+      "        <differential_steering implementation=\"default\" noise_std_dev=\"0.1\" />"
+      "      </actuators>"
+      "      <sensors>"
+      "        <footbot_proximity implementation=\"default\" show_rays=\"false\" noise_level=\"0.05\" />"
+      "      </sensors>"
+      "      <params work=\"" + ToString(un_work) + "\" />"
+      "    </bench_init_controller>"
+      "  </controllers>"
+      "  <arena size=\"" + ToString(fSide + 1) + "," + ToString(fSide + 1) + ",2\" center=\"0,0,0.75\">"
+      "    <foot-bot id=\"solo\"><body position=\"" + ToString(fSide * 0.5 + 0.25) + ",0,0\" orientation=\"0,0,0\" />"
+      "      <controller config=\"bench\" /></foot-bot>"
+      "    <distribute>"
+      "      <position method=\"uniform\" min=\"" + ToString(-fSide * 0.5) + "," + ToString(-fSide * 0.5) + ",0\""
+      "                max=\"" + ToString(fSide * 0.5) + "," + ToString(fSide * 0.5) + ",0\" />"
+      "      <orientation method=\"uniform\" min=\"0,0,0\" max=\"360,0,0\" />"
+      "      <entity quantity=\"" + ToString(un_robots) + "\" max_trials=\"100\">"
+      "        <foot-bot id=\"fb\"><controller config=\"bench\" /></foot-bot>"
+      "      </entity>"
+      "    </distribute>"
+      "  </arena>"
+      "  <physics_engines>"
+      "    <dynamics2d id=\"dyn2d\" />"
+      "  </physics_engines>"
+      "  <media />"
+      "</argos-configuration>";
+}
+
+/****************************************/
+/****************************************/
+
+/*
+ * Runs the experiment with the given number of threads and sets the checksum
+ * of the final poses.
+ */
+static bool RunThreads(UInt32 un_threads,
+                       UInt32 un_robots,
+                       UInt32 un_work,
+                       UInt64& un_checksum) {
+   LoadExperiment(MakeExperiment(un_threads, un_robots, un_work));
+   CSimulator& cSimulator = CSimulator::GetInstance();
+   for(UInt32 i = 0; i < 50; ++i) {
+      cSimulator.UpdateSpace();
+   }
+   un_checksum = ComputePoseChecksum("foot-bot");
+   cSimulator.Destroy();
+   return true;
+}
+
+/****************************************/
+/****************************************/
+
+int main(int n_argc, char** ppch_argv) {
+   UInt32 unRobots = (n_argc > 1) ? FromString<UInt32>(ppch_argv[1]) : 1000;
+   UInt32 unWork   = (n_argc > 2) ? FromString<UInt32>(ppch_argv[2]) : 200000;
+   std::vector<UInt32> vecThreads = { 0 };
+   for(int i = 3; i < n_argc; ++i) {
+      vecThreads.push_back(FromString<UInt32>(ppch_argv[i]));
+   }
+   if(vecThreads.size() == 1) {
+      vecThreads.insert(vecThreads.end(), { 1, 2, 4 });
+   }
+   UInt64 unReference = 0;
+   for(size_t i = 0; i < vecThreads.size(); ++i) {
+      UInt64 unChecksum;
+      if(!RunInChildProcess(
+            [&vecThreads, i, unRobots, unWork](UInt64& un_checksum) {
+               return RunThreads(vecThreads[i], unRobots, unWork, un_checksum);
+            },
+            unChecksum)) {
+         std::cout << "The run on " << vecThreads[i] << " threads failed" << std::endl;
+         return 1;
+      }
+      if(i == 0) {
+         unReference = unChecksum;
+      }
+      else if(unChecksum != unReference) {
+         std::cout << "The run with parallel initialization on " << vecThreads[i]
+                   << " threads differs from the serial run" << std::endl;
+         return 1;
+      }
+   }
+   return 0;
+}
@@ -0,0 +1,242 @@
+/**
+ * @file <argos3/testing/unit/test-pointmass3d-bvh.cpp>
+ *
+ * Compares the ray query methods of the point-mass 3D engine.
+ *
+ * An arena is filled with eye-bots that wander around at the same altitude,
+ * avoiding each other with their proximity sensors and sensing a light
+ * through their light sensors. The proximity sensors cast their rays in
+ * batches, while the light sensors cast one ray at a time to check for
+ * occlusions. Each ray query method is run in a separate process, so that
+ * the simulator singleton starts clean. The test fails if the sensor
+ * readings differ between the methods.
+ *
+ * Then, with the BVH, a box and an eye-bot are moved with MoveTo() between
+ * two steps, as loop functions would. The test fails if a ray cast at the
+ * new position of either entity misses it.
+ *
+ * Example:
+ *
+ *   test-pointmass3d-bvh
+ *   test-pointmass3d-bvh 2000 50
+ */
+#include "test_experiment.h"
+#include <argos3/core/simulator/simulator.h>
+#include <argos3/core/simulator/space/space.h>
+#include <argos3/core/simulator/physics_engine/physics_engine.h>
+#include <argos3/core/control_interface/ci_controller.h>
+#include <argos3/core/utility/string_utilities.h>
+#include <argos3/plugins/simulator/entities/box_entity.h>
+#include <argos3/plugins/robots/generic/control_interface/ci_quadrotor_position_actuator.h>
+#include <argos3/plugins/robots/eye-bot/control_interface/ci_eyebot_proximity_sensor.h>
+#include <argos3/plugins/robots/eye-bot/control_interface/ci_eyebot_light_sensor.h>
+#include <argos3/plugins/robots/eye-bot/simulator/eyebot_entity.h>
+#include <cmath>
+
+/****************************************/
+/****************************************/
+
+/* Checksum of the sensor readings, the sum of the robot checksums */
+static UInt64 CHECKSUM = 0;
+
+/****************************************/
+/****************************************/
+
+class CBenchEyeBotController : public CCI_Controller {
+
+public:
+
+   virtual void Init(TConfigurationNode& t_tree) {
+      m_pcPosition  = GetActuator<CCI_QuadRotorPositionActuator>("quadrotor_position");
+      m_pcProximity = GetSensor  <CCI_EyeBotProximitySensor    >("eyebot_proximity"  );
+      m_pcLight     = GetSensor  <CCI_EyeBotLightSensor        >("eyebot_light"      );
+      m_unId = FromString<UInt32>(GetId().substr(2));
+      m_unTicks = 0;
+      m_unChecksum = CHECKSUM_SEED;
+   }
+
+   virtual void Destroy() {
+      /* The robots are destroyed by the main thread */
+      CHECKSUM += m_unChecksum;
+   }
+
+   virtual void ControlStep() {
+      /* Add the readings to the checksum */
+      const CCI_EyeBotProximitySensor::TReadings& tProxReads = m_pcProximity->GetReadings();
+      const CCI_EyeBotLightSensor::TReadings& tLightReads = m_pcLight->GetReadings();
+      AddToChecksum(m_unChecksum, &m_unId, sizeof(m_unId));
+      for(size_t i = 0; i < tProxReads.size(); ++i) {
+         AddToChecksum(m_unChecksum, &tProxReads[i].Value, sizeof(Real));
+      }
+      for(size_t i = 0; i < tLightReads.size(); ++i) {
+         AddToChecksum(m_unChecksum, &tLightReads[i].Value, sizeof(Real));
+      }
+      /* Wander along a direction that changes slowly, away from the obstacles */
+      CVector2 cAccumulator;
+      for(size_t i = 0; i < tProxReads.size(); ++i) {
+         cAccumulator += CVector2(tProxReads[i].Value, tProxReads[i].Angle);
+      }
+      CVector2 cDirection(0.1, CRadians(m_unId + 0.02 * m_unTicks));
+      cDirection -= cAccumulator;
+      m_pcPosition->SetRelativePosition(CVector3(cDirection.GetX(), cDirection.GetY(), 0.0));
+      ++m_unTicks;
+   }
+
+private:
+
+   CCI_QuadRotorPositionActuator* m_pcPosition;
+   CCI_EyeBotProximitySensor* m_pcProximity;
+   CCI_EyeBotLightSensor* m_pcLight;
+   UInt32 m_unId;
+   UInt32 m_unTicks;
+   UInt64 m_unChecksum;
+
+};
+
+REGISTER_CONTROLLER(CBenchEyeBotController, "bench_eyebot_controller");
+
+/****************************************/
+/****************************************/
+
+static std::string MakeExperiment(const std::string& str_ray_queries,
+                                  UInt32 un_robots) {
+   Real fSide = Max<Real>(4.0, 1.2 * std::sqrt(static_cast<Real>(un_robots)));
+   return
+      "<argos-configuration>"
+      "  <framework>"
+      "    <experiment length=\"0\" ticks_per_second=\"10\" random_seed=\"12345\" />"
+      "  </framework>"
+      "  <controllers>"
+      "    <bench_eyebot_controller id=\"bench\">"
+      "      <actuators>"
+      "        <quadrotor_position implementation=\"default\" />"
+      "      </actuators>"
+      "      <sensors>"
+      "        <eyebot_proximity implementation=\"default\" show_rays=\"false\" />"
+      "        <eyebot_light implementation=\"rot_z_only\" show_rays=\"false\" />"
+      "      </sensors>"
+      "      <params />"
+      "    </bench_eyebot_controller>"
+      "  </controllers>"
+      "  <arena size=\"" + ToString(fSide) + "," + ToString(fSide) + ",4\" center=\"0,0,2\">"
+      "    <light id=\"light\" position=\"0,0,3.5\" orientation=\"0,0,0\" color=\"yellow\" intensity=\"1\" medium=\"leds\" />"
+      "    <box id=\"obstacle\" size=\"0.2,0.2,0.2\" movable=\"false\">"
+      "      <body position=\"0,0,0\" orientation=\"0,0,0\" />"
+      "    </box>"
+      "    <distribute>"
+      "      <position method=\"uniform\" min=\"" + ToString(-fSide * 0.45) + "," + ToString(-fSide * 0.45) + ",1\""
+      "                max=\"" + ToString(fSide * 0.45) + "," + ToString(fSide * 0.45) + ",1\" />"
+      "      <orientation method=\"uniform\" min=\"0,0,0\" max=\"360,0,0\" />"
+      "      <entity quantity=\"" + ToString(un_robots) + "\" max_trials=\"100\">"
+      "        <eye-bot id=\"eb\"><controller config=\"bench\" /></eye-bot>"
+      "      </entity>"
+      "    </distribute>"
+      "  </arena>"
+      "  <physics_engines>"
+      "    <pointmass3d id=\"pm3d\" ray_queries=\"" + str_ray_queries + "\" />"
+      "  </physics_engines>"
+      "  <media>"
+      "    <led id=\"leds\" />"
+      "  </media>"
+      "</argos-configuration>";
+}
+
+/****************************************/
+/****************************************/
+
+/*
+ * Returns true if the methods produce the same readings.
+ */
+static bool Compare(UInt32 un_robots,
+                    UInt32 un_ticks) {
+   static const char* METHODS[] = { "linear", "bvh" };
+   UInt64 punChecksums[2];
+   for(size_t m = 0; m < 2; ++m) {
+      if(!RunInChildProcess(
+            [m, un_robots, un_ticks](UInt64& un_checksum) {
+               LoadExperiment(MakeExperiment(METHODS[m], un_robots));
+               for(UInt32 i = 0; i < un_ticks; ++i) {
+                  CSimulator::GetInstance().UpdateSpace();
+               }
+               CSimulator::GetInstance().Destroy();
+               un_checksum = CHECKSUM;
+               return true;
+            },
+            punChecksums[m])) {
+         return false;
+      }
+   }
+   if(punChecksums[0] != punChecksums[1]) {
+      std::cout << "The ray query methods produced different readings" << std::endl;
+      return false;
+   }
+   return true;
+}
+
+/****************************************/
+/****************************************/
+
+/*
+ * Moves the entity and returns true if a horizontal ray cast at its new
+ * position hits it.
+ */
+static bool MoveAndCastRay(CEmbodiedEntity& c_entity,
+                           const CVector3& c_position) {
+   if(!c_entity.MoveTo(c_position, CQuaternion())) {
+      std::cout << "Cannot move \"" << c_entity.GetRootEntity().GetId() << "\"" << std::endl;
+      return false;
+   }
+   CRay3 cRay(c_position + CVector3(-0.5, 0.0, 0.05),
+              c_position + CVector3( 0.5, 0.0, 0.05));
+   SEmbodiedEntityIntersectionItem sItem;
+   if(!GetClosestEmbodiedEntityIntersectedByRay(sItem, cRay) ||
+      sItem.IntersectedEntity != &c_entity) {
+      std::cout << "A ray cast at the new position of \""
+                << c_entity.GetRootEntity().GetId() << "\" misses it" << std::endl;
+      return false;
+   }
+   return true;
+}
+
+/****************************************/
+/****************************************/
+
+/*
+ * Returns true if the rays find the entities moved with MoveTo() between two
+ * steps, both before and after the next step.
+ */
+static bool CheckMoveTo(UInt32 un_robots) {
+   return RunInChildProcess(
+      [un_robots]() {
+         LoadExperiment(MakeExperiment("bvh", un_robots));
+         CSimulator& cSimulator = CSimulator::GetInstance();
+         for(UInt32 i = 0; i < 5; ++i) {
+            cSimulator.UpdateSpace();
+         }
+         CEmbodiedEntity& cBox =
+            dynamic_cast<CBoxEntity&>(cSimulator.GetSpace().GetEntity("obstacle")).GetEmbodiedEntity();
+         CEmbodiedEntity& cEyeBot =
+            dynamic_cast<CEyeBotEntity&>(cSimulator.GetSpace().GetEntity("eb0")).GetEmbodiedEntity();
+         /* Above the other eye-bots, away from the light */
+         bool bOK =
+            MoveAndCastRay(cBox, CVector3(1.0, 1.0, 2.5)) &&
+            MoveAndCastRay(cEyeBot, CVector3(-1.0, -1.0, 2.5));
+         if(bOK) {
+            cSimulator.UpdateSpace();
+            bOK =
+               MoveAndCastRay(cBox, CVector3(1.0, -1.0, 2.5)) &&
+               MoveAndCastRay(cEyeBot, CVector3(-1.0, 1.0, 2.5));
+         }
+         cSimulator.Destroy();
+         return bOK;
+      });
+}
+
+/****************************************/
+/****************************************/
+
+int main(int n_argc, char** ppch_argv) {
+   UInt32 unRobots = (n_argc > 1) ? FromString<UInt32>(ppch_argv[1]) : 300;
+   UInt32 unTicks  = (n_argc > 2) ? FromString<UInt32>(ppch_argv[2]) : 30;
+   return (Compare(unRobots, unTicks) && CheckMoveTo(unRobots)) ? 0 : 1;
+}
@@ -0,0 +1,311 @@
+/**
+ * @file <argos3/testing/unit/test-rab-routing.cpp>
+ *
+ * Compares the routing methods of the range-and-bearing medium.
+ *
+ * A walled arena is filled with foot-bots that wander around and broadcast
+ * their id over the range-and-bearing system. Each routing method is run in a
+ * separate process, so that the simulator singleton starts clean. For each
+ * method, the throughput (ticks/s) is printed along with a checksum of all
+ * the messages received, in the order each robot received them. The test
+ * fails if the checksums differ. The checksum does not depend on the number
+ * of threads, so runs with different thread counts can be compared too.
+ * With the cells method, some robots are then removed, and the test fails if
+ * the other robots do not keep their senders.
+ *
+ * Example:
+ *
+ *   test-rab-routing 500 200
+ *   test-rab-routing 2000 100 false
+ *   test-rab-routing 2000 100 true 4
+ */
+#include <argos3/core/simulator/simulator.h>
+#include <argos3/core/control_interface/ci_controller.h>
+#include <argos3/core/utility/plugins/dynamic_loading.h>
+#include <argos3/core/utility/string_utilities.h>
+#include <argos3/plugins/robots/generic/control_interface/ci_differential_steering_actuator.h>
+#include <argos3/plugins/robots/generic/control_interface/ci_range_and_bearing_actuator.h>
+#include <argos3/plugins/robots/generic/control_interface/ci_range_and_bearing_sensor.h>
+#include <argos3/plugins/robots/foot-bot/control_interface/ci_footbot_proximity_sensor.h>
+#include <argos3/plugins/robots/foot-bot/simulator/footbot_entity.h>
+#include <argos3/plugins/simulator/media/rab_medium.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <cmath>
+#include <cstring>
+
+using namespace argos;
+
+/****************************************/
+/****************************************/
+
+/* Checksum of the received messages, the sum of the robot checksums */
+static UInt64 CHECKSUM = 0;
+
+static void AddToChecksum(UInt64& un_checksum,
+                          const void* pt_data,
+                          size_t un_size) {
+   const UInt8* punData = static_cast<const UInt8*>(pt_data);
+   for(size_t i = 0; i < un_size; ++i) {
+      un_checksum = (un_checksum ^ punData[i]) * 1099511628211ULL;
+   }
+}
+
+/****************************************/
+/****************************************/
+
+class CBenchRABController : public CCI_Controller {
+
+public:
+
+   virtual void Init(TConfigurationNode& t_tree) {
+      m_pcWheels    = GetActuator<CCI_DifferentialSteeringActuator>("differential_steering");
+      m_pcRABAct    = GetActuator<CCI_RangeAndBearingActuator     >("range_and_bearing"    );
+      m_pcRABSens   = GetSensor  <CCI_RangeAndBearingSensor       >("range_and_bearing"    );
+      m_pcProximity = GetSensor  <CCI_FootBotProximitySensor      >("footbot_proximity"    );
+      m_unId = FromString<UInt32>(GetId().substr(2));
+      m_unChecksum = 14695981039346656037ULL;
+   }
+
+   virtual void Destroy() {
+      /* The robots are destroyed by the main thread */
+      CHECKSUM += m_unChecksum;
+   }
+
+   virtual void ControlStep() {
+      /* Broadcast the id */
+      m_pcRABAct->SetData(0, m_unId & 0xFF);
+      m_pcRABAct->SetData(1, (m_unId >> 8) & 0xFF);
+      /* Add the received messages to the checksum */
+      const CCI_RangeAndBearingSensor::TReadings& tRABReads = m_pcRABSens->GetReadings();
+      AddToChecksum(m_unChecksum, &m_unId, sizeof(m_unId));
+      for(size_t i = 0; i < tRABReads.size(); ++i) {
+         AddToChecksum(m_unChecksum, &tRABReads[i].Range, sizeof(Real));
+         AddToChecksum(m_unChecksum, tRABReads[i].Data.ToCArray(), 2);
+      }
+      /* Obstacle avoidance */
+      const CCI_FootBotProximitySensor::TReadings& tProxReads = m_pcProximity->GetReadings();
+      CVector2 cAccumulator;
+      for(size_t i = 0; i < tProxReads.size(); ++i) {
+         cAccumulator += CVector2(tProxReads[i].Value, tProxReads[i].Angle);
+      }
+      if(cAccumulator.Length() < 0.1) {
+         m_pcWheels->SetLinearVelocity(10.0, 10.0);
+      }
+      else if(cAccumulator.Angle().GetValue() > 0.0) {
+         m_pcWheels->SetLinearVelocity(10.0, 0.0);
+      }
+      else {
+         m_pcWheels->SetLinearVelocity(0.0, 10.0);
+      }
+   }
+
+private:
+
+   CCI_DifferentialSteeringActuator* m_pcWheels;
+   CCI_RangeAndBearingActuator* m_pcRABAct;
+   CCI_RangeAndBearingSensor* m_pcRABSens;
+   CCI_FootBotProximitySensor* m_pcProximity;
+   UInt32 m_unId;
+   UInt64 m_unChecksum;
+
+};
+
+REGISTER_CONTROLLER(CBenchRABController, "bench_rab_controller");
+
+/****************************************/
+/****************************************/
+
+static std::string MakeExperiment(const std::string& str_routing,
+                                  UInt32 un_robots,
+                                  const std::string& str_occlusions,
+                                  UInt32 un_threads) {
+   Real fSide = Max<Real>(2.0, 0.5 * std::sqrt(static_cast<Real>(un_robots)));
+   /* The robots are kept in the arena by walls, 10 cm thick */
+   std::string strHalf = ToString(fSide * 0.5 - 0.05);
+   std::string strPlace = ToString(fSide * 0.5 - 0.2);
+   std::string strWalls =
+      "    <box id=\"wall_north\" size=\"" + ToString(fSide) + ",0.1,0.5\" movable=\"false\">"
+      "      <body position=\"0," + strHalf + ",0\" orientation=\"0,0,0\" />"
+      "    </box>"
+      "    <box id=\"wall_south\" size=\"" + ToString(fSide) + ",0.1,0.5\" movable=\"false\">"
+      "      <body position=\"0,-" + strHalf + ",0\" orientation=\"0,0,0\" />"
+      "    </box>"
+      "    <box id=\"wall_east\" size=\"0.1," + ToString(fSide) + ",0.5\" movable=\"false\">"
+      "      <body position=\"" + strHalf + ",0,0\" orientation=\"0,0,0\" />"
+      "    </box>"
+      "    <box id=\"wall_west\" size=\"0.1," + ToString(fSide) + ",0.5\" movable=\"false\">"
+      "      <body position=\"-" + strHalf + ",0,0\" orientation=\"0,0,0\" />"
+      "    </box>";
+   return
+      "<argos-configuration>"
+      "  <framework>"
+      "    <system threads=\"" + ToString(un_threads) + "\" />"
+      "    <experiment length=\"0\" ticks_per_second=\"10\" random_seed=\"12345\" />"
+      "  </framework>"
+      "  <controllers>"
+      "    <bench_rab_controller id=\"bench\">"
+      "      <actuators>"
+      "        <differential_steering implementation=\"default\" />"
+      "        <range_and_bearing implementation=\"default\" />"
+      "      </actuators>"
+      "      <sensors>"
+      "        <footbot_proximity implementation=\"default\" show_rays=\"false\" />"
+      "        <range_and_bearing implementation=\"medium\" medium=\"rab\" show_rays=\"false\" />"
+      "      </sensors>"
+      "      <params />"
+      "    </bench_rab_controller>"
+      "  </controllers>"
+      "  <arena size=\"" + ToString(fSide) + "," + ToString(fSide) + ",2\" center=\"0,0,0.75\">"
+      + strWalls +
+      "    <distribute>"
+      "      <position method=\"uniform\" min=\"-" + strPlace + ",-" + strPlace + ",0\""
+      "                max=\"" + strPlace + "," + strPlace + ",0\" />"
+      "      <orientation method=\"uniform\" min=\"0,0,0\" max=\"360,0,0\" />"
+      "      <entity quantity=\"" + ToString(un_robots) + "\" max_trials=\"100\">"
+      "        <foot-bot id=\"fb\" rab_range=\"1.5\"><controller config=\"bench\" /></foot-bot>"
+      "      </entity>"
+      "    </distribute>"
+      "  </arena>"
+      "  <physics_engines>"
+      "    <dynamics2d id=\"dyn2d\" />"
+      "  </physics_engines>"
+      "  <media>"
+      "    <range_and_bearing id=\"rab\" routing=\"" + str_routing + "\""
+      "                       check_occlusions=\"" + str_occlusions + "\" />"
+      "  </media>"
+      "</argos-configuration>";
+}
+
+/****************************************/
+/****************************************/
+
+/*
+ * Removes some of the robots, one at a time, and checks that the other
+ * robots keep the senders found by the last update, without the removed
+ * robot.
+ */
+static void CheckRemovals() {
+   CSpace& cSpace = CSimulator::GetInstance().GetSpace();
+   CRABMedium& cMedium = CSimulator::GetInstance().GetMedium<CRABMedium>("rab");
+   std::vector<CFootBotEntity*> vecRobots;
+   CSpace::TMapPerType& tRobots = cSpace.GetEntitiesByType("foot-bot");
+   for(CSpace::TMapPerType::iterator it = tRobots.begin(); it != tRobots.end(); ++it) {
+      vecRobots.push_back(any_cast<CFootBotEntity*>(it->second));
+   }
+   for(size_t r = 0; r < vecRobots.size(); r += 7) {
+      /* Take the senders of the other robots, without the removed one */
+      CRABEquippedEntity* pcRemoved = &vecRobots[r]->GetRABEquippedEntity();
+      std::vector<std::vector<CRABEquippedEntity*> > vecExpected(vecRobots.size());
+      for(size_t i = 0; i < vecRobots.size(); ++i) {
+         if(vecRobots[i] == nullptr || i == r) continue;
+         CRABMedium::SRABView sView = cMedium.GetRABViewCommunicatingWith(vecRobots[i]->GetRABEquippedEntity());
+         for(CRABMedium::SRABView::const_iterator it = sView.begin(); it != sView.end(); ++it) {
+            if(*it != pcRemoved) vecExpected[i].push_back(*it);
+         }
+      }
+      CallEntityOperation<CSpaceOperationRemoveEntity, CSpace, void>(cSpace, *vecRobots[r]);
+      vecRobots[r] = nullptr;
+      for(size_t i = 0; i < vecRobots.size(); ++i) {
+         if(vecRobots[i] == nullptr) continue;
+         CRABMedium::SRABView sView = cMedium.GetRABViewCommunicatingWith(vecRobots[i]->GetRABEquippedEntity());
+         if(!std::equal(sView.begin(), sView.end(), vecExpected[i].begin()) ||
+            sView.size() != vecExpected[i].size()) {
+            THROW_ARGOSEXCEPTION("Robot \"" << vecRobots[i]->GetId() << "\" has wrong senders after a removal");
+         }
+      }
+   }
+}
+
+/****************************************/
+/****************************************/
+
+Real RunMethod(const std::string& str_routing,
+               UInt32 un_robots,
+               UInt32 un_ticks,
+               const std::string& str_occlusions,
+               UInt32 un_threads) {
+   ticpp::Document tDoc;
+   tDoc.Parse(MakeExperiment(str_routing, un_robots, str_occlusions, un_threads));
+   CSimulator& cSimulator = CSimulator::GetInstance();
+   cSimulator.Load(tDoc);
+   ::timeval tStart, tEnd;
+   ::gettimeofday(&tStart, nullptr);
+   for(UInt32 i = 0; i < un_ticks; ++i) {
+      cSimulator.UpdateSpace();
+   }
+   ::gettimeofday(&tEnd, nullptr);
+   /* The pairs method keeps the removed robot among the senders */
+   if(str_routing == "cells") {
+      CheckRemovals();
+   }
+   cSimulator.Destroy();
+   Real fElapsed =
+      (tEnd.tv_sec - tStart.tv_sec) +
+      (tEnd.tv_usec - tStart.tv_usec) / 1e6;
+   return un_ticks / fElapsed;
+}
+
+/****************************************/
+/****************************************/
+
+int main(int n_argc, char** ppch_argv) {
+   UInt32 unRobots = (n_argc > 1) ? FromString<UInt32>(ppch_argv[1]) : 300;
+   UInt32 unTicks  = (n_argc > 2) ? FromString<UInt32>(ppch_argv[2]) : 50;
+   std::string strOcclusions = (n_argc > 3) ? ppch_argv[3] : "true";
+   UInt32 unThreads = (n_argc > 4) ? FromString<UInt32>(ppch_argv[4]) : 0;
+   static const char* METHODS[] = { "pairs", "cells" };
+   UInt64 punChecksums[2];
+   for(size_t m = 0; m < 2; ++m) {
+      /* Run each method in its own process, and get the checksum back through a pipe */
+      int pnPipe[2];
+      if(::pipe(pnPipe) != 0) {
+         LOGERR << "Cannot create pipe: " << ::strerror(errno) << std::endl;
+         LOGERR.Flush();
+         return 1;
+      }
+      pid_t tPid = ::fork();
+      if(tPid == 0) {
+         ::close(pnPipe[0]);
+         try {
+            LOG.DisableColoredOutput();
+            LOGERR.DisableColoredOutput();
+            CDynamicLoading::LoadAllLibraries();
+            Real fTicksPerSec = RunMethod(METHODS[m], unRobots, unTicks, strOcclusions, unThreads);
+            std::cout << METHODS[m] << "\t"
+                      << unThreads << " threads\t"
+                      << unRobots << " robots\t"
+                      << fTicksPerSec << " ticks/s\t"
+                      << "checksum " << CHECKSUM
+                      << std::endl;
+            if(::write(pnPipe[1], &CHECKSUM, sizeof(CHECKSUM)) != sizeof(CHECKSUM)) {
+               ::_exit(1);
+            }
+         }
+         catch(std::exception& ex) {
+            LOGERR << ex.what() << std::endl;
+            LOGERR.Flush();
+            ::_exit(1);
+         }
+         LOG.Flush();
+         LOGERR.Flush();
+         ::_exit(0);
+      }
+      ::close(pnPipe[1]);
+      if(::read(pnPipe[0], &punChecksums[m], sizeof(UInt64)) != sizeof(UInt64)) {
+         punChecksums[m] = m;
+      }
+      ::close(pnPipe[0]);
+      int nStatus;
+      ::waitpid(tPid, &nStatus, 0);
+      if(!WIFEXITED(nStatus) || WEXITSTATUS(nStatus) != 0) {
+         return 1;
+      }
+   }
+   if(punChecksums[0] != punChecksums[1]) {
+      std::cout << "The routing methods received different messages" << std::endl;
+      return 1;
+   }
+   return 0;
+}
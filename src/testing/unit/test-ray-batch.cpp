@@ -0,0 +1,221 @@
+/**
+ * @file <argos3/testing/unit/test-ray-batch.cpp>
+ *
+ * Compares the batched and closest-hit ray queries of the physics engines
+ * with the ray-by-ray queries.
+ *
+ * An arena is filled with boxes and cylinders, managed in turn by each of
+ * the dynamics2d, dynamics3d and pointmass3d engines. Then, rings of rays
+ * like those of the foot-bot proximity sensor are cast at random positions,
+ * once with CPhysicsEngine::CheckIntersectionWithRays() of the engine, once
+ * with CPhysicsEngine::CheckClosestIntersectionWithRay() of the engine for
+ * each ray, and once with the default implementation, which collects all the
+ * intersections of one ray at a time. The test fails if the closest
+ * intersections differ. The time per ring is printed for the three methods.
+ * Each engine runs in a separate process, so that the simulator singleton
+ * starts clean.
+ *
+ * Example:
+ *
+ *   test-ray-batch 200 10000
+ */
+#include <argos3/core/simulator/simulator.h>
+#include <argos3/core/simulator/physics_engine/physics_engine.h>
+#include <argos3/core/simulator/entity/embodied_entity.h>
+#include <argos3/core/utility/plugins/dynamic_loading.h>
+#include <argos3/core/utility/string_utilities.h>
+#include <argos3/plugins/simulator/entities/box_entity.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <cmath>
+
+using namespace argos;
+
+/****************************************/
+/****************************************/
+
+static Real GetTime() {
+   ::timeval tTime;
+   ::gettimeofday(&tTime, nullptr);
+   return tTime.tv_sec + tTime.tv_usec / 1e6;
+}
+
+/****************************************/
+/****************************************/
+
+static std::string MakeExperiment(const std::string& str_engine,
+                                  UInt32 un_objects) {
+   Real fSide = Max<Real>(2.0, 0.3 * std::sqrt(static_cast<Real>(un_objects)));
+   return
+      "<argos-configuration>"
+      "  <framework>"
+      "    <experiment length=\"0\" ticks_per_second=\"10\" random_seed=\"12345\" />"
+      "  </framework>"
+      "  <controllers />"
+      "  <arena size=\"" + ToString(fSide) + "," + ToString(fSide) + ",2\" center=\"0,0,0.75\">"
+      "    <distribute>"
+      "      <position method=\"uniform\" min=\"" + ToString(-fSide * 0.45) + "," + ToString(-fSide * 0.45) + ",0\""
+      "                max=\"" + ToString(fSide * 0.45) + "," + ToString(fSide * 0.45) + ",0\" />"
+      "      <orientation method=\"uniform\" min=\"0,0,0\" max=\"360,0,0\" />"
+      "      <entity quantity=\"" + ToString(un_objects / 2) + "\" max_trials=\"100\">"
+      "        <box id=\"box\" size=\"0.2,0.1,0.15\" movable=\"false\" />"
+      "      </entity>"
+      "    </distribute>"
+      "    <distribute>"
+      "      <position method=\"uniform\" min=\"" + ToString(-fSide * 0.45) + "," + ToString(-fSide * 0.45) + ",0\""
+      "                max=\"" + ToString(fSide * 0.45) + "," + ToString(fSide * 0.45) + ",0\" />"
+      "      <orientation method=\"constant\" values=\"0,0,0\" />"
+      "      <entity quantity=\"" + ToString(un_objects - un_objects / 2) + "\" max_trials=\"100\">"
+      "        <cylinder id=\"cyl\" radius=\"0.05\" height=\"0.1\" movable=\"true\" mass=\"1\" />"
+      "      </entity>"
+      "    </distribute>"
+      "  </arena>"
+      "  <physics_engines>"
+      "    <" + str_engine + " id=\"engine\" />"
+      "  </physics_engines>"
+      "  <media />"
+      "</argos-configuration>";
+}
+
+/****************************************/
+/****************************************/
+
+/*
+ * Fills the vector with a ring of 24 rays, like those of the foot-bot
+ * proximity sensor, at a random position and height.
+ */
+static void MakeRing(std::vector<CRay3>& vec_rays,
+                     CRandom::CRNG* pc_rng,
+                     Real f_side) {
+   CRange<Real> cPosRange(-f_side * 0.5, f_side * 0.5);
+   CVector3 cCenter(pc_rng->Uniform(cPosRange),
+                    pc_rng->Uniform(cPosRange),
+                    pc_rng->Uniform(CRange<Real>(0.0, 0.3)));
+   Real fSlope = pc_rng->Uniform(CRange<Real>(-0.05, 0.05));
+   vec_rays.resize(24);
+   for(size_t i = 0; i < vec_rays.size(); ++i) {
+      CVector3 cDirection(0.1, 0.0, fSlope);
+      cDirection.RotateZ(CRadians::TWO_PI * i / vec_rays.size());
+      CVector3 cStart(0.085, 0.0, 0.0);
+      cStart.RotateZ(CRadians::TWO_PI * i / vec_rays.size());
+      cStart += cCenter;
+      vec_rays[i].Set(cStart, cStart + cDirection);
+   }
+}
+
+/****************************************/
+/****************************************/
+
+/*
+ * Returns the number of rings whose intersections differ.
+ */
+UInt32 RunEngine(const std::string& str_engine,
+                 UInt32 un_objects,
+                 UInt32 un_rings) {
+   ticpp::Document tDoc;
+   tDoc.Parse(MakeExperiment(str_engine, un_objects));
+   CSimulator& cSimulator = CSimulator::GetInstance();
+   cSimulator.Load(tDoc);
+   /* Make sure the engine is up to date */
+   cSimulator.UpdateSpace();
+   CPhysicsEngine& cEngine = cSimulator.GetPhysicsEngine("engine");
+   Real fSide = cSimulator.GetSpace().GetArenaSize().GetX();
+   /* The entity to exclude, as a sensor would exclude its robot */
+   CEmbodiedEntity* pcExcluded =
+      &dynamic_cast<CBoxEntity&>(cSimulator.GetSpace().GetEntity("box0")).GetEmbodiedEntity();
+   /* Generate the rings in advance, so that both methods get the same */
+   CRandom::CreateCategory("testing", 12345);
+   CRandom::CRNG* pcRNG = CRandom::CreateRNG("testing");
+   std::vector<std::vector<CRay3> > vecRings(un_rings);
+   for(UInt32 i = 0; i < un_rings; ++i) {
+      MakeRing(vecRings[i], pcRNG, fSide);
+   }
+   /* Batched queries */
+   std::vector<TEmbodiedEntityIntersectionData> vecBatched(un_rings);
+   Real fStart = GetTime();
+   for(UInt32 i = 0; i < un_rings; ++i) {
+      vecBatched[i].assign(vecRings[i].size(), SEmbodiedEntityIntersectionItem());
+      cEngine.CheckIntersectionWithRays(vecBatched[i], vecRings[i], pcExcluded);
+   }
+   Real fBatched = GetTime() - fStart;
+   /* Closest-hit queries */
+   std::vector<TEmbodiedEntityIntersectionData> vecClosest(un_rings);
+   fStart = GetTime();
+   for(UInt32 i = 0; i < un_rings; ++i) {
+      vecClosest[i].assign(vecRings[i].size(), SEmbodiedEntityIntersectionItem());
+      for(size_t j = 0; j < vecRings[i].size(); ++j) {
+         cEngine.CheckClosestIntersectionWithRay(vecClosest[i][j], vecRings[i][j], pcExcluded);
+      }
+   }
+   Real fClosest = GetTime() - fStart;
+   /* Ray-by-ray queries */
+   std::vector<TEmbodiedEntityIntersectionData> vecSingle(un_rings);
+   fStart = GetTime();
+   for(UInt32 i = 0; i < un_rings; ++i) {
+      vecSingle[i].assign(vecRings[i].size(), SEmbodiedEntityIntersectionItem());
+      cEngine.CPhysicsEngine::CheckIntersectionWithRays(vecSingle[i], vecRings[i], pcExcluded);
+   }
+   Real fSingle = GetTime() - fStart;
+   /* Compare the results */
+   UInt32 unMismatches = 0, unHits = 0;
+   for(UInt32 i = 0; i < un_rings; ++i) {
+      bool bMismatch = false;
+      for(size_t j = 0; j < vecBatched[i].size(); ++j) {
+         if(vecSingle[i][j].IntersectedEntity != nullptr) ++unHits;
+         if(vecBatched[i][j].IntersectedEntity != vecSingle[i][j].IntersectedEntity ||
+            Abs(vecBatched[i][j].TOnRay - vecSingle[i][j].TOnRay) > 1e-6 ||
+            vecClosest[i][j].IntersectedEntity != vecSingle[i][j].IntersectedEntity ||
+            Abs(vecClosest[i][j].TOnRay - vecSingle[i][j].TOnRay) > 1e-6) {
+            bMismatch = true;
+         }
+      }
+      if(bMismatch) ++unMismatches;
+   }
+   std::cout << str_engine << "\t"
+             << un_objects << " objects\t"
+             << unHits << " hits\t"
+             << "batched " << 1e6 * fBatched / un_rings << " us/ring\t"
+             << "closest " << 1e6 * fClosest / un_rings << " us/ring\t"
+             << "single " << 1e6 * fSingle / un_rings << " us/ring\t"
+             << unMismatches << " mismatches"
+             << std::endl;
+   CRandom::RemoveCategory("testing");
+   cSimulator.Destroy();
+   return unMismatches;
+}
+
+/****************************************/
+/****************************************/
+
+int main(int n_argc, char** ppch_argv) {
+   UInt32 unObjects = (n_argc > 1) ? FromString<UInt32>(ppch_argv[1]) : 200;
+   UInt32 unRings   = (n_argc > 2) ? FromString<UInt32>(ppch_argv[2]) : 10000;
+   static const char* ENGINES[] = { "dynamics2d", "dynamics3d", "pointmass3d" };
+   int nResult = 0;
+   for(size_t e = 0; e < sizeof(ENGINES) / sizeof(ENGINES[0]); ++e) {
+      /* Run each engine in its own process */
+      pid_t tPid = ::fork();
+      if(tPid == 0) {
+         UInt32 unMismatches = 1;
+         try {
+            LOG.DisableColoredOutput();
+            LOGERR.DisableColoredOutput();
+            CDynamicLoading::LoadAllLibraries();
+            unMismatches = RunEngine(ENGINES[e], unObjects, unRings);
+         }
+         catch(std::exception& ex) {
+            LOGERR << ex.what() << std::endl;
+         }
+         LOG.Flush();
+         LOGERR.Flush();
+         ::_exit(unMismatches == 0 ? 0 : 1);
+      }
+      int nStatus;
+      ::waitpid(tPid, &nStatus, 0);
+      if(!WIFEXITED(nStatus) || WEXITSTATUS(nStatus) != 0) {
+         nResult = 1;
+      }
+   }
+   return nResult;
+}
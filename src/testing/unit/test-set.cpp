@@ -0,0 +1,218 @@
+/**
+ * @file <argos3/testing/unit/test-set.cpp>
+ *
+ * Checks CSet against std::set and measures the cost of filling, iterating
+ * and clearing a set at typical neighbourhood sizes.
+ *
+ * For comparison, the same operations are measured on a sorted doubly-linked
+ * list with one node per element, which is how CSet used to be implemented.
+ */
+#include <argos3/core/utility/datatypes/set.h>
+#include <argos3/core/utility/math/rng.h>
+#include <sys/time.h>
+#include <algorithm>
+#include <cstdio>
+#include <set>
+#include <vector>
+
+using namespace argos;
+
+/****************************************/
+/****************************************/
+
+/*
+ * The previous CSet, reduced to the operations measured here.
+ */
+template <class T>
+class CListSet {
+
+public:
+
+   struct SElement {
+      T Data;
+      SElement* Previous;
+      SElement* Next;
+
+      SElement(const T& t_data, SElement* ps_prev, SElement* ps_next) :
+         Data(t_data), Previous(ps_prev), Next(ps_next) {}
+   };
+
+public:
+
+   CListSet() : m_psFirst(nullptr), m_psLast(nullptr), m_unSize(0) {}
+
+   ~CListSet() { clear(); }
+
+   void insert(const T& t_element) {
+      SElement* psNext = m_psFirst;
+      while(psNext != nullptr && psNext->Data < t_element) {
+         psNext = psNext->Next;
+      }
+      if(psNext != nullptr && psNext->Data == t_element) return;
+      SElement* psPrev = (psNext != nullptr) ? psNext->Previous : m_psLast;
+      SElement* psNew = new SElement(t_element, psPrev, psNext);
+      if(psPrev != nullptr) psPrev->Next = psNew; else m_psFirst = psNew;
+      if(psNext != nullptr) psNext->Previous = psNew; else m_psLast = psNew;
+      ++m_unSize;
+   }
+
+   void clear() {
+      while(m_psFirst != nullptr) {
+         SElement* psNext = m_psFirst->Next;
+         delete m_psFirst;
+         m_psFirst = psNext;
+      }
+      m_psLast = nullptr;
+      m_unSize = 0;
+   }
+
+   size_t size() const { return m_unSize; }
+
+   SElement* m_psFirst;
+   SElement* m_psLast;
+   size_t m_unSize;
+
+};
+
+/****************************************/
+/****************************************/
+
+static Real GetTime() {
+   ::timeval tTime;
+   ::gettimeofday(&tTime, nullptr);
+   return tTime.tv_sec + tTime.tv_usec / 1e6;
+}
+
+/****************************************/
+/****************************************/
+
+/*
+ * Returns true if CSet behaves like std::set on random inserts and erases.
+ */
+bool Check(CRandom::CRNG* pc_rng) {
+   static int pnObjects[300];
+   CSet<int*> cSet;
+   std::set<int*> cReference;
+   CRange<UInt32> cRange(0, 300);
+   for(UInt32 i = 0; i < 5000; ++i) {
+      int* pnObject = pnObjects + pc_rng->Uniform(cRange);
+      if(pc_rng->Bernoulli(0.7)) {
+         cSet.insert(pnObject);
+         cReference.insert(pnObject);
+      }
+      else {
+         cSet.erase(pnObject);
+         cReference.erase(pnObject);
+      }
+      if(cSet.size() != cReference.size() ||
+         !std::equal(cReference.begin(), cReference.end(), cSet.begin())) {
+         fprintf(stdout, "Mismatch after %u operations\n", i + 1);
+         return false;
+      }
+   }
+   /* Copies and moves */
+   CSet<int*> cCopy(cSet);
+   CSet<int*> cMoved(std::move(cCopy));
+   if(cCopy.size() != 0 ||
+      cMoved.size() != cReference.size() ||
+      !std::equal(cReference.begin(), cReference.end(), cMoved.begin())) {
+      fprintf(stdout, "Mismatch after copy and move\n");
+      return false;
+   }
+   return true;
+}
+
+/****************************************/
+/****************************************/
+
+void Benchmark(UInt32 un_size, UInt32 un_rounds, CRandom::CRNG* pc_rng) {
+   /* Elements in random order, like the neighbours returned by a query */
+   std::vector<int> vecObjects(un_size);
+   std::vector<int*> vecElements(un_size);
+   for(UInt32 i = 0; i < un_size; ++i) {
+      vecElements[i] = &vecObjects[i];
+   }
+   for(UInt32 i = un_size; i > 1; --i) {
+      std::swap(vecElements[i-1], vecElements[pc_rng->Uniform(CRange<UInt32>(0, i))]);
+   }
+   size_t unSum = 0;
+   /* CSet */
+   CSet<int*> cSet;
+   Real fStart = GetTime();
+   for(UInt32 r = 0; r < un_rounds; ++r) {
+      for(UInt32 i = 0; i < un_size; ++i) {
+         cSet.insert(vecElements[i]);
+      }
+   }
+   Real fSetInsert = GetTime() - fStart;
+   fStart = GetTime();
+   for(UInt32 r = 0; r < un_rounds; ++r) {
+      for(CSet<int*>::iterator it = cSet.begin(); it != cSet.end(); ++it) {
+         unSum += reinterpret_cast<size_t>(*it);
+      }
+   }
+   Real fSetIterate = GetTime() - fStart;
+   fStart = GetTime();
+   for(UInt32 r = 0; r < un_rounds; ++r) {
+      for(UInt32 i = 0; i < un_size; ++i) {
+         cSet.insert(vecElements[i]);
+      }
+      cSet.clear();
+   }
+   Real fSetFillClear = GetTime() - fStart;
+   /* Linked list */
+   CListSet<int*> cList;
+   fStart = GetTime();
+   for(UInt32 r = 0; r < un_rounds; ++r) {
+      for(UInt32 i = 0; i < un_size; ++i) {
+         cList.insert(vecElements[i]);
+      }
+   }
+   Real fListInsert = GetTime() - fStart;
+   fStart = GetTime();
+   for(UInt32 r = 0; r < un_rounds; ++r) {
+      for(CListSet<int*>::SElement* psElem = cList.m_psFirst; psElem != nullptr; psElem = psElem->Next) {
+         unSum += reinterpret_cast<size_t>(psElem->Data);
+      }
+   }
+   Real fListIterate = GetTime() - fStart;
+   fStart = GetTime();
+   for(UInt32 r = 0; r < un_rounds; ++r) {
+      for(UInt32 i = 0; i < un_size; ++i) {
+         cList.insert(vecElements[i]);
+      }
+      cList.clear();
+   }
+   Real fListFillClear = GetTime() - fStart;
+   /* Keep the compiler from removing the loops */
+   if(unSum == 0) fprintf(stdout, "empty sets\n");
+   /* Insert: repeated inserts of present elements (lookup cost)
+      Fill+clear: inserts into an empty set, then clear */
+   fprintf(stdout, "%4u elements | lookup %7.1f / %7.1f ns | iterate %6.1f / %6.1f ns | fill+clear %8.1f / %8.1f ns\n",
+           un_size,
+           1e9 * fSetInsert / (un_rounds * un_size),
+           1e9 * fListInsert / (un_rounds * un_size),
+           1e9 * fSetIterate / (un_rounds * un_size),
+           1e9 * fListIterate / (un_rounds * un_size),
+           1e9 * fSetFillClear / un_rounds,
+           1e9 * fListFillClear / un_rounds);
+}
+
+/****************************************/
+/****************************************/
+
+int main() {
+   CRandom::CreateCategory("testing", 12345);
+   CRandom::CRNG* pcRNG = CRandom::CreateRNG("testing");
+   if(!Check(pcRNG)) {
+      CRandom::RemoveCategory("testing");
+      return 1;
+   }
+   fprintf(stdout, "All times are CSet / linked list, per element except fill+clear (per set)\n");
+   static const UInt32 SIZES[] = { 5, 10, 20, 50, 100, 200 };
+   for(size_t i = 0; i < sizeof(SIZES) / sizeof(SIZES[0]); ++i) {
+      Benchmark(SIZES[i], 200000 / SIZES[i], pcRNG);
+   }
+   CRandom::RemoveCategory("testing");
+   return 0;
+}
@@ -0,0 +1,230 @@
+/**
+ * @file <argos3/testing/unit/test-space-churn.cpp>
+ *
+ * Measures how long it takes to add and remove entities while an experiment
+ * is running, and checks the indexes of the space afterwards.
+ *
+ * The arena is filled with boxes and foot-bots. Then, at every tick, random
+ * entities are removed and replaced by new ones, as loop functions do with
+ * food items or markers. For each population size given on the command line,
+ * the time per replacement is printed, without the time spent stepping the
+ * experiment, so that the cost can be compared across sizes. After the run,
+ * the test fails if the entity vectors, the maps and the entity indices of
+ * the space do not agree.
+ *
+ * Example:
+ *
+ *   test-space-churn
+ *   test-space-churn 100 20
+ *   test-space-churn 100 20 1000 10000
+ */
+#include <argos3/core/simulator/simulator.h>
+#include <argos3/core/simulator/space/space.h>
+#include <argos3/core/control_interface/ci_controller.h>
+#include <argos3/core/utility/math/rng.h>
+#include <argos3/core/utility/plugins/dynamic_loading.h>
+#include <argos3/core/utility/string_utilities.h>
+#include <argos3/plugins/simulator/entities/box_entity.h>
+#include <argos3/plugins/robots/foot-bot/simulator/footbot_entity.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace argos;
+
+/****************************************/
+/****************************************/
+
+class CBenchChurnController : public CCI_Controller {
+
+public:
+
+   virtual void Init(TConfigurationNode& t_tree) {}
+
+   virtual void ControlStep() {}
+
+};
+
+REGISTER_CONTROLLER(CBenchChurnController, "bench_churn_controller");
+
+/****************************************/
+/****************************************/
+
+static std::string MakeExperiment(Real f_side) {
+   return
+      "<argos-configuration>"
+      "  <framework>"
+      "    <experiment length=\"0\" ticks_per_second=\"10\" random_seed=\"12345\" />"
+      "  </framework>"
+      "  <controllers>"
+      "    <bench_churn_controller id=\"bench\">"
+      "      <actuators />"
+      "      <sensors />"
+      "      <params />"
+      "    </bench_churn_controller>"
+      "  </controllers>"
+      "  <arena size=\"" + ToString(f_side + 1) + "," + ToString(f_side + 1) + ",2\" center=\"0,0,0.75\" />"
+      "  <physics_engines>"
+      "    <dynamics2d id=\"dyn2d\" />"
+      "  </physics_engines>"
+      "  <media />"
+      "</argos-configuration>";
+}
+
+/****************************************/
+/****************************************/
+
+static CEntity* MakeEntity(UInt32 un_id,
+                           Real f_side,
+                           CRandom::CRNG& c_rng) {
+   CRange<Real> cRange(-f_side * 0.5, f_side * 0.5);
+   CVector3 cPosition(c_rng.Uniform(cRange), c_rng.Uniform(cRange), 0.0);
+   if(un_id % 4 == 0) {
+      return new CFootBotEntity("fb" + ToString(un_id), "bench", cPosition);
+   }
+   return new CBoxEntity("box" + ToString(un_id),
+                         cPosition,
+                         CQuaternion(),
+                         false,
+                         CVector3(0.05, 0.05, 0.05));
+}
+
+/****************************************/
+/****************************************/
+
+/*
+ * Checks that the vectors, the maps and the indices of the space agree.
+ */
+static bool CheckIndexes(CSpace& c_space,
+                         const std::vector<CEntity*>& vec_alive,
+                         const std::vector<ssize_t>& vec_removed) {
+   CEntity::TVector& vecEntities = c_space.GetEntityVector();
+   for(size_t i = 0; i < vecEntities.size(); ++i) {
+      if(c_space.GetEntityByIndex(vecEntities[i]->GetIndex()) != vecEntities[i]) {
+         std::cout << "Entity \"" << vecEntities[i]->GetId() << "\" is not found by its index" << std::endl;
+         return false;
+      }
+   }
+   for(size_t i = 0; i < vec_removed.size(); ++i) {
+      if(c_space.GetEntityByIndex(vec_removed[i]) != NULL) {
+         std::cout << "The index " << vec_removed[i] << " of a removed entity is still in use" << std::endl;
+         return false;
+      }
+   }
+   CEntity::TVector& vecRoots = c_space.GetRootEntityVector();
+   if(vecRoots.size() != vec_alive.size()) {
+      std::cout << "The space has " << vecRoots.size() << " root entities instead of "
+                << vec_alive.size() << std::endl;
+      return false;
+   }
+   for(size_t i = 0; i < vec_alive.size(); ++i) {
+      if(&c_space.GetEntity(vec_alive[i]->GetId()) != vec_alive[i]) {
+         std::cout << "Entity \"" << vec_alive[i]->GetId() << "\" is not found by its id" << std::endl;
+         return false;
+      }
+   }
+   if(c_space.GetEntityMapPerId().size() != vecEntities.size()) {
+      std::cout << "The map of entities has " << c_space.GetEntityMapPerId().size()
+                << " entries for " << vecEntities.size() << " entities" << std::endl;
+      return false;
+   }
+   return true;
+}
+
+/****************************************/
+/****************************************/
+
+static bool RunSize(UInt32 un_entities,
+                    UInt32 un_ticks,
+                    UInt32 un_per_tick) {
+   Real fSide = std::sqrt(un_entities / 4.0);
+   ticpp::Document tDoc;
+   tDoc.Parse(MakeExperiment(fSide));
+   CSimulator& cSimulator = CSimulator::GetInstance();
+   cSimulator.Load(tDoc);
+   CSpace& cSpace = cSimulator.GetSpace();
+   CRandom::CRNG* pcRNG = CRandom::CreateRNG("argos");
+   /* Fill the arena */
+   UInt32 unNextId = 0;
+   std::vector<CEntity*> vecAlive;
+   for(UInt32 i = 0; i < un_entities; ++i) {
+      vecAlive.push_back(MakeEntity(unNextId++, fSide, *pcRNG));
+      CallEntityOperation<CSpaceOperationAddEntity, CSpace, void>(cSpace, *vecAlive.back());
+   }
+   /* Replace random entities at every tick */
+   std::vector<ssize_t> vecRemoved;
+   ::timeval tStart, tEnd;
+   Real fElapsed = 0.0;
+   for(UInt32 t = 0; t < un_ticks; ++t) {
+      ::gettimeofday(&tStart, nullptr);
+      for(UInt32 i = 0; i < un_per_tick; ++i) {
+         UInt32 unVictim = pcRNG->Uniform(CRange<UInt32>(0, vecAlive.size()));
+         vecRemoved.push_back(vecAlive[unVictim]->GetIndex());
+         CallEntityOperation<CSpaceOperationRemoveEntity, CSpace, void>(cSpace, *vecAlive[unVictim]);
+         vecAlive[unVictim] = MakeEntity(unNextId++, fSide, *pcRNG);
+         CallEntityOperation<CSpaceOperationAddEntity, CSpace, void>(cSpace, *vecAlive[unVictim]);
+      }
+      ::gettimeofday(&tEnd, nullptr);
+      fElapsed +=
+         (tEnd.tv_sec - tStart.tv_sec) +
+         (tEnd.tv_usec - tStart.tv_usec) / 1e6;
+      cSimulator.UpdateSpace();
+   }
+   std::cout << un_entities << " entities\t"
+             << un_ticks * un_per_tick << " replacements\t"
+             << 1e6 * fElapsed / (un_ticks * un_per_tick) << " us per replacement"
+             << std::endl;
+   bool bOK = CheckIndexes(cSpace, vecAlive, vecRemoved);
+   cSimulator.Destroy();
+   return bOK;
+}
+
+/****************************************/
+/****************************************/
+
+/*
+ * Runs the experiment with the given number of entities in a separate process.
+ * Returns false if the run failed.
+ */
+bool Run(UInt32 un_entities,
+         UInt32 un_ticks,
+         UInt32 un_per_tick) {
+   pid_t tPid = ::fork();
+   if(tPid == 0) {
+      bool bOK = false;
+      try {
+         LOG.DisableColoredOutput();
+         LOGERR.DisableColoredOutput();
+         CDynamicLoading::LoadAllLibraries();
+         bOK = RunSize(un_entities, un_ticks, un_per_tick);
+      }
+      catch(std::exception& ex) {
+         LOGERR << ex.what() << std::endl;
+      }
+      LOG.Flush();
+      LOGERR.Flush();
+      ::_exit(bOK ? 0 : 1);
+   }
+   int nStatus;
+   ::waitpid(tPid, &nStatus, 0);
+   return WIFEXITED(nStatus) && WEXITSTATUS(nStatus) == 0;
+}
+
+/****************************************/
+/****************************************/
+
+int main(int n_argc, char** ppch_argv) {
+   UInt32 unTicks   = (n_argc > 1) ? FromString<UInt32>(ppch_argv[1]) : 100;
+   UInt32 unPerTick = (n_argc > 2) ? FromString<UInt32>(ppch_argv[2]) : 20;
+   std::vector<UInt32> vecSizes;
+   for(int i = 3; i < n_argc; ++i) {
+      vecSizes.push_back(FromString<UInt32>(ppch_argv[i]));
+   }
+   if(vecSizes.empty()) {
+      vecSizes = { 1000, 4000, 16000 };
+   }
+   for(size_t i = 0; i < vecSizes.size(); ++i) {
+      if(!Run(vecSizes[i], unTicks, unPerTick)) return 1;
+   }
+   return 0;
+}
@@ -0,0 +1,283 @@
+/**
+ * @file <argos3/testing/unit/test-space-hash.cpp>
+ *
+ * Checks the native space hash against a reference space hash.
+ *
+ * The reference stores the elements of each cell in a std::map. Both hashes
+ * hold the same elements, which cover one or more cells depending on their
+ * size. For a number of rounds, random elements are moved, removed and
+ * inserted back, both hashes are updated, and the elements found in each
+ * cell around the elements and in random cells are compared. The native
+ * hash starts small, so that it also grows during the test.
+ *
+ * The test fails if the two hashes return different elements for any cell.
+ *
+ * Example:
+ *
+ *   test-space-hash
+ *   test-space-hash 5000 200
+ */
+#include <argos3/core/simulator/space/positional_indices/space_hash_native.h>
+#include <argos3/core/utility/math/rng.h>
+#include <argos3/core/utility/string_utilities.h>
+#include <map>
+#include <set>
+#include <tuple>
+#include <vector>
+
+using namespace argos;
+
+/****************************************/
+/****************************************/
+
+static const Real CELL_SIZE = 0.3;
+
+/****************************************/
+/****************************************/
+
+struct STestElement {
+   std::string Id;
+   CVector3 Position;
+   Real HalfSize;
+
+   const std::string& GetId() const { return Id; }
+};
+
+/****************************************/
+/****************************************/
+
+/*
+ * Stores the element in all the cells covered by its bounding box.
+ */
+class CTestElementUpdater : public CSpaceHashUpdater<STestElement> {
+
+public:
+
+   virtual void operator()(CAbstractSpaceHash<STestElement>& c_space_hash,
+                           STestElement& c_element) {
+      CVector3 cHalfSize(c_element.HalfSize, c_element.HalfSize, c_element.HalfSize);
+      SInt32 nMinI, nMinJ, nMinK, nMaxI, nMaxJ, nMaxK;
+      c_space_hash.SpaceToHashTable(nMinI, nMinJ, nMinK, c_element.Position - cHalfSize);
+      c_space_hash.SpaceToHashTable(nMaxI, nMaxJ, nMaxK, c_element.Position + cHalfSize);
+      for(SInt32 k = nMinK; k <= nMaxK; ++k) {
+         for(SInt32 j = nMinJ; j <= nMaxJ; ++j) {
+            for(SInt32 i = nMinI; i <= nMaxI; ++i) {
+               c_space_hash.UpdateCell(i, j, k, c_element);
+            }
+         }
+      }
+   }
+
+};
+
+/****************************************/
+/****************************************/
+
+/*
+ * The positional index queries are not used here.
+ */
+template <class BASE>
+class CTestSpaceHash : public BASE {
+
+public:
+
+   virtual void Init(TConfigurationNode&) {}
+   virtual void Reset() {}
+   virtual void Destroy() {}
+   virtual void GetEntitiesAt(CSet<STestElement*,SEntityComparator>&,
+                              const CVector3&) const {}
+   virtual void ForAllEntities(typename BASE::COperation&) {}
+   virtual void ForEntitiesInSphereRange(const CVector3&, Real, typename BASE::COperation&) {}
+   virtual void ForEntitiesInBoxRange(const CVector3&, const CVector3&, typename BASE::COperation&) {}
+   virtual void ForEntitiesInCircleRange(const CVector3&, Real, typename BASE::COperation&) {}
+   virtual void ForEntitiesInRectangleRange(const CVector3&, const CVector2&, typename BASE::COperation&) {}
+   virtual void ForEntitiesAlongRay(const CRay3&, typename BASE::COperation&, bool) {}
+
+};
+
+/****************************************/
+/****************************************/
+
+/*
+ * The reference space hash, which keeps the elements of each cell in a map.
+ */
+class CReferenceSpaceHash : public CSpaceHash<STestElement, CTestElementUpdater> {
+
+public:
+
+   typedef std::tuple<SInt32, SInt32, SInt32> TCell;
+
+public:
+
+   virtual void Update() {
+      m_mapCells.clear();
+      CSpaceHash<STestElement, CTestElementUpdater>::Update();
+   }
+
+   virtual void UpdateCell(SInt32 n_i,
+                           SInt32 n_j,
+                           SInt32 n_k,
+                           STestElement& c_element) {
+      m_mapCells[TCell(n_i, n_j, n_k)].insert(&c_element);
+   }
+
+   virtual bool CheckCell(SInt32 n_i,
+                          SInt32 n_j,
+                          SInt32 n_k,
+                          TEntityList& t_elements) {
+      std::map<TCell, std::set<STestElement*> >::const_iterator it =
+         m_mapCells.find(TCell(n_i, n_j, n_k));
+      if(it == m_mapCells.end()) return false;
+      for(std::set<STestElement*>::const_iterator itElem = it->second.begin();
+          itElem != it->second.end();
+          ++itElem) {
+         t_elements.insert(*itElem);
+      }
+      return true;
+   }
+
+   virtual void Dump(CARGoSLog&) {}
+
+private:
+
+   std::map<TCell, std::set<STestElement*> > m_mapCells;
+
+};
+
+/****************************************/
+/****************************************/
+
+typedef CTestSpaceHash<CSpaceHashNative<STestElement, CTestElementUpdater> > TNativeHash;
+typedef CTestSpaceHash<CReferenceSpaceHash> TReferenceHash;
+
+/****************************************/
+/****************************************/
+
+static void PlaceElement(STestElement& s_element,
+                         CRandom::CRNG& c_rng,
+                         const CRange<Real>& c_range) {
+   static const CRange<Real> HALF_SIZE_RANGE(0.01, 0.5);
+   s_element.Position.Set(c_rng.Uniform(c_range),
+                          c_rng.Uniform(c_range),
+                          c_rng.Uniform(CRange<Real>(-0.5, 0.5)));
+   s_element.HalfSize = c_rng.Uniform(HALF_SIZE_RANGE);
+}
+
+/****************************************/
+/****************************************/
+
+/*
+ * Returns true if both hashes find the same elements in the given cell.
+ */
+static bool CompareCell(TNativeHash& c_native,
+                        TReferenceHash& c_reference,
+                        SInt32 n_i,
+                        SInt32 n_j,
+                        SInt32 n_k) {
+   CAbstractSpaceHash<STestElement>::TEntityList tNative, tReference;
+   bool bNative = c_native.CheckCell(n_i, n_j, n_k, tNative);
+   bool bReference = c_reference.CheckCell(n_i, n_j, n_k, tReference);
+   if(bNative != bReference || tNative.size() != tReference.size()) return false;
+   for(CAbstractSpaceHash<STestElement>::TEntityList::iterator it = tNative.begin(), itRef = tReference.begin();
+       it != tNative.end();
+       ++it, ++itRef) {
+      if(*it != *itRef) return false;
+   }
+   return true;
+}
+
+/****************************************/
+/****************************************/
+
+/*
+ * Returns true if the hashes agree through all the rounds.
+ */
+static bool Compare(UInt32 un_elements,
+                    UInt32 un_rounds) {
+   CRandom::CRNG* pcRNG = CRandom::CreateRNG("testing");
+   Real fSide = CELL_SIZE * Sqrt(static_cast<Real>(un_elements));
+   CRange<Real> cRange(-fSide / 2.0, fSide / 2.0);
+   /* Make the hashes */
+   TNativeHash cNative;
+   cNative.SetCellSize(CVector3(CELL_SIZE, CELL_SIZE, CELL_SIZE));
+   cNative.SetSize(16);
+   TReferenceHash cReference;
+   cReference.SetCellSize(CVector3(CELL_SIZE, CELL_SIZE, CELL_SIZE));
+   cReference.SetSize(16);
+   /* Make the elements, and add them all */
+   std::vector<STestElement> vecElements(un_elements);
+   std::vector<bool> vecInHash(un_elements, true);
+   for(UInt32 i = 0; i < un_elements; ++i) {
+      vecElements[i].Id = "e" + ToString(i);
+      PlaceElement(vecElements[i], *pcRNG, cRange);
+      cNative.AddEntity(vecElements[i]);
+      cReference.AddEntity(vecElements[i]);
+   }
+   CRange<UInt32> cElementRange(0, un_elements);
+   for(UInt32 r = 0; r < un_rounds; ++r) {
+      /* Move, remove and insert back random elements */
+      for(UInt32 n = 0; n < un_elements / 10 + 1; ++n) {
+         UInt32 unElem = pcRNG->Uniform(cElementRange);
+         Real fChoice = pcRNG->Uniform(CRange<Real>(0.0, 1.0));
+         if(fChoice < 0.6) {
+            PlaceElement(vecElements[unElem], *pcRNG, cRange);
+         }
+         else if(vecInHash[unElem]) {
+            cNative.RemoveEntity(vecElements[unElem]);
+            cReference.RemoveEntity(vecElements[unElem]);
+            vecInHash[unElem] = false;
+         }
+         else {
+            PlaceElement(vecElements[unElem], *pcRNG, cRange);
+            cNative.AddEntity(vecElements[unElem]);
+            cReference.AddEntity(vecElements[unElem]);
+            vecInHash[unElem] = true;
+         }
+      }
+      cNative.Update();
+      cReference.Update();
+      /* Check the cells around each element, and random cells */
+      for(UInt32 i = 0; i < un_elements; ++i) {
+         SInt32 nI, nJ, nK;
+         cNative.SpaceToHashTable(nI, nJ, nK, vecElements[i].Position);
+         for(SInt32 k = nK - 1; k <= nK + 1; ++k) {
+            for(SInt32 j = nJ - 1; j <= nJ + 1; ++j) {
+               for(SInt32 l = nI - 1; l <= nI + 1; ++l) {
+                  if(!CompareCell(cNative, cReference, l, j, k)) {
+                     LOGERR << "Round " << r
+                            << ": the hashes differ in cell ("
+                            << l << "," << j << "," << k << ")"
+                            << std::endl;
+                     return false;
+                  }
+               }
+            }
+         }
+         CVector3 cRandom(pcRNG->Uniform(cRange),
+                          pcRNG->Uniform(cRange),
+                          pcRNG->Uniform(CRange<Real>(-1.0, 1.0)));
+         cNative.SpaceToHashTable(nI, nJ, nK, cRandom);
+         if(!CompareCell(cNative, cReference, nI, nJ, nK)) {
+            LOGERR << "Round " << r
+                   << ": the hashes differ in cell ("
+                   << nI << "," << nJ << "," << nK << ")"
+                   << std::endl;
+            return false;
+         }
+      }
+   }
+   return true;
+}
+
+/****************************************/
+/****************************************/
+
+int main(int n_argc, char** ppch_argv) {
+   UInt32 unElements = (n_argc > 1) ? FromString<UInt32>(ppch_argv[1]) : 2000;
+   UInt32 unRounds   = (n_argc > 2) ? FromString<UInt32>(ppch_argv[2]) : 100;
+   CRandom::CreateCategory("testing", 12345);
+   bool bOK = Compare(unElements, unRounds);
+   CRandom::RemoveCategory("testing");
+   LOGERR.Flush();
+   return bOK ? 0 : 1;
+}
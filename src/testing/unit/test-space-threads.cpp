@@ -0,0 +1,214 @@
+/**
+ * @file <argos3/testing/unit/test-space-threads.cpp>
+ *
+ * Compares the throughput (ticks/s) of the multi-thread spaces.
+ *
+ * The given arena template is filled with foot-bots running a simple
+ * obstacle avoidance controller. Each threading method is run in a
+ * separate process, so that the simulator singleton starts clean.
+ *
+ * By default, all the methods are compared. A subset can be given as
+ * additional arguments. The chunking of balance_length is given after a
+ * slash, as in balance_length/guided.
+ *
+ * Example:
+ *
+ *   test-space-threads arena_large.template.argos 32 2000 200
+ *   test-space-threads arena_large.template.argos 32 2000 200 work_stealing
+ *   test-space-threads arena_large.template.argos 32 2000 200 balance_length/guided
+ */
+#include <argos3/core/simulator/simulator.h>
+#include <argos3/core/simulator/space/space.h>
+#include <argos3/core/control_interface/ci_controller.h>
+#include <argos3/core/utility/plugins/dynamic_loading.h>
+#include <argos3/core/utility/string_utilities.h>
+#include <argos3/plugins/robots/generic/control_interface/ci_differential_steering_actuator.h>
+#include <argos3/plugins/robots/foot-bot/control_interface/ci_footbot_proximity_sensor.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <cmath>
+
+using namespace argos;
+
+/****************************************/
+/****************************************/
+
+class CBenchFootBotController : public CCI_Controller {
+
+public:
+
+   virtual void Init(TConfigurationNode& t_tree) {
+      m_pcWheels    = GetActuator<CCI_DifferentialSteeringActuator>("differential_steering");
+      m_pcProximity = GetSensor  <CCI_FootBotProximitySensor      >("footbot_proximity"    );
+   }
+
+   virtual void ControlStep() {
+      const CCI_FootBotProximitySensor::TReadings& tProxReads = m_pcProximity->GetReadings();
+      CVector2 cAccumulator;
+      for(size_t i = 0; i < tProxReads.size(); ++i) {
+         cAccumulator += CVector2(tProxReads[i].Value, tProxReads[i].Angle);
+      }
+      if(cAccumulator.Length() < 0.1) {
+         m_pcWheels->SetLinearVelocity(10.0, 10.0);
+      }
+      else if(cAccumulator.Angle().GetValue() > 0.0) {
+         m_pcWheels->SetLinearVelocity(10.0, 0.0);
+      }
+      else {
+         m_pcWheels->SetLinearVelocity(0.0, 10.0);
+      }
+   }
+
+private:
+
+   CCI_DifferentialSteeringActuator* m_pcWheels;
+   CCI_FootBotProximitySensor* m_pcProximity;
+
+};
+
+REGISTER_CONTROLLER(CBenchFootBotController, "bench_footbot_controller");
+
+/****************************************/
+/****************************************/
+
+static const char* CONTROLLER_XML =
+   "<bench_footbot_controller id=\"bench\">"
+   "  <actuators>"
+   "    <differential_steering implementation=\"default\" />"
+   "  </actuators>"
+   "  <sensors>"
+   "    <footbot_proximity implementation=\"default\" show_rays=\"false\" />"
+   "  </sensors>"
+   "  <params />"
+   "</bench_footbot_controller>";
+
+/****************************************/
+/****************************************/
+
+void AddNodeFromString(TConfigurationNode& t_parent,
+                       const std::string& str_xml) {
+   ticpp::Document tDoc;
+   tDoc.Parse(str_xml);
+   AddChildNode(t_parent, *tDoc.FirstChildElement());
+}
+
+/****************************************/
+/****************************************/
+
+Real RunMethod(const std::string& str_template,
+               const std::string& str_method,
+               UInt32 un_threads,
+               UInt32 un_robots,
+               UInt32 un_ticks) {
+   /* Load the template */
+   ticpp::Document tDoc;
+   tDoc.LoadFile(str_template);
+   TConfigurationNode& tRoot = *tDoc.FirstChildElement();
+   /* Threading */
+   TConfigurationNode& tFramework = GetNode(tRoot, "framework");
+   if(NodeExists(tFramework, "system")) {
+      tFramework.RemoveChild(&GetNode(tFramework, "system"));
+   }
+   std::string strMethod = str_method;
+   std::string strChunking = "single";
+   size_t unSlash = str_method.find('/');
+   if(unSlash != std::string::npos) {
+      strMethod = str_method.substr(0, unSlash);
+      strChunking = str_method.substr(unSlash + 1);
+   }
+   AddNodeFromString(tFramework,
+                     "<system threads=\"" + ToString(un_threads) +
+                     "\" method=\"" + strMethod +
+                     "\" chunking=\"" + strChunking + "\" />");
+   SetNodeAttribute(GetNode(tFramework, "experiment"), "random_seed", 12345);
+   /* Controller */
+   AddNodeFromString(GetNode(tRoot, "controllers"), CONTROLLER_XML);
+   /* Make the arena large enough for the robots and distribute them */
+   TConfigurationNode& tArena = GetNode(tRoot, "arena");
+   Real fSide = Max<Real>(2.0, 0.5 * std::sqrt(static_cast<Real>(un_robots)));
+   SetNodeAttribute(tArena, "size", CVector3(fSide, fSide, 2.0));
+   SetNodeAttribute(tArena, "center", CVector3(0.0, 0.0, 0.75));
+   AddNodeFromString(
+      tArena,
+      "<distribute>"
+      "  <position method=\"uniform\" min=\"" + ToString(-fSide * 0.45) + "," + ToString(-fSide * 0.45) + ",0\""
+      "            max=\"" + ToString(fSide * 0.45) + "," + ToString(fSide * 0.45) + ",0\" />"
+      "  <orientation method=\"uniform\" min=\"0,0,0\" max=\"360,0,0\" />"
+      "  <entity quantity=\"" + ToString(un_robots) + "\" max_trials=\"100\">"
+      "    <foot-bot id=\"fb\"><controller config=\"bench\" /></foot-bot>"
+      "  </entity>"
+      "</distribute>");
+   /* No visualization */
+   if(NodeExists(tRoot, "visualization")) {
+      tRoot.RemoveChild(&GetNode(tRoot, "visualization"));
+   }
+   /* Run the experiment */
+   CSimulator& cSimulator = CSimulator::GetInstance();
+   cSimulator.Load(tDoc);
+   ::timeval tStart, tEnd;
+   ::gettimeofday(&tStart, nullptr);
+   for(UInt32 i = 0; i < un_ticks; ++i) {
+      cSimulator.UpdateSpace();
+   }
+   ::gettimeofday(&tEnd, nullptr);
+   cSimulator.Destroy();
+   Real fElapsed =
+      (tEnd.tv_sec - tStart.tv_sec) +
+      (tEnd.tv_usec - tStart.tv_usec) / 1e6;
+   return un_ticks / fElapsed;
+}
+
+/****************************************/
+/****************************************/
+
+int main(int n_argc, char** ppch_argv) {
+   if(n_argc < 5) {
+      LOGERR << "Usage:" << std::endl;
+      LOGERR << ppch_argv[0] << " <template> <threads> <robots> <ticks> [method...]" << std::endl << std::endl;
+      LOGERR.Flush();
+      return 1;
+   }
+   std::string strTemplate = ppch_argv[1];
+   UInt32 unThreads = FromString<UInt32>(ppch_argv[2]);
+   UInt32 unRobots  = FromString<UInt32>(ppch_argv[3]);
+   UInt32 unTicks   = FromString<UInt32>(ppch_argv[4]);
+   std::vector<std::string> vecMethods;
+   for(int i = 5; i < n_argc; ++i) {
+      vecMethods.push_back(ppch_argv[i]);
+   }
+   if(vecMethods.empty()) {
+      vecMethods.push_back("balance_quantity");
+      vecMethods.push_back("balance_length");
+      vecMethods.push_back("balance_length/guided");
+      vecMethods.push_back("work_stealing");
+   }
+   for(const std::string& strMethod : vecMethods) {
+      /* Run each method in its own process */
+      pid_t tPid = ::fork();
+      if(tPid == 0) {
+         try {
+            LOG.DisableColoredOutput();
+            LOGERR.DisableColoredOutput();
+            CDynamicLoading::LoadAllLibraries();
+            Real fTicksPerSec = RunMethod(strTemplate, strMethod, unThreads, unRobots, unTicks);
+            std::cout << strMethod << "\t"
+                      << unThreads << " threads\t"
+                      << unRobots << " robots\t"
+                      << fTicksPerSec << " ticks/s"
+                      << std::endl;
+         }
+         catch(std::exception& ex) {
+            LOGERR << ex.what() << std::endl;
+            LOGERR.Flush();
+            ::_exit(1);
+         }
+         LOG.Flush();
+         LOGERR.Flush();
+         ::_exit(0);
+      }
+      int nStatus;
+      ::waitpid(tPid, &nStatus, 0);
+   }
+   return 0;
+}
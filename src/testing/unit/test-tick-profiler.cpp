@@ -0,0 +1,287 @@
+/**
+ * @file <argos3/testing/unit/test-tick-profiler.cpp>
+ *
+ * Measures the overhead of the tick profiler and checks its output.
+ *
+ * A foot-bot experiment runs with LEDs, a range-and-bearing system and
+ * proximity sensors. In mode 'off', the <profiling> tag is absent. In mode
+ * 'summary', the profiler writes the CSV summary. In mode 'trace', it writes
+ * the Chrome trace as well. Each mode runs in a separate process, so that the
+ * simulator singleton starts clean. For each mode, the time per tick is
+ * printed.
+ *
+ * When ARGoS is compiled with ARGOS_TICK_PROFILER, the test fails if the
+ * summary misses a phase, the physics engine, a medium, a sensor, an actuator
+ * or the controller, or if the number of steps does not match, or if the
+ * trace has no timers.
+ *
+ * Example:
+ *
+ *   test-tick-profiler
+ *   test-tick-profiler 500 200 4
+ *   test-tick-profiler 500 200 4 off trace
+ */
+#include <argos3/core/simulator/simulator.h>
+#include <argos3/core/control_interface/ci_controller.h>
+#include <argos3/core/utility/plugins/dynamic_loading.h>
+#include <argos3/core/utility/string_utilities.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <cmath>
+#include <fstream>
+#include <map>
+
+using namespace argos;
+
+/****************************************/
+/****************************************/
+
+class CBenchProfilerController : public CCI_Controller {
+
+public:
+
+   virtual void Init(TConfigurationNode& t_tree) {}
+
+   virtual void ControlStep() {}
+
+};
+
+REGISTER_CONTROLLER(CBenchProfilerController, "bench_profiler_controller");
+
+/****************************************/
+/****************************************/
+
+static const std::string TRACE_FILE   = "test-tick-profiler-trace.json";
+static const std::string SUMMARY_FILE = "test-tick-profiler-summary.csv";
+static const std::string PROFILE_FILE = "test-tick-profiler-profile.txt";
+
+/****************************************/
+/****************************************/
+
+static std::string MakeExperiment(const std::string& str_mode,
+                                  UInt32 un_robots,
+                                  UInt32 un_threads) {
+   Real fSide = std::sqrt(un_robots / 2.0);
+   std::string strProfiling;
+   if(str_mode == "summary") {
+      strProfiling = "<profiling file=\"" + PROFILE_FILE + "\" format=\"table\""
+         " summary_file=\"" + SUMMARY_FILE + "\" />";
+   }
+   else if(str_mode == "trace") {
+      strProfiling = "<profiling file=\"" + PROFILE_FILE + "\" format=\"table\""
+         " summary_file=\"" + SUMMARY_FILE + "\" trace_file=\"" + TRACE_FILE + "\" />";
+   }
+   return
+      "<argos-configuration>"
+      "  <framework>"
+      "    <system threads=\"" + ToString(un_threads) + "\" />"
+      "    <experiment length=\"0\" ticks_per_second=\"10\" random_seed=\"12345\" />"
+      + strProfiling +
+      "  </framework>"
+      "  <controllers>"
+      "    <bench_profiler_controller id=\"bench\">"
+      "      <actuators>"
+      "        <differential_steering implementation=\"default\" />"
+      "        <leds implementation=\"default\" medium=\"leds\" />"
+      "        <range_and_bearing implementation=\"default\" />"
+      "      </actuators>"
+      "      <sensors>"
+      "        <footbot_proximity implementation=\"default\" show_rays=\"false\" />"
+      "        <range_and_bearing implementation=\"medium\" medium=\"rab\" show_rays=\"false\" />"
+      "      </sensors>"
+      "      <params />"
+      "    </bench_profiler_controller>"
+      "  </controllers>"
+      "  <arena size=\"" + ToString(fSide + 1) + "," + ToString(fSide + 1) + ",2\" center=\"0,0,0.75\">"
+      "    <distribute>"
+      "      <position method=\"uniform\" min=\"" + ToString(-fSide / 2) + "," + ToString(-fSide / 2) + ",0\""
+      "                max=\"" + ToString(fSide / 2) + "," + ToString(fSide / 2) + ",0\" />"
+      "      <orientation method=\"uniform\" min=\"0,0,0\" max=\"360,0,0\" />"
+      "      <entity quantity=\"" + ToString(un_robots) + "\" max_trials=\"100\">"
+      "        <foot-bot id=\"fb\"><controller config=\"bench\" /></foot-bot>"
+      "      </entity>"
+      "    </distribute>"
+      "  </arena>"
+      "  <physics_engines>"
+      "    <dynamics2d id=\"dyn2d\" />"
+      "  </physics_engines>"
+      "  <media>"
+      "    <led id=\"leds\" />"
+      "    <range_and_bearing id=\"rab\" />"
+      "  </media>"
+      "</argos-configuration>";
+}
+
+/****************************************/
+/****************************************/
+
+/*
+ * Checks that the summary has a row for each part of the tick, and that the
+ * step phase was timed once per tick.
+ */
+static bool CheckSummary(UInt32 un_ticks) {
+   std::ifstream cInFile(SUMMARY_FILE.c_str());
+   if(!cInFile) {
+      std::cout << "The summary was not written" << std::endl;
+      return false;
+   }
+   /* Read the count of each zone */
+   std::map<std::string, UInt64> mapCounts;
+   std::string strLine;
+   std::getline(cInFile, strLine);
+   while(std::getline(cInFile, strLine)) {
+      std::vector<std::string> vecFields;
+      Tokenize(strLine, vecFields, ",");
+      if(vecFields.size() != 10) {
+         std::cout << "Malformed summary line \"" << strLine << "\"" << std::endl;
+         return false;
+      }
+      mapCounts[vecFields[0] + "/" + vecFields[1]] = FromString<UInt64>(vecFields[2]);
+   }
+#ifdef ARGOS_TICK_PROFILER
+   const char* ppchExpected[] = {
+      "phase/step", "phase/act", "phase/physics", "phase/media",
+      "phase/pre_step", "phase/sense_step", "phase/post_step",
+      "physics_engine/dyn2d", "medium/leds", "medium/rab",
+      "sensor/footbot_proximity", "sensor/range_and_bearing",
+      "actuator/differential_steering", "actuator/leds", "actuator/range_and_bearing",
+      "controller/bench_profiler_controller"
+   };
+   for(size_t i = 0; i < sizeof(ppchExpected) / sizeof(ppchExpected[0]); ++i) {
+      if(mapCounts.find(ppchExpected[i]) == mapCounts.end()) {
+         std::cout << "The summary has no row for \"" << ppchExpected[i] << "\"" << std::endl;
+         return false;
+      }
+   }
+   if(mapCounts["phase/step"] != un_ticks) {
+      std::cout << "The summary has " << mapCounts["phase/step"] << " steps instead of " << un_ticks << std::endl;
+      return false;
+   }
+#else
+   std::cout << "ARGoS was compiled without ARGOS_TICK_PROFILER, the summary is not checked" << std::endl;
+#endif
+   return true;
+}
+
+/****************************************/
+/****************************************/
+
+/*
+ * Checks that the trace is a Chrome trace with timers.
+ */
+static bool CheckTrace() {
+   std::ifstream cInFile(TRACE_FILE.c_str());
+   if(!cInFile) {
+      std::cout << "The trace was not written" << std::endl;
+      return false;
+   }
+   std::string strTrace((std::istreambuf_iterator<char>(cInFile)),
+                        std::istreambuf_iterator<char>());
+   if(strTrace.compare(0, 1, "{") != 0 ||
+      strTrace.find("\"traceEvents\":[") == std::string::npos) {
+      std::cout << "The trace is not a Chrome trace" << std::endl;
+      return false;
+   }
+#ifdef ARGOS_TICK_PROFILER
+   if(strTrace.find("\"ph\":\"X\"") == std::string::npos) {
+      std::cout << "The trace has no timers" << std::endl;
+      return false;
+   }
+#endif
+   return true;
+}
+
+/****************************************/
+/****************************************/
+
+static bool RunMode(const std::string& str_mode,
+                    UInt32 un_robots,
+                    UInt32 un_ticks,
+                    UInt32 un_threads) {
+   ::unlink(TRACE_FILE.c_str());
+   ::unlink(SUMMARY_FILE.c_str());
+   ticpp::Document tDoc;
+   tDoc.Parse(MakeExperiment(str_mode, un_robots, un_threads));
+   CSimulator& cSimulator = CSimulator::GetInstance();
+   cSimulator.Load(tDoc);
+   ::timeval tStart, tEnd;
+   ::gettimeofday(&tStart, nullptr);
+   for(UInt32 t = 0; t < un_ticks; ++t) {
+      cSimulator.UpdateSpace();
+   }
+   ::gettimeofday(&tEnd, nullptr);
+   Real fElapsed =
+      (tEnd.tv_sec - tStart.tv_sec) +
+      (tEnd.tv_usec - tStart.tv_usec) / 1e6;
+   std::cout << str_mode << "\t"
+             << un_robots << " robots\t"
+             << un_threads << " threads\t"
+             << 1e6 * fElapsed / un_ticks << " us per tick"
+             << std::endl;
+   /* The profiler writes its files when the simulator is destroyed */
+   cSimulator.Destroy();
+   bool bOK = true;
+   if(str_mode != "off") {
+      bOK = CheckSummary(un_ticks);
+   }
+   if(bOK && str_mode == "trace") {
+      bOK = CheckTrace();
+   }
+   ::unlink(PROFILE_FILE.c_str());
+   ::unlink(TRACE_FILE.c_str());
+   ::unlink(SUMMARY_FILE.c_str());
+   return bOK;
+}
+
+/****************************************/
+/****************************************/
+
+/*
+ * Runs the experiment in the given mode in a separate process.
+ * Returns false if the run failed.
+ */
+bool Run(const std::string& str_mode,
+         UInt32 un_robots,
+         UInt32 un_ticks,
+         UInt32 un_threads) {
+   pid_t tPid = ::fork();
+   if(tPid == 0) {
+      bool bOK = false;
+      try {
+         LOG.DisableColoredOutput();
+         LOGERR.DisableColoredOutput();
+         CDynamicLoading::LoadAllLibraries();
+         bOK = RunMode(str_mode, un_robots, un_ticks, un_threads);
+      }
+      catch(std::exception& ex) {
+         LOGERR << ex.what() << std::endl;
+      }
+      LOG.Flush();
+      LOGERR.Flush();
+      ::_exit(bOK ? 0 : 1);
+   }
+   int nStatus;
+   ::waitpid(tPid, &nStatus, 0);
+   return WIFEXITED(nStatus) && WEXITSTATUS(nStatus) == 0;
+}
+
+/****************************************/
+/****************************************/
+
+int main(int n_argc, char** ppch_argv) {
+   UInt32 unRobots  = (n_argc > 1) ? FromString<UInt32>(ppch_argv[1]) : 200;
+   UInt32 unTicks   = (n_argc > 2) ? FromString<UInt32>(ppch_argv[2]) : 200;
+   UInt32 unThreads = (n_argc > 3) ? FromString<UInt32>(ppch_argv[3]) : 0;
+   std::vector<std::string> vecModes;
+   for(int i = 4; i < n_argc; ++i) {
+      vecModes.push_back(ppch_argv[i]);
+   }
+   if(vecModes.empty()) {
+      vecModes = { "off", "summary", "trace" };
+   }
+   for(size_t i = 0; i < vecModes.size(); ++i) {
+      if(!Run(vecModes[i], unRobots, unTicks, unThreads)) return 1;
+   }
+   return 0;
+}
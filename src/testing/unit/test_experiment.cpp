@@ -0,0 +1,114 @@
+/**
+ * @file <argos3/testing/unit/test_experiment.cpp>
+ */
+#include "test_experiment.h"
+#include <argos3/core/simulator/simulator.h>
+#include <argos3/core/simulator/space/space.h>
+#include <argos3/core/simulator/entity/composable_entity.h>
+#include <argos3/core/simulator/entity/embodied_entity.h>
+#include <argos3/core/utility/plugins/dynamic_loading.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+
+/****************************************/
+/****************************************/
+
+const UInt64 CHECKSUM_SEED = 14695981039346656037ULL;
+
+/****************************************/
+/****************************************/
+
+void AddToChecksum(UInt64& un_checksum,
+                   const void* pt_data,
+                   size_t un_size) {
+   const UInt8* punData = static_cast<const UInt8*>(pt_data);
+   for(size_t i = 0; i < un_size; ++i) {
+      un_checksum = (un_checksum ^ punData[i]) * 1099511628211ULL;
+   }
+}
+
+/****************************************/
+/****************************************/
+
+UInt64 ComputePoseChecksum(const std::string& str_type) {
+   UInt64 unChecksum = CHECKSUM_SEED;
+   CSpace::TMapPerType& tEntities = CSimulator::GetInstance().GetSpace().GetEntitiesByType(str_type);
+   for(CSpace::TMapPerType::iterator it = tEntities.begin(); it != tEntities.end(); ++it) {
+      /* The entities are stored by their own type, so go through the base class */
+      CComposableEntity& cEntity =
+         dynamic_cast<CComposableEntity&>(CSimulator::GetInstance().GetSpace().GetEntity(it->first));
+      const SAnchor& sOrigin = cEntity.GetComponent<CEmbodiedEntity>("body").GetOriginAnchor();
+      Real pfPose[7] = {
+         sOrigin.Position.GetX(), sOrigin.Position.GetY(), sOrigin.Position.GetZ(),
+         sOrigin.Orientation.GetW(), sOrigin.Orientation.GetX(),
+         sOrigin.Orientation.GetY(), sOrigin.Orientation.GetZ()
+      };
+      AddToChecksum(unChecksum, it->first.c_str(), it->first.size());
+      AddToChecksum(unChecksum, pfPose, sizeof(pfPose));
+   }
+   return unChecksum;
+}
+
+/****************************************/
+/****************************************/
+
+void LoadExperiment(const std::string& str_experiment) {
+   ticpp::Document tDoc;
+   tDoc.Parse(str_experiment);
+   CSimulator::GetInstance().Load(tDoc);
+}
+
+/****************************************/
+/****************************************/
+
+bool RunInChildProcess(const std::function<bool(UInt64&)>& fun_run,
+                       UInt64& un_checksum) {
+   int pnPipe[2];
+   if(::pipe(pnPipe) != 0) {
+      LOGERR << "Cannot create pipe: " << ::strerror(errno) << std::endl;
+      LOGERR.Flush();
+      return false;
+   }
+   pid_t tPid = ::fork();
+   if(tPid == 0) {
+      ::close(pnPipe[0]);
+      bool bOK = false;
+      try {
+         LOG.DisableColoredOutput();
+         LOGERR.DisableColoredOutput();
+         CDynamicLoading::LoadAllLibraries();
+         UInt64 unChecksum = 0;
+         bOK = fun_run(unChecksum) &&
+            ::write(pnPipe[1], &unChecksum, sizeof(unChecksum)) == sizeof(unChecksum);
+      }
+      catch(std::exception& ex) {
+         LOGERR << ex.what() << std::endl;
+      }
+      LOG.Flush();
+      LOGERR.Flush();
+      /* _exit() does not flush the streams, and they are buffered when redirected */
+      std::cout.flush();
+      std::cerr.flush();
+      ::_exit(bOK ? 0 : 1);
+   }
+   ::close(pnPipe[1]);
+   bool bRead = (::read(pnPipe[0], &un_checksum, sizeof(UInt64)) == sizeof(UInt64));
+   ::close(pnPipe[0]);
+   int nStatus;
+   ::waitpid(tPid, &nStatus, 0);
+   return bRead && WIFEXITED(nStatus) && WEXITSTATUS(nStatus) == 0;
+}
+
+/****************************************/
+/****************************************/
+
+bool RunInChildProcess(const std::function<bool()>& fun_run) {
+   UInt64 unChecksum;
+   return RunInChildProcess(
+      [&fun_run](UInt64&) {
+         return fun_run();
+      },
+      unChecksum);
+}
@@ -0,0 +1,56 @@
+/**
+ * @file <argos3/testing/unit/test_experiment.h>
+ *
+ * Helpers for the tests that run whole experiments.
+ *
+ * The simulator is a singleton, so each experiment runs in a child process
+ * that starts clean. The results are compared through checksums, which the
+ * child sends back to the parent.
+ */
+#ifndef TEST_EXPERIMENT_H
+#define TEST_EXPERIMENT_H
+
+#include <argos3/core/utility/datatypes/datatypes.h>
+#include <functional>
+#include <string>
+
+using namespace argos;
+
+/**
+ * The initial value of a checksum.
+ */
+extern const UInt64 CHECKSUM_SEED;
+
+/**
+ * Adds the given bytes to a checksum (FNV-1a).
+ */
+void AddToChecksum(UInt64& un_checksum,
+                   const void* pt_data,
+                   size_t un_size);
+
+/**
+ * Returns the checksum of the ids and the poses of the entities of the given type.
+ * The entities must have an embodied entity called "body".
+ */
+UInt64 ComputePoseChecksum(const std::string& str_type);
+
+/**
+ * Parses the given XML and loads it into the simulator.
+ */
+void LoadExperiment(const std::string& str_experiment);
+
+/**
+ * Runs the given function in a child process, after loading the plugins.
+ * The function returns false if the test failed, and can set a checksum to
+ * send back. Returns false if the function failed or threw an exception.
+ */
+bool RunInChildProcess(const std::function<bool(UInt64&)>& fun_run,
+                       UInt64& un_checksum);
+
+/**
+ * Runs the given function in a child process, after loading the plugins.
+ * Returns false if the function failed or threw an exception.
+ */
+bool RunInChildProcess(const std::function<bool()>& fun_run);
+
+#endif